@@ -9,13 +9,22 @@
 #define NUM_STATES_PER_ACTUATOR 2
 #define NUM_TOTAL_STATES NUM_ACTUATORS*NUM_STATES_PER_ACTUATOR
 
+// Fixed sizes of the actuator matrices
+struct Hopper_Actuator_Dimensions{
+    typedef Eigen::Matrix<double, NUM_TOTAL_STATES, NUM_TOTAL_STATES> Matrix_states; // Mass, damping and stiffness matrices
+    typedef Eigen::Matrix<double, NUM_ACTUATORS, NUM_ACTUATORS> Matrix_act;
+    typedef Eigen::Matrix<double, NUM_ACTUATORS, 1> Vector_act;
+};
+
 // The hopper model has 1 actuator with
 // States are z = Actuator linear position and 
 //            delta = spring position
 
 class HopperActuatorModel{
 public:
+    // Returns the calling thread's model. Each thread gets its own copy of the parameters.
     static HopperActuatorModel* GetActuatorModel();
+    HopperActuatorModel(const HopperActuatorModel &other) = default;
     ~HopperActuatorModel(void);
 
     void getMassMatrix(sejong::Matrix &M_act);
@@ -39,6 +48,61 @@ public:
 
     void getFull_act_pos_z(const sejong::Vector &q_in, sejong::Vector &z_out);
 
+    // Fixed-size versions used by the combined model
+    void getMassMatrix(Hopper_Actuator_Dimensions::Matrix_states &M_act);
+    void getDampingMatrix(Hopper_Actuator_Dimensions::Matrix_states &B_act);
+    void getStiffnessMatrix(Hopper_Actuator_Dimensions::Matrix_states &K_act);
+    void getKm_Matrix(Hopper_Actuator_Dimensions::Matrix_act &Km_act);
+
+    void getFullJacobian_dzdq(const Hopper_Actuator_Dimensions::Vector_act &z_pos, Hopper_Actuator_Dimensions::Matrix_act &L);   
+    void getFullJacobian_dqdz(const Hopper_Actuator_Dimensions::Vector_act &q_pos, Hopper_Actuator_Dimensions::Matrix_act &J);
+
+    void getFull_joint_pos_q(const Hopper_Actuator_Dimensions::Vector_act &z_in, Hopper_Actuator_Dimensions::Vector_act &q_out);
+    void getFull_joint_vel_qdot(const Hopper_Actuator_Dimensions::Vector_act &z_in, const Hopper_Actuator_Dimensions::Vector_act &zdot_in, 
+                                Hopper_Actuator_Dimensions::Vector_act &qdot_out);
+
+
+    // Templated on the scalar type for automatic differentiation, eg: with Dual<N>. The double versions above use these.
+    template <typename Scalar>
+    Scalar get_joint_pos_q(const int &index, const Scalar &z_act_pos){
+        return (z_act_pos - z_o[index])/r_arm[index] + q_o[index];
+    }
+    template <typename Scalar>
+    Scalar getJacobian_dqdz(const int &index, const Scalar &q_act_pos){
+        return Scalar(1.0/r_arm[index]);
+    }
+    template <typename Scalar>
+    Scalar getJacobian_dzdq(const int &index, const Scalar &z_act_pos){
+        return Scalar(r_arm[index]);
+    }
+
+    template <typename Scalar>
+    void getFull_joint_pos_q(const Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &z_in, Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &q_out){
+        for(int i = 0; i < NUM_ACTUATORS; i++){
+            q_out[i] = get_joint_pos_q(i, z_in[i]);
+        }
+    }
+    template <typename Scalar>
+    void getFull_joint_vel_qdot(const Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &z_in, const Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &zdot_in,
+                                Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &qdot_out){
+        for(int i = 0; i < NUM_ACTUATORS; i++){
+            qdot_out[i] = getJacobian_dqdz(i, z_in[i])*zdot_in[i];
+        }
+    }
+    template <typename Scalar>
+    void getFullJacobian_dzdq(const Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &z_pos, Eigen::Matrix<Scalar, NUM_ACTUATORS, NUM_ACTUATORS> &L){
+        L.setIdentity();
+        for(int i = 0; i < NUM_ACTUATORS; i++){
+            L(i,i) = getJacobian_dzdq(i, z_pos[i]);
+        }
+    }
+    template <typename Scalar>
+    void getFullJacobian_dqdz(const Eigen::Matrix<Scalar, NUM_ACTUATORS, 1> &q_pos, Eigen::Matrix<Scalar, NUM_ACTUATORS, NUM_ACTUATORS> &J){
+        J.setIdentity();
+        for(int i = 0; i < NUM_ACTUATORS; i++){
+            J(i,i) = getJacobian_dqdz(i, q_pos[i]);
+        }
+    }
 
     void set_zero_pos_q_o(sejong::Vector &q_o_in);
     // double
@@ -6,83 +6,124 @@
 #include <hopper_actuator_model/hopper_actuator_model.hpp>
 #include "HopperModel.hpp"
 
+// Compile-time sizes of the combined model. x = [q_virt, z, delta]
+struct Hopper_Combined_Dimensions{
+	static const int num_x = NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT;
+
+	typedef Eigen::Matrix<double, num_x, 1> Vector_x;
+	typedef Eigen::Matrix<double, num_x, num_x> Matrix_x;
+	typedef Eigen::Matrix<double, num_x, NUM_ACT_JOINT> Matrix_x_act;
+	typedef Eigen::Matrix<double, NUM_VIRTUAL, NUM_VIRTUAL> Matrix_virtual;
+	typedef Eigen::Matrix<double, NUM_VIRTUAL, NUM_ACT_JOINT> Matrix_virtual_act;
+	typedef Eigen::Matrix<double, NUM_ACT_JOINT, NUM_VIRTUAL> Matrix_act_virtual;
+};
+
+// Variables of the combined backward Euler dynamics for a set of knotpoints, in the layout of knotpoint_batch.hpp
+struct Hopper_Act_Dynamics_Batch{
+	typedef Eigen::Matrix<double, Eigen::Dynamic, Hopper_Combined_Dimensions::num_x> Matrix_x_batch;
+	typedef Eigen::Matrix<double, Eigen::Dynamic, NUM_ACT_JOINT> Matrix_act_batch;
+
+	Matrix_x_batch x;
+	Matrix_x_batch xdot;
+	Matrix_x_batch xdot_prev;
+	Matrix_act_batch u;
+	sejong::Matrix Fr; // Inactive contacts must be zero
+	sejong::Vector h;
+
+	void resize(const int &num_knotpoints, const int &num_Fr){
+		x.resize(num_knotpoints, Hopper_Combined_Dimensions::num_x);
+		xdot.resize(num_knotpoints, Hopper_Combined_Dimensions::num_x);
+		xdot_prev.resize(num_knotpoints, Hopper_Combined_Dimensions::num_x);
+		u.resize(num_knotpoints, NUM_ACT_JOINT);
+		Fr.resize(num_knotpoints, num_Fr);
+		h.resize(num_knotpoints);
+	}
+};
+
 class Hopper_Combined_Dynamics_Model{
 public:
+    // Returns the calling thread's model. UpdateModel overwrites the cached matrices, so threads must not share one.
     static Hopper_Combined_Dynamics_Model* GetCombinedModel();
+    // Copies the cached state and uses the calling thread's robot and actuator models
+    Hopper_Combined_Dynamics_Model(const Hopper_Combined_Dynamics_Model &other);
     ~Hopper_Combined_Dynamics_Model(void);
 
 	HopperModel* robot_model;	
 	HopperActuatorModel* actuator_model;
 
-	sejong::Matrix M_combined;
-	sejong::Matrix M_combined_inv;
-	sejong::Matrix B_combined;
-	sejong::Matrix K_combined;
+	Hopper_Combined_Dimensions::Matrix_x M_combined;
+	Eigen::PartialPivLU<Hopper_Combined_Dimensions::Matrix_x> M_combined_lu; // M_combined is not symmetric, so LU instead of LDLT
+	Hopper_Combined_Dimensions::Matrix_x B_combined;
+	Hopper_Combined_Dimensions::Matrix_x K_combined;
 
-	sejong::Matrix M_act;
-	sejong::Matrix M_zz;	
-	sejong::Matrix M_z_delta;
-	sejong::Matrix M_delta_z;	
-	sejong::Matrix M_delta_delta;	
+	Hopper_Actuator_Dimensions::Matrix_states M_act;
+	Hopper_Actuator_Dimensions::Matrix_act M_zz;	
+	Hopper_Actuator_Dimensions::Matrix_act M_z_delta;
+	Hopper_Actuator_Dimensions::Matrix_act M_delta_z;	
+	Hopper_Actuator_Dimensions::Matrix_act M_delta_delta;	
 
-	sejong::Matrix B_act;
-	sejong::Matrix B_zz;	
-	sejong::Matrix B_z_delta;
-	sejong::Matrix B_delta_z;	
-	sejong::Matrix B_delta_delta;
+	Hopper_Actuator_Dimensions::Matrix_states B_act;
+	Hopper_Actuator_Dimensions::Matrix_act B_zz;	
+	Hopper_Actuator_Dimensions::Matrix_act B_z_delta;
+	Hopper_Actuator_Dimensions::Matrix_act B_delta_z;	
+	Hopper_Actuator_Dimensions::Matrix_act B_delta_delta;
 
-	sejong::Matrix K_act;		
-	sejong::Matrix K_zz;	
-	sejong::Matrix K_z_delta;
-	sejong::Matrix K_delta_z;	
-	sejong::Matrix K_delta_delta;
+	Hopper_Actuator_Dimensions::Matrix_states K_act;		
+	Hopper_Actuator_Dimensions::Matrix_act K_zz;	
+	Hopper_Actuator_Dimensions::Matrix_act K_z_delta;
+	Hopper_Actuator_Dimensions::Matrix_act K_delta_z;	
+	Hopper_Actuator_Dimensions::Matrix_act K_delta_delta;
 
-	sejong::Matrix Km_act;
+	Hopper_Actuator_Dimensions::Matrix_act Km_act;
 
-	sejong::Matrix A_mat; // NUM_QDOT x NUM_QDT
-	sejong::Matrix A_bb; // NUM_VIRTUAL x NUM_VIRTUAL
-	sejong::Matrix A_br; // NUM_VIRTUAL x NUM_ACT_JOINT
-	sejong::Matrix A_brT; // NUM_ACT_JOINT x NUM_VIRTUAL
-	sejong::Matrix A_rr; // NUM_ACT_JOINT x NUM_ACT_JOINT
+	Hopper_Dimensions::Matrix_qdot A_mat; // NUM_QDOT x NUM_QDT
+	Hopper_Combined_Dimensions::Matrix_virtual A_bb; // NUM_VIRTUAL x NUM_VIRTUAL
+	Hopper_Combined_Dimensions::Matrix_virtual_act A_br; // NUM_VIRTUAL x NUM_ACT_JOINT
+	Hopper_Combined_Dimensions::Matrix_act_virtual A_brT; // NUM_ACT_JOINT x NUM_VIRTUAL
+	Hopper_Dimensions::Matrix_act A_rr; // NUM_ACT_JOINT x NUM_ACT_JOINT
 
-	sejong::Vector grav;
-	sejong::Vector coriolis;
+	Hopper_Dimensions::Vector_qdot grav;
+	Hopper_Dimensions::Vector_qdot coriolis;
 
-	sejong::Matrix Sv; // Virtual Dynamics Selection Matrix
-	sejong::Matrix Sa; // Actuated Dynamics Selection Matrix			
+	Hopper_Dimensions::Matrix_virtual_qdot Sv; // Virtual Dynamics Selection Matrix
+	Hopper_Dimensions::Matrix_act_qdot Sa; // Actuated Dynamics Selection Matrix			
 
-	sejong::Matrix Jc; // Contact Jacobian;
-	sejong::Matrix L; // dz/dq Jacobian;
-	sejong::Matrix J; // dq/dz Jacobian
+	Hopper_Dimensions::Matrix_contact_jacobian Jc; // Contact Jacobian;
+	Hopper_Actuator_Dimensions::Matrix_act L; // dz/dq Jacobian;
+	Hopper_Actuator_Dimensions::Matrix_act J; // dq/dz Jacobian
 
-	sejong::Vector x_state;
-	sejong::Vector xdot_state;	
+	Hopper_Combined_Dimensions::Vector_x x_state;
+	Hopper_Combined_Dimensions::Vector_x xdot_state;	
 
-	sejong::Vector z_state;
-	sejong::Vector zdot_state;	
+	Hopper_Dimensions::Vector_act z_state;
+	Hopper_Dimensions::Vector_act zdot_state;	
 	
-	sejong::Vector q_virt_state;
-	sejong::Vector qdot_virt_state;
+	Hopper_Dimensions::Vector_virtual q_virt_state;
+	Hopper_Dimensions::Vector_virtual qdot_virt_state;
 	
-	sejong::Vector q_act;
-	sejong::Vector qdot_act;	
+	Hopper_Dimensions::Vector_act q_act;
+	Hopper_Dimensions::Vector_act qdot_act;	
 
 	//sejong::Vector delta_state;
 	//sejong::Vector delta_dot_state;
 
-	sejong::Vector q_state;
-	sejong::Vector qdot_state;	
+	Hopper_Dimensions::Vector_q q_state;
+	Hopper_Dimensions::Vector_qdot qdot_state;	
 
 	// Input/Impedances
-	sejong::Vector total_imp;
-	sejong::Vector virt_imp;
-	sejong::Vector current_input;
-	sejong::Vector joint_imp;		
+	Hopper_Dimensions::Vector_qdot total_imp;
+	Hopper_Dimensions::Vector_virtual virt_imp;
+	Hopper_Dimensions::Vector_act current_input;
+	Hopper_Dimensions::Vector_act joint_imp;		
 
 
 
+	// Does nothing if the model is already at x_state_in and xdot_state_in
 	void UpdateModel(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in);
-	void setContactJacobian(sejong::Matrix &Jc_in);
+	// Same, with the robot's M, g and h already computed at the q and qdot of x_state_in, eg: by a Knotpoint_Model_Cache
+	void UpdateModel(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in, const Hopper_Dimensions::Matrix_qdot &A_in,
+					 const Hopper_Dimensions::Vector_qdot &grav_in, const Hopper_Dimensions::Vector_qdot &coriolis_in);
+	void setContactJacobian(const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in);
 
 	void get_combined_mass_matrix(const sejong::Vector &x_state, const sejong::Vector &xdot_state, sejong::Matrix &M_out);
 	void get_combined_damping_matrix(const sejong::Vector &x_state, const sejong::Vector &xdot_state, sejong::Matrix &B_out);
@@ -109,20 +150,281 @@ public:
 	void getDynamics_constraint(const sejong::Vector &x_state_k, const sejong::Vector &xdot_state_k, const sejong::Vector &xdot_state_k_prev, 
                                                            const sejong::Vector &u_current_k, const sejong::Vector &Fr_state_k, double h_k, sejong::Vector &dynamics_out);
 
+	// The backward Euler dynamics constraint above at every knotpoint of the batch in one pass. Row i of dynamics_out is the
+	// constraint of row i of the batch. The model is updated at the first knotpoint only: M_combined, B_combined, K_combined,
+	// the gravity, the coriolis and Jc (set with setContactJacobian) are the same at every knotpoint of the hopper.
+	void getDynamics_constraint_batch(const Hopper_Act_Dynamics_Batch &batch, Hopper_Act_Dynamics_Batch::Matrix_x_batch &dynamics_out);
+
+	// Partial derivatives of the backward Euler dynamics constraint above w.r.t. each of its arguments.
+	void getDynamics_constraint_gradient(const sejong::Vector &x_state_k, const sejong::Vector &xdot_state_k, const sejong::Vector &xdot_state_k_prev, 
+	                                     const sejong::Vector &u_current_k, const sejong::Vector &Fr_state_k, double h_k,
+	                                     sejong::Matrix &dF_dx_k, sejong::Matrix &dF_dxdot_k, sejong::Matrix &dF_dxdot_k_prev,
+	                                     sejong::Matrix &dF_du_k, sejong::Matrix &dF_dFr_k, sejong::Vector &dF_dh_k);
+
+	// dq/dx Jacobian of the x to q conversion
+	void getJacobian_dq_dx(const sejong::Vector &x_state, sejong::Matrix &dq_dx_out);
+
+	// x to q templated on the scalar type for automatic differentiation
+	template <typename Scalar>
+	void convert_x_to_q(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state, Eigen::Matrix<Scalar, NUM_Q, 1> &q_state_out);
+
+	// The backward Euler dynamics constraint templated on the scalar type for automatic differentiation, eg: with Dual<N>.
+	// It computes the model at x_state_k, xdot_state_k from scratch and does not touch the cached matrices.
+	// Jc_in is the contact Jacobian at the q of x_state_k. It is a constant because the hopper's contact Jacobian does not depend on q.
+	template <typename Scalar>
+	void getDynamics_constraint(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state_k, 
+								const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k,
+								const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k_prev, 
+								const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current_k,
+								const Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> &Fr_state_k,
+								const Scalar &h_k, const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in,
+								Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &dynamics_out);
+
+	// xddot of the combined model templated on the scalar type. Like the templated dynamics constraint above, it computes the model
+	// at x_state, xdot_state from scratch, and Jc_in is the constant contact Jacobian. M_out is the combined mass matrix at x_state.
+	template <typename Scalar>
+	void get_state_acceleration(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state,
+								const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state,
+								const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current,
+								const Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> &Fr_state,
+								const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in,
+								Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xddot_out,
+								Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M_out);
+
+	// M_combined, B_combined and K_combined from the robot inertia and the actuator Jacobians L = dz/dq and J = dq/dz
+	template <typename Scalar>
+	static void formulate_mass_matrix(const Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> &A, const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &L, 
+									  const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J, const Hopper_Actuator_Dimensions::Matrix_states &M_act_in, 
+									  Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M_out);
+	template <typename Scalar>
+	static void formulate_damping_matrix(const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &L, const Hopper_Actuator_Dimensions::Matrix_states &B_act_in, 
+										 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &B_out);
+	template <typename Scalar>
+	static void formulate_stiffness_matrix(const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &L, const Hopper_Actuator_Dimensions::Matrix_states &K_act_in, 
+										   Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &K_out);
+	// input = [virtual impedance - A_br*J*zdot, Km*u, joint impedance] of the combined dynamics M*xddot + B*xdot + K*x = input
+	template <typename Scalar>
+	static void formulate_total_input(const Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> &A_br_in, const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J_in,
+									  const Hopper_Actuator_Dimensions::Matrix_act &Km_act_in, const Eigen::Matrix<Scalar, NUM_QDOT, 1> &total_imp_in,
+									  const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state,
+									  const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current,
+									  Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &total_input_out);
+	// M*(xdot[k] - xdot[k-1]) + h*(B*xdot[k] + K*x[k] - input) from the matrices of the model at x[k]. total_imp = -coriolis - grav + Jc^T*Fr.
+	// Both getDynamics_constraint versions assemble the constraint with it: the double one from the cached matrices.
+	template <typename Scalar>
+	static void formulate_dynamics_constraint(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M, 
+											  const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &B, 
+											  const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &K,
+											  const Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> &A_br_in, const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J_in,
+											  const Hopper_Actuator_Dimensions::Matrix_act &Km_act_in, const Eigen::Matrix<Scalar, NUM_QDOT, 1> &total_imp_in,
+											  const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state_k, 
+											  const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k,
+											  const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k_prev, 
+											  const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current_k, const Scalar &h_k,
+											  Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &dynamics_out);
+
 
 protected:
+	// The combined model at x_state, xdot_state from scratch, shared by the templated dynamics constraint and state acceleration.
+	// total_imp_out = -coriolis - grav + Jc^T*Fr.
+	template <typename Scalar>
+	void formulate_model(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state,
+						 const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state,
+						 const Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> &Fr_state,
+						 const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in,
+						 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M_out,
+						 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &B_out,
+						 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &K_out,
+						 Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> &A_br_out, Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J_out,
+						 Hopper_Actuator_Dimensions::Matrix_act &Km_act_out, Eigen::Matrix<Scalar, NUM_QDOT, 1> &total_imp_out);
 
 	void formulate_mass_matrix();
 	void formulate_damping_matrix();	
 	void formulate_stiffness_matrix();
 	void formulate_joint_link_impedance(const::sejong::Vector &Fr_state_in);			
+	void update_q_qdot_states();
+	void update_combined_matrices();
+	bool is_model_updated(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in);
+
+	bool model_updated = false; // x_state and xdot_state hold the state of the last UpdateModel
 
 	void Initialization();
-	void initialize_actuator_matrices(sejong::Matrix &Mat);
+	void initialize_actuator_matrices(Hopper_Actuator_Dimensions::Matrix_act &Mat);
 
 private:
     Hopper_Combined_Dynamics_Model();
 
 };
 
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::formulate_mass_matrix(const Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> &A, const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &L, 
+														   const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J, const Hopper_Actuator_Dimensions::Matrix_states &M_act_in, 
+														   Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M_out){
+	const Eigen::Matrix<Scalar, NUM_ACT_JOINT * NUM_STATES_PER_ACTUATOR, NUM_ACT_JOINT * NUM_STATES_PER_ACTUATOR> M_act_s = M_act_in.template cast<Scalar>();
+	M_out.setZero();
+	M_out.block(0, 0, NUM_VIRTUAL, NUM_VIRTUAL) = A.block(0, 0, NUM_VIRTUAL, NUM_VIRTUAL);
+	M_out.block(0, NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT) = A.block(0, NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT)*J;
+	M_out.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = M_act_s.block(0, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	M_out.block(NUM_VIRTUAL, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = M_act_s.block(0, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	M_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_VIRTUAL) = A.block(NUM_VIRTUAL, 0, NUM_ACT_JOINT, NUM_VIRTUAL);
+	M_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_VIRTUAL) = A.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT)*J 
+																						+ L.transpose()*M_act_s.block(NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	M_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = L.transpose()*M_act_s.block(NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::formulate_damping_matrix(const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &L, const Hopper_Actuator_Dimensions::Matrix_states &B_act_in, 
+															  Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &B_out){
+	const Eigen::Matrix<Scalar, NUM_ACT_JOINT * NUM_STATES_PER_ACTUATOR, NUM_ACT_JOINT * NUM_STATES_PER_ACTUATOR> B_act_s = B_act_in.template cast<Scalar>();
+	B_out.setZero();
+	B_out.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = B_act_s.block(0, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	B_out.block(NUM_VIRTUAL, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = B_act_s.block(0, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	B_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_VIRTUAL) = L.transpose()*B_act_s.block(NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	B_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = L.transpose()*B_act_s.block(NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::formulate_stiffness_matrix(const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &L, const Hopper_Actuator_Dimensions::Matrix_states &K_act_in, 
+																Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &K_out){
+	const Eigen::Matrix<Scalar, NUM_ACT_JOINT * NUM_STATES_PER_ACTUATOR, NUM_ACT_JOINT * NUM_STATES_PER_ACTUATOR> K_act_s = K_act_in.template cast<Scalar>();
+	K_out.setZero();
+	K_out.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = K_act_s.block(0, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	K_out.block(NUM_VIRTUAL, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = K_act_s.block(0, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	K_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_VIRTUAL) = L.transpose()*K_act_s.block(NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
+	K_out.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = L.transpose()*K_act_s.block(NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::convert_x_to_q(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state, Eigen::Matrix<Scalar, NUM_Q, 1> &q_state_out){
+	Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> z = x_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+	Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> q_act_out;
+	actuator_model->getFull_joint_pos_q(z, q_act_out);
+	q_state_out.head(NUM_VIRTUAL) = x_state.head(NUM_VIRTUAL);
+	q_state_out.tail(NUM_ACT_JOINT) = q_act_out;
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::formulate_model(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state,
+													 const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state,
+													 const Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> &Fr_state,
+													 const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in,
+													 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M_out,
+													 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &B_out,
+													 Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &K_out,
+													 Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> &A_br_out, Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J_out,
+													 Hopper_Actuator_Dimensions::Matrix_act &Km_act_out, Eigen::Matrix<Scalar, NUM_QDOT, 1> &total_imp_out){
+	typedef Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> Vector_act_s;
+	typedef Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> Matrix_act_s;
+
+	// x = [q_virt, z, delta] to q, qdot
+	Vector_act_s z = x_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+	Vector_act_s zdot = xdot_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+	Vector_act_s qdot_act;
+	actuator_model->getFull_joint_vel_qdot(z, zdot, qdot_act);
+
+	Eigen::Matrix<Scalar, NUM_Q, 1> q;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> qdot;
+	convert_x_to_q(x_state, q);
+	Vector_act_s q_act = q.tail(NUM_ACT_JOINT);
+	qdot.head(NUM_VIRTUAL) = xdot_state.head(NUM_VIRTUAL);
+	qdot.tail(NUM_ACT_JOINT) = qdot_act;
+
+	Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> A;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> grav_s;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> coriolis_s;
+	robot_model->getMassInertia(q, A);
+	robot_model->getGravity(q, grav_s);
+	robot_model->getCoriolis(q, qdot, coriolis_s);
+
+	Matrix_act_s L_s;
+	actuator_model->getFullJacobian_dzdq(z, L_s);
+	actuator_model->getFullJacobian_dqdz(q_act, J_out);
+
+	Hopper_Actuator_Dimensions::Matrix_states M_act_s;
+	Hopper_Actuator_Dimensions::Matrix_states B_act_s;
+	Hopper_Actuator_Dimensions::Matrix_states K_act_s;
+	actuator_model->getMassMatrix(M_act_s);
+	actuator_model->getDampingMatrix(B_act_s);
+	actuator_model->getStiffnessMatrix(K_act_s);
+	actuator_model->getKm_Matrix(Km_act_out);
+
+	formulate_mass_matrix(A, L_s, J_out, M_act_s, M_out);
+	formulate_damping_matrix(L_s, B_act_s, B_out);
+	formulate_stiffness_matrix(L_s, K_act_s, K_out);
+
+	total_imp_out = -coriolis_s - grav_s + Jc_in.template cast<Scalar>().transpose()*Fr_state;
+	A_br_out = A.block(0, NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::getDynamics_constraint(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state_k, 
+															const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k,
+															const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k_prev, 
+															const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current_k,
+															const Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> &Fr_state_k,
+															const Scalar &h_k, const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in,
+															Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &dynamics_out){
+	typedef Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> Matrix_x_s;
+	Matrix_x_s M_k;
+	Matrix_x_s B_k;
+	Matrix_x_s K_k;
+	Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> A_br_k;
+	Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> J_k;
+	Hopper_Actuator_Dimensions::Matrix_act Km_act_k;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> total_imp_k;
+	formulate_model(x_state_k, xdot_state_k, Fr_state_k, Jc_in, M_k, B_k, K_k, A_br_k, J_k, Km_act_k, total_imp_k);
+	formulate_dynamics_constraint(M_k, B_k, K_k, A_br_k, J_k, Km_act_k, total_imp_k, x_state_k, xdot_state_k, xdot_state_k_prev, u_current_k, h_k, dynamics_out);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::get_state_acceleration(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state,
+															const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state,
+															const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current,
+															const Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> &Fr_state,
+															const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in,
+															Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xddot_out,
+															Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M_out){
+	typedef Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> Matrix_x_s;
+	Matrix_x_s B_s;
+	Matrix_x_s K_s;
+	Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> A_br_s;
+	Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> J_s;
+	Hopper_Actuator_Dimensions::Matrix_act Km_act_s;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> total_imp_s;
+	formulate_model(x_state, xdot_state, Fr_state, Jc_in, M_out, B_s, K_s, A_br_s, J_s, Km_act_s, total_imp_s);
+
+	Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> total_input;
+	formulate_total_input(A_br_s, J_s, Km_act_s, total_imp_s, xdot_state, u_current, total_input);
+	// M_combined is not symmetric, so LU instead of LDLT. The pivoting only looks at the values of Duals.
+	xddot_out = M_out.partialPivLu().solve(total_input - B_s*xdot_state - K_s*x_state);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::formulate_total_input(const Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> &A_br_in, const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J_in,
+														   const Hopper_Actuator_Dimensions::Matrix_act &Km_act_in, const Eigen::Matrix<Scalar, NUM_QDOT, 1> &total_imp_in,
+														   const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state,
+														   const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current,
+														   Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &total_input_out){
+	total_input_out.head(NUM_VIRTUAL) = total_imp_in.head(NUM_VIRTUAL) - A_br_in*J_in*xdot_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+	total_input_out.segment(NUM_VIRTUAL, NUM_ACT_JOINT) = Km_act_in.template cast<Scalar>()*u_current;
+	total_input_out.tail(NUM_ACT_JOINT) = total_imp_in.tail(NUM_ACT_JOINT);
+}
+
+template <typename Scalar>
+void Hopper_Combined_Dynamics_Model::formulate_dynamics_constraint(const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &M, 
+																   const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &B, 
+																   const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> &K,
+																   const Eigen::Matrix<Scalar, NUM_VIRTUAL, NUM_ACT_JOINT> &A_br_in, const Eigen::Matrix<Scalar, NUM_ACT_JOINT, NUM_ACT_JOINT> &J_in,
+																   const Hopper_Actuator_Dimensions::Matrix_act &Km_act_in, const Eigen::Matrix<Scalar, NUM_QDOT, 1> &total_imp_in,
+																   const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &x_state_k, 
+																   const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k,
+																   const Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &xdot_state_k_prev, 
+																   const Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> &u_current_k, const Scalar &h_k,
+																   Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> &dynamics_out){
+	Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> total_input;
+	formulate_total_input(A_br_in, J_in, Km_act_in, total_imp_in, xdot_state_k, u_current_k, total_input);
+
+	dynamics_out = M*(xdot_state_k - xdot_state_k_prev) + h_k*(B*xdot_state_k + K*x_state_k - total_input);
+}
+
 #endif
\ No newline at end of file
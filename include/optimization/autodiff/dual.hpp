@@ -0,0 +1,132 @@
+#ifndef OPT_AUTODIFF_DUAL_H
+#define OPT_AUTODIFF_DUAL_H
+
+#include <Utils/wrap_eigen.hpp>
+#include <cmath>
+
+// Forward mode automatic differentiation with N directions at once.
+// A Dual<N> holds a value and its derivatives w.r.t. N seeded variables, so evaluating a function
+// templated on its scalar type with Dual<N> inputs gives its value and its full Jacobian in one pass.
+//
+// Usage:
+//   Eigen::Matrix<Dual<4>, 4, 1> x_dual;
+//   seed_dual_vector(x, 0, x_dual);        // Variables 0 to 3
+//   f(x_dual, F_dual);                     // f is templated on the scalar type
+//   get_dual_jacobian(F_dual, dF_dx);      // F_dual.size() x 4
+template <int N>
+struct Dual{
+	// The derivatives are not aligned so that Duals can be stored anywhere, eg: in dynamic Eigen matrices
+	typedef Eigen::Matrix<double, N, 1, Eigen::DontAlign> Derivative;
+
+	double value;
+	Derivative deriv;
+
+	Dual(): value(0.0) { deriv.setZero(); }
+	Dual(const double &value_in): value(value_in) { deriv.setZero(); } // Constants have no derivatives
+	Dual(const double &value_in, const Derivative &deriv_in): value(value_in), deriv(deriv_in) {}
+
+	// value_in is the variable of the given direction
+	static Dual variable(const double &value_in, const int &direction){
+		Dual x(value_in);
+		x.deriv[direction] = 1.0;
+		return x;
+	}
+
+	Dual& operator+=(const Dual &b){ value += b.value; deriv += b.deriv; return *this; }
+	Dual& operator-=(const Dual &b){ value -= b.value; deriv -= b.deriv; return *this; }
+	Dual& operator*=(const Dual &b){ deriv = deriv*b.value + value*b.deriv; value *= b.value; return *this; }
+	Dual& operator/=(const Dual &b){ deriv = (deriv*b.value - value*b.deriv)/(b.value*b.value); value /= b.value; return *this; }
+};
+
+template <int N> inline Dual<N> operator-(const Dual<N> &a){ return Dual<N>(-a.value, -a.deriv); }
+template <int N> inline Dual<N> operator+(const Dual<N> &a){ return a; }
+
+template <int N> inline Dual<N> operator+(const Dual<N> &a, const Dual<N> &b){ return Dual<N>(a.value + b.value, a.deriv + b.deriv); }
+template <int N> inline Dual<N> operator+(const Dual<N> &a, const double &b){ return Dual<N>(a.value + b, a.deriv); }
+template <int N> inline Dual<N> operator+(const double &a, const Dual<N> &b){ return Dual<N>(a + b.value, b.deriv); }
+
+template <int N> inline Dual<N> operator-(const Dual<N> &a, const Dual<N> &b){ return Dual<N>(a.value - b.value, a.deriv - b.deriv); }
+template <int N> inline Dual<N> operator-(const Dual<N> &a, const double &b){ return Dual<N>(a.value - b, a.deriv); }
+template <int N> inline Dual<N> operator-(const double &a, const Dual<N> &b){ return Dual<N>(a - b.value, -b.deriv); }
+
+template <int N> inline Dual<N> operator*(const Dual<N> &a, const Dual<N> &b){ return Dual<N>(a.value*b.value, a.deriv*b.value + a.value*b.deriv); }
+template <int N> inline Dual<N> operator*(const Dual<N> &a, const double &b){ return Dual<N>(a.value*b, a.deriv*b); }
+template <int N> inline Dual<N> operator*(const double &a, const Dual<N> &b){ return Dual<N>(a*b.value, a*b.deriv); }
+
+template <int N> inline Dual<N> operator/(const Dual<N> &a, const Dual<N> &b){
+	return Dual<N>(a.value/b.value, (a.deriv*b.value - a.value*b.deriv)/(b.value*b.value));
+}
+template <int N> inline Dual<N> operator/(const Dual<N> &a, const double &b){ return Dual<N>(a.value/b, a.deriv/b); }
+template <int N> inline Dual<N> operator/(const double &a, const Dual<N> &b){ return Dual<N>(a/b.value, (-a/(b.value*b.value))*b.deriv); }
+
+// Comparisons only look at the values, eg: for the pivoting of Eigen's decompositions
+template <int N> inline bool operator<(const Dual<N> &a, const Dual<N> &b){ return a.value < b.value; }
+template <int N> inline bool operator>(const Dual<N> &a, const Dual<N> &b){ return a.value > b.value; }
+template <int N> inline bool operator<=(const Dual<N> &a, const Dual<N> &b){ return a.value <= b.value; }
+template <int N> inline bool operator>=(const Dual<N> &a, const Dual<N> &b){ return a.value >= b.value; }
+template <int N> inline bool operator==(const Dual<N> &a, const Dual<N> &b){ return a.value == b.value; }
+template <int N> inline bool operator!=(const Dual<N> &a, const Dual<N> &b){ return a.value != b.value; }
+
+template <int N> inline Dual<N> sqrt(const Dual<N> &a){ double s = std::sqrt(a.value); return Dual<N>(s, a.deriv*(0.5/s)); }
+template <int N> inline Dual<N> sin(const Dual<N> &a){ return Dual<N>(std::sin(a.value), a.deriv*std::cos(a.value)); }
+template <int N> inline Dual<N> cos(const Dual<N> &a){ return Dual<N>(std::cos(a.value), -a.deriv*std::sin(a.value)); }
+template <int N> inline Dual<N> exp(const Dual<N> &a){ double e = std::exp(a.value); return Dual<N>(e, a.deriv*e); }
+template <int N> inline Dual<N> log(const Dual<N> &a){ return Dual<N>(std::log(a.value), a.deriv/a.value); }
+template <int N> inline Dual<N> pow(const Dual<N> &a, const double &b){
+	return Dual<N>(std::pow(a.value, b), a.deriv*(b*std::pow(a.value, b - 1.0)));
+}
+template <int N> inline Dual<N> abs(const Dual<N> &a){ return (a.value < 0.0) ? -a : a; }
+template <int N> inline Dual<N> fabs(const Dual<N> &a){ return abs(a); }
+
+// Value of a double or of a Dual, so templated code can branch on the value of its inputs
+inline double dual_value(const double &a){ return a; }
+template <int N> inline double dual_value(const Dual<N> &a){ return a.value; }
+
+// out[i] is the variable of direction offset + i with the value values[i]
+template <typename Derived, typename Out>
+void seed_dual_vector(const Eigen::MatrixBase<Derived> &values, const int &offset, Out &out){
+	typedef typename Out::Scalar Dual_Scalar;
+	out.resize(values.size());
+	for(int i = 0; i < values.size(); i++){
+		out[i] = Dual_Scalar::variable(values[i], offset + i);
+	}
+}
+
+template <typename Derived>
+void get_dual_values(const Eigen::MatrixBase<Derived> &F, sejong::Vector &F_out){
+	F_out.resize(F.size());
+	for(int i = 0; i < F.size(); i++){
+		F_out[i] = F[i].value;
+	}
+}
+
+// Row i holds the derivatives of F[i] w.r.t. the N seeded variables
+template <typename Derived>
+void get_dual_jacobian(const Eigen::MatrixBase<Derived> &F, sejong::Matrix &J_out){
+	typedef typename Derived::Scalar Dual_Scalar;
+	J_out.resize(F.size(), Dual_Scalar::Derivative::RowsAtCompileTime);
+	for(int i = 0; i < F.size(); i++){
+		J_out.row(i) = F[i].deriv.transpose();
+	}
+}
+
+namespace Eigen{
+	template <int N>
+	struct NumTraits< Dual<N> >: NumTraits<double>{
+		typedef Dual<N> Real;
+		typedef Dual<N> NonInteger;
+		typedef Dual<N> Nested;
+		typedef Dual<N> Literal;
+		enum{
+			IsComplex = 0,
+			IsInteger = 0,
+			IsSigned = 1,
+			RequireInitialization = 1,
+			ReadCost = 1,
+			AddCost = N + 1,
+			MulCost = 2*N + 1
+		};
+	};
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <optimization/optimization_problems/opt_problem_main.hpp>
+#include <optimization/parallel/thread_pool.hpp>
+#include <optimization/snopt_wrapper.hpp>
+
+// Describes one problem of a batch
+struct Batch_Problem_Spec{
+	std::string name;
+	// Builds the problem. It is called on the thread that solves it and the problem is deleted after the solve.
+	std::function<Optimization_Problem_Main*()> create_problem;
+	bool use_gradients = true;
+	// Optional. A previous solver state of the problem, eg: from read_solver_state, to warm start from.
+	snopt_wrapper::Solver_State warm_start;
+	// Optional. Called after the solve while the problem still exists, eg: to parse the trajectory.
+	std::function<void(Optimization_Problem_Main*, const snopt_wrapper::Solve_Result&)> process_result;
+};
+
+// Solves many problems in one process, several at the same time.
+// The threads of the batch are kept between calls to solve_all so their robot models are only built once.
+// Each problem evaluates its own constraints with a single thread since the batch already uses the cores.
+class Batch_Solver{
+public:
+	Batch_Solver(const int &num_concurrent_solves = 1);
+	~Batch_Solver();	
+
+	void add_problem(const Batch_Problem_Spec &spec);
+	void clear_problems();
+	int get_num_problems();
+
+	void set_num_concurrent_solves(const int &num_concurrent_solves);
+	int get_num_concurrent_solves();
+
+	// SNOPT writes each solve to "<print_file_prefix>_<problem index>.out". Print files are off by default.
+	// SNOPT opens every print file on the same Fortran unit, so solves with a print file run one at a time.
+	// Only leave the prefix empty, the default, if the batch should solve concurrently.
+	void set_print_file_prefix(const std::string &prefix);
+
+	// results_out[i] belongs to the i-th added problem. A problem that fails to build or solve has an exit_code of -1.
+	void solve_all(std::vector<snopt_wrapper::Solve_Result> &results_out);
+
+private:
+	void solve_problem(const int &index, snopt_wrapper::Solve_Result &result_out);
+
+	Thread_Pool thread_pool;
+	std::vector<Batch_Problem_Spec> problem_specs;
+	std::string print_file_prefix;
+};
+
+#endif
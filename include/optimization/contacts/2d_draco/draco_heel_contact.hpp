@@ -9,12 +9,12 @@ class Draco_Heel_Contact: public Contact{
 public:
 	Draco_Heel_Contact();
 	~Draco_Heel_Contact();	
-	DracoModel* robot_model;
 
 	void getContactJacobian(const sejong::Vector &q_state, sejong::Matrix & Jt);
     void getContactJacobianDotQdot(const sejong::Vector &q_state, 
   								   const sejong::Vector &qdot_state, sejong::Vector & JtDotQdot);
     void signed_distance_to_contact(const sejong::Vector &q_state, double &distance);
+    void getSignedDistanceJacobian(const sejong::Vector &q_state, sejong::Matrix & J_dist);
 };
 
 #endif
\ No newline at end of file
@@ -15,6 +15,8 @@ public:
   int contact_link_id;
 
   virtual void signed_distance_to_contact(const sejong::Vector &q_state, double &distance){}
+  // 1 x NUM_QDOT Jacobian of the signed distance w.r.t. q
+  virtual void getSignedDistanceJacobian(const sejong::Vector &q_state, sejong::Matrix & J_dist){}
   sejong::Vector contact_pos; // contact position
 };
 
@@ -2,6 +2,7 @@
 #define CONTACT_LIST_H
 
 #include <vector>
+#include <iostream>
 #include <optimization/contacts/contact_main.hpp>
 
 class Contact_List{
@@ -14,10 +15,38 @@ public:
 
 	int get_size();
 	Contact* get_contact(int index);
+	int get_total_contact_dim(); // Rows of the stacked contact Jacobian
+
+	// Stacks the Jacobians of all the contacts into Jc. Jc can be a robot's Matrix_contact_jacobian 
+	// (see Robot_Dimensions), which is sized once and does not allocate.
+	template <typename Jacobian_Type>
+	void get_stacked_contact_jacobian(const sejong::Vector &q_state, Jacobian_Type &Jc);
 
 private:
 	sejong::Matrix Q_matrix; // contact reaction force cost matrix
 	std::vector<Contact*> contact_list;
 };
 
+template <typename Jacobian_Type>
+void Contact_List::get_stacked_contact_jacobian(const sejong::Vector &q_state, Jacobian_Type &Jc){
+	int total_rows = get_total_contact_dim();
+	if ((Jacobian_Type::MaxRowsAtCompileTime != Eigen::Dynamic) && (total_rows > Jacobian_Type::MaxRowsAtCompileTime)){
+		std::cerr << "Error stacking the contact Jacobians. The contacts have " << total_rows << " rows but at most " 
+				  << Jacobian_Type::MaxRowsAtCompileTime << " fit" << std::endl;
+		throw "invalid_index";
+	}
+
+	// Keeps its capacity between calls
+	static thread_local sejong::Matrix J_tmp;
+	int prev_row_size = 0;
+	for (size_t i = 0; i < contact_list.size(); i++){
+		contact_list[i]->getContactJacobian(q_state, J_tmp);
+		if (i == 0){
+			Jc.resize(total_rows, J_tmp.cols());
+		}
+		Jc.block(prev_row_size, 0, J_tmp.rows(), J_tmp.cols()) = J_tmp;
+		prev_row_size += J_tmp.rows();
+	}
+}
+
 #endif
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <Utils/wrap_eigen.hpp>
 #include <vector>
 #include <string>
+#include <stdint.h>
+
+class Contact_List;
 
 class Contact_Mode_Schedule{
 public:
@@ -12,15 +15,34 @@ public:
 
 	void add_new_mode(const int &mode_start_time, const int &mode_final_time, std::vector<int> &active_contacts_indices);	
 	void get_active_contacts(const int &knotpoint, std::vector<int> &active_contacts_indices_out);
-	int get_mode(const int &knotpoint);
+	int get_mode(const int &knotpoint); // -1 if no mode contains the knotpoint
 	int get_num_modes();
 
+	// Tabulates the mode, the active contacts and the reaction force mask of knotpoints 0 to N_total_knotpoints.
+	// Call it after the last add_new_mode. Adding a mode discards the tables.
+	void finalize_schedule(Contact_List* contact_list, const int &N_total_knotpoints);
+	bool is_finalized();
+
+	// These require a finalized schedule
+	uint64_t get_active_contact_mask(const int &knotpoint); // Bit i is set if contact i is active
+	int get_contact_Fr_offset(const int &contact_index);   // Row of the contact's forces in the stacked Fr vector
+	// Ones in the rows of active contacts and zeros elsewhere, so Fr.cwiseProduct(mask) zeroes the inactive forces
+	const sejong::Vector& get_active_Fr_mask(const int &knotpoint);
+
 private:
 	int num_modes = 0;
 	std::vector< std::vector<int> > mode_to_active_contacts;
 	std::vector<int> mode_start_times;
 	std::vector<int> mode_final_times;	
 
+	bool finalized = false;
+	std::vector<int> knotpoint_to_mode;
+	std::vector<uint64_t> knotpoint_active_contact_masks;
+	std::vector<sejong::Vector> knotpoint_Fr_masks;
+	std::vector<int> contact_Fr_offsets;
+
+	void check_finalized_knotpoint(const int &knotpoint);
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef KNOTPOINT_MODEL_CACHE_H
+#define KNOTPOINT_MODEL_CACHE_H
+
+#include <Utils/wrap_eigen.hpp>
+#include <vector>
+#include <deque>
+#include <iostream>
+#include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/contact_list.hpp>
+
+// Position and Jacobian of a link
+struct Link_Kinematics{
+	int link_id = -1;
+	sejong::Vector pos;
+	sejong::Matrix J;
+};
+
+// Robot model quantities at the (q, qdot) of one knotpoint. M and either h and g or their sum are filled with
+// the state, depending on what the robot's constraints use.
+// The contact Jacobian and link kinematics are computed on their first request. Other knotpoints may have
+// moved the thread's robot model since the state was filled, so its kinematics are brought back to q first.
+template <typename Dimensions>
+struct Knotpoint_Model_State{
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	sejong::Vector q;
+	sejong::Vector qdot;
+
+	typename Dimensions::Matrix_qdot A; // M
+	typename Dimensions::Vector_qdot coriolis; // h
+	typename Dimensions::Vector_qdot gravity; // g
+	typename Dimensions::Vector_qdot nonlinear_effects; // h + g
+
+	// Called before the state is filled again
+	void clear(){
+		contact_jacobian_updated = false;
+		links.clear();
+	}
+
+	// Stacked contact Jacobian at q. The constraints of a knotpoint must share one contact list.
+	template <typename Robot_Model>
+	const typename Dimensions::Matrix_contact_jacobian& get_contact_jacobian(Robot_Model* robot_model, Contact_List* contact_list){
+		if (!contact_jacobian_updated){
+			robot_model->UpdateKinematics(q, qdot);
+			contact_list->get_stacked_contact_jacobian(q, Jc);
+			contact_jacobian_updated = true;
+		}
+		return Jc;
+	}
+
+	// Position and Jacobian of the link at q. The robot model must give the position as a sejong::Vector.
+	template <typename Robot_Model>
+	const Link_Kinematics& get_link_kinematics(Robot_Model* robot_model, const int &link_id){
+		for(size_t i = 0; i < links.size(); i++){
+			if (links[i].link_id == link_id){
+				return links[i];
+			}
+		}
+		links.push_back(Link_Kinematics());
+		Link_Kinematics &link = links.back();
+		link.link_id = link_id;
+		robot_model->UpdateKinematics(q, qdot);
+		robot_model->getPosition(q, link_id, link.pos);
+		robot_model->getFullJacobian(q, link_id, link.J);
+		return link;
+	}
+
+private:
+	bool contact_jacobian_updated = false;
+	typename Dimensions::Matrix_contact_jacobian Jc;
+	std::vector<Link_Kinematics> links; // Few links are requested per knotpoint
+};
+
+// Per thread cache of a model state for each knotpoint, keyed by (knotpoint, state version) of the variable manager.
+// The first constraint of a knotpoint fills the state and the other constraints of the same evaluation read it,
+// so the robot model is updated once per knotpoint instead of once per constraint.
+// Only the state stored in the variable manager may be cached. States perturbed for finite differences
+// must go through the robot model directly.
+template <typename State>
+class Knotpoint_Model_Cache{
+public:
+	// Returns the calling thread's state of the knotpoint. fill(state) is called if the variables have
+	// changed since the state was filled. The reference stays valid until the thread exits.
+	template <typename Fill_Function>
+	static State& get_state(const int &knotpoint, const Opt_Variable_Manager &var_manager, const Fill_Function &fill){
+		if (knotpoint < 0){
+			std::cerr << "[Knotpoint_Model_Cache] Error! Invalid knotpoint " << knotpoint << std::endl;
+			throw "invalid_index";
+		}
+		std::deque<Entry, Eigen::aligned_allocator<Entry> > &entries = get_entries();
+		// Growing a deque at the end does not move the other entries
+		if (knotpoint >= (int) entries.size()){
+			entries.resize(knotpoint + 1);
+		}
+
+		Entry &entry = entries[knotpoint];
+		unsigned long state_version = var_manager.get_state_version();
+		if (entry.state_version != state_version){
+			// Stays stale if fill throws
+			entry.state_version = 0;
+			entry.state.clear();
+			fill(entry.state);
+			entry.state_version = state_version;
+		}
+		return entry.state;
+	}
+
+private:
+	struct Entry{
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+		unsigned long state_version = 0; // Never handed out by a variable manager
+		State state;
+	};
+
+	static std::deque<Entry, Eigen::aligned_allocator<Entry> >& get_entries(){
+		static thread_local std::deque<Entry, Eigen::aligned_allocator<Entry> > entries;
+		return entries;
+	}
+};
+
+#endif
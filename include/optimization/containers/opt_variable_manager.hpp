@@ -3,9 +3,11 @@
 
 #include <Utils/wrap_eigen.hpp>
 #include <vector>
-#include <map>
 #include <optimization/containers/opt_variable.hpp>
 
+// Values and bounds of all variables are stored in flat buffers in the order they are appended.
+// Variables of the same type at the same knotpoint must be appended contiguously so that each
+// (type, knotpoint) block can be viewed in place.
 class Opt_Variable_Manager{
 public:
 	Opt_Variable_Manager();
@@ -17,12 +19,21 @@ public:
 
 	Opt_Variable* get_opt_variable(const int index);
 
+	// Zero copy view of the current values of var_type at the knotpoint. Empty if there are no such variables.
+	Eigen::Map<const sejong::Vector> get_var_block(const int &var_type, const int &knotpoint) const;
+	void set_var_bounds(const int &var_type, const int &knotpoint, const int &i, const double &l_bound, const double &u_bound);
+
+	// The get_*_states getters copy the block, for callers that keep the values. Constraints read get_var_block.
 	void get_var_states(const int &knotpoint, sejong::Vector &q_state, sejong::Vector &qdot_state);	
 	void get_task_accelerations(const int &knotpoint, sejong::Vector &xddot);		
 	void get_var_reaction_forces(const int &knotpoint, sejong::Vector &Fr_state);		
 	void get_var_keyframes(const int &knotpoint, sejong::Vector &keyframe_state);		
 	void get_var_knotpoint_dt(const int &knotpoint, double &h_dt);
 
+	// Returns the SNOPT column of each variable of var_type at the knotpoint.
+	// Fixed initial condition variables have no column and are returned as -1.
+	void get_var_indices(const int &var_type, const int &knotpoint, std::vector<int> &indices_out);
+
 	void get_var_qddot_virt_states(const int &knotpoint, sejong::Vector &qddot_virt_states);
 
 	void get_q_states(const int &knotpoint, sejong::Vector &q_state);		
@@ -54,6 +65,11 @@ public:
 	void get_opt_vars_bounds(std::vector<double> &x_low, std::vector<double> &x_upp);
 	void get_current_opt_vars(std::vector<double> &x_out); 
 	void update_opt_vars(std::vector<double> &x_in);	 
+	void update_opt_vars(const double* x_in, const int &n); // Copies the n SNOPT variables after the initial conditions. Throws if there are fewer.
+
+	// Changes whenever the variable values change. Versions are unique across all managers, 
+	// so (knotpoint, state version) identifies the state of a knotpoint, eg: in Knotpoint_Model_Cache.
+	unsigned long get_state_version() const;
 
 	int initial_conditions_offset = 0;
 	int total_knotpoints;
@@ -75,45 +91,24 @@ public:
 	int get_num_u_vars();
 	int get_num_delta_vars();	
 
-	std::vector<Opt_Variable*> opt_var_list;
-
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_q_state_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_qdot_state_vars;
-
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_xddot_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_Fr_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_keyframe_vars;
-
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_z_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_zdot_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_delta_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_delta_dot_vars;
+	std::vector<Opt_Variable*> opt_var_list; // Names and types. Current values are in var_values.
 
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_u_vars;	
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_beta_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_alpha_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_gamma_vars;		
-
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_qddot_virt_vars;
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_xddot_all_vars;	
-
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_x_vars;	
-	std::map<int, std::vector<Opt_Variable*> > knotpoint_to_xdot_vars;	
-
-
-	std::vector<Opt_Variable*> knotpoint_to_dt;
+private:
+	void copy_block(const int &var_type, const int &knotpoint, sejong::Vector &vec_out);
+	int count_num_vars(const int &var_type, const int &knotpoint);
 
+	void update_state_version();
 
-private:
-	void add_variable_to_map(std::map<int, std::vector<Opt_Variable*> > &map_kp_to_var_vec, Opt_Variable* opt_variable);
+	std::vector<double> var_values;
+	unsigned long state_version = 0;
+	std::vector<double> var_l_bounds;
+	std::vector<double> var_u_bounds;
 
-	void convert_to_vector(const int &knotpoint, 
-						   std::map<int, std::vector<Opt_Variable*> > &map_kp_to_var_vec,
-						   sejong::Vector &vec_out);
-	
+	// block_start[type][knotpoint] is the index of the first variable of the block in the flat buffers
+	std::vector< std::vector<int> > block_start;
+	std::vector< std::vector<int> > block_size;
+	std::vector<int> dt_indices; // Index of the timestep variable of each knotpoint, in the order appended
 
-	int count_num_vars_in_map(const int &knotpoint, std::map<int, std::vector<Opt_Variable*> > &map_kp_to_var_vec);
-	//std::vector< int, std::vector<Opt_Variable*> > 
 	int num_timedep_vars = 0; 
 
 	int num_q_vars = 0;
@@ -136,4 +131,4 @@ private:
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,47 @@
+#ifndef SPARSITY_PATTERN_CONTAINER_H
+#define SPARSITY_PATTERN_CONTAINER_H
+
+#include <vector>
+#include <utility>
+#include <optimization/containers/opt_variable_manager.hpp>
+
+// A variable type read by a function at (knotpoint + knotpoint_offset)
+struct Var_Dependency{
+	Var_Dependency(const int &var_type_in, const int &knotpoint_offset_in): var_type(var_type_in), knotpoint_offset(knotpoint_offset_in){}
+	int var_type;
+	int knotpoint_offset;
+};
+
+// Holds the (row, column) structure of the problem Jacobian in the order given to SNOPT.
+class Sparsity_Pattern{
+public:
+	Sparsity_Pattern();
+	~Sparsity_Pattern();	
+
+	void clear();
+	void add_element(const int &row, const int &col);
+	// Every row in [row_offset, row_offset + num_rows) depends on every variable in var_indices. -1 columns are skipped.
+	void add_block(const int &row_offset, const int &num_rows, const std::vector<int> &var_indices);
+	// Resolves the dependencies at the knotpoint through the variable manager and adds them as a block
+	void add_dependencies(const int &row_offset, const int &num_rows, const int &knotpoint, 
+						  const std::vector<Var_Dependency> &dependencies, Opt_Variable_Manager& var_manager);
+
+	// Sorts by (row, col) and removes duplicates. Must be called before the pattern is used.
+	void finalize();
+	// Removes elements that are given elsewhere, e.g. the constant linear A matrix
+	void remove_elements(const std::vector<int> &rows, const std::vector<int> &cols);
+
+	int get_size();
+	int find_element(const int &row, const int &col); // Returns the position in the pattern or -1
+	void get_pattern(std::vector<int> &iGfun, std::vector<int> &jGvar);
+
+	// Accumulates gradient elements given in any order into G_out, which follows the pattern order.
+	// Returns false if an element is not part of the pattern.
+	bool scatter(const std::vector<double> &G, const std::vector<int> &iG, const std::vector<int> &jG, double G_out[]);
+
+private:
+	std::vector< std::pair<int, int> > elements;
+	bool finalized = false;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef TRAJECTORY_FILE_H
+#define TRAJECTORY_FILE_H
+
+#include <Utils/wrap_eigen.hpp>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+
+// Binary trajectory files. A header describes the dimensions of each block and is followed by one
+// record of doubles per knotpoint: [x, xdot, q, qdot, u, Fr, h]. Records start at a multiple of 8 bytes,
+// so a mapped file can be read in place. Values are in native byte order.
+// Blocks that do not exist at a knotpoint, eg: u, Fr and h at knotpoint 0, are stored as NaN.
+
+#define TRAJ_BLOCK_X 0
+#define TRAJ_BLOCK_XDOT 1
+#define TRAJ_BLOCK_Q 2
+#define TRAJ_BLOCK_QDOT 3
+#define TRAJ_BLOCK_U 4
+#define TRAJ_BLOCK_FR 5
+#define TRAJ_BLOCK_H 6
+#define NUM_TRAJ_BLOCKS 7
+
+struct Trajectory_File_Header{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order; // Reads back as TRAJECTORY_BYTE_ORDER on machines with the writer's byte order
+	uint32_t header_size; // Bytes before the first record
+	uint32_t num_knotpoints;
+	uint32_t record_size; // Doubles per knotpoint
+	uint32_t block_size[NUM_TRAJ_BLOCKS];
+	uint32_t problem_name_length; // The name follows the header
+	uint32_t reserved;
+};
+
+// Values of one knotpoint. Empty vectors are written as NaN.
+struct Trajectory_Knotpoint{
+	sejong::Vector x;
+	sejong::Vector xdot;
+	sejong::Vector q;
+	sejong::Vector qdot;
+	sejong::Vector u;
+	sejong::Vector Fr;
+	double h;
+
+	Trajectory_Knotpoint();
+	void clear();
+};
+
+// Streams knotpoints to a file. The knotpoint count in the header is written by close().
+class Trajectory_Writer{
+public:
+	Trajectory_Writer();
+	~Trajectory_Writer(); // Closes the file
+
+	// block_sizes gives the size of x, xdot, q, qdot, u and Fr in that order. h always has size 1.
+	bool open(const std::string &filename, const int (&block_sizes)[NUM_TRAJ_BLOCKS - 1], const std::string &problem_name = "");
+	bool append_knotpoint(const Trajectory_Knotpoint &knotpoint);
+	bool close();
+
+	bool is_open() const;
+	int get_num_knotpoints() const;
+
+private:
+	bool append_block(const int &block, const sejong::Vector &values);
+
+	std::ofstream file;
+	std::string filename;
+	Trajectory_File_Header header;
+	std::vector<double> record;
+};
+
+// Maps a trajectory file into memory. Blocks are read in place without parsing or copying.
+class Trajectory_Reader{
+public:
+	Trajectory_Reader();
+	~Trajectory_Reader(); // Unmaps the file
+
+	bool open(const std::string &filename);
+	void close();
+	bool is_open() const;
+
+	int get_num_knotpoints() const;
+	int get_block_size(const int &block) const;
+	std::string get_problem_name() const;
+
+	// Views into the mapped file. They are valid until the reader is closed.
+	Eigen::Map<const sejong::Vector> get_block(const int &knotpoint, const int &block) const;
+	double get_h(const int &knotpoint) const;
+
+private:
+	const double* get_record(const int &knotpoint) const;
+
+	const char* mapped_data = NULL;
+	size_t mapped_size = 0;
+	const Trajectory_File_Header* header = NULL;
+	int block_offset[NUM_TRAJ_BLOCKS];
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CONTINUATION_SOLVER_H
+#define CONTINUATION_SOLVER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <optimization/optimization_problems/opt_problem_main.hpp>
+#include <optimization/snopt_wrapper.hpp>
+
+// Sets the initial guess of fine_problem from the current solution of coarse_problem.
+// Both problems must have the same sequence of contact modes. Each mode keeps its duration and its
+// knotpoints are spaced evenly over it, so no sample is taken across a mode boundary.
+// States are interpolated with minimum jerk polynomials that match the position, velocity and acceleration
+// at the coarse knotpoints. Inputs and forces use a cubic between neighbouring knotpoints, which never leaves the range of its end values.
+// Returns false and leaves fine_problem unchanged if the problems do not match.
+bool resample_knotpoints(Optimization_Problem_Main* coarse_problem, Optimization_Problem_Main* fine_problem);
+
+// Solves a problem on increasingly finer knotpoint grids. Each stage starts from the resampled solution of the previous one.
+class Continuation_Solver{
+public:
+	// create_problem builds the problem with the given number of knotpoints.
+	// knotpoint_schedule lists the knotpoints of each stage from coarse to fine, eg: {9, 27}.
+	Continuation_Solver(const std::function<Optimization_Problem_Main*(const int&)> &create_problem, const std::vector<int> &knotpoint_schedule);
+	~Continuation_Solver();
+
+	void set_use_gradients(const bool &use_gradients);
+	// SNOPT writes each stage to "<print_file_prefix>_<knotpoints>_kp.out". An empty prefix disables the print files.
+	void set_print_file_prefix(const std::string &prefix);
+
+	// stage_results_out[i] belongs to the i-th stage. Returns the problem of the last solved stage, which the caller deletes.
+	// If a stage can not be resampled the remaining stages are skipped.
+	Optimization_Problem_Main* solve(std::vector<snopt_wrapper::Solve_Result> &stage_results_out);
+
+private:
+	void solve_stage(Optimization_Problem_Main* opt_problem, const int &N_total_knotpoints, snopt_wrapper::Solve_Result &result_out);
+
+	std::function<Optimization_Problem_Main*(const int&)> create_problem;
+	std::vector<int> knotpoint_schedule;
+	bool use_gradients = true;
+	std::string print_file_prefix = "snopt_continuation";
+};
+
+#endif
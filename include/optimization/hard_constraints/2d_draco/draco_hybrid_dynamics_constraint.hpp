@@ -11,6 +11,7 @@
 #include <optimization/containers/contact_list.hpp>
 #include <optimization/containers/contact_mode_schedule.hpp>
 
+#include <optimization/hard_constraints/2d_draco/draco_knotpoint_state.hpp>
 #include "DracoModel.hpp"
 
 class Draco_Hybrid_Dynamics_Constraint: public Constraint_Function{
@@ -19,10 +20,7 @@ public:
 	Draco_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in);	
 	~Draco_Hybrid_Dynamics_Constraint();
 
-	DracoModel* robot_model;	
-
-	sejong::Matrix Jc; // Contact Jacobian
-	sejong::Matrix Sa; // Actuation selection matrix
+	Draco_Dimensions::Matrix_act_qdot Sa; // Actuation selection matrix
 
 	void setContact_List(Contact_List* contact_list_in);
 	void setContact_Mode_Schedule(Contact_Mode_Schedule* contact_mode_schedule_in);	
@@ -40,6 +38,15 @@ private:
 	void initialize_Flow_Fupp();
 
 	void set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all);
-	void Update_Contact_Jacobian_Jc(sejong::Vector &q_state);
+	// Updates the robot model at q_state_k. Used for the states perturbed by finite differences.
+	void compute_dynamics_residual(const sejong::Vector &q_state_k, const sejong::Vector &qdot_state_k, const sejong::Vector &qdot_state_k_prev,
+								   const sejong::Vector &u_state_k, const sejong::Vector &Fr_state_k, const double &h_k, sejong::Vector &dynamics_out);
+	// Uses M, h + g and Jc cached for the state of the knotpoint
+	void compute_dynamics_residual(Draco_Knotpoint_State &knotpoint_state, const sejong::Vector &qdot_state_k_prev,
+								   const sejong::Vector &u_state_k, const sejong::Vector &Fr_state_k, const double &h_k, sejong::Vector &dynamics_out);
+	void compute_dynamics_residual(const Draco_Dimensions::Matrix_qdot &A_mat, const Draco_Dimensions::Vector_qdot &nonlinear_effects,
+								   const Draco_Dimensions::Matrix_contact_jacobian &Jc,
+								   const sejong::Vector &qdot_state_k, const sejong::Vector &qdot_state_k_prev,
+								   const sejong::Vector &u_state_k, const sejong::Vector &Fr_state_k, const double &h_k, sejong::Vector &dynamics_out);
 };
 #endif
\ No newline at end of file
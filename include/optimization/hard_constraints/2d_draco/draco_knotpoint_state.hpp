@@ -0,0 +1,14 @@
+#ifndef DRACO_KNOTPOINT_STATE_H
+#define DRACO_KNOTPOINT_STATE_H
+
+#include <optimization/containers/knotpoint_model_cache.hpp>
+#include <optimization/containers/opt_variable_manager.hpp>
+#include "DracoModel.hpp"
+
+typedef Knotpoint_Model_State<Draco_Dimensions> Draco_Knotpoint_State;
+
+// Model state at the q, qdot of the knotpoint, shared by the Draco constraints of the knotpoint.
+// M and h + g come from one RBDL update of the calling thread's DracoModel.
+Draco_Knotpoint_State& get_draco_knotpoint_state(const int &knotpoint, Opt_Variable_Manager &var_manager);
+
+#endif
@@ -18,7 +18,6 @@ public:
 	double l_bound;
 	double u_bound;
 
-	HopperModel* robot_model;	
 	int contact_index;
 
 	void setContact_List(Contact_List* contact_list_in);
@@ -0,0 +1,107 @@
+#ifndef HOPPER_COLLOCATION_CONSTRAINTS_H
+#define HOPPER_COLLOCATION_CONSTRAINTS_H
+
+#include <Utils/wrap_eigen.hpp>
+
+#include <string>
+#include <iostream>
+
+#include <optimization/hard_constraints/constraint_main.hpp>
+#include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/contact_list.hpp>
+#include <optimization/containers/contact_mode_schedule.hpp>
+
+#include <optimization/autodiff/dual.hpp>
+
+#include "HopperModel.hpp"
+
+// Variables of the interval between knotpoints k-1 and k, templated on the scalar type for automatic differentiation.
+// As in the backward Euler constraints, u[k] and Fr[k] act over the whole interval and the contact mode of k applies to it.
+template <typename Scalar>
+struct Hopper_Interval{
+	int knotpoint; // k
+	Eigen::Matrix<Scalar, NUM_Q, 1> q_prev;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> qdot_prev;
+	Eigen::Matrix<Scalar, NUM_Q, 1> q;
+	Eigen::Matrix<Scalar, NUM_QDOT, 1> qdot;
+	Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> u;
+	Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> Fr;
+	Scalar h;
+};
+
+// Directions of the dual numbers. The variables are [q_k-1, qdot_k-1, q_k, qdot_k, u_k, Fr_k, h_k].
+namespace Hopper_Collocation_Directions{
+	const int Q_K_PREV = 0;
+	const int QDOT_K_PREV = Q_K_PREV + NUM_Q;
+	const int Q_K = QDOT_K_PREV + NUM_QDOT;
+	const int QDOT_K = Q_K + NUM_Q;
+	const int U_K = QDOT_K + NUM_QDOT;
+	const int FR_K = U_K + NUM_ACT_JOINT;
+	const int H_K = FR_K + Hopper_Dimensions::max_contact_dim;
+	const int NUM_DIRECTIONS = H_K + 1;
+}
+typedef Dual<Hopper_Collocation_Directions::NUM_DIRECTIONS> Hopper_Collocation_Dual;
+
+// Trapezoidal or Hermite-Simpson collocation of the interval ending at the knotpoint.
+// Hermite-Simpson uses the compressed form, so the midpoint state is interpolated from the knotpoints and adds no variables.
+// The exact gradient w.r.t. all the interval variables comes from one evaluation of the defects with dual numbers.
+class Hopper_Collocation_Constraint: public Constraint_Function{
+public:
+	Hopper_Collocation_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in, const int &collocation_method_in);
+	virtual ~Hopper_Collocation_Constraint();
+
+	Hopper_Dimensions::Matrix_act_qdot Sa; // Actuation selection matrix
+
+	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
+	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
+	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);
+
+protected:
+	int collocation_method;
+	Contact_List* contact_list_obj;
+	Contact_Mode_Schedule* contact_mode_schedule_obj;
+
+	// Each derived constraint implements both with one templated function
+	virtual void compute_defects(const Hopper_Interval<double> &interval, Eigen::Matrix<double, NUM_QDOT, 1> &F_out) = 0;
+	virtual void compute_defects(const Hopper_Interval<Hopper_Collocation_Dual> &interval, Eigen::Matrix<Hopper_Collocation_Dual, NUM_QDOT, 1> &F_out) = 0;
+
+	// qddot = A^-1 (Sa^T u + Jc^T Fr - b - g) with the inputs of the interval. A_out is the mass matrix at q_state.
+	template <typename Scalar>
+	void get_acceleration(const Eigen::Matrix<Scalar, NUM_Q, 1> &q_state, const Eigen::Matrix<Scalar, NUM_QDOT, 1> &qdot_state, const Hopper_Interval<Scalar> &interval,
+						  Eigen::Matrix<Scalar, NUM_QDOT, 1> &qddot_out, Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> &A_out);
+
+private:
+	void get_interval(const int &knotpoint, Opt_Variable_Manager& var_manager, Hopper_Interval<double> &interval);
+};
+
+// q[k] - q[k-1] = integral of qdot over the interval
+class Hopper_Collocation_Time_Integration_Constraint: public Hopper_Collocation_Constraint{
+public:
+	Hopper_Collocation_Time_Integration_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in, const int &collocation_method_in);
+	~Hopper_Collocation_Time_Integration_Constraint();
+
+protected:
+	void compute_defects(const Hopper_Interval<double> &interval, Eigen::Matrix<double, NUM_QDOT, 1> &F_out);
+	void compute_defects(const Hopper_Interval<Hopper_Collocation_Dual> &interval, Eigen::Matrix<Hopper_Collocation_Dual, NUM_QDOT, 1> &F_out);
+
+private:
+	template <typename Scalar>
+	void compute_defects_s(const Hopper_Interval<Scalar> &interval, Eigen::Matrix<Scalar, NUM_QDOT, 1> &F_out);
+};
+
+// A*(qdot[k] - qdot[k-1] - integral of qddot over the interval)/h = 0. This scales the rows like the backward Euler hybrid dynamics constraint.
+class Hopper_Collocation_Hybrid_Dynamics_Constraint: public Hopper_Collocation_Constraint{
+public:
+	Hopper_Collocation_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in, const int &collocation_method_in);
+	~Hopper_Collocation_Hybrid_Dynamics_Constraint();
+
+protected:
+	void compute_defects(const Hopper_Interval<double> &interval, Eigen::Matrix<double, NUM_QDOT, 1> &F_out);
+	void compute_defects(const Hopper_Interval<Hopper_Collocation_Dual> &interval, Eigen::Matrix<Hopper_Collocation_Dual, NUM_QDOT, 1> &F_out);
+
+private:
+	template <typename Scalar>
+	void compute_defects_s(const Hopper_Interval<Scalar> &interval, Eigen::Matrix<Scalar, NUM_QDOT, 1> &F_out);
+};
+
+#endif
@@ -17,8 +17,6 @@ public:
 	Hopper_Floor_Contact_LCP_Constraint(Contact_List* contact_list_in, int index_in);	
 	~Hopper_Floor_Contact_LCP_Constraint();
 
-	HopperModel* robot_model;	
-
 	void setContact_List(Contact_List* contact_list_in);
 	void setContact_index(int index_in);	
 
@@ -18,10 +18,7 @@ public:
 	Hopper_Dynamics_Constraint(Contact_List* contact_list_in);	
 	~Hopper_Dynamics_Constraint();
 
-	HopperModel* robot_model;	
-
-	sejong::Matrix Jc; // Contact Jacobian
-	sejong::Matrix Sa; // Actuation selection matrix
+	Hopper_Dimensions::Matrix_act_qdot Sa; // Actuation selection matrix
 
 	void setContact_List(Contact_List* contact_list_in);
 
@@ -36,6 +33,5 @@ private:
 	void Initialization();
 	void initialize_Flow_Fupp();
 
-	void Update_Contact_Jacobian_Jc(sejong::Vector &q_state);
 };
 #endif
\ No newline at end of file
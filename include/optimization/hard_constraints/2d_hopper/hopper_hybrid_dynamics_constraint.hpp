@@ -13,21 +13,45 @@
 
 #include "HopperModel.hpp"
 
+// Variables of the backward Euler dynamics for a set of knotpoints, in the layout of knotpoint_batch.hpp
+struct Hopper_Dynamics_Batch{
+	typedef Eigen::Matrix<double, Eigen::Dynamic, NUM_QDOT> Matrix_qdot_batch;
+
+	Matrix_qdot_batch qdot;
+	Matrix_qdot_batch qdot_prev;
+	Eigen::Matrix<double, Eigen::Dynamic, NUM_ACT_JOINT> u;
+	sejong::Matrix Fr; // Inactive contacts must be zero
+	sejong::Vector h;
+
+	void resize(const int &num_knotpoints, const int &num_Fr){
+		qdot.resize(num_knotpoints, NUM_QDOT);
+		qdot_prev.resize(num_knotpoints, NUM_QDOT);
+		u.resize(num_knotpoints, NUM_ACT_JOINT);
+		Fr.resize(num_knotpoints, num_Fr);
+		h.resize(num_knotpoints);
+	}
+};
+
 class Hopper_Hybrid_Dynamics_Constraint: public Constraint_Function{
 public:
 	Hopper_Hybrid_Dynamics_Constraint();
 	Hopper_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in);	
 	~Hopper_Hybrid_Dynamics_Constraint();
 
-	HopperModel* robot_model;	
-
-	sejong::Matrix Jc; // Contact Jacobian
-	sejong::Matrix Sa; // Actuation selection matrix
+	Hopper_Dimensions::Matrix_act_qdot Sa; // Actuation selection matrix
 
 	void setContact_List(Contact_List* contact_list_in);
 	void setContact_Mode_Schedule(Contact_Mode_Schedule* contact_mode_schedule_in);	
 
 	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
+	// The dynamics of all the knotpoints are computed in one pass by evaluate_dynamics_batch
+	bool supports_batch_evaluation(){ return true; }
+	void evaluate_constraint_batch(const std::vector<int> &knotpoints, Opt_Variable_Manager& var_manager, double* F_eval, const int &knotpoint_stride);
+	// A*(qdot[k] - qdot[k-1])/h[k] + b + g - Jc^T*Fr[k] - Sa^T*u[k] of every row k of the batch.
+	// The hopper's A, b, g and Jc do not depend on the state, so they are the same for every knotpoint.
+	void evaluate_dynamics_batch(const Hopper_Dynamics_Batch &batch, const Hopper_Dimensions::Matrix_qdot &A_mat, const Hopper_Dimensions::Vector_qdot &coriolis,
+								 const Hopper_Dimensions::Vector_qdot &gravity, const Hopper_Dimensions::Matrix_contact_jacobian &Jc,
+								 Hopper_Dynamics_Batch::Matrix_qdot_batch &dynamics_out);
 	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
 	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);	
 
@@ -36,10 +60,13 @@ private:
 	Contact_List* contact_list_obj;
 	Contact_Mode_Schedule* contact_mode_schedule_obj;	
 
+	// Buffers of evaluate_constraint_batch. Keep their capacity between calls.
+	Hopper_Dynamics_Batch batch;
+	Hopper_Dynamics_Batch::Matrix_qdot_batch dynamics_batch;
+
 	void Initialization();
 	void initialize_Flow_Fupp();
 
 	void set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all);
-	void Update_Contact_Jacobian_Jc(sejong::Vector &q_state);
 };
 #endif
\ No newline at end of file
@@ -23,13 +23,10 @@ public:
 	double l_bound;
 	double u_bound;
 
-	HopperModel* robot_model;	
-
-	sejong::Vector pos;
-
 	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
 	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
 	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);	
+	bool is_linear(){ return true; }
 
 
 private:
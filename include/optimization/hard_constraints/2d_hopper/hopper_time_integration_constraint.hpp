@@ -16,8 +16,6 @@ public:
 	Hopper_Back_Euler_Time_Integration_Constraint();
 	~Hopper_Back_Euler_Time_Integration_Constraint();
 
-	HopperModel* robot_model;	
-
 	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
 	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
 	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);	
@@ -9,6 +9,7 @@
 #include <optimization/hard_constraints/constraint_main.hpp>
 #include <optimization/containers/contact_list.hpp>
 #include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+#include <optimization/hard_constraints/2d_hopper_act/hopper_act_knotpoint_state.hpp>
 
 class Hopper_Act_Active_Contact_Kinematic_Constraint: public Constraint_Function{
 public:
@@ -18,7 +19,6 @@ public:
 	double l_bound;
 	double u_bound;
 
-	Hopper_Combined_Dynamics_Model* combined_model;	
 	int contact_index;
 
 	void setContact_List(Contact_List* contact_list_in);
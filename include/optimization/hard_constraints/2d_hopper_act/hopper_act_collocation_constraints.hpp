@@ -0,0 +1,125 @@
+#ifndef HOPPER_ACT_COLLOCATION_CONSTRAINTS_H
+#define HOPPER_ACT_COLLOCATION_CONSTRAINTS_H
+
+#include <Utils/wrap_eigen.hpp>
+
+#include <string>
+#include <iostream>
+
+#include <optimization/hard_constraints/constraint_main.hpp>
+#include <optimization/autodiff/dual.hpp>
+#include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/contact_list.hpp>
+#include <optimization/containers/contact_mode_schedule.hpp>
+
+#include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+#include <optimization/hard_constraints/2d_hopper_act/hopper_act_knotpoint_state.hpp>
+
+// Variables of the interval between knotpoints k-1 and k, templated on the scalar type for automatic differentiation.
+// As in the backward Euler constraints, u[k] and Fr[k] act over the whole interval and the contact mode of k applies to it.
+template <typename Scalar>
+struct Hopper_Act_Interval{
+	typedef Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, 1> Vector_x;
+	typedef Eigen::Matrix<Scalar, Hopper_Combined_Dimensions::num_x, Hopper_Combined_Dimensions::num_x> Matrix_x;
+
+	int knotpoint; // k
+	Vector_x x_prev;
+	Vector_x xdot_prev;
+	Vector_x x;
+	Vector_x xdot;
+	Eigen::Matrix<Scalar, NUM_ACT_JOINT, 1> u;
+	Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> Fr;
+	Scalar h;
+};
+
+// Directions of the dual numbers of an interval. The variables are [x_k-1, xdot_k-1, x_k, xdot_k, u_k, Fr_k, h_k].
+struct Hopper_Act_Interval_Directions{
+	enum{
+		x_prev = 0,
+		xdot_prev = x_prev + Hopper_Combined_Dimensions::num_x,
+		x = xdot_prev + Hopper_Combined_Dimensions::num_x,
+		xdot = x + Hopper_Combined_Dimensions::num_x,
+		u = xdot + Hopper_Combined_Dimensions::num_x,
+		Fr = u + NUM_ACT_JOINT,
+		h = Fr + Hopper_Dimensions::max_contact_dim,
+		num_directions = h + 1
+	};
+};
+typedef Dual<Hopper_Act_Interval_Directions::num_directions> Hopper_Act_Interval_Dual;
+
+// Trapezoidal or Hermite-Simpson collocation of the interval ending at the knotpoint.
+// Hermite-Simpson uses the compressed form, so the midpoint state is interpolated from the knotpoints and adds no variables.
+// The defects are templated on the scalar type: F uses the cached model states of the knotpoints, and the gradient is the
+// Jacobian of one evaluation with dual numbers, which computes the model and xddot from scratch at the interval's states.
+class Hopper_Act_Collocation_Constraint: public Constraint_Function{
+public:
+	Hopper_Act_Collocation_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in, const int &collocation_method_in);
+	virtual ~Hopper_Act_Collocation_Constraint();
+
+	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
+	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
+	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);
+
+protected:
+	int collocation_method;
+	Contact_List* contact_list_obj;
+	Contact_Mode_Schedule* contact_mode_schedule_obj;
+
+	// The knotpoint states are the cached model states of the interval ends, or NULL. Each subclass forwards both versions to its
+	// templated defects.
+	virtual void compute_defects(const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+								 Hopper_Act_Interval<double>::Vector_x &F_out) = 0;
+	virtual void compute_defects(const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+								 Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &F_out) = 0;
+
+	// xddot of the combined model with the inputs of the interval and M at x_state. The double version uses the knotpoint state
+	// if it is not NULL, the dual version always ignores it.
+	void get_state_acceleration(const Hopper_Act_Interval<double>::Vector_x &x_state, const Hopper_Act_Interval<double>::Vector_x &xdot_state,
+								const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state,
+								Hopper_Act_Interval<double>::Vector_x &xddot_out, Hopper_Act_Interval<double>::Matrix_x &M_out);
+	void get_state_acceleration(const Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &x_state, const Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &xdot_state,
+								const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state,
+								Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &xddot_out, Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Matrix_x &M_out);
+
+private:
+	void get_interval(const int &knotpoint, Opt_Variable_Manager& var_manager, Hopper_Act_Interval<double> &interval);
+	void set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all);
+};
+
+// x[k] - x[k-1] = integral of xdot over the interval
+class Hopper_Act_Collocation_Time_Integration_Constraint: public Hopper_Act_Collocation_Constraint{
+public:
+	Hopper_Act_Collocation_Time_Integration_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in, const int &collocation_method_in);
+	~Hopper_Act_Collocation_Time_Integration_Constraint();
+
+protected:
+	void compute_defects(const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+						 Hopper_Act_Interval<double>::Vector_x &F_out);
+	void compute_defects(const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+						 Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &F_out);
+
+private:
+	template <typename Scalar>
+	void formulate_defects(const Hopper_Act_Interval<Scalar> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+						   typename Hopper_Act_Interval<Scalar>::Vector_x &F_out);
+};
+
+// M*(xdot[k] - xdot[k-1] - integral of xddot over the interval) = 0. M scales the rows like the backward Euler dynamics constraint.
+class Hopper_Act_Collocation_Hybrid_Dynamics_Constraint: public Hopper_Act_Collocation_Constraint{
+public:
+	Hopper_Act_Collocation_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in, const int &collocation_method_in);
+	~Hopper_Act_Collocation_Hybrid_Dynamics_Constraint();
+
+protected:
+	void compute_defects(const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+						 Hopper_Act_Interval<double>::Vector_x &F_out);
+	void compute_defects(const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+						 Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &F_out);
+
+private:
+	template <typename Scalar>
+	void formulate_defects(const Hopper_Act_Interval<Scalar> &interval, Hopper_Act_Knotpoint_State* state_prev, Hopper_Act_Knotpoint_State* state,
+						   typename Hopper_Act_Interval<Scalar>::Vector_x &F_out);
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include <optimization/containers/contact_mode_schedule.hpp>
 
 #include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+#include <optimization/hard_constraints/2d_hopper_act/hopper_act_knotpoint_state.hpp>
 
 class Hopper_Act_Hybrid_Dynamics_Constraint: public Constraint_Function{
 public:
@@ -19,15 +20,15 @@ public:
 	Hopper_Act_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in);	
 	~Hopper_Act_Hybrid_Dynamics_Constraint();
 
-	Hopper_Combined_Dynamics_Model* combined_model;	
-
-	sejong::Matrix Jc; // Contact Jacobian
 	sejong::Matrix Sa; // Actuation selection matrix
 
 	void setContact_List(Contact_List* contact_list_in);
 	void setContact_Mode_Schedule(Contact_Mode_Schedule* contact_mode_schedule_in);	
 
 	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
+	// The dynamics of all the knotpoints are computed in one pass by Hopper_Combined_Dynamics_Model::getDynamics_constraint_batch
+	bool supports_batch_evaluation(){ return true; }
+	void evaluate_constraint_batch(const std::vector<int> &knotpoints, Opt_Variable_Manager& var_manager, double* F_eval, const int &knotpoint_stride);
 	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
 	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);	
 
@@ -36,10 +37,13 @@ private:
 	Contact_List* contact_list_obj;
 	Contact_Mode_Schedule* contact_mode_schedule_obj;	
 
+	// Buffers of evaluate_constraint_batch. Keep their capacity between calls.
+	Hopper_Act_Dynamics_Batch batch;
+	Hopper_Act_Dynamics_Batch::Matrix_x_batch dynamics_batch;
+
 	void Initialization();
 	void initialize_Flow_Fupp();
 
 	void set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all);
-	void Update_Contact_Jacobian_Jc(sejong::Vector &q_state);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef HOPPER_ACT_KNOTPOINT_STATE_H
+#define HOPPER_ACT_KNOTPOINT_STATE_H
+
+#include <optimization/containers/knotpoint_model_cache.hpp>
+#include <optimization/containers/opt_variable_manager.hpp>
+#include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+
+typedef Knotpoint_Model_State<Hopper_Dimensions> Hopper_Act_Knotpoint_State;
+
+// Model state at the x, xdot of the knotpoint, shared by the hopper actuator constraints of the knotpoint.
+// q and qdot are converted from x and xdot, and M, h and g come from the calling thread's robot model.
+Hopper_Act_Knotpoint_State& get_hopper_act_knotpoint_state(const int &knotpoint, Opt_Variable_Manager &var_manager);
+
+#endif
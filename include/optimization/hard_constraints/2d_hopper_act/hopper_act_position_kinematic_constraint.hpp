@@ -8,6 +8,7 @@
 
 #include <optimization/hard_constraints/constraint_main.hpp>
 #include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+#include <optimization/hard_constraints/2d_hopper_act/hopper_act_knotpoint_state.hpp>
 
 #define Z_DIM 0
 
@@ -23,10 +24,6 @@ public:
 	double l_bound;
 	double u_bound;
 
-	Hopper_Combined_Dynamics_Model* combined_model;	
-
-	sejong::Vector pos;
-
 	void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec);
 	void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG);
 	void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA);	
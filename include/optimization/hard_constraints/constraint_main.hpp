@@ -7,6 +7,7 @@
 #include <iostream>
 #include <optimization/containers/opt_variable.hpp>
 #include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/sparsity_pattern.hpp>
 #include <optimization/optimization_constants.hpp>
 
 class Constraint_Function{
@@ -15,9 +16,32 @@ public:
 	virtual ~Constraint_Function(){
 		std::cout << "Constraint Function Destructor called" << std::endl;
 	}
+	// Values without the constant linear terms of evaluate_sparse_A_matrix, which SNOPT adds as A*x itself
 	virtual void evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec) {}
+	// Writes the constraint values starting at F_out. The default goes through evaluate_constraint 
+	// with a per-thread scratch vector, which keeps its capacity between calls.
+	virtual void evaluate_constraint_in_place(const int &knotpoint, Opt_Variable_Manager& var_manager, double* F_out){
+		static thread_local std::vector<double> F_vec;
+		F_vec.clear();
+		evaluate_constraint(knotpoint, var_manager, F_vec);
+		for(size_t i = 0; i < F_low.size(); i++){
+			F_out[i] = F_vec[i];
+		}
+	}
+	// Constraints that evaluate many knotpoints in one pass, eg: with a kernel over the stacked variables of the knotpoints,
+	// return true and override evaluate_constraint_batch. The Knotpoint_Evaluator then calls it once per evaluation.
+	virtual bool supports_batch_evaluation(){ return false; }
+	// Writes the values of each knotpoint k starting at F_eval + (k-1)*knotpoint_stride + constraint_index.
+	// The default evaluates the knotpoints one at a time.
+	virtual void evaluate_constraint_batch(const std::vector<int> &knotpoints, Opt_Variable_Manager& var_manager, double* F_eval, const int &knotpoint_stride){
+		for(size_t i = 0; i < knotpoints.size(); i++){
+			evaluate_constraint_in_place(knotpoints[i], var_manager, F_eval + (knotpoints[i] - 1)*knotpoint_stride + constraint_index);
+		}
+	}
 	virtual void evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG) {}
 	virtual void evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA) {}	
+	// True if evaluate_sparse_A_matrix gives the whole constraint. Its rows are then zero in compute_F and are not evaluated.
+	virtual bool is_linear(){ return false; }
 
 	// Each constraint containts its bounds
 	std::vector<double> F_low;
@@ -35,6 +59,40 @@ public:
 	}
 	virtual int get_constraint_index(){ return constraint_index;}	
 
+	// Variable types and knotpoint offsets (k, k-1) read by this constraint. Declared by the Object Constructor.
+	std::vector<Var_Dependency> var_dependencies;
+
+	// Adds the structural nonzeros of this constraint at the knotpoint. Every row depends on every declared variable.
+	virtual void get_sparsity_pattern(const int &knotpoint, Opt_Variable_Manager& var_manager, const int &row_offset, Sparsity_Pattern &pattern){
+		pattern.add_dependencies(row_offset, get_constraint_size(), knotpoint, var_dependencies, var_manager);
+	}
+
+protected:
+	void add_var_dependency(const int &var_type, const int &knotpoint_offset){
+		var_dependencies.push_back(Var_Dependency(var_type, knotpoint_offset));
+	}
+
+	// Appends a dense block d(F)/d(vars) with local row indices starting at row_offset. Also used for the A matrix.
+	// Every entry is emitted, even zeros, so the sparsity pattern is the same on every call.
+	// Columns with index -1 are fixed initial conditions and are skipped.
+	// Takes any Eigen expression so that fixed-size blocks are not copied into a dynamic matrix.
+	template <typename Derived>
+	void append_gradient_block(const Eigen::MatrixBase<Derived> &block, const int &row_offset, const std::vector<int> &var_indices,
+							   std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+		// Products are evaluated once. Plain matrices are used by reference.
+		const typename Derived::EvalReturnType block_eval = block.eval();
+		for(size_t j = 0; j < var_indices.size(); j++){
+			if (var_indices[j] < 0){
+				continue;
+			}
+			for(int i = 0; i < block_eval.rows(); i++){
+				G.push_back(block_eval(i, j));
+				iG.push_back(row_offset + i);
+				jG.push_back(var_indices[j]);
+			}
+		}
+	}
+
 	// virtual void test_function(){}
 	// virtual	void test_function2(const sejong::Vector &q, const sejong::Vector &qdot, sejong::Matrix &B_out, sejong::Vector &c_out){}
 };
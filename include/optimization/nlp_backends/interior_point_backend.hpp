@@ -0,0 +1,43 @@
+#ifndef INTERIOR_POINT_BACKEND_H
+#define INTERIOR_POINT_BACKEND_H
+
+#include <optimization/nlp_backends/nlp_backend.hpp>
+
+// Exit codes follow SNOPT's INFO numbers so results of both backends read the same
+#define INTERIOR_POINT_OPTIMAL 1
+#define INTERIOR_POINT_ITERATION_LIMIT 32
+#define INTERIOR_POINT_NUMERICAL_DIFFICULTIES 41
+
+// Primal-dual interior point method with a log barrier on the variable bounds. Function rows with different
+// bounds get a slack variable, equal bounds become equality constraints and rows without bounds are ignored.
+// Each step solves the sparse KKT system with an LDL^T factorization. The system is kept quasi-definite by a
+// small dual regularization and the inertia is corrected by adding to the Hessian diagonal. Steps are accepted by a
+// filter line search on the constraint violation and the barrier objective, with second order corrections of
+// steps that increase the violation.
+// The Hessian of the Lagrangian is the problem's compute_lagrangian_hessian if it provides one. Otherwise it has
+// a dense block for each group of rows of F that depend on the same variables, eg: the constraints of one
+// knotpoint interval, so it keeps the banded knotpoint structure of the KKT system. The blocks are finite
+// differences of G, and variables that never share a block are perturbed in the same evaluation of G.
+class Interior_Point_Backend: public NLP_Backend{
+public:
+	Interior_Point_Backend();
+	~Interior_Point_Backend();
+
+	std::string get_name(){ return "interior_point"; }
+
+	void set_tolerance(const double &tolerance); // Scaled KKT error at the solution. Default 1e-6.
+	void set_constraint_tolerance(const double &constraint_tolerance); // Unscaled bound violation of F. Default 1e-6.
+	void set_max_iterations(const int &max_iterations); // Default 3000
+	void set_verbose(const bool &verbose); // Prints one line per iteration
+
+protected:
+	void solve_problem(Optimization_Problem_Main* opt_problem, NLP_Result &result_out);
+
+private:
+	double tolerance = 1e-6;
+	double constraint_tolerance = 1e-6;
+	int max_iterations = 3000;
+	bool verbose = true;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef NLP_BACKEND_H
+#define NLP_BACKEND_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <optimization/optimization_problems/opt_problem_main.hpp>
+
+// Outcome of one solve with any backend
+struct NLP_Result{
+	std::string problem_name;
+	std::string backend_name;
+	int exit_code = -1; // Backend specific. 1 means an optimal point was found by every backend.
+	int iterations = -1; // Major iterations, or -1 if the backend does not report them
+	double objective = 0.0;
+	double max_violation = 0.0; // Largest violation of the variable and function bounds at x
+	double solve_time = 0.0; // Wall clock seconds
+	std::vector<double> x; // Final variables. The problem's variable manager is also updated to them.
+};
+
+// A nonlinear programming solver for an Optimization_Problem_Main.
+// The problem provides the sizes and bounds of x and F, F itself, the sparse Jacobian of F as the structural G
+// plus the constant A, and optionally the Hessian of the Lagrangian (see compute_lagrangian_hessian).
+class NLP_Backend{
+public:
+	NLP_Backend(){}
+	virtual ~NLP_Backend(){}
+
+	virtual std::string get_name() = 0;
+
+	// Solves from the problem's initial guess. The objective and the violation of the result are evaluated
+	// from the final variables in the same way for every backend, so results can be compared directly.
+	void solve(Optimization_Problem_Main* opt_problem, NLP_Result &result_out);
+
+protected:
+	// Sets exit_code, iterations and x of the result
+	virtual void solve_problem(Optimization_Problem_Main* opt_problem, NLP_Result &result_out) = 0;
+};
+
+// Solves a new problem from create_problem with each backend and prints one line per result.
+// The problem is deleted after its solve.
+void compare_backends(const std::vector<NLP_Backend*> &backends, const std::function<Optimization_Problem_Main*()> &create_problem,
+					  std::vector<NLP_Result> &results_out);
+
+// Largest violation of the variable and function bounds at x. The objective row is not bounded.
+// The problem's variable manager is updated to x.
+double compute_max_violation(Optimization_Problem_Main* opt_problem, const std::vector<double> &x, double &objective_out);
+
+#endif
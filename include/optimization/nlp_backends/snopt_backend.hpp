@@ -0,0 +1,36 @@
+#ifndef SNOPT_BACKEND_H
+#define SNOPT_BACKEND_H
+
+#include <optimization/nlp_backends/nlp_backend.hpp>
+#include <optimization/snopt_wrapper.hpp>
+
+// Solves through snopt_wrapper. The SNOPT result of the last solve is kept for its solver state.
+class SNOPT_Backend: public NLP_Backend{
+public:
+	SNOPT_Backend();
+	~SNOPT_Backend();
+
+	std::string get_name(){ return "snopt"; }
+
+	void set_use_gradients(const bool &use_gradients);
+	// G from colored finite differences instead of compute_G, or NULL to stop using it. It is not owned by the backend.
+	void set_finite_difference_jacobian(Finite_Difference_Jacobian* fd_jacobian);
+	// An empty print file disables the SNOPT print file
+	void set_print_file(const std::string &print_file);
+	// Used by the following solves until it is cleared with an empty Solver_State
+	void set_warm_start(const snopt_wrapper::Solver_State &warm_start);
+
+	const snopt_wrapper::Solve_Result& get_last_snopt_result(){ return last_snopt_result; }
+
+protected:
+	void solve_problem(Optimization_Problem_Main* opt_problem, NLP_Result &result_out);
+
+private:
+	bool use_gradients = true;
+	Finite_Difference_Jacobian* fd_jacobian = NULL;
+	std::string print_file = "snopt_problem.out";
+	snopt_wrapper::Solver_State warm_start;
+	snopt_wrapper::Solve_Result last_snopt_result;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <optimization/containers/opt_variable.hpp>
 #include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/sparsity_pattern.hpp>
 #include <optimization/optimization_constants.hpp>
 
 class Objective_Function{
@@ -27,6 +28,34 @@ public:
 
 	std::string objective_function_name = "undefined objective function";	
 	int objective_function_index = -1; // Modified after all constraints have been specified
+
+	// Variable types and knotpoint offsets read by the cost at every knotpoint k = 1, ..., N
+	std::vector<Var_Dependency> var_dependencies;
+
+	virtual void get_sparsity_pattern(Opt_Variable_Manager& var_manager, Sparsity_Pattern &pattern){
+		for(int k = 1; k < var_manager.total_knotpoints + 1; k++){
+			pattern.add_dependencies(objective_function_index, 1, k, var_dependencies, var_manager);
+		}
+	}
+
+protected:
+	void add_var_dependency(const int &var_type, const int &knotpoint_offset){
+		var_dependencies.push_back(Var_Dependency(var_type, knotpoint_offset));
+	}
+
+	// Appends the partial derivatives of the cost w.r.t. the given variables on the local row 0.
+	// Columns with index -1 are fixed initial conditions and are skipped.
+	void append_gradient_entries(const sejong::Vector &grad, const std::vector<int> &var_indices,
+								 std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+		for(size_t j = 0; j < var_indices.size(); j++){
+			if (var_indices[j] < 0){
+				continue;
+			}
+			G.push_back(grad[j]);
+			iG.push_back(0);
+			jG.push_back(var_indices[j]);
+		}
+	}
 	
 };
 
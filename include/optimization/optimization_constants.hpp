@@ -5,6 +5,7 @@
 
 
   #define OPT_ZERO_GRADIENT_EPS 1.0e-8
+  #define OPT_FINITE_DIFF_STEP 1.0e-6 // Perturbation used for numerical partial derivatives
 
   #define OPT_TIMESTEP 0.01
 
@@ -30,10 +31,15 @@
 
   #define VAR_TYPE_ALPHA 16 // alpha_lcp_constraint
   #define VAR_TYPE_GAMMA 17 // beta_lcp_constraint
+  #define NUM_VAR_TYPES 18 // Number of variable types above
 
   #define ND_2D_CONST 2 // Number of friction cone basis vectors for a 2D plane. This number is fixed.
   #define CALC_F_MODE 0 // Decides if we are computing F
   #define CALC_G_MODE 1 // Decides if we are computing the gradient of F
 
+  #define COLLOCATION_BACK_EULER 0       // Backward Euler integration between knotpoints
+  #define COLLOCATION_TRAPEZOIDAL 1      // Trapezoidal collocation between knotpoints
+  #define COLLOCATION_HERMITE_SIMPSON 2  // Compressed Hermite-Simpson collocation between knotpoints
+
 
 #endif 
\ No newline at end of file
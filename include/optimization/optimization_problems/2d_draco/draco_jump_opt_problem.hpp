@@ -16,6 +16,7 @@
 class Draco_Jump_Opt: public Optimization_Problem_Main{
 public:
   Draco_Jump_Opt();
+  Draco_Jump_Opt(const int &N_total_knotpoints_in); // Default is 10 knotpoints
   ~Draco_Jump_Opt();	
 
   Opt_Variable_Manager    			opt_var_manager;
@@ -45,6 +46,9 @@ public:
   void get_var_manager(Opt_Variable_Manager* &var_manager_out){
     var_manager_out = &opt_var_manager;
   }
+  void get_contact_mode_schedule(Contact_Mode_Schedule* &schedule_out){
+    schedule_out = &contact_mode_schedule;
+  }
 
   // Interface to SNOPT -------------------------------------------------------------------
 
@@ -52,13 +56,16 @@ public:
   void get_opt_vars_bounds(std::vector<double> &x_low, std::vector<double> &x_upp);   	  	
 
   void update_opt_vars(std::vector<double> &x_vars); 	  		
+  void update_opt_vars(const double* x_vars, const int &n);
   void get_current_opt_vars(std::vector<double> &x_vars_out);   	  	  	
 
   void get_F_bounds(std::vector<double> &F_low, std::vector<double> &F_upp);
   void get_F_obj_Row(int &obj_row);	
 
   void compute_F(std::vector<double> &F_eval);
+  void compute_F(double* F_eval);
   void compute_F_constraints(std::vector<double> &F_eval);
+  void compute_F_constraints(double* F_eval);
   void compute_F_objective_function(double &result_out);
 
   void compute_G(std::vector<double> &G_eval, std::vector<int> &iGfun, std::vector<int> &jGvar, int &neG);
@@ -77,6 +84,7 @@ private:
   void initialize_specific_variable_bounds();
 
   void initialize_objective_func();
+  void initialize_G_sparsity_pattern();
 
 
 };
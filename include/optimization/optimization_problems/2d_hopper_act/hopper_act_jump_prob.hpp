@@ -21,6 +21,8 @@
 class Hopper_Act_Jump_Opt: public Optimization_Problem_Main{
 public:
   Hopper_Act_Jump_Opt();
+  Hopper_Act_Jump_Opt(const int &N_total_knotpoints_in); // Default is 27 knotpoints
+  Hopper_Act_Jump_Opt(const int &N_total_knotpoints_in, const int &collocation_method_in); // Default is COLLOCATION_BACK_EULER
   ~Hopper_Act_Jump_Opt();	
 
   Opt_Variable_Manager    			   opt_var_manager;
@@ -41,6 +43,7 @@ public:
   sejong::Vector                act_delta_dot_init; 
 
   int 										      N_total_knotpoints;
+  int                           collocation_method; // Integrator of the dynamics and time integration constraints
 
   double										    h_dt_min;
   double										    max_normal_force;
@@ -56,6 +59,9 @@ public:
   void get_var_manager(Opt_Variable_Manager* &var_manager_out){
     var_manager_out = &opt_var_manager;
   }
+  void get_contact_mode_schedule(Contact_Mode_Schedule* &schedule_out){
+    schedule_out = &contact_mode_schedule;
+  }
 
   // Interface to SNOPT -------------------------------------------------------------------
 
@@ -63,13 +69,16 @@ public:
   void get_opt_vars_bounds(std::vector<double> &x_low, std::vector<double> &x_upp);   	  	
 
   void update_opt_vars(std::vector<double> &x_vars); 	  		
+  void update_opt_vars(const double* x_vars, const int &n);
   void get_current_opt_vars(std::vector<double> &x_vars_out);   	  	  	
 
   void get_F_bounds(std::vector<double> &F_low, std::vector<double> &F_upp);
   void get_F_obj_Row(int &obj_row);	
 
   void compute_F(std::vector<double> &F_eval);
+  void compute_F(double* F_eval);
   void compute_F_constraints(std::vector<double> &F_eval);
+  void compute_F_constraints(double* F_eval);
   void compute_F_objective_function(double &result_out);
 
   void compute_G(std::vector<double> &G_eval, std::vector<int> &iGfun, std::vector<int> &jGvar, int &neG);
@@ -88,6 +97,7 @@ private:
   void initialize_specific_variable_bounds();
 
   void initialize_objective_func();
+  void initialize_G_sparsity_pattern();
 
 
 };
@@ -3,6 +3,9 @@
 #include <Utils/wrap_eigen.hpp>
 #include <optimization/optimization_constants.hpp>
 #include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/sparsity_pattern.hpp>
+#include <optimization/containers/contact_mode_schedule.hpp>
+#include <optimization/parallel/knotpoint_evaluator.hpp>
 #include <string>
 
 class Optimization_Problem_Main{
@@ -12,23 +15,68 @@ public:
 
   std::string problem_name = "Undefined Optimization Problem";
 
+  // Structural nonzeros of the Jacobian of F. Assembled once by the problem after its constraints are set up.
+  Sparsity_Pattern G_sparsity_pattern;
+
+  // Threads used to evaluate the timestep independent constraints of the knotpoints. Defaults to the number of cores.
+  void set_num_threads(const int &num_threads){ knotpoint_evaluator.set_num_threads(num_threads); }
+  int get_num_threads(){ return knotpoint_evaluator.get_num_threads(); }
+
+  // compute_F only re-evaluates the constraint blocks whose variables changed since the last call. Enabled by default.
+  void set_incremental_evaluation(const bool &incremental){ knotpoint_evaluator.set_incremental_evaluation(incremental); }
+  bool get_incremental_evaluation(){ return knotpoint_evaluator.get_incremental_evaluation(); }
+  // Constraints with a batched kernel evaluate all the knotpoints in one pass. Enabled by default.
+  // Only the backward Euler hopper dynamics have one, the collocation constraints of other methods do not.
+  void set_batch_evaluation(const bool &batch){ knotpoint_evaluator.set_batch_evaluation(batch); }
+  bool get_batch_evaluation(){ return knotpoint_evaluator.get_batch_evaluation(); }
+  // Must be called if anything besides the optimization variables changes the constraint values
+  void invalidate_F_cache(){ knotpoint_evaluator.invalidate_cache(); }
+
   virtual void get_init_opt_vars(std::vector<double> &x_vars){}
   virtual void get_opt_vars_bounds(std::vector<double> &x_low, std::vector<double> &x_upp){}   	  	
   virtual void get_current_opt_vars(std::vector<double> &x_vars_out){}
   virtual void update_opt_vars(std::vector<double> &x_vars){} 	  		
+  virtual void update_opt_vars(const double* x_vars, const int &n){}
 
   virtual void get_var_manager(Opt_Variable_Manager* &var_manager_out){}
+  // NULL if the problem has no contact modes
+  virtual void get_contact_mode_schedule(Contact_Mode_Schedule* &schedule_out){ schedule_out = NULL; }
 
   virtual void get_F_bounds(std::vector<double> &F_low, std::vector<double> &F_upp){}
   virtual void get_F_obj_Row(int &obj_row){}
 
+  // The constraint rows of F leave out the constant linear terms of compute_A, as SNOPT adds A*x itself
   virtual void compute_F(std::vector<double> &F_eval){}
   virtual void compute_F_constraints(std::vector<double> &F_eval){}
+  // Raw versions used by the SNOPT callbacks. F_eval must hold every row and is written in place.
+  virtual void compute_F(double* F_eval){}
+  virtual void compute_F_constraints(double* F_eval){}
   virtual void compute_F_objective_function(double &result_out){}
 
   virtual void compute_G(std::vector<double> &G_eval, std::vector<int> &iGfun, std::vector<int> &jGvar, int &neG){}
   virtual void compute_A(std::vector<double> &A_eval, std::vector<int> &iAfun, std::vector<int> &jAvar, int &neA){}
 
+  // Adds A*x at the current variables to F of compute_F, which gives the constraint values that the bounds apply to
+  void add_linear_terms(std::vector<double> &F_eval){
+    std::vector<double> x_vars;
+    std::vector<double> A_eval;
+    std::vector<int> iAfun;
+    std::vector<int> jAvar;
+    int neA = 0;
+    get_current_opt_vars(x_vars);
+    compute_A(A_eval, iAfun, jAvar, neA);
+    for(int i = 0; i < neA; i++){
+      F_eval[iAfun[i]] += A_eval[i]*x_vars[jAvar[i]];
+    }
+  }
+
+  // Optional. Lower triangle of the Hessian of sum_i lambda[i]*F[i] at the current variables, with one multiplier per row of F
+  // including the objective row. Returns false if the problem does not provide it and solvers must approximate it.
+  virtual bool compute_lagrangian_hessian(const std::vector<double> &lambda, std::vector<double> &H_eval, std::vector<int> &iHrow, 
+                                          std::vector<int> &jHcol, int &neH){ return false; }
+
+protected:
+  Knotpoint_Evaluator knotpoint_evaluator;
 
 };
 
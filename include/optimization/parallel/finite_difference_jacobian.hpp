@@ -0,0 +1,62 @@
+#ifndef FINITE_DIFFERENCE_JACOBIAN_H
+#define FINITE_DIFFERENCE_JACOBIAN_H
+
+#include <vector>
+#include <functional>
+
+#include <optimization/parallel/thread_pool.hpp>
+#include <optimization/optimization_problems/opt_problem_main.hpp>
+
+// Forward difference G for problems without analytic gradients.
+// Columns of G that share no row get the same color (Curtis-Powell-Reid) and are perturbed together, so one
+// evaluation of F gives every column of a color. A Jacobian costs one evaluation per color instead of one per variable,
+// and the banded knotpoint structure keeps the number of colors close to the variables of a few knotpoints.
+// compute_F leaves out the constant linear A terms, so A does not add colors.
+//
+// With a problem factory, the colors are spread over a thread pool and every thread evaluates F on its own copy
+// of the problem. Without one, the colors are evaluated one after the other on the problem itself.
+class Finite_Difference_Jacobian{
+public:
+	Finite_Difference_Jacobian(Optimization_Problem_Main* problem_in);
+	// problem_factory makes one copy per thread, eg: [](){ return new Hopper_Act_Jump_Opt(); }. The copies are deleted with this object.
+	Finite_Difference_Jacobian(Optimization_Problem_Main* problem_in, const std::function<Optimization_Problem_Main*()> &problem_factory,
+							   const int &num_threads);
+	~Finite_Difference_Jacobian();
+
+	int get_num_colors();
+	int get_num_threads();
+
+	// The perturbation of variable j is step*(1 + |x_j|). Same default as SNOPT's Difference interval.
+	void set_relative_step(const double &step);
+
+	// Writes G at x in the order of the problem's G_sparsity_pattern. F_nominal is the F of compute_F at x,
+	// or NULL to evaluate it here. The problem's variables are at x on return.
+	void compute_G(const double* x, const int &n, const double* F_nominal, double* G_out);
+
+private:
+	void initialize_colors();
+	// Difference of one color on eval_problem with the scratch buffers of slot
+	void evaluate_color(const int &color, Optimization_Problem_Main* eval_problem, const int &slot, const double* x,
+						const double* F_nominal, double* G_out);
+
+	Optimization_Problem_Main* problem;
+	std::vector<Optimization_Problem_Main*> problem_copies; // One per thread
+	Thread_Pool thread_pool;
+
+	int n = 0;
+	int nF = 0;
+	double relative_step = 5.5e-7;
+
+	// Rows and columns of the pattern elements, and the columns and pattern elements of each color
+	std::vector<int> G_rows;
+	std::vector<int> G_cols;
+	std::vector< std::vector<int> > color_cols;
+	std::vector< std::vector<int> > color_elements;
+
+	// Scratch buffers of each slot
+	std::vector< std::vector<double> > x_work;
+	std::vector< std::vector<double> > F_work;
+	std::vector<double> F_nominal_buffer;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef KNOTPOINT_BATCH_H
+#define KNOTPOINT_BATCH_H
+
+#include <Utils/wrap_eigen.hpp>
+
+// Helpers of the batched constraint kernels. A batch stacks the variables of a set of knotpoints: row i of every matrix
+// holds the i-th knotpoint. The matrices are column-major, so every component is contiguous over the knotpoints
+// (structure of arrays) and a kernel vectorizes across them.
+
+// out += X*R, eg: R = M^T applies M to the vector of every knotpoint.
+// Eigen's products sum the terms in an order that depends on the number of rows, so the columns are accumulated one
+// at a time instead. A knotpoint then gets the same bits in any batch, which the incremental evaluation relies on.
+template <typename Derived_X, typename Derived_R, typename Derived_Out>
+void batch_add_product(const Eigen::MatrixBase<Derived_X> &X, const Eigen::MatrixBase<Derived_R> &R, const Eigen::MatrixBase<Derived_Out> &out_const){
+	Eigen::MatrixBase<Derived_Out> &out = const_cast< Eigen::MatrixBase<Derived_Out>& >(out_const);
+	for(int j = 0; j < R.cols(); j++){
+		for(int k = 0; k < R.rows(); k++){
+			out.col(j) += X.col(k)*R(k, j);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef KNOTPOINT_EVALUATOR_H
+#define KNOTPOINT_EVALUATOR_H
+
+#include <optimization/parallel/thread_pool.hpp>
+#include <optimization/containers/constraint_list.hpp>
+#include <optimization/containers/opt_variable_manager.hpp>
+
+// Evaluates the timestep independent constraints of every knotpoint on a thread pool.
+// Knotpoint k owns the F rows [(k-1)*num_ti_funcs, k*num_ti_funcs), so the knotpoints write to disjoint ranges.
+// Constraints get the robot models per call, and every thread has its own model instances.
+//
+// evaluate_constraints also keeps the last constraint rows of F. Each knotpoint and each timestep dependent 
+// constraint is a block that reads the variables declared in var_dependencies. Only the blocks that read a 
+// variable changed since the previous call are evaluated again, so a finite difference step costs one or two knotpoints.
+//
+// Constraints that support batch evaluation are evaluated once for all the (changed) knotpoints on the calling thread
+// before the other constraints are spread over the thread pool.
+class Knotpoint_Evaluator{
+public:
+	Knotpoint_Evaluator();
+	~Knotpoint_Evaluator();	
+
+	void set_num_threads(const int &num_threads);
+	int get_num_threads();
+
+	// Writes the constraints of knotpoints 1 to total_knotpoints into F_eval
+	void evaluate_ti_constraints(Constraint_List &ti_constraint_list, Opt_Variable_Manager &var_manager, 
+								 const int &total_knotpoints, double* F_eval);
+
+	// Maps every variable to the blocks that read it. Must be called once the constraints and variables are set up.
+	void initialize_dependencies(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, 
+								 Opt_Variable_Manager &var_manager, const int &total_knotpoints);
+
+	// Writes every constraint row of F into F_eval, timestep independent rows first as in evaluate_ti_constraints.
+	// Unchanged blocks are copied from the previous call when incremental evaluation is enabled.
+	void evaluate_constraints(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, 
+							  Opt_Variable_Manager &var_manager, const int &total_knotpoints, double* F_eval);
+
+	// Enabled by default. Has no effect until initialize_dependencies is called.
+	void set_incremental_evaluation(const bool &incremental);
+	bool get_incremental_evaluation();
+	// Enabled by default. When disabled, batched constraints are evaluated one knotpoint at a time like the others.
+	// Only the backward Euler (COLLOCATION_BACK_EULER) dynamics of the hopper problems have a batched kernel. The
+	// trapezoidal and Hermite-Simpson collocation constraints are always evaluated one knotpoint at a time.
+	void set_batch_evaluation(const bool &batch);
+	bool get_batch_evaluation();
+	// Forces the next evaluate_constraints to evaluate every block, eg: after changing anything that is not a variable
+	void invalidate_cache();
+
+private:
+	bool is_batched(Constraint_Function* constraint);
+	void evaluate_batches(Constraint_List &ti_constraint_list, Opt_Variable_Manager &var_manager, const std::vector<int> &knotpoints, double* F_eval);
+	void evaluate_knotpoint(Constraint_List &ti_constraint_list, Opt_Variable_Manager &var_manager, const int &knotpoint, double* F_eval);
+	void evaluate_td_constraint(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, const int &index, 
+								Opt_Variable_Manager &var_manager, const int &total_knotpoints, double* F_eval);
+	void evaluate_all(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, 
+					  Opt_Variable_Manager &var_manager, const int &total_knotpoints, double* F_eval);
+
+	Thread_Pool thread_pool;
+
+	bool incremental_evaluation = true;
+	bool batch_evaluation = true;
+	bool dependencies_initialized = false;
+	bool cache_valid = false;
+
+	int num_ti_blocks = 0; // Block k-1 is knotpoint k. Timestep dependent constraint i is block num_ti_blocks + i.
+	std::vector< std::vector<int> > var_blocks; // Blocks that read each variable
+	std::vector<bool> dirty_blocks;
+	std::vector<int> dirty_knotpoints;
+	std::vector<int> all_knotpoints;
+
+	std::vector<double> x_prev; // Variables at the last evaluation
+	std::vector<double> x_current;
+	std::vector<double> F_cache; // Constraint rows at the last evaluation
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef OPT_THREAD_POOL_H
+#define OPT_THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+// Fixed set of worker threads that run the iterations of a loop. The calling thread also takes part,
+// so a pool of 1 thread runs everything serially on the caller and starts no workers.
+// Workers are only started by the first parallel_for.
+class Thread_Pool{
+public:
+	Thread_Pool(const int &num_threads_in = 1);
+	~Thread_Pool();	
+
+	// Calls func(i) for every i in [begin, end) and returns once all calls are done.
+	// The first exception thrown by func is rethrown on the calling thread.
+	void parallel_for(const int &begin, const int &end, const std::function<void(int)> &func);
+
+	void set_num_threads(const int &num_threads_in);
+	int get_num_threads();
+
+private:
+	void start_workers();
+	void stop_workers();
+	void worker_loop(unsigned int seen_generation);
+	void run_tasks();
+
+	std::vector<std::thread> workers;
+	int num_threads = 1;
+
+	std::mutex pool_mutex;
+	std::condition_variable work_cv;
+	std::condition_variable done_cv;
+
+	// State of the current loop
+	const std::function<void(int)>* current_func = NULL;
+	std::atomic<int> next_index;
+	int end_index = 0;
+	int num_busy_workers = 0; // Workers that have not finished the current loop
+	unsigned int generation = 0;
+	bool stop = false;
+	std::exception_ptr first_exception;
+};
+
+#endif
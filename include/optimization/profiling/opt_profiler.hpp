@@ -0,0 +1,75 @@
+#ifndef OPT_PROFILER_H
+#define OPT_PROFILER_H
+
+#include <string>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+
+// Wall time and call counts of the optimization hot paths. Scopes are only recorded when the tree is
+// compiled with OPT_PROFILING (cmake -DOPT_PROFILING=ON). Otherwise OPT_PROFILE_SCOPE expands to nothing
+// and its arguments are not evaluated.
+//
+// Usage: OPT_PROFILE_SCOPE("model", "UpdateModel"); with string literals. Each call site looks up its record once per thread.
+//        OPT_PROFILE_SCOPE_NAMED("constraint F", constraint_name); with a std::string name, looked up on every call.
+// Times are inclusive, so a scope also counts the time of the scopes nested in it.
+
+// Totals of one (category, name) key on one thread. Only the owning thread writes them.
+struct Profile_Record{
+	std::atomic<unsigned long> calls;
+	std::atomic<long long> total_ns;
+	std::atomic<long long> max_ns;
+	Profile_Record(): calls(0), total_ns(0), max_ns(0) {}
+};
+
+class Opt_Profiler{
+public:
+	// Record of the key for the calling thread. The pointer stays valid for the lifetime of the thread.
+	static Profile_Record* get_record(const char* category, const std::string &name);
+
+	// Totals over all threads since the start of the program or the last reset.
+	// Sorted by total time. The summary is a table and the dump has one CSV line per key.
+	static void print_summary(std::ostream &os);
+	static bool write_dump(const std::string &filename);
+	static void reset();
+};
+
+// Adds the wall time between its construction and destruction to a record
+class Opt_Profile_Scope{
+public:
+	Opt_Profile_Scope(Profile_Record* record_in): record(record_in), start(std::chrono::steady_clock::now()) {}
+	Opt_Profile_Scope(const char* category, const std::string &name): record(Opt_Profiler::get_record(category, name)),
+																	  start(std::chrono::steady_clock::now()) {}
+	~Opt_Profile_Scope(){
+		long long elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		// A single writer, so the counters do not need atomic read-modify-writes
+		record->calls.store(record->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		record->total_ns.store(record->total_ns.load(std::memory_order_relaxed) + elapsed_ns, std::memory_order_relaxed);
+		if (elapsed_ns > record->max_ns.load(std::memory_order_relaxed)){
+			record->max_ns.store(elapsed_ns, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	Opt_Profile_Scope(const Opt_Profile_Scope&);
+	Opt_Profile_Scope& operator=(const Opt_Profile_Scope&);
+
+	Profile_Record* record;
+	std::chrono::steady_clock::time_point start;
+};
+
+#define OPT_PROFILE_CONCAT_INNER(a, b) a##b
+#define OPT_PROFILE_CONCAT(a, b) OPT_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef OPT_PROFILING
+	// "" name only compiles for a literal, whose record can be kept by the call site
+	#define OPT_PROFILE_SCOPE(category, name) \
+		static thread_local Profile_Record* const OPT_PROFILE_CONCAT(opt_profile_record_, __LINE__) = Opt_Profiler::get_record(category, "" name); \
+		Opt_Profile_Scope OPT_PROFILE_CONCAT(opt_profile_scope_, __LINE__)(OPT_PROFILE_CONCAT(opt_profile_record_, __LINE__))
+	#define OPT_PROFILE_SCOPE_NAMED(category, name) Opt_Profile_Scope OPT_PROFILE_CONCAT(opt_profile_scope_, __LINE__)(category, name)
+#else
+	#define OPT_PROFILE_SCOPE(category, name) ((void)0)
+	#define OPT_PROFILE_SCOPE_NAMED(category, name) ((void)0)
+#endif
+
+#endif
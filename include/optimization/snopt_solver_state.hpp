@@ -0,0 +1,34 @@
+#ifndef SNOPT_SOLVER_STATE_H
+#define SNOPT_SOLVER_STATE_H
+
+#include <string>
+#include <vector>
+
+namespace snopt_wrapper{
+
+  // Everything SNOPT needs to Warm start a solve: the variables and functions with their
+  // basis states and multipliers, and the number of superbasic variables.
+  struct Solver_State{
+    std::string problem_name;
+    int nS = 0;
+
+    std::vector<double> x;
+    std::vector<int> xstate;
+    std::vector<double> xmul;
+
+    std::vector<double> F;
+    std::vector<int> Fstate;
+    std::vector<double> Fmul;
+
+    bool empty() const { return x.empty(); }
+    // A state can only warm start a problem with the same number of variables and functions
+    bool matches(const int &n, const int &nF) const { return ((int) x.size() == n) && ((int) F.size() == nF); }
+  };
+
+  // Compact binary file of a solver state. A versioned header with the dimensions is followed by
+  // the arrays in native byte order. Both return false and print the reason if the file can not be used.
+  bool write_solver_state(const std::string &filename, const Solver_State &state);
+  bool read_solver_state(const std::string &filename, Solver_State &state_out);
+}
+
+#endif
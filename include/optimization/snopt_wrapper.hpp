@@ -4,14 +4,29 @@
 #include <stdio.h>
 #include <string.h>
 #include <map>
+#include <string>
+#include <vector>
 
 #include <iostream>
 #include <math.h>
 
 #include <Optimizer/snopt/include/snoptProblem.hpp>
 #include <optimization/optimization_problems/opt_problem_main.hpp>
+#include <optimization/snopt_solver_state.hpp>
+#include <optimization/parallel/finite_difference_jacobian.hpp>
 
 namespace snopt_wrapper{
+
+  // Outcome of one solve
+  struct Solve_Result{
+    std::string problem_name;
+    int exit_code = -1; // SNOPT INFO code
+    double objective = 0.0;
+    int nInf = 0; // Number of infeasibilities
+    double sInf = 0.0; // Sum of infeasibilities
+    std::vector<double> x; // Final SNOPT variables. The problem's variable manager is also updated to them.
+    Solver_State solver_state; // Final state, eg: saved with write_solver_state to warm start a later solve
+  };
  
   void wbt_F(int    *Status, int *n,    double x[],
      int    *needF,  int *lenF,  double F[],
@@ -20,7 +35,35 @@ namespace snopt_wrapper{
      int    iu[],    int *leniu,
      double ru[],    int *lenru);
 
+  void wbt_FG(int    *Status, int *n,    double x[],
+     int    *needF,  int *lenF,  double F[],
+     int    *needG,  int *lenG,  double G[],
+     char      *cu,  int *lencu,
+     int    iu[],    int *leniu,
+     double ru[],    int *lenru);
+
   void solve_problem_no_gradients(Optimization_Problem_Main* input_ptr_optimization_problem);
+  void solve_problem_with_gradients(Optimization_Problem_Main* input_ptr_optimization_problem);
+
+  // The problem is handed to the callbacks through SNOPT's iu array, so different problems can be solved
+  // at the same time from different threads. An empty print_file disables the SNOPT print file.
+  void solve_problem_no_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, Solve_Result &result_out);
+  void solve_problem_with_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, Solve_Result &result_out);
+
+  // Start with SNOPT's Warm option from a previous solver state instead of the problem's initial guess.
+  // The bounds are the problem's own, so a state can warm start the same problem with changed bounds.
+  // A state whose dimensions differ from the problem is ignored with a warning.
+  void solve_problem_no_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, 
+                                  const Solver_State &warm_start, Solve_Result &result_out);
+  void solve_problem_with_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, 
+                                    const Solver_State &warm_start, Solve_Result &result_out);
+
+  // SNOPT is given G from the colored, multithreaded differences of fd_jacobian instead of differencing F itself
+  // (Derivative option 0). fd_jacobian must have been built for input_ptr_optimization_problem.
+  void solve_problem_with_finite_differences(Optimization_Problem_Main* input_ptr_optimization_problem, Finite_Difference_Jacobian* fd_jacobian,
+                                             const std::string &print_file, Solve_Result &result_out);
+  void solve_problem_with_finite_differences(Optimization_Problem_Main* input_ptr_optimization_problem, Finite_Difference_Jacobian* fd_jacobian,
+                                             const std::string &print_file, const Solver_State &warm_start, Solve_Result &result_out);
 }
 
 
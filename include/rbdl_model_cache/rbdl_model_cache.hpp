@@ -0,0 +1,28 @@
+#ifndef RBDL_MODEL_CACHE_H
+#define RBDL_MODEL_CACHE_H
+
+#include <rbdl/rbdl.h>
+#include <string>
+#include <stdint.h>
+
+// Binary snapshots of assembled RBDL models, so that every process does not parse the same URDF again.
+// A snapshot holds the joint frames, joints, bodies, fixed bodies and body names of the model. Reading it adds the
+// bodies to an empty model in their original order, so the body ids, and the link ids defined on them, are unchanged.
+// Snapshots are keyed by a hash of the URDF and are ignored when the key differs. Models with custom joints are not cached.
+namespace rbdl_model_cache{
+	// FNV-1a hash of the contents of the file. Returns false if it cannot be read.
+	bool hash_file(const std::string &file_path, uint64_t &hash_out);
+
+	// Returns false if the model has custom joints or the file cannot be written. The file is replaced in one rename,
+	// so processes started at the same time never read a partial snapshot.
+	bool write_model_cache(const RigidBodyDynamics::Model &model, const uint64_t &key, const std::string &cache_path);
+	// The file is memory mapped. model must be empty, eg: just constructed. Returns false and leaves the model empty
+	// if there is no snapshot for the key or it is damaged.
+	bool read_model_cache(const std::string &cache_path, const uint64_t &key, RigidBodyDynamics::Model* model);
+
+	// Addons::URDFReadFromFile through a snapshot in $RBDL_MODEL_CACHE_DIR, or /tmp if it is not set.
+	// The first run parses the URDF and writes the snapshot, later runs read the snapshot instead.
+	bool read_urdf_model(const std::string &urdf_path, RigidBodyDynamics::Model* model, const bool &floating_base);
+}
+
+#endif
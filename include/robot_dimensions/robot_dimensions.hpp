@@ -0,0 +1,35 @@
+#ifndef ROBOT_DIMENSIONS_H
+#define ROBOT_DIMENSIONS_H
+
+#include <Utils/wrap_eigen.hpp>
+
+// Compile-time sizes of a robot. Each robot defines its own typedef from its Definition header, eg:
+//   typedef Robot_Dimensions<NUM_Q, NUM_QDOT, NUM_VIRTUAL, 1> Hopper_Dimensions;
+// The fixed-size types live on the stack, so the hot paths do not allocate for these small matrices.
+// The number of active contact rows is only known at runtime. Those types have a dynamic size 
+// with a compile-time maximum of max_contact_dim rows, which also keeps them on the stack.
+template <int num_q_in, int num_qdot_in, int num_virtual_in, int max_contact_dim_in>
+struct Robot_Dimensions{
+	static const int num_q = num_q_in;
+	static const int num_qdot = num_qdot_in;
+	static const int num_virtual = num_virtual_in;
+	static const int num_act_joint = num_qdot_in - num_virtual_in;
+	static const int max_contact_dim = max_contact_dim_in;
+
+	typedef Eigen::Matrix<double, num_q, 1> Vector_q;
+	typedef Eigen::Matrix<double, num_qdot, 1> Vector_qdot;
+	typedef Eigen::Matrix<double, num_virtual, 1> Vector_virtual;
+	typedef Eigen::Matrix<double, num_act_joint, 1> Vector_act;
+
+	typedef Eigen::Matrix<double, num_qdot, num_qdot> Matrix_qdot; // Mass matrix
+	typedef Eigen::Matrix<double, num_virtual, num_qdot> Matrix_virtual_qdot; // Virtual joint selection matrix
+	typedef Eigen::Matrix<double, num_act_joint, num_qdot> Matrix_act_qdot; // Actuated joint selection matrix
+	typedef Eigen::Matrix<double, num_act_joint, num_act_joint> Matrix_act;
+
+	// Stacked contact Jacobian and reaction forces. Eigen requires a single row matrix to be row major.
+	typedef Eigen::Matrix<double, Eigen::Dynamic, num_qdot, (max_contact_dim == 1 && num_qdot != 1) ? Eigen::RowMajor : Eigen::ColMajor, 
+						  max_contact_dim, num_qdot> Matrix_contact_jacobian;
+	typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, max_contact_dim, 1> Vector_contact;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "benchmark_harness.hpp"
+#include "problem_benchmarks.hpp"
+#include <optimization/optimization_problems/2d_draco/draco_jump_opt_problem.hpp>
+#include "DracoModel.hpp"
+
+void benchmark_draco_model(Benchmark_Harness &harness, Draco_Jump_Opt &problem, Problem_States<Draco_Jump_Opt> &states){
+	DracoModel* robot_model = DracoModel::GetDracoModel();
+	sejong::Vector q_state, qdot_state;
+
+	harness.run("DracoModel/UpdateModel",
+				[&](int sample){
+					states.apply(sample);
+					problem.opt_var_manager.get_var_states(harness.random_int(1, problem.N_total_knotpoints), q_state, qdot_state);
+				},
+				[&](){ robot_model->UpdateModel(q_state, qdot_state); });
+
+	// The dynamics are only computed when they are read, as in Draco_Hybrid_Dynamics_Constraint
+	Draco_Dimensions::Matrix_qdot A;
+	Draco_Dimensions::Vector_qdot nonlinear_effects;
+	harness.run("DracoModel/UpdateModel+dynamics",
+				[&](int sample){
+					states.apply(sample);
+					problem.opt_var_manager.get_var_states(harness.random_int(1, problem.N_total_knotpoints), q_state, qdot_state);
+				},
+				[&](){
+					robot_model->UpdateModel(q_state, qdot_state);
+					robot_model->getMassInertia(A);
+					robot_model->getNonlinearEffects(nonlinear_effects);
+				});
+}
+
+int main(int argc, char **argv){
+	std::string json_file = (argc > 1) ? argv[1] : "benchmark_draco.json";
+	Benchmark_Harness harness("draco");
+
+	Draco_Jump_Opt jump_problem;
+	Problem_States<Draco_Jump_Opt> jump_states(jump_problem, harness, 16);
+
+	benchmark_draco_model(harness, jump_problem, jump_states);
+	benchmark_constraints(harness, "Draco_Jump_Opt", jump_problem, jump_states);
+	benchmark_compute_F(harness, "Draco_Jump_Opt", jump_problem, jump_states);
+
+	harness.print_summary(std::cout);
+	harness.write_json(json_file);
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include "benchmark_harness.hpp"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+Benchmark_Harness::Benchmark_Harness(const std::string &suite_name_in, const int &num_samples_in): suite_name(suite_name_in),
+																								   num_samples(num_samples_in), rng(12345){}
+Benchmark_Harness::~Benchmark_Harness(){}
+
+void Benchmark_Harness::run(const std::string &name, const std::function<void(int)> &setup, const std::function<void()> &kernel,
+							const int &calls_per_sample){
+	if ((num_samples < 1) || (calls_per_sample < 1)){
+		std::cerr << "[Benchmark_Harness] Error! " << name << " needs at least one sample and one call per sample" << std::endl;
+		throw "invalid_index";
+	}
+
+	std::vector<double> sample_ns;
+	sample_ns.reserve(num_samples);
+	for(int sample = -num_warmup_samples; sample < num_samples; sample++){
+		setup(std::max(sample, 0));
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(int i = 0; i < calls_per_sample; i++){
+			kernel();
+		}
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		if (sample >= 0){
+			sample_ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / calls_per_sample);
+		}
+	}
+
+	Result result;
+	result.name = name;
+	result.num_samples = num_samples;
+	result.calls_per_sample = calls_per_sample;
+
+	double sum = 0.0;
+	for(size_t i = 0; i < sample_ns.size(); i++){
+		sum += sample_ns[i];
+	}
+	result.mean_ns = sum / sample_ns.size();
+	double sum_sq = 0.0;
+	for(size_t i = 0; i < sample_ns.size(); i++){
+		sum_sq += (sample_ns[i] - result.mean_ns)*(sample_ns[i] - result.mean_ns);
+	}
+	result.stddev_ns = (sample_ns.size() > 1) ? std::sqrt(sum_sq / (sample_ns.size() - 1)) : 0.0;
+
+	std::sort(sample_ns.begin(), sample_ns.end());
+	result.min_ns = sample_ns.front();
+	result.median_ns = sample_ns[sample_ns.size()/2];
+	result.p90_ns = sample_ns[(sample_ns.size()*9)/10];
+	result.max_ns = sample_ns.back();
+
+	std::cout << "[Benchmark_Harness] " << std::left << std::setw(96) << name << std::right << std::fixed << std::setprecision(1)
+			  << std::setw(14) << result.median_ns << " ns/call (median)" << std::endl;
+	results.push_back(result);
+}
+
+void Benchmark_Harness::print_summary(std::ostream &os){
+	std::ios::fmtflags flags(os.flags());
+	os << "[Benchmark_Harness] Suite " << suite_name << ": ns/call over " << num_samples << " samples" << std::endl;
+	os << std::left << std::setw(96) << "kernel" << std::right << std::setw(8) << "calls" << std::setw(14) << "mean" << std::setw(12) << "stddev"
+	   << std::setw(12) << "min" << std::setw(12) << "median" << std::setw(12) << "p90" << std::setw(12) << "max" << std::endl;
+	os << std::fixed << std::setprecision(1);
+	for(size_t i = 0; i < results.size(); i++){
+		const Result &r = results[i];
+		os << std::left << std::setw(96) << r.name << std::right << std::setw(8) << r.calls_per_sample << std::setw(14) << r.mean_ns
+		   << std::setw(12) << r.stddev_ns << std::setw(12) << r.min_ns << std::setw(12) << r.median_ns << std::setw(12) << r.p90_ns
+		   << std::setw(12) << r.max_ns << std::endl;
+	}
+	os.flags(flags);
+}
+
+namespace{
+	// Constraint names are plain text, but quotes and backslashes still have to be escaped
+	std::string json_string(const std::string &s){
+		std::string out = "\"";
+		for(size_t i = 0; i < s.size(); i++){
+			if ((s[i] == '"') || (s[i] == '\\')){
+				out += '\\';
+			}
+			out += s[i];
+		}
+		return out + "\"";
+	}
+}
+
+bool Benchmark_Harness::write_json(const std::string &filename){
+	std::ofstream file(filename.c_str());
+	if (!file.is_open()){
+		std::cerr << "[Benchmark_Harness] Error! Could not open " << filename << std::endl;
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(1);
+	file << "{" << std::endl;
+	file << "  \"suite\": " << json_string(suite_name) << "," << std::endl;
+	file << "  \"unit\": \"ns/call\"," << std::endl;
+	file << "  \"benchmarks\": [" << std::endl;
+	for(size_t i = 0; i < results.size(); i++){
+		const Result &r = results[i];
+		file << "    {\"name\": " << json_string(r.name) << ", \"samples\": " << r.num_samples << ", \"calls_per_sample\": " << r.calls_per_sample
+			 << ", \"mean\": " << r.mean_ns << ", \"stddev\": " << r.stddev_ns << ", \"min\": " << r.min_ns << ", \"median\": " << r.median_ns
+			 << ", \"p90\": " << r.p90_ns << ", \"max\": " << r.max_ns << "}" << ((i + 1 < results.size()) ? "," : "") << std::endl;
+	}
+	file << "  ]" << std::endl;
+	file << "}" << std::endl;
+
+	std::cout << "[Benchmark_Harness] Results written to " << filename << std::endl;
+	return true;
+}
+
+void Benchmark_Harness::random_opt_vars(const std::vector<double> &x_nominal, const std::vector<double> &x_low, const std::vector<double> &x_upp,
+										const double &scale, std::vector<double> &x_out){
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	x_out.resize(x_nominal.size());
+	for(size_t i = 0; i < x_nominal.size(); i++){
+		// Narrow bounds shrink the spread. Wide and infinite bounds use scale.
+		double spread = scale*std::min(x_upp[i] - x_low[i], 1.0);
+		x_out[i] = std::min(std::max(x_nominal[i] + spread*unit(rng), x_low[i]), x_upp[i]);
+	}
+}
+
+int Benchmark_Harness::random_int(const int &low, const int &upp){
+	std::uniform_int_distribution<int> dist(low, upp);
+	return dist(rng);
+}
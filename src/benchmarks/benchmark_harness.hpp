@@ -0,0 +1,52 @@
+#ifndef BENCHMARK_HARNESS_H
+#define BENCHMARK_HARNESS_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <functional>
+#include <random>
+
+// Times evaluation kernels in isolation. Each sample calls an untimed setup, which moves the kernel to a new
+// state, and then times calls_per_sample calls of the kernel. The ns/call of every sample are summarized.
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+class Benchmark_Harness{
+public:
+	Benchmark_Harness(const std::string &suite_name_in, const int &num_samples_in = 200);
+	~Benchmark_Harness();
+
+	// setup(sample) is called before each sample. Kernels whose state is cached should get a new state in it.
+	void run(const std::string &name, const std::function<void(int)> &setup, const std::function<void()> &kernel,
+			 const int &calls_per_sample = 1);
+
+	void print_summary(std::ostream &os);
+	// Machine readable results, eg: to track regressions between releases
+	bool write_json(const std::string &filename);
+
+	// Random variable values within the bounds, uniformly spread around x_nominal by up to scale
+	void random_opt_vars(const std::vector<double> &x_nominal, const std::vector<double> &x_low, const std::vector<double> &x_upp,
+						 const double &scale, std::vector<double> &x_out);
+	int random_int(const int &low, const int &upp); // In [low, upp]
+
+	std::string suite_name;
+	int num_samples;
+	int num_warmup_samples = 5;
+
+private:
+	struct Result{
+		std::string name;
+		int num_samples = 0;
+		int calls_per_sample = 0;
+		double mean_ns = 0.0;
+		double stddev_ns = 0.0;
+		double min_ns = 0.0;
+		double median_ns = 0.0;
+		double p90_ns = 0.0;
+		double max_ns = 0.0;
+	};
+
+	std::vector<Result> results;
+	std::mt19937 rng; // Fixed seed, so every run visits the same states
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "benchmark_harness.hpp"
+#include "problem_benchmarks.hpp"
+#include <optimization/optimization_problems/2d_hopper/hopper_stand_opt_problem.hpp>
+#include <optimization/optimization_problems/2d_hopper/hopper_jump_opt_problem.hpp>
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+
+void benchmark_var_manager_getters(Benchmark_Harness &harness, Hopper_Jump_Opt &jump_problem, Hopper_Act_Jump_Opt &act_problem){
+	const int calls = 1000;
+	int knotpoint = 1;
+	sejong::Vector q, qdot, vec;
+	double h_dt;
+	std::vector<int> indices;
+
+	Opt_Variable_Manager &var_manager = jump_problem.opt_var_manager;
+	std::function<void(int)> jump_setup = [&](int sample){ knotpoint = harness.random_int(1, jump_problem.N_total_knotpoints); };
+	harness.run("Opt_Variable_Manager/get_var_block", jump_setup, [&](){ vec = var_manager.get_var_block(VAR_TYPE_Q, knotpoint); }, calls);
+	harness.run("Opt_Variable_Manager/get_var_states", jump_setup, [&](){ var_manager.get_var_states(knotpoint, q, qdot); }, calls);
+	harness.run("Opt_Variable_Manager/get_q_states", jump_setup, [&](){ var_manager.get_q_states(knotpoint, q); }, calls);
+	harness.run("Opt_Variable_Manager/get_qdot_states", jump_setup, [&](){ var_manager.get_qdot_states(knotpoint, qdot); }, calls);
+	harness.run("Opt_Variable_Manager/get_var_reaction_forces", jump_setup, [&](){ var_manager.get_var_reaction_forces(knotpoint, vec); }, calls);
+	harness.run("Opt_Variable_Manager/get_var_knotpoint_dt", jump_setup, [&](){ var_manager.get_var_knotpoint_dt(knotpoint - 1, h_dt); }, calls);
+	harness.run("Opt_Variable_Manager/get_var_indices", jump_setup, [&](){ var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, indices); }, calls);
+
+	Opt_Variable_Manager &act_var_manager = act_problem.opt_var_manager;
+	std::function<void(int)> act_setup = [&](int sample){ knotpoint = harness.random_int(1, act_problem.N_total_knotpoints); };
+	harness.run("Opt_Variable_Manager/get_x_states", act_setup, [&](){ act_var_manager.get_x_states(knotpoint, vec); }, calls);
+	harness.run("Opt_Variable_Manager/get_xdot_states", act_setup, [&](){ act_var_manager.get_xdot_states(knotpoint, vec); }, calls);
+	harness.run("Opt_Variable_Manager/get_u_states", act_setup, [&](){ act_var_manager.get_u_states(knotpoint, vec); }, calls);
+}
+
+void benchmark_combined_dynamics(Benchmark_Harness &harness, Hopper_Act_Jump_Opt &problem, Problem_States<Hopper_Act_Jump_Opt> &states){
+	Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+	Opt_Variable_Manager &var_manager = problem.opt_var_manager;
+
+	sejong::Vector x_state, xdot_state, xdot_state_prev, u_state, Fr_state, q_state, dynamics;
+	Hopper_Dimensions::Matrix_contact_jacobian Jc;
+	double h_dt;
+
+	harness.run("Hopper_Combined_Dynamics_Model/getDynamics_constraint",
+				[&](int sample){
+					states.apply(sample);
+					int knotpoint = harness.random_int(1, problem.N_total_knotpoints);
+					var_manager.get_x_states(knotpoint, x_state);
+					var_manager.get_xdot_states(knotpoint, xdot_state);
+					var_manager.get_xdot_states(knotpoint - 1, xdot_state_prev);
+					var_manager.get_u_states(knotpoint, u_state);
+					var_manager.get_var_reaction_forces(knotpoint, Fr_state);
+					var_manager.get_var_knotpoint_dt(knotpoint - 1, h_dt);
+
+					combined_model->convert_x_to_q(x_state, q_state);
+					problem.contact_list.get_stacked_contact_jacobian(q_state, Jc);
+					combined_model->setContactJacobian(Jc);
+				},
+				[&](){ combined_model->getDynamics_constraint(x_state, xdot_state, xdot_state_prev, u_state, Fr_state, h_dt, dynamics); });
+}
+
+int main(int argc, char **argv){
+	std::string json_file = (argc > 1) ? argv[1] : "benchmark_hopper.json";
+	Benchmark_Harness harness("hopper");
+
+	Hopper_Stand_Opt stand_problem;
+	Hopper_Jump_Opt jump_problem;
+	Hopper_Act_Jump_Opt act_problem;
+
+	const int num_states = 16;
+	Problem_States<Hopper_Stand_Opt> stand_states(stand_problem, harness, num_states);
+	Problem_States<Hopper_Jump_Opt> jump_states(jump_problem, harness, num_states);
+	Problem_States<Hopper_Act_Jump_Opt> act_states(act_problem, harness, num_states);
+
+	benchmark_var_manager_getters(harness, jump_problem, act_problem);
+	benchmark_combined_dynamics(harness, act_problem, act_states);
+
+	benchmark_constraints(harness, "Hopper_Stand_Opt", stand_problem, stand_states);
+	benchmark_constraints(harness, "Hopper_Jump_Opt", jump_problem, jump_states);
+	benchmark_constraints(harness, "Hopper_Act_Jump_Opt", act_problem, act_states);
+
+	benchmark_compute_F(harness, "Hopper_Stand_Opt", stand_problem, stand_states);
+	benchmark_compute_F(harness, "Hopper_Jump_Opt", jump_problem, jump_states);
+	benchmark_compute_F(harness, "Hopper_Act_Jump_Opt", act_problem, act_states);
+
+	harness.print_summary(std::cout);
+	harness.write_json(json_file);
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "benchmark_harness.hpp"
+#include "ValkyrieRobotModel.hpp"
+#include "valkyrie_definition.h"
+#include <random>
+
+// Random valid Valkyrie states around the standing pose. The pelvis orientation is a unit quaternion
+// with x, y, z in q[3], q[4], q[5] and w in q[NUM_QDOT].
+void random_valkyrie_state(std::mt19937 &rng, sejong::Vector &q, sejong::Vector &qdot){
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	q = sejong::Vector::Zero(NUM_Q);
+	qdot = sejong::Vector::Zero(NUM_QDOT);
+
+	q[0] = 0.1*unit(rng);
+	q[1] = 0.1*unit(rng);
+	q[2] = 1.14 + 0.05*unit(rng);
+
+	sejong::Quaternion ori(1.0, 0.1*unit(rng), 0.1*unit(rng), 0.1*unit(rng));
+	ori.normalize();
+	q[3] = ori.x();
+	q[4] = ori.y();
+	q[5] = ori.z();
+	q[NUM_QDOT] = ori.w();
+
+	for(int i = NUM_VIRTUAL; i < NUM_QDOT; i++){
+		q[i] = 0.5*unit(rng);
+	}
+	for(int i = 0; i < NUM_QDOT; i++){
+		qdot[i] = unit(rng);
+	}
+}
+
+int main(int argc, char **argv){
+	std::string json_file = (argc > 1) ? argv[1] : "benchmark_valkyrie.json";
+	Benchmark_Harness harness("valkyrie");
+
+	ValkyrieRobotModel* robot_model = ValkyrieRobotModel::GetValkyrieRobotModel();
+
+	std::mt19937 rng(12345);
+	std::vector<sejong::Vector> q_states(16), qdot_states(16);
+	for(size_t i = 0; i < q_states.size(); i++){
+		random_valkyrie_state(rng, q_states[i], qdot_states[i]);
+	}
+
+	int state = 0;
+	harness.run("ValkyrieRobotModel/UpdateModel",
+				[&](int sample){ state = sample % q_states.size(); },
+				[&](){ robot_model->UpdateModel(q_states[state], qdot_states[state]); });
+
+	// The dynamics are only computed when they are read
+	sejong::Matrix A;
+	sejong::Vector nonlinear_effects;
+	harness.run("ValkyrieRobotModel/UpdateModel+dynamics",
+				[&](int sample){ state = sample % q_states.size(); },
+				[&](){
+					robot_model->UpdateModel(q_states[state], qdot_states[state]);
+					robot_model->getMassInertia(A);
+					robot_model->getNonlinearEffects(nonlinear_effects);
+				});
+
+	harness.print_summary(std::cout);
+	harness.write_json(json_file);
+	return 0;
+}
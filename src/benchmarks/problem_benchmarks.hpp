@@ -0,0 +1,69 @@
+#ifndef PROBLEM_BENCHMARKS_H
+#define PROBLEM_BENCHMARKS_H
+
+#include "benchmark_harness.hpp"
+#include <optimization/hard_constraints/constraint_main.hpp>
+
+// Kernels shared by the problems of every robot. Problem is one of the optimization problem classes.
+
+// Random valid variable values of a problem. Consecutive samples use different states, so the
+// model updates cached per state are recomputed in every sample.
+template <typename Problem>
+struct Problem_States{
+	Problem_States(Problem &problem_in, Benchmark_Harness &harness, const int &num_states): problem(problem_in){
+		std::vector<double> x_init, x_low, x_upp;
+		problem.get_init_opt_vars(x_init);
+		problem.get_opt_vars_bounds(x_low, x_upp);
+		states.resize(num_states);
+		for(int i = 0; i < num_states; i++){
+			harness.random_opt_vars(x_init, x_low, x_upp, 0.05, states[i]);
+		}
+	}
+
+	void apply(const int &sample){
+		problem.update_opt_vars(states[sample % states.size()]);
+	}
+
+	Problem &problem;
+	std::vector< std::vector<double> > states;
+};
+
+template <typename Problem>
+void benchmark_constraints(Benchmark_Harness &harness, const std::string &problem_name, Problem &problem, Problem_States<Problem> &states){
+	Opt_Variable_Manager &var_manager = problem.opt_var_manager;
+	std::vector<double> F_vec;
+	int knotpoint = 1;
+
+	for(int i = 0; i < problem.ti_constraint_list.get_size(); i++){
+		Constraint_Function* constraint = problem.ti_constraint_list.get_constraint(i);
+		harness.run(problem_name + "/evaluate_constraint/ti/" + constraint->constraint_name,
+					[&](int sample){ states.apply(sample); knotpoint = harness.random_int(1, problem.N_total_knotpoints); },
+					[&](){ constraint->evaluate_constraint(knotpoint, var_manager, F_vec); });
+	}
+	for(int i = 0; i < problem.td_constraint_list.get_size(); i++){
+		Constraint_Function* constraint = problem.td_constraint_list.get_constraint(i);
+		// Several timestep dependent constraints may share a name
+		harness.run(problem_name + "/evaluate_constraint/td" + std::to_string(i) + "/" + constraint->constraint_name,
+					[&](int sample){ states.apply(sample); },
+					[&](){ constraint->evaluate_constraint(constraint->des_knotpoint, var_manager, F_vec); });
+	}
+}
+
+// Every constraint is evaluated on the calling thread
+template <typename Problem>
+void benchmark_compute_F(Benchmark_Harness &harness, const std::string &problem_name, Problem &problem, Problem_States<Problem> &states){
+	std::vector<double> F_eval;
+	problem.set_num_threads(1);
+	problem.set_incremental_evaluation(false);
+	harness.run(problem_name + "/compute_F",
+				[&](int sample){ states.apply(sample); },
+				[&](){ problem.compute_F(F_eval); });
+	// Batched constraints one knotpoint at a time, for comparison
+	problem.set_batch_evaluation(false);
+	harness.run(problem_name + "/compute_F/unbatched",
+				[&](int sample){ states.apply(sample); },
+				[&](){ problem.compute_F(F_eval); });
+	problem.set_batch_evaluation(true);
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include "Draco_Kin_Model.hpp"
 #include "rbdl/urdfreader.h"
 #include <Utils/utilities.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
 
 #include <stdio.h>
 
@@ -10,10 +11,18 @@ using namespace RigidBodyDynamics;
 using namespace RigidBodyDynamics::Math;
 
 DracoModel* DracoModel::GetDracoModel(){
-    static DracoModel draco_model_;
+    // The model is assembled once and every thread works on its own clone of it
+    static const DracoModel draco_model_prototype;
+    thread_local DracoModel draco_model_(draco_model_prototype);
     return & draco_model_;
 }
 
+DracoModel::DracoModel(const DracoModel &other){
+    model_ = new Model(*other.model_);
+    dyn_model_ = new Draco_Dyn_Model(*other.dyn_model_, model_);
+    kin_model_ = new Draco_Kin_Model(*other.kin_model_, model_);
+}
+
 DracoModel::DracoModel(){
   model_ = new Model();
   rbdl_check_api_version (RBDL_API_VERSION);
@@ -80,47 +89,43 @@ DracoModel::DracoModel(){
   // ground to Virtual X link
   vlink_x = Body (mass_zero, com_pos_zero, gyration_radii_zero);
   int vlx_id = model_->AddBody(0, Xtrans(Vector3d(0., 0., 0.)), vjoint_x, vlink_x, "virtual_x");
-  printf("X virtual id: %i \n", vlx_id);
 
   // Virtual X link to Virtual Z
   vlink_z = Body (mass_zero, com_pos_zero, gyration_radii_zero);
   int vlz_id = model_->AddBody(vlx_id, Xtrans(Vector3d(0.,0.,0.)), vjoint_z, vlink_z, "virtual_z");
-  printf("Z virtual Z id: %i \n", vlz_id);
 
   // Virtual Z link to Body
   link_body = Body (mass_body, body_com, inertia_body);
   int body_id = model_->AddBody(vlz_id, Xtrans(Vector3d(0., 0., 0.)), joint_ry, link_body, "body");
-  printf("body id: %i \n", body_id);
 
   // Body to Thigh
   link_thigh = Body (mass_upperLeg, upperLeg_com, inertia_upperLeg);
   int thigh_id = model_->AddBody(body_id, Xtrans(bodyPitch_joff),
                                 joint_ry, link_thigh, "upperLeg");
-  printf("upperLeg id: %i \n", thigh_id);
 
   // Thigh to Shank
   link_shank = Body (mass_lowerLeg, lowerLeg_com, inertia_lowerLeg);
   int shank_id = model_->AddBody(thigh_id, Xtrans(Knee_joff),
                                 joint_ry, link_shank, "lowerLeg");
-  printf("lowerLeg id: %i \n", shank_id);
 
   // Shank to Foot
   link_foot = Body (mass_foot, foot_com, inertia_foot);
   int foot_id = model_->AddBody(shank_id, Xtrans(Ankle_joff),
                                joint_ry, link_foot, "foot");
-  printf("foot id: %i \n", foot_id);
 
   Joint fixed_joint = Joint(JointTypeFixed);
   // Fixed Joint (Toe)
   link_toe = Body(mass_zero, com_pos_zero, gyration_radii_zero);
   int toe_id = model_->AddBody(foot_id, Xtrans(Vector3d(lx_toe, 0., lz_foot)), fixed_joint, link_toe, "toe");
-  printf("toe id: %i \n", toe_id);
 
   // Fixed Joint (Heel)
   link_heel = Body(mass_zero, com_pos_zero, gyration_radii_zero);
   int heel_id = model_->AddBody(foot_id, Xtrans(Vector3d(lx_heel, 0., lz_foot)),
                                fixed_joint, link_heel, "heel");
-  printf("body heel id: %i \n", heel_id);
+
+  // One line for all the body ids, the model is only assembled by the prototype
+  std::cout << "[Draco Model] Body ids: virtual_x " << vlx_id << ", virtual_z " << vlz_id << ", body " << body_id
+            << ", upperLeg " << thigh_id << ", lowerLeg " << shank_id << ", foot " << foot_id << ", toe " << toe_id << ", heel " << heel_id << std::endl;
 
   //////////////////////////////////////////////////////
   ///            End of Assemble Model               ///
@@ -139,6 +144,7 @@ DracoModel::~DracoModel(){
     delete model_;
 }
 void DracoModel::UpdateModel(const Vector & q, const Vector & qdot){
+    OPT_PROFILE_SCOPE("model", "DracoModel::UpdateModel");
     UpdateKinematicsCustom(*model_, &q, &qdot, NULL);
     dyn_model_->UpdateDynamics(q, qdot);
     kin_model_->UpdateKinematics(q, qdot);
@@ -163,6 +169,7 @@ void DracoModel::getCentroidJacobian(sejong::Matrix & Jcent){
 }
 
 void DracoModel::UpdateKinematics(const Vector & q, const Vector &qdot){
+    OPT_PROFILE_SCOPE("model", "DracoModel::UpdateKinematics");
     UpdateKinematicsCustom(*model_, &q, &qdot, NULL);
 }
 
@@ -182,7 +189,28 @@ bool DracoModel::getCoriolis(Vector & coriolis) {
     return dyn_model_->getCoriolis(coriolis);
 }
 
+bool DracoModel::getNonlinearEffects(Vector & nonlinear) {
+    return dyn_model_->getNonlinearEffects(nonlinear);
+}
+
+bool DracoModel::getMassInertia(Draco_Dimensions::Matrix_qdot & A) {
+    return dyn_model_->getMassInertia(A);
+}
+
+bool DracoModel::getGravity(Draco_Dimensions::Vector_qdot & grav) {
+    return dyn_model_->getGravity(grav);
+}
+
+bool DracoModel::getCoriolis(Draco_Dimensions::Vector_qdot & coriolis) {
+    return dyn_model_->getCoriolis(coriolis);
+}
+
+bool DracoModel::getNonlinearEffects(Draco_Dimensions::Vector_qdot & nonlinear) {
+    return dyn_model_->getNonlinearEffects(nonlinear);
+}
+
 void DracoModel::getFullJacobian(const Vector & q, int link_id, sejong::Matrix & J) const {
+  OPT_PROFILE_SCOPE("model", "DracoModel::getFullJacobian");
   sejong::Matrix Jtmp(6, NUM_QDOT);
   Jtmp.setZero();
   kin_model_->getJacobian(q, link_id, Jtmp);
@@ -232,14 +260,12 @@ void DracoModel::getCoMJacobian(const Vector & q, sejong::Matrix & J){
 }
 
 void DracoModel::getCoMPosition(const Vector & q, Vect3 & com_pos, bool update){
-  com_pos = kin_model_->com_pos_;
-    // kin_model_->getCoMPos(q, com_pos, update);
+  kin_model_->getCentroidCoMPos(com_pos);
 }
 
 void DracoModel::getCoMVelocity(const Vector & q, const Vector & qdot, Vect3 & com_vel){
     kin_model_->getCoMVel(q, qdot, com_vel);
 }
 void DracoModel::getCentroidVelocity(sejong::Vector & centroid_vel){
-  centroid_vel = kin_model_->centroid_vel_;
-  // kin_model_->getCentroidVelocity(centroid_vel);
+  kin_model_->getCentroidVelocity(centroid_vel);
 }
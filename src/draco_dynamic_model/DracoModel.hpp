@@ -3,16 +3,25 @@
 
 #include <rbdl/rbdl.h>
 #include <Utils/wrap_eigen.hpp>
+#include <robot_dimensions/robot_dimensions.hpp>
+#include "DracoP1Rot_Definition.h"
 
 class Draco_Dyn_Model;
 class Draco_Kin_Model;
 
 using namespace sejong;
 
+// The toe and heel contacts have 2 rows each
+typedef Robot_Dimensions<NUM_Q, NUM_QDOT, NUM_VIRTUAL, 4> Draco_Dimensions;
+
 class DracoModel{
 public:
     // EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    // Returns the calling thread's model. UpdateModel writes into the RBDL model, so threads must not share one.
     static DracoModel* GetDracoModel();
+    // Clones the assembled RBDL model and the cached dynamics
+    DracoModel(const DracoModel &other);
+    DracoModel& operator=(const DracoModel &other) = delete;
     virtual ~DracoModel(void);
 
     bool getMassInertia(sejong::Matrix & A);
@@ -20,6 +29,13 @@ public:
     virtual bool getInverseMassInertia(sejong::Matrix & Ainv) ;
     virtual bool getGravity(Vector & grav) ;
     virtual bool getCoriolis(Vector & coriolis) ;
+    virtual bool getNonlinearEffects(Vector & nonlinear) ;
+
+    // Fixed-size versions for the constraint hot paths
+    bool getMassInertia(Draco_Dimensions::Matrix_qdot & A);
+    bool getGravity(Draco_Dimensions::Vector_qdot & grav);
+    bool getCoriolis(Draco_Dimensions::Vector_qdot & coriolis);
+    bool getNonlinearEffects(Draco_Dimensions::Vector_qdot & nonlinear);
 
     virtual void getCentroidJacobian(sejong::Matrix & Jcent);
     virtual void getCentroidInertia(sejong::Matrix & Icent);
@@ -36,6 +52,8 @@ public:
     void getCentroidVelocity(sejong::Vector & centroid_vel);
     void getCoMJacobian(const Vector & q, sejong::Matrix & J);
     void UpdateKinematics(const Vector & q, const Vector &qdot);
+    // Updates the kinematics. M, the coriolis and gravity terms, Ainv and the centroid frame are computed on their
+    // first request, so read them before the model is moved to another state with UpdateKinematics or UpdateModel.
     void UpdateModel(const sejong::Vector & q, const sejong::Vector & qdot);
 
 protected:
@@ -5,7 +5,8 @@
 #include <cmath>
 
 HopperActuatorModel* HopperActuatorModel::GetActuatorModel(){
-    static HopperActuatorModel hopper_act_model;
+    static const HopperActuatorModel hopper_act_model_prototype;
+    thread_local HopperActuatorModel hopper_act_model(hopper_act_model_prototype);
     return & hopper_act_model;
 }
 
@@ -96,7 +97,12 @@ void HopperActuatorModel::Initialization(){
 }
 
 void HopperActuatorModel::getMassMatrix(sejong::Matrix &M_act){
-	M_act.resize(NUM_TOTAL_STATES, NUM_TOTAL_STATES);
+	Hopper_Actuator_Dimensions::Matrix_states M_act_fixed;
+	getMassMatrix(M_act_fixed);
+	M_act = M_act_fixed;
+}
+
+void HopperActuatorModel::getMassMatrix(Hopper_Actuator_Dimensions::Matrix_states &M_act){
 	M_act.setZero();
 /*	// Assign block diagonally
 	for(size_t i = 0; i < NUM_ACTUATORS; i++){
@@ -120,7 +126,12 @@ void HopperActuatorModel::getMassMatrix(sejong::Matrix &M_act){
 }
 
 void HopperActuatorModel::getDampingMatrix(sejong::Matrix &B_act){
-	B_act.resize(NUM_TOTAL_STATES, NUM_TOTAL_STATES);
+	Hopper_Actuator_Dimensions::Matrix_states B_act_fixed;
+	getDampingMatrix(B_act_fixed);
+	B_act = B_act_fixed;
+}
+
+void HopperActuatorModel::getDampingMatrix(Hopper_Actuator_Dimensions::Matrix_states &B_act){
 	B_act.setZero();
 /*	// Assign block diagonally
 	for(size_t i = 0; i < NUM_ACTUATORS; i++){
@@ -144,7 +155,12 @@ void HopperActuatorModel::getDampingMatrix(sejong::Matrix &B_act){
 }
 
 void HopperActuatorModel::getStiffnessMatrix(sejong::Matrix &K_act){
-	K_act.resize(NUM_TOTAL_STATES, NUM_TOTAL_STATES);
+	Hopper_Actuator_Dimensions::Matrix_states K_act_fixed;
+	getStiffnessMatrix(K_act_fixed);
+	K_act = K_act_fixed;
+}
+
+void HopperActuatorModel::getStiffnessMatrix(Hopper_Actuator_Dimensions::Matrix_states &K_act){
 	K_act.setZero();
 	// Assign block diagonally	
 /*	for(size_t i = 0; i < NUM_ACTUATORS; i++){
@@ -177,7 +193,7 @@ void HopperActuatorModel::set_zero_pos_q_o(sejong::Vector &q_o_in){
 // Simple Relationship between actuator position and joint position
 // (z - z_o) = r*(q - q_o) 
 double HopperActuatorModel::get_joint_pos_q(const int &index, const double &z_act_pos){
-	return (z_act_pos - z_o[index])/r_arm[index] + q_o[index];
+	return get_joint_pos_q<double>(index, z_act_pos);
 }
 
 double HopperActuatorModel::get_joint_vel_qdot(const int &index, const double z_act_pos, const double &z_act_vel){
@@ -191,49 +207,55 @@ double HopperActuatorModel::get_act_pos_z(const int &index, const double &q_act_
 }
 
 double HopperActuatorModel::getJacobian_dqdz(const int &index, const double &q_act_pos){
-	return 1.0/r_arm[index];
+	return getJacobian_dqdz<double>(index, q_act_pos);
 }
 
 // dz/dq = r 
 double HopperActuatorModel::getJacobian_dzdq(const int &index, const double &z_act_pos){
-	return r_arm[index];
+	return getJacobian_dzdq<double>(index, z_act_pos);
 }
 // -----------------------------------------------------------------------------
 
 void HopperActuatorModel::getFullJacobian_dzdq(const sejong::Vector &z_pos, sejong::Matrix &L){
-	L.resize(NUM_ACTUATORS, NUM_ACTUATORS);
-	L.setIdentity();
-	for(size_t i = 0; i < NUM_ACTUATORS; i++){
-		L(i,i) = getJacobian_dzdq(i, z_pos[i]); 
-	}
+	Hopper_Actuator_Dimensions::Matrix_act L_fixed;
+	getFullJacobian_dzdq(Hopper_Actuator_Dimensions::Vector_act(z_pos), L_fixed);
+	L = L_fixed;
+}
+
+void HopperActuatorModel::getFullJacobian_dzdq(const Hopper_Actuator_Dimensions::Vector_act &z_pos, Hopper_Actuator_Dimensions::Matrix_act &L){
+	getFullJacobian_dzdq<double>(z_pos, L);
 }
 
 void HopperActuatorModel::getFullJacobian_dqdz(const sejong::Vector &q_pos, sejong::Matrix &J){
-	J.resize(NUM_ACTUATORS, NUM_ACTUATORS);
-	J.setIdentity();
-	for(size_t i = 0; i < NUM_ACTUATORS; i++){
-		J(i,i) = getJacobian_dqdz(i, q_pos[i]); 
-	}
+	Hopper_Actuator_Dimensions::Matrix_act J_fixed;
+	getFullJacobian_dqdz(Hopper_Actuator_Dimensions::Vector_act(q_pos), J_fixed);
+	J = J_fixed;
+}
+
+void HopperActuatorModel::getFullJacobian_dqdz(const Hopper_Actuator_Dimensions::Vector_act &q_pos, Hopper_Actuator_Dimensions::Matrix_act &J){
+	getFullJacobian_dqdz<double>(q_pos, J);
 }
 
 
 void HopperActuatorModel::getFull_joint_pos_q(const sejong::Vector &z_in, sejong::Vector &q_out){
-	q_out.resize(NUM_ACTUATORS);
-	q_out.setZero();
+	Hopper_Actuator_Dimensions::Vector_act q_fixed;
+	getFull_joint_pos_q(Hopper_Actuator_Dimensions::Vector_act(z_in), q_fixed);
+	q_out = q_fixed;
+}
 
-	double z_val = 0.0;
-	for(int i = 0; i < NUM_ACTUATORS; i++){
-		z_val = z_in[i];
-		q_out[i] = get_joint_pos_q(i, z_val);
-	}	
+void HopperActuatorModel::getFull_joint_pos_q(const Hopper_Actuator_Dimensions::Vector_act &z_in, Hopper_Actuator_Dimensions::Vector_act &q_out){
+	getFull_joint_pos_q<double>(z_in, q_out);
 }
 
 void HopperActuatorModel::getFull_joint_vel_qdot(const sejong::Vector &z_in, const sejong::Vector &zdot_in, sejong::Vector &qdot_out){
-	qdot_out.resize(NUM_ACTUATORS);
-	qdot_out.setZero();
-	for(int i = 0; i < NUM_ACTUATORS; i++){
-		qdot_out[i] = get_joint_vel_qdot(i, z_in[i], zdot_in[i]);
-	}	
+	Hopper_Actuator_Dimensions::Vector_act qdot_fixed;
+	getFull_joint_vel_qdot(Hopper_Actuator_Dimensions::Vector_act(z_in), Hopper_Actuator_Dimensions::Vector_act(zdot_in), qdot_fixed);
+	qdot_out = qdot_fixed;
+}
+
+void HopperActuatorModel::getFull_joint_vel_qdot(const Hopper_Actuator_Dimensions::Vector_act &z_in, const Hopper_Actuator_Dimensions::Vector_act &zdot_in, 
+												 Hopper_Actuator_Dimensions::Vector_act &qdot_out){
+	getFull_joint_vel_qdot<double>(z_in, zdot_in, qdot_out);
 }
 
 
@@ -249,7 +271,13 @@ void HopperActuatorModel::getFull_act_pos_z(const sejong::Vector &q_in, sejong::
 }
 
 void HopperActuatorModel::getKm_Matrix(sejong::Matrix &Km_act){
-	Km_act = sejong::Matrix::Identity(NUM_ACTUATORS, NUM_ACTUATORS);
+	Hopper_Actuator_Dimensions::Matrix_act Km_fixed;
+	getKm_Matrix(Km_fixed);
+	Km_act = Km_fixed;
+}
+
+void HopperActuatorModel::getKm_Matrix(Hopper_Actuator_Dimensions::Matrix_act &Km_act){
+	Km_act.setIdentity();
 	for(int i = 0; i < NUM_ACTUATORS; i++){
 		Km_act(i, i) = K_m[i];
 	}	
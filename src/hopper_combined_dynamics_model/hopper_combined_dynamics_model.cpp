@@ -1,12 +1,14 @@
 #include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
 #include <Utils/utilities.hpp>
-#include <Utils/pseudo_inverse.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
+#include <optimization/parallel/knotpoint_batch.hpp>
 
 #include "Hopper_Definition.h"
 
 
 Hopper_Combined_Dynamics_Model* Hopper_Combined_Dynamics_Model::GetCombinedModel(){
-    static Hopper_Combined_Dynamics_Model combined_dynamics_model;
+    static const Hopper_Combined_Dynamics_Model combined_dynamics_model_prototype;
+    thread_local Hopper_Combined_Dynamics_Model combined_dynamics_model(combined_dynamics_model_prototype);
     return & combined_dynamics_model;
 }
 
@@ -19,6 +21,26 @@ Hopper_Combined_Dynamics_Model::Hopper_Combined_Dynamics_Model(){
 	std::cout << "[Hopper_Combined_Dynamics_Model] Constructed" << std::endl;
 }
 
+Hopper_Combined_Dynamics_Model::Hopper_Combined_Dynamics_Model(const Hopper_Combined_Dynamics_Model &other):
+	robot_model(HopperModel::GetRobotModel()), actuator_model(HopperActuatorModel::GetActuatorModel()),
+	M_combined(other.M_combined), M_combined_lu(other.M_combined_lu), B_combined(other.B_combined), K_combined(other.K_combined),
+	M_act(other.M_act), M_zz(other.M_zz), M_z_delta(other.M_z_delta), M_delta_z(other.M_delta_z), M_delta_delta(other.M_delta_delta),
+	B_act(other.B_act), B_zz(other.B_zz), B_z_delta(other.B_z_delta), B_delta_z(other.B_delta_z), B_delta_delta(other.B_delta_delta),
+	K_act(other.K_act), K_zz(other.K_zz), K_z_delta(other.K_z_delta), K_delta_z(other.K_delta_z), K_delta_delta(other.K_delta_delta),
+	Km_act(other.Km_act),
+	A_mat(other.A_mat), A_bb(other.A_bb), A_br(other.A_br), A_brT(other.A_brT), A_rr(other.A_rr),
+	grav(other.grav), coriolis(other.coriolis),
+	Sv(other.Sv), Sa(other.Sa),
+	Jc(other.Jc), L(other.L), J(other.J),
+	x_state(other.x_state), xdot_state(other.xdot_state),
+	z_state(other.z_state), zdot_state(other.zdot_state),
+	q_virt_state(other.q_virt_state), qdot_virt_state(other.qdot_virt_state),
+	q_act(other.q_act), qdot_act(other.qdot_act),
+	q_state(other.q_state), qdot_state(other.qdot_state),
+	total_imp(other.total_imp), virt_imp(other.virt_imp), current_input(other.current_input), joint_imp(other.joint_imp),
+	model_updated(other.model_updated){
+}
+
 
 
 void Hopper_Combined_Dynamics_Model::Initialization(){
@@ -74,14 +96,13 @@ void Hopper_Combined_Dynamics_Model::Initialization(){
 
 	// Initialize Combined Matrices
 	M_combined.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); M_combined.setZero();
-	M_combined_inv.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); M_combined_inv.setZero();
 
 	B_combined.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); B_combined.setZero();
 	K_combined.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); K_combined.setZero();
 
 	// Initialize x, xdot vectors
-	x_state.resize(NUM_QDOT + NUM_ACT_JOINT + NUM_ACT_JOINT); x_state.setZero();
-	xdot_state.resize(NUM_QDOT + NUM_ACT_JOINT + NUM_ACT_JOINT); xdot_state.setZero();
+	x_state.setZero();
+	xdot_state.setZero();
 
 	// Initialize z, zdot vectors
 	z_state.resize(NUM_ACT_JOINT); z_state.setZero();
@@ -108,16 +129,26 @@ void Hopper_Combined_Dynamics_Model::Initialization(){
 
 }
 
-void Hopper_Combined_Dynamics_Model::initialize_actuator_matrices(sejong::Matrix &Mat){
-	Mat.resize(NUM_ACT_JOINT, NUM_ACT_JOINT); Mat.setZero();
+void Hopper_Combined_Dynamics_Model::initialize_actuator_matrices(Hopper_Actuator_Dimensions::Matrix_act &Mat){
+	Mat.setZero();
+}
+
+bool Hopper_Combined_Dynamics_Model::is_model_updated(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in){
+	return model_updated && (x_state == x_state_in) && (xdot_state == xdot_state_in);
 }
 
 void Hopper_Combined_Dynamics_Model::UpdateModel(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in){
+	OPT_PROFILE_SCOPE("model", "Hopper_Combined_Dynamics_Model::UpdateModel");
+	// Constraints update the model before calling getDynamics_constraint, which updates it again
+	if (is_model_updated(x_state_in, xdot_state_in)){
+		return;
+	}
+	model_updated = false;
 	x_state = x_state_in;
 	xdot_state = xdot_state_in;
 
 	// Convert x to q
-	convert_x_xdot_to_q_qdot(x_state, xdot_state, q_state, qdot_state);
+	update_q_qdot_states();
 
 	// Update the Robot's Model
 	robot_model->UpdateModel(q_state, qdot_state);
@@ -125,6 +156,29 @@ void Hopper_Combined_Dynamics_Model::UpdateModel(const sejong::Vector &x_state_i
     robot_model->getGravity(grav);
     robot_model->getCoriolis(coriolis);
 
+	update_combined_matrices();
+	model_updated = true;
+}
+
+void Hopper_Combined_Dynamics_Model::UpdateModel(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in, const Hopper_Dimensions::Matrix_qdot &A_in,
+												 const Hopper_Dimensions::Vector_qdot &grav_in, const Hopper_Dimensions::Vector_qdot &coriolis_in){
+	if (is_model_updated(x_state_in, xdot_state_in)){
+		return;
+	}
+	model_updated = false;
+	x_state = x_state_in;
+	xdot_state = xdot_state_in;
+	update_q_qdot_states();
+
+	A_mat = A_in;
+	grav = grav_in;
+	coriolis = coriolis_in;
+
+	update_combined_matrices();
+	model_updated = true;
+}
+
+void Hopper_Combined_Dynamics_Model::update_combined_matrices(){
 	actuator_model->getFullJacobian_dzdq(z_state, L);
 	actuator_model->getFullJacobian_dqdz(q_state.tail(NUM_ACT_JOINT), J);	   
 
@@ -163,13 +217,7 @@ void Hopper_Combined_Dynamics_Model::formulate_mass_matrix(){
 	M_delta_z = M_act.block(NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
 	M_delta_delta = M_act.block(NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);	
 
-	M_combined.block(0, 0, NUM_VIRTUAL, NUM_VIRTUAL) = A_bb;
-	M_combined.block(0, NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT) = A_br*J;
-	M_combined.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = M_zz;
-	M_combined.block(NUM_VIRTUAL, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = M_z_delta;	
-	M_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_VIRTUAL) = A_brT;
-	M_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_VIRTUAL) = A_rr*J + L.transpose()*M_delta_z;	
-	M_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = L.transpose()*M_delta_delta;	
+	formulate_mass_matrix(A_mat, L, J, M_act, M_combined);
 
 //	sejong::pretty_print(M_combined, std::cout, "M_combined");
 }
@@ -180,10 +228,7 @@ void Hopper_Combined_Dynamics_Model::formulate_damping_matrix(){
 	B_delta_z = B_act.block(NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
 	B_delta_delta = B_act.block(NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);	
 
-	B_combined.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = B_zz;
-	B_combined.block(NUM_VIRTUAL, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = B_z_delta;	
-	B_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_VIRTUAL) = L.transpose()*B_delta_z;
-	B_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = L.transpose()*B_delta_delta;	
+	formulate_damping_matrix(L, B_act, B_combined);
 
 //	sejong::pretty_print(B_combined, std::cout, "B_combined");
 }	
@@ -194,10 +239,7 @@ void Hopper_Combined_Dynamics_Model::formulate_stiffness_matrix(){
 	K_delta_z = K_act.block(NUM_ACT_JOINT, 0, NUM_ACT_JOINT, NUM_ACT_JOINT);
 	K_delta_delta = K_act.block(NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT);	
 
-	K_combined.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = K_zz;
-	K_combined.block(NUM_VIRTUAL, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = K_z_delta;	
-	K_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_VIRTUAL) = L.transpose()*K_delta_z;
-	K_combined.block(NUM_VIRTUAL + NUM_ACT_JOINT, NUM_VIRTUAL + NUM_ACT_JOINT, NUM_ACT_JOINT, NUM_ACT_JOINT) = L.transpose()*K_delta_delta;	
+	formulate_stiffness_matrix(L, K_act, K_combined);
 
 //	sejong::pretty_print(K_act, std::cout, "K_act");
 //	sejong::pretty_print(K_combined, std::cout, "K_combined");
@@ -236,6 +278,22 @@ void Hopper_Combined_Dynamics_Model::convert_x_xdot_to_q_qdot(const sejong::Vect
 	sejong::pretty_print(qdot_state_out, std::cout, "qdot_state_out");	*/
 }
 
+void Hopper_Combined_Dynamics_Model::update_q_qdot_states(){
+	// Same as convert_x_xdot_to_q_qdot but stays on the fixed-size members
+	q_virt_state = x_state.head(NUM_VIRTUAL);
+	z_state = x_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+	qdot_virt_state = xdot_state.head(NUM_VIRTUAL);
+	zdot_state = xdot_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+
+	actuator_model->getFull_joint_pos_q(z_state, q_act);
+	actuator_model->getFull_joint_vel_qdot(zdot_state, zdot_state, qdot_act);
+
+	q_state.head(NUM_VIRTUAL) = q_virt_state;
+	q_state.tail(NUM_ACT_JOINT) = q_act;
+	qdot_state.head(NUM_VIRTUAL) = qdot_virt_state;	
+	qdot_state.tail(NUM_ACT_JOINT) = qdot_act;	
+}
+
 void Hopper_Combined_Dynamics_Model::convert_x_to_q(const sejong::Vector &x_state, sejong::Vector &q_state_out){
 	q_virt_state = x_state.head(NUM_VIRTUAL);
 	z_state = x_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
@@ -260,7 +318,7 @@ void Hopper_Combined_Dynamics_Model::convert_xdot_to_qdot(const sejong::Vector &
 	qdot_state_out.tail(NUM_ACT_JOINT) = qdot_act;	
 }
 
-void Hopper_Combined_Dynamics_Model::setContactJacobian(sejong::Matrix &Jc_in){
+void Hopper_Combined_Dynamics_Model::setContactJacobian(const Hopper_Dimensions::Matrix_contact_jacobian &Jc_in){
 	Jc = Jc_in;
 	//sejong::pretty_print(Jc, std::cout, "Jc_in");
 }
@@ -268,11 +326,12 @@ void Hopper_Combined_Dynamics_Model::setContactJacobian(sejong::Matrix &Jc_in){
 void Hopper_Combined_Dynamics_Model::get_state_acceleration(const sejong::Vector &x_state_in, const::sejong::Vector &xdot_state_in, 
 							    						   const sejong::Vector &u_current_in, const::sejong::Vector &Fr_state_in,
 							    						   sejong::Vector &xddot_state_out){
+	OPT_PROFILE_SCOPE("model", "Hopper_Combined_Dynamics_Model::get_state_acceleration");
 	UpdateModel(x_state_in, xdot_state_in);
-    sejong::pseudoInverse(M_combined, 1.e-10, M_combined_inv, 0);
+    M_combined_lu.compute(M_combined);
     formulate_joint_link_impedance(Fr_state_in);
 
-    sejong::Vector total_input; total_input.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); total_input.setZero();
+    Hopper_Combined_Dimensions::Vector_x total_input;
     total_input.head(NUM_VIRTUAL) = virt_imp - A_br*J*xdot_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
     total_input.segment(NUM_VIRTUAL, NUM_ACT_JOINT) = Km_act*u_current_in;
     total_input.tail(NUM_ACT_JOINT) = joint_imp;
@@ -293,17 +352,18 @@ void Hopper_Combined_Dynamics_Model::get_state_acceleration(const sejong::Vector
     // sejong::pretty_print(u_current_in, std::cout, "u_current_in");
     // sejong::pretty_print(total_input, std::cout, "total_input");
 
-    xddot_state_out = M_combined_inv*(total_input - B_combined*xdot_state_in - K_combined*x_state_in);
+    xddot_state_out = M_combined_lu.solve(total_input - B_combined*xdot_state_in - K_combined*x_state_in);
 
 }
 
 void Hopper_Combined_Dynamics_Model::getDynamics_constraint(const sejong::Vector &x_state_in, const sejong::Vector &xdot_state_in, const sejong::Vector &xddot_state_in,
 						  							       const sejong::Vector &u_current_in, const sejong::Vector &Fr_state_in, sejong::Vector &dynamics_out){
+	OPT_PROFILE_SCOPE("model", "Hopper_Combined_Dynamics_Model::getDynamics_constraint");
 
 	UpdateModel(x_state_in, xdot_state_in);
     formulate_joint_link_impedance(Fr_state_in);
 
-    sejong::Vector total_input; total_input.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); total_input.setZero();
+    Hopper_Combined_Dimensions::Vector_x total_input;
     total_input.head(NUM_VIRTUAL) = virt_imp - A_br*J*xdot_state_in.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
     total_input.segment(NUM_VIRTUAL, NUM_ACT_JOINT) = Km_act*u_current_in;
     total_input.tail(NUM_ACT_JOINT) = joint_imp;
@@ -323,12 +383,9 @@ void Hopper_Combined_Dynamics_Model::getDynamics_constraint(const sejong::Vector
     dynamics_out = M_combined*xddot_state_in + B_combined*xdot_state_in +K_combined*x_state_in - total_input;    
 //    dynamics_out += M_combined*xddot_state_in + B_combined*xdot_state_in + K_combined*x_state_in;
 
-    sejong::pretty_print(grav, std::cout, "grav");
-
     // sejong::pretty_print(xddot_state_in, std::cout, "xddot_state_in");
     // sejong::pretty_print(virt_forces, std::cout, "virt_forces");
     // sejong::pretty_print(total_input, std::cout, "total_input");    
-    sejong::pretty_print(Fr_state_in, std::cout, "Fr_state_in");
     // sejong::pretty_print(u_current_in, std::cout, "u_current_in");
     // sejong::pretty_print(dynamics_out, std::cout, "dynamics_out");
 
@@ -351,19 +408,93 @@ void Hopper_Combined_Dynamics_Model::getDynamics_constraint(const sejong::Vector
 
 void Hopper_Combined_Dynamics_Model::getDynamics_constraint(const sejong::Vector &x_state_k, const sejong::Vector &xdot_state_k, const sejong::Vector &xdot_state_k_prev, 
                                                            const sejong::Vector &u_current_k, const sejong::Vector &Fr_state_k, double h_k, sejong::Vector &dynamics_out){
-    // Update the model and impedances
+    // Update the model and impedances. x_state and xdot_state now hold x_k and xdot_k.
+    UpdateModel(x_state_k, xdot_state_k);
+    formulate_joint_link_impedance(Fr_state_k);
+    // The same assembly as the templated version, from the cached matrices
+    Hopper_Combined_Dimensions::Vector_x dynamics_k;
+    formulate_dynamics_constraint<double>(M_combined, B_combined, K_combined, A_br, J, Km_act, total_imp, x_state, xdot_state, xdot_state_k_prev,
+                                          u_current_k, h_k, dynamics_k);
+    dynamics_out = dynamics_k;
+}
+
+void Hopper_Combined_Dynamics_Model::getDynamics_constraint_batch(const Hopper_Act_Dynamics_Batch &batch, Hopper_Act_Dynamics_Batch::Matrix_x_batch &dynamics_out){
+    OPT_PROFILE_SCOPE("model", "Hopper_Combined_Dynamics_Model::getDynamics_constraint_batch");
+    const int num_knotpoints = batch.x.rows();
+    dynamics_out.resize(num_knotpoints, Hopper_Combined_Dimensions::num_x);
+    if (num_knotpoints == 0){
+        return;
+    }
+    // The matrices do not depend on the state, so one update serves every knotpoint
+    UpdateModel(batch.x.row(0).transpose(), batch.xdot.row(0).transpose());
+
+    // Same inputs as the single knotpoint version, one knotpoint per row. total_imp^T = Fr^T*Jc - (coriolis + grav)^T
+    static thread_local Eigen::Matrix<double, Eigen::Dynamic, NUM_QDOT> total_imp_batch;
+    static thread_local Hopper_Act_Dynamics_Batch::Matrix_x_batch total_input_batch;
+    static thread_local Hopper_Act_Dynamics_Batch::Matrix_x_batch impedance_batch;
+    total_imp_batch.setZero(num_knotpoints, NUM_QDOT);
+    batch_add_product(batch.Fr, Jc, total_imp_batch);
+    total_imp_batch.rowwise() -= (coriolis + grav).transpose();
+
+    const Hopper_Combined_Dimensions::Matrix_virtual_act A_br_J = A_br*J;
+    total_input_batch.setZero(num_knotpoints, Hopper_Combined_Dimensions::num_x);
+    total_input_batch.leftCols(NUM_VIRTUAL) = total_imp_batch.leftCols(NUM_VIRTUAL);
+    batch_add_product(batch.xdot.middleCols(NUM_VIRTUAL, NUM_ACT_JOINT), -A_br_J.transpose(), total_input_batch.leftCols(NUM_VIRTUAL));
+    batch_add_product(batch.u, Km_act.transpose(), total_input_batch.middleCols(NUM_VIRTUAL, NUM_ACT_JOINT));
+    total_input_batch.rightCols(NUM_ACT_JOINT) = total_imp_batch.rightCols(NUM_ACT_JOINT);
+
+    // B*xdot + K*x - total_input
+    impedance_batch = -total_input_batch;
+    batch_add_product(batch.xdot, B_combined.transpose(), impedance_batch);
+    batch_add_product(batch.x, K_combined.transpose(), impedance_batch);
+
+    dynamics_out.setZero();
+    batch_add_product(batch.xdot - batch.xdot_prev, M_combined.transpose(), dynamics_out);
+    dynamics_out += batch.h.asDiagonal()*impedance_batch;
+}
+
+void Hopper_Combined_Dynamics_Model::getDynamics_constraint_gradient(const sejong::Vector &x_state_k, const sejong::Vector &xdot_state_k, const sejong::Vector &xdot_state_k_prev, 
+                                                                     const sejong::Vector &u_current_k, const sejong::Vector &Fr_state_k, double h_k,
+                                                                     sejong::Matrix &dF_dx_k, sejong::Matrix &dF_dxdot_k, sejong::Matrix &dF_dxdot_k_prev,
+                                                                     sejong::Matrix &dF_du_k, sejong::Matrix &dF_dFr_k, sejong::Vector &dF_dh_k){
+    // The hopper's inertia, gravity and contact Jacobian do not depend on q and the actuator 
+    // maps dq/dz, dz/dq are constant. So M_combined, B_combined and K_combined are constant.
     UpdateModel(x_state_k, xdot_state_k);
     formulate_joint_link_impedance(Fr_state_k);
-    // Construct the dynamics input and impedances
-    sejong::Vector total_input; total_input.resize(NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); total_input.setZero();
-    total_input.head(NUM_VIRTUAL) = virt_imp - A_br*J*xdot_state_k.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+
+    const int num_x = Hopper_Combined_Dimensions::num_x;
+    Hopper_Combined_Dimensions::Vector_x total_input;
+    total_input.head(NUM_VIRTUAL) = virt_imp - A_br*J*xdot_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
     total_input.segment(NUM_VIRTUAL, NUM_ACT_JOINT) = Km_act*u_current_k;
-    total_input.tail(NUM_ACT_JOINT) = joint_imp  ;  
+    total_input.tail(NUM_ACT_JOINT) = joint_imp;  
+
+    // The virtual rows of the input contain -A_br*J*zdot_k
+    Hopper_Combined_Dimensions::Matrix_x P_input = Hopper_Combined_Dimensions::Matrix_x::Zero();
+    P_input.block(0, NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT) = A_br*J;
 
-    dynamics_out = M_combined*(xdot_state_k - xdot_state_k_prev) + h_k*(B_combined*xdot_state_k + K_combined*x_state_k - total_input);    
+    dF_dx_k = h_k*K_combined;
+    dF_dxdot_k = M_combined + h_k*(B_combined + P_input);
+    dF_dxdot_k_prev = -M_combined;
 
-    sejong::Vector xddot_est = (xdot_state_k - xdot_state_k_prev) / h_k;
-    //sejong::pretty_print(xddot_est, std::cout, "xddot_est");
-    //sejong::pretty_print(Fr_state_k, std::cout, "Fr_state_k");
+    dF_du_k = sejong::Matrix::Zero(num_x, NUM_ACT_JOINT);
+    dF_du_k.block(NUM_VIRTUAL, 0, NUM_ACT_JOINT, NUM_ACT_JOINT) = -h_k*Km_act;
 
-}
\ No newline at end of file
+    dF_dFr_k = sejong::Matrix::Zero(num_x, Fr_state_k.size());
+    dF_dFr_k.topRows(NUM_VIRTUAL) = -h_k*Sv*Jc.transpose();
+    dF_dFr_k.bottomRows(NUM_ACT_JOINT) = -h_k*Sa*Jc.transpose();
+
+    dF_dh_k = B_combined*xdot_state + K_combined*x_state - total_input;
+}
+
+void Hopper_Combined_Dynamics_Model::getJacobian_dq_dx(const sejong::Vector &x_state, sejong::Matrix &dq_dx_out){
+	// q = [q_virt, q_act(z)]. The spring deflections do not change q.
+	Hopper_Actuator_Dimensions::Vector_act z_pos = x_state.segment(NUM_VIRTUAL, NUM_ACT_JOINT);
+	Hopper_Actuator_Dimensions::Vector_act q_act_pos;
+	Hopper_Actuator_Dimensions::Matrix_act J_dqdz;
+	actuator_model->getFull_joint_pos_q(z_pos, q_act_pos);
+	actuator_model->getFullJacobian_dqdz(q_act_pos, J_dqdz);
+
+	dq_dx_out = sejong::Matrix::Zero(NUM_QDOT, x_state.size());
+	dq_dx_out.block(0, 0, NUM_VIRTUAL, NUM_VIRTUAL) = sejong::Matrix::Identity(NUM_VIRTUAL, NUM_VIRTUAL);
+	dq_dx_out.block(NUM_VIRTUAL, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = J_dqdz;
+}
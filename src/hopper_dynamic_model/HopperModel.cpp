@@ -4,7 +4,8 @@
 #include <stdio.h>
 
 HopperModel* HopperModel::GetRobotModel(){
-    static HopperModel hopper_model;
+    static const HopperModel hopper_model_prototype;
+    thread_local HopperModel hopper_model(hopper_model_prototype);
     return & hopper_model;
 }
 
@@ -14,7 +15,7 @@ HopperModel::HopperModel(){
 	m_leg = 1; //kg	
 
 
-    A_int = sejong::Matrix::Zero(NUM_QDOT, NUM_QDOT);
+    A_int.setZero();
     A_int(0,0) = m_base;
     A_int(0,1) = m_leg;
     A_int(1,0) = m_leg;    
@@ -27,6 +28,12 @@ HopperModel::~HopperModel(){
 
 bool HopperModel::getMassInertia(sejong::Matrix & A){
 	A = A_int;
+	return true;
+}
+
+bool HopperModel::getMassInertia(Hopper_Dimensions::Matrix_qdot & A){
+	A = A_int;
+	return true;
 }
 
 bool HopperModel::getInverseMassInertia(sejong::Matrix & Ainv){
@@ -38,31 +45,36 @@ bool HopperModel::getInverseMassInertia(sejong::Matrix & Ainv){
 
 	double det = (m_base*m_leg - m_leg*m_leg);
 	Ainv *= (1.0/det);
+	return true;
 }
 
 
 bool HopperModel::getGravity(Vector & grav){
-	grav = sejong::Vector::Zero(NUM_QDOT);
+	Hopper_Dimensions::Vector_qdot grav_fixed;
+	getGravity(grav_fixed);
+	grav = grav_fixed;
+	return true;
+}
+
+bool HopperModel::getGravity(Hopper_Dimensions::Vector_qdot & grav){
 	grav[0] = (m_base + m_leg)*grav_const;
 	grav[1] = (m_leg)*grav_const;	
+	return true;
 }
 
 bool HopperModel::getCoriolis(Vector & coriolis){
 	coriolis = sejong::Vector::Zero(NUM_QDOT);
+	return true;
+}
+
+bool HopperModel::getCoriolis(Hopper_Dimensions::Vector_qdot & coriolis){
+	coriolis.setZero();
+	return true;
 }
 
 void HopperModel::getPosition(const Vector & q, int link_id, sejong::Vector & pos){
 	pos = sejong::Vector::Zero(1);
-	if (link_id == SJ_Hopper_LinkID::LK_body){
-		// std::cout << "[HopperModel] Body Position" << std::endl;
-		pos[0] = q[0];
-	}else if(link_id == SJ_Hopper_LinkID::LK_leg){
-		// std::cout << "[HopperModel] Leg Position" << std::endl;
-		pos[0] = q[0] + q[1]/2.0;		
-	}else if(link_id == SJ_Hopper_LinkID::LK_foot){
-		// std::cout << "[HopperModel] Foot Position" << std::endl;
-		pos[0] = q[0] + q[1];		
-	}
+	pos[0] = getPosition(Hopper_Dimensions::Vector_q(q), link_id);
 }
 
 void HopperModel::getFullJacobian(const Vector & q, int link_id, sejong::Matrix & J){
@@ -84,3 +96,4 @@ void HopperModel::getFullJacobian(const Vector & q, int link_id, sejong::Matrix
 
 void HopperModel::UpdateKinematics(const Vector & q, const Vector &qdot){}
 void HopperModel::UpdateModel(const sejong::Vector & q, const sejong::Vector & qdot){}
+void HopperModel::UpdateModel(const Hopper_Dimensions::Vector_q & q, const Hopper_Dimensions::Vector_qdot & qdot){}
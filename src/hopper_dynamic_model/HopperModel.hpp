@@ -4,13 +4,19 @@
 #include <rbdl/rbdl.h>
 #include <Utils/wrap_eigen.hpp>
 #include "Hopper_Definition.h"
+#include <robot_dimensions/robot_dimensions.hpp>
 
 using namespace sejong;
 
+// The hopper has a single contact with 1 row
+typedef Robot_Dimensions<NUM_Q, NUM_QDOT, NUM_VIRTUAL, 1> Hopper_Dimensions;
+
 class HopperModel{
 public:
     // EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    // Returns the calling thread's model. Each thread gets its own copy so that UpdateModel calls do not race.
     static HopperModel* GetRobotModel();
+    HopperModel(const HopperModel &other) = default;
     virtual ~HopperModel(void);
 
     bool getMassInertia(sejong::Matrix & A);
@@ -18,6 +24,40 @@ public:
     bool getGravity(Vector & grav) ;
     bool getCoriolis(Vector & coriolis) ;
 
+    // Fixed-size versions for the constraint hot paths
+    bool getMassInertia(Hopper_Dimensions::Matrix_qdot & A);
+    bool getGravity(Hopper_Dimensions::Vector_qdot & grav);
+    bool getCoriolis(Hopper_Dimensions::Vector_qdot & coriolis);
+
+    // Templated on the scalar type for automatic differentiation, eg: with Dual<N>.
+    // The hopper's inertia and gravity do not depend on q, but they take q like a general robot model.
+    template <typename Scalar>
+    void getMassInertia(const Eigen::Matrix<Scalar, NUM_Q, 1> & q, Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> & A){
+        A = A_int.template cast<Scalar>();
+    }
+    template <typename Scalar>
+    void getGravity(const Eigen::Matrix<Scalar, NUM_Q, 1> & q, Eigen::Matrix<Scalar, NUM_QDOT, 1> & grav){
+        grav[0] = Scalar((m_base + m_leg)*grav_const);
+        grav[1] = Scalar((m_leg)*grav_const);
+    }
+    template <typename Scalar>
+    void getCoriolis(const Eigen::Matrix<Scalar, NUM_Q, 1> & q, const Eigen::Matrix<Scalar, NUM_QDOT, 1> & qdot,
+                     Eigen::Matrix<Scalar, NUM_QDOT, 1> & coriolis){
+        coriolis.setZero();
+    }
+    // Vertical position of the link
+    template <typename Scalar>
+    Scalar getPosition(const Eigen::Matrix<Scalar, NUM_Q, 1> & q, int link_id){
+        if (link_id == SJ_Hopper_LinkID::LK_body){
+            return q[0];
+        }else if (link_id == SJ_Hopper_LinkID::LK_leg){
+            return q[0] + q[1]/2.0;
+        }else if (link_id == SJ_Hopper_LinkID::LK_foot){
+            return q[0] + q[1];
+        }
+        return Scalar(0.0);
+    }
+
     // virtual void getCentroidJacobian(sejong::Matrix & Jcent);
     // virtual void getCentroidInertia(sejong::Matrix & Icent);
     void getPosition(const Vector & q,
@@ -34,13 +74,14 @@ public:
     // void getCoMJacobian(const Vector & q, sejong::Matrix & J);
     void UpdateKinematics(const Vector & q, const Vector &qdot);
     void UpdateModel(const sejong::Vector & q, const sejong::Vector & qdot);
+    void UpdateModel(const Hopper_Dimensions::Vector_q & q, const Hopper_Dimensions::Vector_qdot & qdot);
 
 protected:
     double m_base;
     double m_leg;
     double grav_const = 9.81; // m/s^2
 
-    sejong::Matrix A_int;
+    Hopper_Dimensions::Matrix_qdot A_int;
 
 private:
     HopperModel();
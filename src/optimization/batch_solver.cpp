@@ -0,0 +1,83 @@
+#include <optimization/batch_solver.hpp>
+#include <iostream>
+#include <mutex>
+
+namespace{
+	// SNOPT's print unit is shared by every solve of the process
+	std::mutex print_file_mutex;
+}
+
+Batch_Solver::Batch_Solver(const int &num_concurrent_solves){
+	set_num_concurrent_solves(num_concurrent_solves);
+}
+Batch_Solver::~Batch_Solver(){}
+
+void Batch_Solver::add_problem(const Batch_Problem_Spec &spec){
+	problem_specs.push_back(spec);
+}
+
+void Batch_Solver::clear_problems(){
+	problem_specs.clear();
+}
+
+int Batch_Solver::get_num_problems(){
+	return problem_specs.size();
+}
+
+void Batch_Solver::set_num_concurrent_solves(const int &num_concurrent_solves){
+	thread_pool.set_num_threads(num_concurrent_solves);
+}
+
+int Batch_Solver::get_num_concurrent_solves(){
+	return thread_pool.get_num_threads();
+}
+
+void Batch_Solver::set_print_file_prefix(const std::string &prefix){
+	print_file_prefix = prefix;
+}
+
+void Batch_Solver::solve_all(std::vector<snopt_wrapper::Solve_Result> &results_out){
+	results_out.clear();
+	results_out.resize(problem_specs.size());
+
+	thread_pool.parallel_for(0, problem_specs.size(), [&](int index){
+		solve_problem(index, results_out[index]);
+	});
+}
+
+void Batch_Solver::solve_problem(const int &index, snopt_wrapper::Solve_Result &result_out){
+	const Batch_Problem_Spec &spec = problem_specs[index];
+	result_out.problem_name = spec.name;
+
+	std::string print_file;
+	if (!print_file_prefix.empty()){
+		print_file = print_file_prefix + "_" + std::to_string(index) + ".out";
+	}
+
+	// A failed problem is reported in its result and does not stop the rest of the batch
+	Optimization_Problem_Main* opt_problem = NULL;
+	std::unique_lock<std::mutex> print_file_lock(print_file_mutex, std::defer_lock);
+	if (!print_file.empty()){
+		print_file_lock.lock();
+	}
+	try{
+		opt_problem = spec.create_problem();
+		opt_problem->set_num_threads(1);
+
+		if (spec.use_gradients){
+			snopt_wrapper::solve_problem_with_gradients(opt_problem, print_file, spec.warm_start, result_out);
+		}else{
+			snopt_wrapper::solve_problem_no_gradients(opt_problem, print_file, spec.warm_start, result_out);
+		}
+		result_out.problem_name = spec.name;
+
+		if (spec.process_result){
+			spec.process_result(opt_problem, result_out);
+		}
+	}catch(...){
+		std::cerr << "[Batch Solver] Error! Problem " << index << " (" << spec.name << ") failed" << std::endl;
+		result_out.exit_code = -1;
+	}
+
+	delete opt_problem;
+}
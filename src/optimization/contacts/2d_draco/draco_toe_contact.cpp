@@ -4,7 +4,6 @@
 // Define LeftFoot Contact ---------------------------------------------------------------
 Draco_Toe_Contact::Draco_Toe_Contact(){
     std::cout << "[Draco Toe Contact] Constructed" << std::endl;
-	robot_model = DracoModel::GetDracoModel();
 	contact_dim = 2;
     contact_name = "Draco Toe Contact";
     contact_link_id = SJLinkID::LK_FootToe;
@@ -14,6 +13,7 @@ Draco_Toe_Contact::~Draco_Toe_Contact(){}
 
 void Draco_Toe_Contact::getContactJacobian(const sejong::Vector &q_state, sejong::Matrix & Jt){
 	sejong::Matrix Jtmp;
+    DracoModel* robot_model = DracoModel::GetDracoModel();
     robot_model->getFullJacobian(q_state, contact_link_id, Jtmp);
     //Jt = Jtmp;
     Jt = Jtmp.block(0, 0, 2, NUM_QDOT);    
@@ -22,6 +22,7 @@ void Draco_Toe_Contact::getContactJacobian(const sejong::Vector &q_state, sejong
 void Draco_Toe_Contact::getContactJacobianDotQdot(const sejong::Vector &q_state, 
   							  			  const sejong::Vector &qdot_state, sejong::Vector & JtDotQdot){
 	sejong::Matrix Jdot_tmp;    
+    DracoModel* robot_model = DracoModel::GetDracoModel();
     robot_model->getFullJacobianDot(q_state, qdot_state, contact_link_id, Jdot_tmp);
     //sejong::Matrix Jdot_task = Jdot_tmp;
     sejong::Matrix Jdot_task = Jdot_tmp.block(0, 0, 2, NUM_QDOT);    
@@ -31,9 +32,18 @@ void Draco_Toe_Contact::getContactJacobianDotQdot(const sejong::Vector &q_state,
 
 void Draco_Toe_Contact::signed_distance_to_contact(const sejong::Vector &q_state, double &distance){
     sejong::Vect3 pos_vec;
+    DracoModel* robot_model = DracoModel::GetDracoModel();
     robot_model->getPosition(q_state, contact_link_id, pos_vec) ;   
 
     // floor contact with the ground
     distance = pos_vec[1];
 }
 
+void Draco_Toe_Contact::getSignedDistanceJacobian(const sejong::Vector &q_state, sejong::Matrix & J_dist){
+    sejong::Matrix Jtmp;
+    DracoModel* robot_model = DracoModel::GetDracoModel();
+    robot_model->getFullJacobian(q_state, contact_link_id, Jtmp);
+
+    // Z row of the (X, Z, Ry) Jacobian
+    J_dist = Jtmp.block(1, 0, 1, NUM_QDOT);
+}
@@ -5,7 +5,6 @@
 // Define LeftFoot Contact ---------------------------------------------------------------
 Hopper_Foot_Contact::Hopper_Foot_Contact(){
     std::cout << "[Hopper_Foot_Contact] Constructed" << std::endl;
-	robot_model = HopperModel::GetRobotModel();
 	contact_dim = 1;
     contact_name = "Hopper_Foot_Contact";
     contact_link_id = SJ_Hopper_LinkID::LK_foot;
@@ -14,6 +13,7 @@ Hopper_Foot_Contact::Hopper_Foot_Contact(){
 Hopper_Foot_Contact::~Hopper_Foot_Contact(){}
 
 void Hopper_Foot_Contact::getContactJacobian(const sejong::Vector &q_state, sejong::Matrix & Jt){
+    HopperModel* robot_model = HopperModel::GetRobotModel();
     robot_model->getFullJacobian(q_state, contact_link_id, Jt);
 }
 
@@ -23,8 +23,14 @@ void Hopper_Foot_Contact::getContactJacobianDotQdot(const sejong::Vector &q_stat
 
 void Hopper_Foot_Contact::signed_distance_to_contact(const sejong::Vector &q_state, double &distance){
 	sejong::Vector pos_vec;
+    HopperModel* robot_model = HopperModel::GetRobotModel();
     robot_model->getPosition(q_state, contact_link_id, pos_vec) ;	
 
     // floor contact with the ground
 	distance = pos_vec[0];
 }
+
+void Hopper_Foot_Contact::getSignedDistanceJacobian(const sejong::Vector &q_state, sejong::Matrix & J_dist){
+    HopperModel* robot_model = HopperModel::GetRobotModel();
+    robot_model->getFullJacobian(q_state, contact_link_id, J_dist);
+}
@@ -21,6 +21,14 @@ int Contact_List::get_size(){
 	return contact_list.size();
 }
 
+int Contact_List::get_total_contact_dim(){
+	int total_contact_dim = 0;
+	for(size_t i = 0; i < contact_list.size(); i++){
+		total_contact_dim += contact_list[i]->contact_dim;
+	}
+	return total_contact_dim;
+}
+
 Contact* Contact_List::get_contact(int index){
 	if ((index >= 0) && (index < contact_list.size())){
 		return contact_list[index];
@@ -1,4 +1,5 @@
 #include <optimization/containers/contact_mode_schedule.hpp>
+#include <optimization/containers/contact_list.hpp>
 #include <iostream>
 
 Contact_Mode_Schedule::Contact_Mode_Schedule(){
@@ -21,6 +22,7 @@ void Contact_Mode_Schedule::add_new_mode(const int &mode_start_time, const int &
 	std::cout << " " << std::endl;
 
 	num_modes++;
+	finalized = false;
 	mode_start_times.push_back(mode_start_time);
 	mode_final_times.push_back(mode_final_time);
 	mode_to_active_contacts.push_back(active_contacts_indices);	
@@ -31,16 +33,96 @@ int Contact_Mode_Schedule::get_num_modes(){
 }
 
 int Contact_Mode_Schedule::get_mode(const int &knotpoint){
+	if (finalized && (knotpoint >= 0) && (knotpoint < knotpoint_to_mode.size())){
+		return knotpoint_to_mode[knotpoint];
+	}
 	for (size_t m = 0; m < num_modes; m++){
 		if ( (mode_start_times[m] <= knotpoint) && (knotpoint <= mode_final_times[m] )){
 			return m;
 		}
 	}
+	// The knotpoint is not covered by any mode
+	return -1;
 }
 
 void Contact_Mode_Schedule::get_active_contacts(const int &knotpoint, std::vector<int> &active_contacts_indices_out){
 	active_contacts_indices_out.clear();
-	if (mode_to_active_contacts.size() > 0){
-		active_contacts_indices_out = mode_to_active_contacts[get_mode(knotpoint)];
+	int mode = get_mode(knotpoint);
+	if (mode >= 0){
+		active_contacts_indices_out = mode_to_active_contacts[mode];
+	}
+}
+
+void Contact_Mode_Schedule::finalize_schedule(Contact_List* contact_list, const int &N_total_knotpoints){
+	int num_contacts = contact_list->get_size();
+	if (num_contacts > 64){
+		std::cerr << "[Contact_Mode_Schedule] Error! " << num_contacts << " contacts do not fit in the 64 bit contact mask" << std::endl;
+		throw "invalid_index";
+	}
+
+	contact_Fr_offsets.clear();
+	int total_contact_dim = 0;
+	for(size_t i = 0; i < num_contacts; i++){
+		contact_Fr_offsets.push_back(total_contact_dim);
+		total_contact_dim += contact_list->get_contact(i)->contact_dim;
+	}
+
+	// get_mode scans the modes until the tables are finalized, so the first matching mode wins as before
+	finalized = false;
+	knotpoint_to_mode.clear();
+	knotpoint_active_contact_masks.clear();
+	knotpoint_Fr_masks.clear();
+	for(int knotpoint = 0; knotpoint <= N_total_knotpoints; knotpoint++){
+		int mode = get_mode(knotpoint);
+		uint64_t contact_mask = 0;
+		sejong::Vector Fr_mask = sejong::Vector::Zero(total_contact_dim);
+		if (mode >= 0){
+			for(size_t i = 0; i < mode_to_active_contacts[mode].size(); i++){
+				int contact_index = mode_to_active_contacts[mode][i];
+				if ((contact_index < 0) || (contact_index >= num_contacts)){
+					std::cerr << "[Contact_Mode_Schedule] Error! Mode " << mode << " has an unknown contact index " << contact_index << std::endl;
+					throw "invalid_index";
+				}
+				contact_mask |= (uint64_t(1) << contact_index);
+				Fr_mask.segment(contact_Fr_offsets[contact_index], contact_list->get_contact(contact_index)->contact_dim).setOnes();
+			}
+		}
+		knotpoint_to_mode.push_back(mode);
+		knotpoint_active_contact_masks.push_back(contact_mask);
+		knotpoint_Fr_masks.push_back(Fr_mask);
+	}
+	finalized = true;
+}
+
+bool Contact_Mode_Schedule::is_finalized(){
+	return finalized;
+}
+
+void Contact_Mode_Schedule::check_finalized_knotpoint(const int &knotpoint){
+	if (!finalized){
+		std::cerr << "[Contact_Mode_Schedule] Error! The schedule has not been finalized" << std::endl;
+		throw "invalid_index";
 	}
+	if ((knotpoint < 0) || (knotpoint >= knotpoint_to_mode.size())){
+		std::cerr << "[Contact_Mode_Schedule] Error! Knotpoint " << knotpoint << " is outside the finalized schedule" << std::endl;
+		throw "invalid_index";
+	}
+}
+
+uint64_t Contact_Mode_Schedule::get_active_contact_mask(const int &knotpoint){
+	check_finalized_knotpoint(knotpoint);
+	return knotpoint_active_contact_masks[knotpoint];
+}
+
+int Contact_Mode_Schedule::get_contact_Fr_offset(const int &contact_index){
+	if (!finalized || (contact_index < 0) || (contact_index >= contact_Fr_offsets.size())){
+		std::cerr << "[Contact_Mode_Schedule] Error! No force offset for contact " << contact_index << std::endl;
+		throw "invalid_index";
+	}
+	return contact_Fr_offsets[contact_index];
+}
+
+const sejong::Vector& Contact_Mode_Schedule::get_active_Fr_mask(const int &knotpoint){
+	check_finalized_knotpoint(knotpoint);
+	return knotpoint_Fr_masks[knotpoint];
 }
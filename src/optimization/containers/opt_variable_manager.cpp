@@ -1,7 +1,11 @@
 #include <optimization/containers/opt_variable_manager.hpp>
 #include <iostream>
+#include <cstring>
+#include <atomic>
 
-Opt_Variable_Manager::Opt_Variable_Manager():total_knotpoints(0){}
+Opt_Variable_Manager::Opt_Variable_Manager():total_knotpoints(0){
+	update_state_version();
+}
 Opt_Variable_Manager::~Opt_Variable_Manager(){
 	for(size_t i = 0; i < opt_var_list.size(); i++){
 		delete opt_var_list[i];
@@ -11,54 +15,44 @@ Opt_Variable_Manager::~Opt_Variable_Manager(){
 }
 
 void Opt_Variable_Manager::append_variable(Opt_Variable* opt_variable){
+	opt_variable->index = opt_var_list.size();
 	opt_var_list.push_back(opt_variable);
 	std::cout << "[Opt_Variable_Manager] Adding " << opt_variable->name 
 			  << " (knotpoint, value, lower, uppers) = " 
 			  << "(" << opt_variable->knotpoint << ", " << opt_variable->value << ", " << opt_variable->l_bound << ", " << opt_variable->u_bound << ")"
 			  << std::endl;	
-	if (opt_variable->type == VAR_TYPE_Q){
-		add_variable_to_map(knotpoint_to_q_state_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_QDOT){
-		add_variable_to_map(knotpoint_to_qdot_state_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_TA){
-		add_variable_to_map(knotpoint_to_xddot_vars, opt_variable);		
-	}else if(opt_variable->type == VAR_TYPE_FR){
-		add_variable_to_map(knotpoint_to_Fr_vars, opt_variable);		
-	}else if(opt_variable->type == VAR_TYPE_KF){
-		add_variable_to_map(knotpoint_to_keyframe_vars, opt_variable);		
-	}else if(opt_variable->type == VAR_TYPE_Z){
-		add_variable_to_map(knotpoint_to_z_vars, opt_variable);					
-	}else if(opt_variable->type == VAR_TYPE_ZDOT){
-		add_variable_to_map(knotpoint_to_zdot_vars, opt_variable);				
-	}else if(opt_variable->type == VAR_TYPE_DELTA){
-		add_variable_to_map(knotpoint_to_delta_vars, opt_variable);				
-	}else if(opt_variable->type == VAR_TYPE_DELTA_DOT){
-		add_variable_to_map(knotpoint_to_delta_dot_vars, opt_variable);				
-	}else if(opt_variable->type == VAR_TYPE_U){
-		add_variable_to_map(knotpoint_to_u_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_BETA){
-		add_variable_to_map(knotpoint_to_beta_vars, opt_variable);						
-	}else if(opt_variable->type == VAR_TYPE_QDDOT_VIRT){
-		add_variable_to_map(knotpoint_to_qddot_virt_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_XDDOT_ALL){
-		add_variable_to_map(knotpoint_to_xddot_all_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_X){
-		add_variable_to_map(knotpoint_to_x_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_XDOT){
-		add_variable_to_map(knotpoint_to_xdot_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_ALPHA){
-		add_variable_to_map(knotpoint_to_alpha_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_GAMMA){
-		add_variable_to_map(knotpoint_to_gamma_vars, opt_variable);
-	}else if(opt_variable->type == VAR_TYPE_H){
-		knotpoint_to_dt.push_back(opt_variable);
+
+	var_values.push_back(opt_variable->value);
+	update_state_version();
+	var_l_bounds.push_back(opt_variable->l_bound);
+	var_u_bounds.push_back(opt_variable->u_bound);
+
+	int type = opt_variable->type;
+	int knotpoint = opt_variable->knotpoint;
+	if ((type < 0) || (type >= NUM_VAR_TYPES) || (knotpoint < 0)){
+		// Untyped variables are stored but do not belong to a block
+		return;
+	}
+	if (type == VAR_TYPE_H){
+		dt_indices.push_back(opt_variable->index);
+	}
+
+	if (block_start.size() == 0){
+		block_start.resize(NUM_VAR_TYPES);
+		block_size.resize(NUM_VAR_TYPES);
+	}
+	if (block_start[type].size() <= knotpoint){
+		block_start[type].resize(knotpoint + 1, -1);
+		block_size[type].resize(knotpoint + 1, 0);
 	}
 
-/*	std::cout << "Size of Q map[knotpoint = 0]:    " << knotpoint_to_q_state_vars[0].size() << std::endl;
-	std::cout << "Size of Qdot map[knotpoint = 0]: " << knotpoint_to_qdot_state_vars[0].size() << std::endl;	
-	std::cout << "Size of xddot map[knotpoint = 0]:    " << knotpoint_to_xddot_vars[0].size() << std::endl;
-	std::cout << "Size of Fr map[knotpoint = 0]: " << knotpoint_to_Fr_vars[0].size() << std::endl;		
-	std::cout << "Size of KF map[knotpoint = 0]: " << knotpoint_to_keyframe_vars[0].size() << std::endl;	*/		
+	if (block_size[type][knotpoint] == 0){
+		block_start[type][knotpoint] = opt_variable->index;
+	}else if (block_start[type][knotpoint] + block_size[type][knotpoint] != opt_variable->index){
+		std::cerr << "[Opt_Variable_Manager] Error! Variables of type " << type << " at knotpoint " << knotpoint << " must be appended contiguously" << std::endl;
+		throw "invalid_index";
+	}
+	block_size[type][knotpoint]++;
 }
 
 
@@ -68,6 +62,10 @@ int Opt_Variable_Manager::get_size(){
 
 Opt_Variable* Opt_Variable_Manager::get_opt_variable(const int index){
 	if ((index >= 0) && (index < opt_var_list.size())){
+		// Sync the stored object with the flat buffers
+		opt_var_list[index]->value = var_values[index];
+		opt_var_list[index]->l_bound = var_l_bounds[index];
+		opt_var_list[index]->u_bound = var_u_bounds[index];
 		return opt_var_list[index];
 	}else{
 		std::cerr << "Error retrieving optimization variable. Index is out of bounds" << std::endl;
@@ -75,131 +73,120 @@ Opt_Variable* Opt_Variable_Manager::get_opt_variable(const int index){
 	}
 }
 
-
-void Opt_Variable_Manager::add_variable_to_map(std::map<int, std::vector<Opt_Variable*>  > &map_kp_to_var_vec, Opt_Variable* opt_variable){
-	int knotpoint = opt_variable->knotpoint;
-	if (map_kp_to_var_vec.count(knotpoint) != 0){
-		// If key is found add this optimization variable to the current time step
-		map_kp_to_var_vec[knotpoint].push_back(opt_variable);
-	}else{
-		// If key is not found, construct a new vector and add it to the map.
-		std::vector<Opt_Variable*> var_vec = {opt_variable};
-		map_kp_to_var_vec.insert(  std::make_pair(knotpoint, var_vec) );
+Eigen::Map<const sejong::Vector> Opt_Variable_Manager::get_var_block(const int &var_type, const int &knotpoint) const{
+	if ((var_type < 0) || (var_type >= block_start.size()) || (knotpoint < 0) || (knotpoint >= block_start[var_type].size()) || (block_size[var_type][knotpoint] == 0)){
+		return Eigen::Map<const sejong::Vector>(NULL, 0);
 	}
+	return Eigen::Map<const sejong::Vector>(var_values.data() + block_start[var_type][knotpoint], block_size[var_type][knotpoint]);
 }
 
-void Opt_Variable_Manager::get_var_states(const int &knotpoint, sejong::Vector &q_state, sejong::Vector &qdot_state){
-		convert_to_vector(knotpoint, knotpoint_to_q_state_vars, q_state);
-		convert_to_vector(knotpoint, knotpoint_to_qdot_state_vars, qdot_state);		
+void Opt_Variable_Manager::set_var_bounds(const int &var_type, const int &knotpoint, const int &i, const double &l_bound, const double &u_bound){
+	if (i >= count_num_vars(var_type, knotpoint)){
+		std::cerr << "Error setting optimization variable bounds. Index is out of bounds" << std::endl;
+		throw "invalid_index";
+	}
+	int index = block_start[var_type][knotpoint] + i;
+	var_l_bounds[index] = l_bound;
+	var_u_bounds[index] = u_bound;
+}
 
-/*		for(size_t i = 0; i < q_state.size(); i++){
-			std::cout << " q_vec[i] val = " << q_state[i] << std::endl;
-		}*/
-/*		for(size_t i = 0; i < qdot_state.size(); i++){
-			std::cout << " qdot_vec[i] val = " << qdot_state[i] << std::endl;
-		}		*/
+void Opt_Variable_Manager::copy_block(const int &var_type, const int &knotpoint, sejong::Vector &vec_out){
+	vec_out = get_var_block(var_type, knotpoint);
+}
 
+void Opt_Variable_Manager::get_var_states(const int &knotpoint, sejong::Vector &q_state, sejong::Vector &qdot_state){
+	copy_block(VAR_TYPE_Q, knotpoint, q_state);
+	copy_block(VAR_TYPE_QDOT, knotpoint, qdot_state);
 }
 
 void Opt_Variable_Manager::get_task_accelerations(const int &knotpoint, sejong::Vector &xddot){
-		convert_to_vector(knotpoint, knotpoint_to_xddot_vars, xddot);
-/*		for(size_t i = 0; i < xddot.size(); i++){
-			std::cout << " xddot[i] val = " << xddot[i] << std::endl;
-		}		*/
-
+	copy_block(VAR_TYPE_TA, knotpoint, xddot);
 }
 
 void Opt_Variable_Manager::get_var_reaction_forces(const int &knotpoint, sejong::Vector &Fr_state){
-		convert_to_vector(knotpoint, knotpoint_to_Fr_vars, Fr_state);
-/*		for(size_t i = 0; i < Fr_state.size(); i++){
-			std::cout << " Fr_state[i] val = " << Fr_state[i] << std::endl;
-		}		*/
-		
+	copy_block(VAR_TYPE_FR, knotpoint, Fr_state);
 }
 
 void Opt_Variable_Manager::get_var_keyframes(const int &knotpoint, sejong::Vector &keyframe_state){
-		convert_to_vector(knotpoint, knotpoint_to_keyframe_vars, keyframe_state);
+	copy_block(VAR_TYPE_KF, knotpoint, keyframe_state);
 }
 
 
 void Opt_Variable_Manager::get_var_knotpoint_dt(const int &knotpoint, double &h_dt){
-	h_dt = knotpoint_to_dt[knotpoint]->value;
+	h_dt = var_values[dt_indices[knotpoint]];
 }
 
 
 
 
+void Opt_Variable_Manager::get_var_indices(const int &var_type, const int &knotpoint, std::vector<int> &indices_out){
+	indices_out.clear();
+	if ((var_type < 0) || (var_type >= NUM_VAR_TYPES)){
+		std::cerr << "Error retrieving optimization variable indices. Unknown variable type " << var_type << std::endl;
+		throw "invalid_index";			
+	}
+
+	int num_vars = count_num_vars(var_type, knotpoint);
+	for(int i = 0; i < num_vars; i++){
+		int index = block_start[var_type][knotpoint] + i;
+		if (index < initial_conditions_offset){
+			indices_out.push_back(-1);
+		}else{
+			indices_out.push_back(index - initial_conditions_offset);
+		}
+	}
+}
+
 void Opt_Variable_Manager::get_q_states(const int &knotpoint, sejong::Vector &q_state){
-	convert_to_vector(knotpoint, knotpoint_to_q_state_vars, q_state);
+	copy_block(VAR_TYPE_Q, knotpoint, q_state);
 }
 void Opt_Variable_Manager::get_qdot_states(const int &knotpoint, sejong::Vector &qdot_state){
-	convert_to_vector(knotpoint, knotpoint_to_qdot_state_vars, qdot_state);
+	copy_block(VAR_TYPE_QDOT, knotpoint, qdot_state);
 }			
 void Opt_Variable_Manager::get_z_states(const int &knotpoint, sejong::Vector &z_state){
-	convert_to_vector(knotpoint, knotpoint_to_z_vars, z_state);
+	copy_block(VAR_TYPE_Z, knotpoint, z_state);
 }
 void Opt_Variable_Manager::get_zdot_states(const int &knotpoint, sejong::Vector &zdot_state){
-	convert_to_vector(knotpoint, knotpoint_to_zdot_vars, zdot_state);	
+	copy_block(VAR_TYPE_ZDOT, knotpoint, zdot_state);
 }
 
 void Opt_Variable_Manager::get_delta_states(const int &knotpoint, sejong::Vector &delta_state){
-	convert_to_vector(knotpoint, knotpoint_to_delta_vars, delta_state);
+	copy_block(VAR_TYPE_DELTA, knotpoint, delta_state);
 }		
 
 void Opt_Variable_Manager::get_delta_dot_states(const int &knotpoint, sejong::Vector &delta_dot_state){
-	convert_to_vector(knotpoint, knotpoint_to_delta_dot_vars, delta_dot_state);	
+	copy_block(VAR_TYPE_DELTA_DOT, knotpoint, delta_dot_state);
 }
 void Opt_Variable_Manager::get_u_states(const int &knotpoint, sejong::Vector &u_state){
-	convert_to_vector(knotpoint, knotpoint_to_u_vars, u_state);
+	copy_block(VAR_TYPE_U, knotpoint, u_state);
 }
 
 void Opt_Variable_Manager::get_beta_states(const int &knotpoint, sejong::Vector &beta_state){
-	convert_to_vector(knotpoint, knotpoint_to_beta_vars, beta_state);
+	copy_block(VAR_TYPE_BETA, knotpoint, beta_state);
 }
 
 void Opt_Variable_Manager::get_qddot_virt_states(const int &knotpoint, sejong::Vector &qddot_virt_states){
-	convert_to_vector(knotpoint, knotpoint_to_qddot_virt_vars, qddot_virt_states);
+	copy_block(VAR_TYPE_QDDOT_VIRT, knotpoint, qddot_virt_states);
 }
 
 void Opt_Variable_Manager::get_xddot_all_states(const int &knotpoint, sejong::Vector &xddot_all){
-	convert_to_vector(knotpoint, knotpoint_to_xddot_all_vars, xddot_all);	
+	copy_block(VAR_TYPE_XDDOT_ALL, knotpoint, xddot_all);
 }
 
 void Opt_Variable_Manager::get_x_states(const int &knotpoint, sejong::Vector &x_state){
-	convert_to_vector(knotpoint, knotpoint_to_x_vars, x_state);	
+	copy_block(VAR_TYPE_X, knotpoint, x_state);
 }
 void Opt_Variable_Manager::get_xdot_states(const int &knotpoint, sejong::Vector &xdot_state){
-	convert_to_vector(knotpoint, knotpoint_to_xdot_vars, xdot_state);	
+	copy_block(VAR_TYPE_XDOT, knotpoint, xdot_state);
 }
 
 void Opt_Variable_Manager::get_alpha_states(const int &knotpoint, sejong::Vector &alpha_state){
-	convert_to_vector(knotpoint, knotpoint_to_alpha_vars, alpha_state);		
+	copy_block(VAR_TYPE_ALPHA, knotpoint, alpha_state);
 }
 void Opt_Variable_Manager::get_gamma_states(const int &knotpoint, sejong::Vector &gamma_state){
-	convert_to_vector(knotpoint, knotpoint_to_gamma_vars, gamma_state);	
+	copy_block(VAR_TYPE_GAMMA, knotpoint, gamma_state);
 }						
 
-void Opt_Variable_Manager::convert_to_vector(const int &knotpoint, 
-						  	 	   			  std::map<int, std::vector<Opt_Variable*> > &map_kp_to_var_vec,
-						   				 	  sejong::Vector &vec_out){
-	
-	std::map<int, std::vector<Opt_Variable*> >::iterator it;
-	it = map_kp_to_var_vec.find(knotpoint);
-
-	// if the key in the map has been found
-	if (it != map_kp_to_var_vec.end()){
-		int size_of_vec = it->second.size(); //is the size of std::vector<Opt_Variable*>
-		vec_out.resize(size_of_vec);
-
-		// Populate vector
-		for(size_t i = 0; i < it->second.size(); i++){
-			vec_out[i] = it->second[i]->value;
-		}
-
-	}
-
-}
-
 int Opt_Variable_Manager::get_num_q_vars(){
 	return num_q_vars;
 }
@@ -225,7 +212,7 @@ int Opt_Variable_Manager::get_num_keyframe_vars(){
 }
 
 int Opt_Variable_Manager::get_num_var_knotpoint_dt(){
-	num_knotpoint_dt_vars = knotpoint_to_dt.size();
+	num_knotpoint_dt_vars = dt_indices.size();
 	return num_knotpoint_dt_vars;
 }
 
@@ -249,21 +236,21 @@ void Opt_Variable_Manager::compute_size_time_dep_vars(){
 	int knotpoint = 1;
 	int total_j_size = 0;
 	
-	num_q_vars = count_num_vars_in_map(knotpoint, knotpoint_to_q_state_vars);
-	num_qdot_vars = count_num_vars_in_map(knotpoint, knotpoint_to_qdot_state_vars);
-	num_xddot_vars = count_num_vars_in_map(knotpoint, knotpoint_to_xddot_vars);
-	num_x_vars = count_num_vars_in_map(knotpoint, knotpoint_to_x_vars);
-	num_xdot_vars = count_num_vars_in_map(knotpoint, knotpoint_to_xdot_vars);
-	num_Fr_vars = count_num_vars_in_map(knotpoint, knotpoint_to_Fr_vars);
-	num_keyframe_vars = count_num_vars_in_map(knotpoint, knotpoint_to_keyframe_vars);
-
-	num_z_vars = count_num_vars_in_map(knotpoint, knotpoint_to_z_vars);
-	num_zdot_vars = count_num_vars_in_map(knotpoint, knotpoint_to_zdot_vars);
-	num_delta_vars = count_num_vars_in_map(knotpoint, knotpoint_to_delta_vars);
-	num_delta_dot_vars = count_num_vars_in_map(knotpoint, knotpoint_to_delta_dot_vars);
-	num_u_vars = count_num_vars_in_map(knotpoint, knotpoint_to_u_vars);
-	num_beta_vars = count_num_vars_in_map(knotpoint, knotpoint_to_beta_vars);
-	num_h = knotpoint_to_dt.size();
+	num_q_vars = count_num_vars(VAR_TYPE_Q, knotpoint);
+	num_qdot_vars = count_num_vars(VAR_TYPE_QDOT, knotpoint);
+	num_xddot_vars = count_num_vars(VAR_TYPE_TA, knotpoint);
+	num_x_vars = count_num_vars(VAR_TYPE_X, knotpoint);
+	num_xdot_vars = count_num_vars(VAR_TYPE_XDOT, knotpoint);
+	num_Fr_vars = count_num_vars(VAR_TYPE_FR, knotpoint);
+	num_keyframe_vars = count_num_vars(VAR_TYPE_KF, knotpoint);
+
+	num_z_vars = count_num_vars(VAR_TYPE_Z, knotpoint);
+	num_zdot_vars = count_num_vars(VAR_TYPE_ZDOT, knotpoint);
+	num_delta_vars = count_num_vars(VAR_TYPE_DELTA, knotpoint);
+	num_delta_dot_vars = count_num_vars(VAR_TYPE_DELTA_DOT, knotpoint);
+	num_u_vars = count_num_vars(VAR_TYPE_U, knotpoint);
+	num_beta_vars = count_num_vars(VAR_TYPE_BETA, knotpoint);
+	num_h = dt_indices.size();
 
 
 /*	std::cout << std::endl;
@@ -297,51 +284,44 @@ int Opt_Variable_Manager::get_size_timedependent_vars(){
 	return num_timedep_vars;
 }
 
-int Opt_Variable_Manager::count_num_vars_in_map(const int &knotpoint, std::map<int, std::vector<Opt_Variable*> > &map_kp_to_var_vec){
-	std::map<int, std::vector<Opt_Variable*> >::iterator it;	
-	it = map_kp_to_var_vec.find(knotpoint);
-
-	if (it != map_kp_to_var_vec.end()){
-		return it->second.size(); //is the size of std::vector<Opt_Variable*>
-	}else{
+int Opt_Variable_Manager::count_num_vars(const int &var_type, const int &knotpoint){
+	if ((var_type < 0) || (var_type >= block_size.size()) || (knotpoint < 0) || (knotpoint >= block_size[var_type].size())){
 		return 0;
 	}
-
+	return block_size[var_type][knotpoint];
 }
 
 void Opt_Variable_Manager::get_init_opt_vars(std::vector<double> &x_vars){
-  x_vars.clear();
-  for(size_t i = initial_conditions_offset; i < opt_var_list.size(); i++){
-    x_vars.push_back(opt_var_list[i]->value);
-  }
-
+	x_vars.assign(var_values.begin() + initial_conditions_offset, var_values.end());
 }
 void Opt_Variable_Manager::get_opt_vars_bounds(std::vector<double> &x_low, std::vector<double> &x_upp){
-  x_low.clear();
-  x_upp.clear();
-  for(size_t i = initial_conditions_offset; i < opt_var_list.size(); i++){
-/*    std::cout << "x[" << i << "] = " << opt_var_list[i]->value << std::endl;
-    std::cout << "lower x[" << i << "] = " << opt_var_list[i]->l_bound << std::endl;     
-    std::cout << "upper x[" << i << "] = " << opt_var_list[i]->u_bound << std::endl;     
-*/
-    x_low.push_back(opt_var_list[i]->l_bound);
-    x_upp.push_back(opt_var_list[i]->u_bound);    
-  }	
+	x_low.assign(var_l_bounds.begin() + initial_conditions_offset, var_l_bounds.end());
+	x_upp.assign(var_u_bounds.begin() + initial_conditions_offset, var_u_bounds.end());
 }
 
 void Opt_Variable_Manager::get_current_opt_vars(std::vector<double> &x_out){
-	x_out.clear();
-	for (size_t i = initial_conditions_offset; i < opt_var_list.size(); i++){
-		x_out.push_back(opt_var_list[i]->value);
-	}
+	x_out.assign(var_values.begin() + initial_conditions_offset, var_values.end());
 }
 
 void Opt_Variable_Manager::update_opt_vars(std::vector<double> &x_in){
-	for (size_t i = 0; i < x_in.size(); i++){
-		opt_var_list[i + initial_conditions_offset]->value = x_in[i];
-	}
+	update_opt_vars(x_in.data(), x_in.size());
 }
 
+void Opt_Variable_Manager::update_opt_vars(const double* x_in, const int &n){
+	if ((n < 0) || (initial_conditions_offset + n > var_values.size())){
+		std::cerr << "[Opt_Variable_Manager] Error! Got " << n << " variables but there are " << var_values.size() - initial_conditions_offset << " after the initial conditions" << std::endl;
+		throw "invalid_index";
+	}
+	memcpy(var_values.data() + initial_conditions_offset, x_in, n*sizeof(double));
+	update_state_version();
+}
 
+unsigned long Opt_Variable_Manager::get_state_version() const{
+	return state_version;
+}
 
-
+void Opt_Variable_Manager::update_state_version(){
+	// Shared by all managers. 0 is never handed out.
+	static std::atomic<unsigned long> next_state_version(1);
+	state_version = next_state_version++;
+}
@@ -0,0 +1,99 @@
+#include <optimization/containers/sparsity_pattern.hpp>
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+
+Sparsity_Pattern::Sparsity_Pattern(){}
+Sparsity_Pattern::~Sparsity_Pattern(){}
+
+void Sparsity_Pattern::clear(){
+	elements.clear();
+	finalized = false;
+}
+
+void Sparsity_Pattern::add_element(const int &row, const int &col){
+	elements.push_back(std::make_pair(row, col));
+	finalized = false;
+}
+
+void Sparsity_Pattern::add_block(const int &row_offset, const int &num_rows, const std::vector<int> &var_indices){
+	for(int i = 0; i < num_rows; i++){
+		for(size_t j = 0; j < var_indices.size(); j++){
+			if (var_indices[j] < 0){
+				continue;
+			}
+			add_element(row_offset + i, var_indices[j]);
+		}
+	}
+}
+
+void Sparsity_Pattern::add_dependencies(const int &row_offset, const int &num_rows, const int &knotpoint, 
+										const std::vector<Var_Dependency> &dependencies, Opt_Variable_Manager& var_manager){
+	std::vector<int> var_indices;
+	std::vector<int> dep_indices;
+	for(size_t i = 0; i < dependencies.size(); i++){
+		var_manager.get_var_indices(dependencies[i].var_type, knotpoint + dependencies[i].knotpoint_offset, dep_indices);
+		var_indices.insert(var_indices.end(), dep_indices.begin(), dep_indices.end());
+	}
+	add_block(row_offset, num_rows, var_indices);
+}
+
+void Sparsity_Pattern::finalize(){
+	std::sort(elements.begin(), elements.end());
+	elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+	finalized = true;
+}
+
+void Sparsity_Pattern::remove_elements(const std::vector<int> &rows, const std::vector<int> &cols){
+	std::vector< std::pair<int, int> > removed;
+	for(size_t i = 0; i < rows.size(); i++){
+		removed.push_back(std::make_pair(rows[i], cols[i]));
+	}
+	std::sort(removed.begin(), removed.end());
+
+	std::vector< std::pair<int, int> > remaining;
+	std::set_difference(elements.begin(), elements.end(), removed.begin(), removed.end(), std::back_inserter(remaining));
+	elements.swap(remaining);
+}
+
+int Sparsity_Pattern::get_size(){
+	return elements.size();
+}
+
+int Sparsity_Pattern::find_element(const int &row, const int &col){
+	if (!finalized){
+		std::cerr << "[Sparsity_Pattern] Error! finalize() must be called before searching the pattern" << std::endl;
+		throw "invalid_index";
+	}
+	std::pair<int, int> element = std::make_pair(row, col);
+	std::vector< std::pair<int, int> >::iterator it = std::lower_bound(elements.begin(), elements.end(), element);
+	if ((it != elements.end()) && (*it == element)){
+		return it - elements.begin();
+	}
+	return -1;
+}
+
+void Sparsity_Pattern::get_pattern(std::vector<int> &iGfun, std::vector<int> &jGvar){
+	iGfun.clear();
+	jGvar.clear();
+	for(size_t i = 0; i < elements.size(); i++){
+		iGfun.push_back(elements[i].first);
+		jGvar.push_back(elements[i].second);
+	}
+}
+
+bool Sparsity_Pattern::scatter(const std::vector<double> &G, const std::vector<int> &iG, const std::vector<int> &jG, double G_out[]){
+	for(size_t i = 0; i < elements.size(); i++){
+		G_out[i] = 0.0;
+	}
+	int pos = -1;
+	for(size_t i = 0; i < G.size(); i++){
+		pos = find_element(iG[i], jG[i]);
+		if (pos < 0){
+			std::cerr << "[Sparsity_Pattern] Error! Element (" << iG[i] << "," << jG[i] << ") is not part of the declared pattern" << std::endl;
+			return false;
+		}
+		G_out[pos] += G[i];
+	}
+	return true;
+}
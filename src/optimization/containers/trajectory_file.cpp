@@ -0,0 +1,253 @@
+#include <optimization/containers/trajectory_file.hpp>
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace{
+	const char TRAJECTORY_MAGIC[8] = {'N', 'L', 'P', 'T', 'R', 'A', 'J', '\0'};
+	const uint32_t TRAJECTORY_VERSION = 1;
+	const uint32_t TRAJECTORY_BYTE_ORDER = 0x01020304;
+
+	// Records start at a multiple of this many bytes
+	const size_t TRAJECTORY_ALIGNMENT = sizeof(double);
+}
+
+Trajectory_Knotpoint::Trajectory_Knotpoint(){
+	clear();
+}
+
+void Trajectory_Knotpoint::clear(){
+	x.resize(0);
+	xdot.resize(0);
+	q.resize(0);
+	qdot.resize(0);
+	u.resize(0);
+	Fr.resize(0);
+	h = std::numeric_limits<double>::quiet_NaN();
+}
+
+Trajectory_Writer::Trajectory_Writer(){}
+
+Trajectory_Writer::~Trajectory_Writer(){
+	close();
+}
+
+bool Trajectory_Writer::open(const std::string &filename_in, const int (&block_sizes)[NUM_TRAJ_BLOCKS - 1], const std::string &problem_name){
+	close();
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+	header.version = TRAJECTORY_VERSION;
+	header.byte_order = TRAJECTORY_BYTE_ORDER;
+	header.record_size = 0;
+	for(int i = 0; i < NUM_TRAJ_BLOCKS; i++){
+		int block_size = (i == TRAJ_BLOCK_H) ? 1 : block_sizes[i];
+		if (block_size < 0){
+			std::cerr << "[Trajectory_Writer] Error! Block " << i << " has negative size " << block_size << std::endl;
+			return false;
+		}
+		header.block_size[i] = block_size;
+		header.record_size += block_size;
+	}
+	header.problem_name_length = problem_name.size();
+	size_t name_padding = (TRAJECTORY_ALIGNMENT - (problem_name.size() % TRAJECTORY_ALIGNMENT)) % TRAJECTORY_ALIGNMENT;
+	header.header_size = sizeof(header) + problem_name.size() + name_padding;
+
+	filename = filename_in;
+	file.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()){
+		std::cerr << "[Trajectory_Writer] Error! Could not open " << filename << std::endl;
+		return false;
+	}
+
+	const char padding[TRAJECTORY_ALIGNMENT] = {0};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(problem_name.data(), problem_name.size());
+	file.write(padding, name_padding);
+
+	record.resize(header.record_size);
+	return file.good();
+}
+
+bool Trajectory_Writer::append_block(const int &block, const sejong::Vector &values){
+	size_t offset = 0;
+	for(int i = 0; i < block; i++){
+		offset += header.block_size[i];
+	}
+
+	if (values.size() == 0){
+		std::fill(record.begin() + offset, record.begin() + offset + header.block_size[block], std::numeric_limits<double>::quiet_NaN());
+		return true;
+	}
+	if (values.size() != (int) header.block_size[block]){
+		std::cerr << "[Trajectory_Writer] Error! Block " << block << " has size " << values.size() << " but the file expects " << header.block_size[block] << std::endl;
+		return false;
+	}
+	for(int i = 0; i < values.size(); i++){
+		record[offset + i] = values[i];
+	}
+	return true;
+}
+
+bool Trajectory_Writer::append_knotpoint(const Trajectory_Knotpoint &knotpoint){
+	if (!file.is_open()){
+		std::cerr << "[Trajectory_Writer] Error! No file is open" << std::endl;
+		return false;
+	}
+
+	bool valid = append_block(TRAJ_BLOCK_X, knotpoint.x) && append_block(TRAJ_BLOCK_XDOT, knotpoint.xdot) &&
+				 append_block(TRAJ_BLOCK_Q, knotpoint.q) && append_block(TRAJ_BLOCK_QDOT, knotpoint.qdot) &&
+				 append_block(TRAJ_BLOCK_U, knotpoint.u) && append_block(TRAJ_BLOCK_FR, knotpoint.Fr);
+	if (!valid){
+		return false;
+	}
+	record.back() = knotpoint.h;
+
+	file.write(reinterpret_cast<const char*>(record.data()), record.size()*sizeof(double));
+	header.num_knotpoints++;
+	return file.good();
+}
+
+bool Trajectory_Writer::close(){
+	if (!file.is_open()){
+		return true;
+	}
+	// Readers only see the knotpoints counted in the header
+	file.seekp(offsetof(Trajectory_File_Header, num_knotpoints));
+	file.write(reinterpret_cast<const char*>(&header.num_knotpoints), sizeof(header.num_knotpoints));
+	bool success = file.good();
+	file.close();
+	if (!success){
+		std::cerr << "[Trajectory_Writer] Error! Could not write " << filename << std::endl;
+	}
+	return success;
+}
+
+bool Trajectory_Writer::is_open() const{
+	return file.is_open();
+}
+
+int Trajectory_Writer::get_num_knotpoints() const{
+	return header.num_knotpoints;
+}
+
+
+Trajectory_Reader::Trajectory_Reader(){
+	memset(block_offset, 0, sizeof(block_offset));
+}
+
+Trajectory_Reader::~Trajectory_Reader(){
+	close();
+}
+
+bool Trajectory_Reader::open(const std::string &filename){
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0){
+		std::cerr << "[Trajectory_Reader] Error! Could not open " << filename << std::endl;
+		return false;
+	}
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size < (off_t) sizeof(Trajectory_File_Header))){
+		std::cerr << "[Trajectory_Reader] Error! " << filename << " is too small to be a trajectory file" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor is closed
+	::close(fd);
+	if (data == MAP_FAILED){
+		std::cerr << "[Trajectory_Reader] Error! Could not map " << filename << std::endl;
+		return false;
+	}
+	mapped_data = static_cast<const char*>(data);
+	mapped_size = file_stat.st_size;
+	header = reinterpret_cast<const Trajectory_File_Header*>(mapped_data);
+
+	std::string error;
+	if (memcmp(header->magic, TRAJECTORY_MAGIC, sizeof(header->magic)) != 0){
+		error = "is not a trajectory file";
+	}else if (header->byte_order != TRAJECTORY_BYTE_ORDER){
+		error = "was written with a different byte order";
+	}else if (header->version != TRAJECTORY_VERSION){
+		error = "has version " + std::to_string(header->version) + " but version " + std::to_string(TRAJECTORY_VERSION) + " is expected";
+	}else if ((header->header_size % TRAJECTORY_ALIGNMENT != 0) || (header->header_size < sizeof(Trajectory_File_Header) + header->problem_name_length) ||
+			  (mapped_size < header->header_size + (size_t) header->num_knotpoints*header->record_size*sizeof(double))){
+		error = "is truncated";
+	}
+
+	if (error.empty()){
+		uint32_t record_size = 0;
+		for(int i = 0; i < NUM_TRAJ_BLOCKS; i++){
+			block_offset[i] = record_size;
+			record_size += header->block_size[i];
+		}
+		if (record_size != header->record_size){
+			error = "has inconsistent block sizes";
+		}
+	}
+
+	if (!error.empty()){
+		std::cerr << "[Trajectory_Reader] Error! " << filename << " " << error << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void Trajectory_Reader::close(){
+	if (mapped_data != NULL){
+		munmap(const_cast<char*>(mapped_data), mapped_size);
+	}
+	mapped_data = NULL;
+	mapped_size = 0;
+	header = NULL;
+}
+
+bool Trajectory_Reader::is_open() const{
+	return (mapped_data != NULL);
+}
+
+int Trajectory_Reader::get_num_knotpoints() const{
+	return (header != NULL) ? header->num_knotpoints : 0;
+}
+
+int Trajectory_Reader::get_block_size(const int &block) const{
+	if ((header == NULL) || (block < 0) || (block >= NUM_TRAJ_BLOCKS)){
+		std::cerr << "[Trajectory_Reader] Error! Invalid block " << block << std::endl;
+		throw "invalid_index";
+	}
+	return header->block_size[block];
+}
+
+std::string Trajectory_Reader::get_problem_name() const{
+	if (header == NULL){
+		return "";
+	}
+	return std::string(mapped_data + sizeof(Trajectory_File_Header), header->problem_name_length);
+}
+
+const double* Trajectory_Reader::get_record(const int &knotpoint) const{
+	if ((header == NULL) || (knotpoint < 0) || (knotpoint >= (int) header->num_knotpoints)){
+		std::cerr << "[Trajectory_Reader] Error! Invalid knotpoint " << knotpoint << std::endl;
+		throw "invalid_index";
+	}
+	return reinterpret_cast<const double*>(mapped_data + header->header_size) + (size_t) knotpoint*header->record_size;
+}
+
+Eigen::Map<const sejong::Vector> Trajectory_Reader::get_block(const int &knotpoint, const int &block) const{
+	int block_size = get_block_size(block);
+	return Eigen::Map<const sejong::Vector>(get_record(knotpoint) + block_offset[block], block_size);
+}
+
+double Trajectory_Reader::get_h(const int &knotpoint) const{
+	return get_record(knotpoint)[block_offset[TRAJ_BLOCK_H]];
+}
@@ -0,0 +1,263 @@
+#include <optimization/continuation_solver.hpp>
+#include <Utils/minjerk_one_dim.hpp>
+#include <Utils/cubic_interpolate_one_dim.hpp>
+#include <iostream>
+
+namespace{
+	// Position and velocity types that are interpolated together
+	const int NUM_STATE_TYPE_PAIRS = 4;
+	const int STATE_TYPE_PAIRS[NUM_STATE_TYPE_PAIRS][2] = {{VAR_TYPE_Q, VAR_TYPE_QDOT},
+														   {VAR_TYPE_X, VAR_TYPE_XDOT},
+														   {VAR_TYPE_Z, VAR_TYPE_ZDOT},
+														   {VAR_TYPE_DELTA, VAR_TYPE_DELTA_DOT}};
+	// Inputs, forces and the other variables that only exist after knotpoint 0
+	const int NUM_KNOTPOINT_TYPES = 9;
+	const int KNOTPOINT_TYPES[NUM_KNOTPOINT_TYPES] = {VAR_TYPE_TA, VAR_TYPE_FR, VAR_TYPE_KF, VAR_TYPE_U, VAR_TYPE_BETA,
+													  VAR_TYPE_QDDOT_VIRT, VAR_TYPE_XDDOT_ALL, VAR_TYPE_ALPHA, VAR_TYPE_GAMMA};
+
+	// Consecutive knotpoints with the same contact mode
+	struct Mode_Segment{
+		int mode;
+		int start_knotpoint;
+		int final_knotpoint;
+	};
+
+	void get_mode_segments(Contact_Mode_Schedule* schedule, const int &N_total_knotpoints, std::vector<Mode_Segment> &segments_out){
+		segments_out.clear();
+		for(int k = 1; k < N_total_knotpoints + 1; k++){
+			int mode = (schedule != NULL) ? schedule->get_mode(k) : -1;
+			if (segments_out.empty() || (segments_out.back().mode != mode)){
+				Mode_Segment segment = {mode, k, k};
+				segments_out.push_back(segment);
+			}else{
+				segments_out.back().final_knotpoint = k;
+			}
+		}
+	}
+
+	double get_knotpoint_dt(Opt_Variable_Manager* var_manager, const int &knotpoint){
+		Eigen::Map<const sejong::Vector> h_dt = var_manager->get_var_block(VAR_TYPE_H, knotpoint);
+		// Problems without timestep variables use a fixed timestep
+		return (h_dt.size() > 0) ? h_dt[0] : OPT_TIMESTEP;
+	}
+
+	// times_out[k] is the time of knotpoint k
+	void get_knotpoint_times(Opt_Variable_Manager* var_manager, std::vector<double> &times_out){
+		times_out.assign(var_manager->total_knotpoints + 1, 0.0);
+		for(int k = 1; k < var_manager->total_knotpoints + 1; k++){
+			times_out[k] = times_out[k-1] + get_knotpoint_dt(var_manager, k);
+		}
+	}
+
+	// First knotpoint of [start_knotpoint, final_knotpoint] that is not before time
+	int find_knotpoint(const std::vector<double> &times, const int &start_knotpoint, const int &final_knotpoint, const double &time){
+		for(int k = start_knotpoint; k < final_knotpoint; k++){
+			if (times[k] >= time){
+				return k;
+			}
+		}
+		return final_knotpoint;
+	}
+
+	bool set_fine_block(Opt_Variable_Manager* fine_var_manager, const int &var_type, const int &knotpoint, const sejong::Vector &values, std::vector<double> &x_vars){
+		std::vector<int> indices;
+		fine_var_manager->get_var_indices(var_type, knotpoint, indices);
+		if (indices.size() != values.size()){
+			std::cerr << "[Continuation Solver] Error! Variable type " << var_type << " has " << values.size() << " coarse values but "
+					  << indices.size() << " fine variables at knotpoint " << knotpoint << std::endl;
+			return false;
+		}
+		for(size_t i = 0; i < indices.size(); i++){
+			if (indices[i] >= 0){
+				x_vars[indices[i]] = values[i];
+			}
+		}
+		return true;
+	}
+
+	// Minimum jerk through the position, velocity and acceleration of knotpoints k-1 and k.
+	// The acceleration over the interval is the backward difference of the velocities.
+	void interpolate_state(Opt_Variable_Manager* var_manager, const int &pos_type, const int &vel_type, const std::vector<double> &times,
+						   const int &k, const double &time, sejong::Vector &pos_out, sejong::Vector &vel_out){
+		Eigen::Map<const sejong::Vector> pos_prev = var_manager->get_var_block(pos_type, k-1);
+		Eigen::Map<const sejong::Vector> vel_prev = var_manager->get_var_block(vel_type, k-1);
+		Eigen::Map<const sejong::Vector> pos = var_manager->get_var_block(pos_type, k);
+		Eigen::Map<const sejong::Vector> vel = var_manager->get_var_block(vel_type, k);
+
+		pos_out = pos;
+		vel_out = vel;
+		double h_dt = times[k] - times[k-1];
+		if (h_dt <= 0.0){
+			return;
+		}
+
+		MinJerk_OneDimension minjerk;
+		sejong::Vect3 init_params;
+		sejong::Vect3 final_params;
+		for(int i = 0; i < pos.size(); i++){
+			double acc = (vel[i] - vel_prev[i])/h_dt;
+			init_params << pos_prev[i], vel_prev[i], acc;
+			final_params << pos[i], vel[i], acc;
+			minjerk.setParams(init_params, final_params, times[k-1], times[k]);
+			minjerk.getPos(time, pos_out[i]);
+			minjerk.getVel(time, vel_out[i]);
+		}
+	}
+
+	// Cubic with zero slope at knotpoints k-1 and k. Before the first knotpoint of the mode, the value of that knotpoint is held.
+	void interpolate_knotpoint_values(Opt_Variable_Manager* var_manager, const int &var_type, const std::vector<double> &times,
+									  const int &start_knotpoint, const int &k, const double &time, sejong::Vector &values_out){
+		Eigen::Map<const sejong::Vector> values = var_manager->get_var_block(var_type, k);
+		values_out = values;
+		if ((k == start_knotpoint) || (times[k] - times[k-1] <= 0.0)){
+			return;
+		}
+
+		Eigen::Map<const sejong::Vector> values_prev = var_manager->get_var_block(var_type, k-1);
+		CubicInterpolate_OneDimension cubic;
+		sejong::Vect2 init_params;
+		sejong::Vect2 final_params;
+		for(int i = 0; i < values.size(); i++){
+			init_params << values_prev[i], 0.0;
+			final_params << values[i], 0.0;
+			cubic.setParams(init_params, final_params, times[k-1], times[k]);
+			cubic.getPos(time, values_out[i]);
+		}
+	}
+}
+
+bool resample_knotpoints(Optimization_Problem_Main* coarse_problem, Optimization_Problem_Main* fine_problem){
+	Opt_Variable_Manager* coarse_var_manager = NULL;
+	Opt_Variable_Manager* fine_var_manager = NULL;
+	coarse_problem->get_var_manager(coarse_var_manager);
+	fine_problem->get_var_manager(fine_var_manager);
+	if ((coarse_var_manager == NULL) || (fine_var_manager == NULL)){
+		std::cerr << "[Continuation Solver] Error! The problems have no variable manager" << std::endl;
+		return false;
+	}
+
+	Contact_Mode_Schedule* coarse_schedule = NULL;
+	Contact_Mode_Schedule* fine_schedule = NULL;
+	coarse_problem->get_contact_mode_schedule(coarse_schedule);
+	fine_problem->get_contact_mode_schedule(fine_schedule);
+
+	std::vector<Mode_Segment> coarse_segments;
+	std::vector<Mode_Segment> fine_segments;
+	get_mode_segments(coarse_schedule, coarse_var_manager->total_knotpoints, coarse_segments);
+	get_mode_segments(fine_schedule, fine_var_manager->total_knotpoints, fine_segments);
+
+	bool modes_match = (coarse_segments.size() == fine_segments.size());
+	for(size_t s = 0; modes_match && (s < coarse_segments.size()); s++){
+		modes_match = (coarse_segments[s].mode == fine_segments[s].mode);
+	}
+	if (!modes_match){
+		std::cerr << "[Continuation Solver] Error! The coarse and fine problems have different contact mode sequences" << std::endl;
+		return false;
+	}
+
+	std::vector<double> times;
+	get_knotpoint_times(coarse_var_manager, times);
+
+	std::vector<double> x_vars;
+	fine_var_manager->get_init_opt_vars(x_vars);
+
+	sejong::Vector pos, vel, values, h_dt(1);
+	for(size_t s = 0; s < coarse_segments.size(); s++){
+		const Mode_Segment &coarse_segment = coarse_segments[s];
+		const Mode_Segment &fine_segment = fine_segments[s];
+
+		// The mode keeps its duration and the fine knotpoints are spaced evenly over it
+		double mode_start_time = times[coarse_segment.start_knotpoint - 1];
+		double mode_duration = times[coarse_segment.final_knotpoint] - mode_start_time;
+		h_dt[0] = mode_duration/(fine_segment.final_knotpoint - fine_segment.start_knotpoint + 1);
+
+		for(int j = fine_segment.start_knotpoint; j < fine_segment.final_knotpoint + 1; j++){
+			double time = mode_start_time + (j - fine_segment.start_knotpoint + 1)*h_dt[0];
+			int k = find_knotpoint(times, coarse_segment.start_knotpoint, coarse_segment.final_knotpoint, time);
+
+			bool valid = true;
+			if (coarse_var_manager->get_var_block(VAR_TYPE_H, k).size() > 0){
+				valid = valid && set_fine_block(fine_var_manager, VAR_TYPE_H, j, h_dt, x_vars);
+			}
+
+			for(int p = 0; p < NUM_STATE_TYPE_PAIRS; p++){
+				int pos_type = STATE_TYPE_PAIRS[p][0];
+				int vel_type = STATE_TYPE_PAIRS[p][1];
+				if (coarse_var_manager->get_var_block(pos_type, k).size() != coarse_var_manager->get_var_block(vel_type, k).size()){
+					std::cerr << "[Continuation Solver] Error! Variable types " << pos_type << " and " << vel_type << " have different sizes" << std::endl;
+					return false;
+				}
+				interpolate_state(coarse_var_manager, pos_type, vel_type, times, k, time, pos, vel);
+				valid = valid && set_fine_block(fine_var_manager, pos_type, j, pos, x_vars);
+				valid = valid && set_fine_block(fine_var_manager, vel_type, j, vel, x_vars);
+			}
+
+			for(int t = 0; t < NUM_KNOTPOINT_TYPES; t++){
+				interpolate_knotpoint_values(coarse_var_manager, KNOTPOINT_TYPES[t], times, coarse_segment.start_knotpoint, k, time, values);
+				valid = valid && set_fine_block(fine_var_manager, KNOTPOINT_TYPES[t], j, values, x_vars);
+			}
+
+			if (!valid){
+				return false;
+			}
+		}
+	}
+
+	fine_var_manager->update_opt_vars(x_vars);
+	return true;
+}
+
+
+Continuation_Solver::Continuation_Solver(const std::function<Optimization_Problem_Main*(const int&)> &create_problem_in,
+										 const std::vector<int> &knotpoint_schedule_in){
+	create_problem = create_problem_in;
+	knotpoint_schedule = knotpoint_schedule_in;
+}
+Continuation_Solver::~Continuation_Solver(){}
+
+void Continuation_Solver::set_use_gradients(const bool &use_gradients_in){
+	use_gradients = use_gradients_in;
+}
+
+void Continuation_Solver::set_print_file_prefix(const std::string &prefix){
+	print_file_prefix = prefix;
+}
+
+void Continuation_Solver::solve_stage(Optimization_Problem_Main* opt_problem, const int &N_total_knotpoints, snopt_wrapper::Solve_Result &result_out){
+	std::string print_file;
+	if (!print_file_prefix.empty()){
+		print_file = print_file_prefix + "_" + std::to_string(N_total_knotpoints) + "_kp.out";
+	}
+
+	if (use_gradients){
+		snopt_wrapper::solve_problem_with_gradients(opt_problem, print_file, result_out);
+	}else{
+		snopt_wrapper::solve_problem_no_gradients(opt_problem, print_file, result_out);
+	}
+}
+
+Optimization_Problem_Main* Continuation_Solver::solve(std::vector<snopt_wrapper::Solve_Result> &stage_results_out){
+	stage_results_out.clear();
+
+	Optimization_Problem_Main* solved_problem = NULL;
+	for(size_t i = 0; i < knotpoint_schedule.size(); i++){
+		int N_total_knotpoints = knotpoint_schedule[i];
+		std::cout << "[Continuation Solver] Stage " << i << " with " << N_total_knotpoints << " knotpoints" << std::endl;
+
+		Optimization_Problem_Main* opt_problem = create_problem(N_total_knotpoints);
+		if ((solved_problem != NULL) && !resample_knotpoints(solved_problem, opt_problem)){
+			std::cerr << "[Continuation Solver] Error! Could not resample the solution with " << knotpoint_schedule[i-1]
+					  << " knotpoints to " << N_total_knotpoints << " knotpoints" << std::endl;
+			delete opt_problem;
+			break;
+		}
+
+		stage_results_out.push_back(snopt_wrapper::Solve_Result());
+		solve_stage(opt_problem, N_total_knotpoints, stage_results_out.back());
+
+		delete solved_problem;
+		solved_problem = opt_problem;
+	}
+
+	return solved_problem;
+}
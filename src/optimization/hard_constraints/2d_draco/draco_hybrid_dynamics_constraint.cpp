@@ -1,7 +1,6 @@
 #include <optimization/hard_constraints/2d_draco/draco_hybrid_dynamics_constraint.hpp>
 #include "DracoP1Rot_Definition.h"
 #include <Utils/utilities.hpp>
-#include <algorithm>
 
 Draco_Hybrid_Dynamics_Constraint::Draco_Hybrid_Dynamics_Constraint(){
 	Initialization();
@@ -19,13 +18,18 @@ Draco_Hybrid_Dynamics_Constraint::~Draco_Hybrid_Dynamics_Constraint(){
 
 void Draco_Hybrid_Dynamics_Constraint::Initialization(){
 	constraint_name = "Draco_Hybrid_Dynamics_Constraint";	
-	robot_model = DracoModel::GetDracoModel();	
 
 	Sa.resize(NUM_ACT_JOINT, NUM_QDOT); 
 	Sa.setZero();
 	Sa.block(0, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = sejong::Matrix::Identity(NUM_ACT_JOINT, NUM_ACT_JOINT);  
 
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_Q, 0);
+	add_var_dependency(VAR_TYPE_QDOT, 0);
+	add_var_dependency(VAR_TYPE_QDOT, -1);
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
   std::cout << "[Draco_Hybrid_Dynamics_Constraint] Initialized" << std::endl;  
 }
 
@@ -49,106 +53,30 @@ void Draco_Hybrid_Dynamics_Constraint::initialize_Flow_Fupp(){
 	constraint_size = F_low.size();
 }
 
-void Draco_Hybrid_Dynamics_Constraint::Update_Contact_Jacobian_Jc(sejong::Vector &q_state){
-  // Stack the contact Jacobians
-  // Extract the segment of Reaction Forces corresponding to this contact-------------------
-  sejong::Matrix J_tmp;
-  int prev_row_size = 0;
-  for (size_t i = 0; i < contact_list_obj->get_size(); i++){
-    // Get the Jacobian for the current contact
-    contact_list_obj->get_contact(i)->getContactJacobian(q_state, J_tmp);   
-    Jc.conservativeResize(prev_row_size + J_tmp.rows(), NUM_QDOT);
-   	Jc.block(prev_row_size, 0, J_tmp.rows(), NUM_QDOT) = J_tmp;
-   	prev_row_size += J_tmp.rows();
-  }
-
-}
-
 void Draco_Hybrid_Dynamics_Constraint::set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all){
-  // Get all the active_contacts
-  std::vector<int> active_contacts;
-  contact_mode_schedule_obj->get_active_contacts(knotpoint, active_contacts);
-
-  // std::cout << "" <<std::endl;
-  // std::cout << "Knotpoint = " << knotpoint << " has active contacts with indices: ";
-  // if (active_contacts.size() == 0){
-  //   std::cout << "no active contacts" << std::endl;
-  // }else{
-  //   for (size_t i = 0; i < active_contacts.size(); i++){
-  //     std::cout << active_contacts[i] << ",";
-  //   }
-  //   std::cout << "" <<std::endl;
-  // }
-
-
-  // Go through all the contacts. If it is not in the active_contacts list, set the contact forces to 0.
-  Contact* current_contact;
-  int current_contact_size;
-  sejong::Vector Fr_contact;
-
-  for (size_t contact_index = 0; contact_index < contact_list_obj->get_size(); contact_index++){
-  // Get the current contact    
-    current_contact = contact_list_obj->get_contact(contact_index);
-    current_contact_size = current_contact->contact_dim;
-
-    // Extract the segment of Reaction Forces corresponding to this contact-------------------
-    int index_offset = 0;
-    for (size_t i = 0; i < contact_index; i++){
-      index_offset += contact_list_obj->get_contact(i)->contact_dim;   
-    }
-
-    // The contact forces for this contact
-    // Fr_contact = Fr_all.segment(index_offset, current_contact_size);
-
-    // Check if this is an active contact:
-    if (!(std::find(active_contacts.begin(), active_contacts.end(), contact_index) != active_contacts.end())) {
-      /* Contact index is not in this list */
-      // Set the contact forces to 0.
-       Fr_all.segment(index_offset, current_contact_size) = sejong::Vector::Zero(current_contact_size);
-    }
-
-  }
-  //sejong::pretty_print(Fr_all, std::cout, "Fr_all");
-
-
+  // The schedule tabulates the force rows of the active contacts at each knotpoint
+  Fr_all = Fr_all.cwiseProduct(contact_mode_schedule_obj->get_active_Fr_mask(knotpoint));
 }
 
 
 void Draco_Hybrid_Dynamics_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
   F_vec.clear();
 
-  sejong::Vector q_state_k; 
-  sejong::Vector q_state_k_prev;   
-  sejong::Vector qdot_state_k; 
-  sejong::Vector qdot_state_k_prev; 
-
   double h_k;
-  sejong::Vector u_state_k;
-  sejong::Vector Fr_state_k;
   sejong::Vector dynamics_k; 
   var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
 
-  var_manager.get_var_states(knotpoint, q_state_k, qdot_state_k);
-  var_manager.get_var_states(knotpoint - 1, q_state_k_prev, qdot_state_k_prev);
-  var_manager.get_u_states(knotpoint, u_state_k);
-  var_manager.get_var_reaction_forces(knotpoint, Fr_state_k);  
+  Eigen::Map<const sejong::Vector> q_state_k = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Eigen::Map<const sejong::Vector> qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  Eigen::Map<const sejong::Vector> q_state_k_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> qdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  sejong::Vector Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint); // Copied, the inactive contacts are zeroed below
 
   set_inactive_contacts_to_zero_force(knotpoint, Fr_state_k);
 
-  sejong::Matrix A_mat;
-  sejong::Vector coriolis;
-  sejong::Vector gravity;
-
-  // Update the model then update the contact jacobian
-  robot_model->UpdateModel(q_state_k, qdot_state_k);
-  robot_model->getMassInertia(A_mat);
-  robot_model->getCoriolis(coriolis);  
-  robot_model->getGravity(gravity);  
-
-  Update_Contact_Jacobian_Jc(q_state_k); 
-
-  // Aqddot + b + g - Jc^T F = Sa^T * torque
-  dynamics_k = A_mat*(qdot_state_k - qdot_state_k_prev)/h_k + coriolis + gravity - Jc.transpose()*Fr_state_k - Sa.transpose()*u_state_k;
+  Draco_Knotpoint_State &knotpoint_state = get_draco_knotpoint_state(knotpoint, var_manager);
+  compute_dynamics_residual(knotpoint_state, qdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_k);
 
   //dynamics_k = A_mat*(qdot_state_k - qdot_state_k_prev)/h_k + coriolis + gravity - Sa.transpose()*u_state_k;
 
@@ -163,7 +91,100 @@ void Draco_Hybrid_Dynamics_Constraint::evaluate_constraint(const int &knotpoint,
 
 }
 
-void Draco_Hybrid_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Draco_Hybrid_Dynamics_Constraint::compute_dynamics_residual(const sejong::Vector &q_state_k, const sejong::Vector &qdot_state_k, const sejong::Vector &qdot_state_k_prev,
+                                                                 const sejong::Vector &u_state_k, const sejong::Vector &Fr_state_k, const double &h_k, sejong::Vector &dynamics_out){
+  Draco_Dimensions::Matrix_qdot A_mat;
+  Draco_Dimensions::Vector_qdot nonlinear_effects;
+
+  // Update the model then update the contact jacobian
+  DracoModel* robot_model = DracoModel::GetDracoModel();
+  robot_model->UpdateModel(q_state_k, qdot_state_k);
+  robot_model->getMassInertia(A_mat);
+  robot_model->getNonlinearEffects(nonlinear_effects);
+
+  Draco_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_state_k, Jc); 
+
+  compute_dynamics_residual(A_mat, nonlinear_effects, Jc, qdot_state_k, qdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_out);
+}
+
+void Draco_Hybrid_Dynamics_Constraint::compute_dynamics_residual(Draco_Knotpoint_State &knotpoint_state, const sejong::Vector &qdot_state_k_prev,
+                                                                 const sejong::Vector &u_state_k, const sejong::Vector &Fr_state_k, const double &h_k, sejong::Vector &dynamics_out){
+  compute_dynamics_residual(knotpoint_state.A, knotpoint_state.nonlinear_effects, knotpoint_state.get_contact_jacobian(DracoModel::GetDracoModel(), contact_list_obj),
+                            knotpoint_state.qdot, qdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_out);
+}
+
+void Draco_Hybrid_Dynamics_Constraint::compute_dynamics_residual(const Draco_Dimensions::Matrix_qdot &A_mat, const Draco_Dimensions::Vector_qdot &nonlinear_effects,
+                                                                 const Draco_Dimensions::Matrix_contact_jacobian &Jc,
+                                                                 const sejong::Vector &qdot_state_k, const sejong::Vector &qdot_state_k_prev,
+                                                                 const sejong::Vector &u_state_k, const sejong::Vector &Fr_state_k, const double &h_k, sejong::Vector &dynamics_out){
+  // Aqddot + b + g - Jc^T F = Sa^T * torque
+  dynamics_out = A_mat*(qdot_state_k - qdot_state_k_prev)/h_k + nonlinear_effects - Jc.transpose()*Fr_state_k - Sa.transpose()*u_state_k;
+}
+
+void Draco_Hybrid_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  double h_k;
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
+
+  Eigen::Map<const sejong::Vector> q_state_k = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Eigen::Map<const sejong::Vector> qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  Eigen::Map<const sejong::Vector> q_state_k_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> qdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  sejong::Vector Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint); // Copied, the inactive contacts are zeroed below
+
+  // Columns of inactive contacts are kept in the pattern with zero entries
+  const sejong::Vector &Fr_mask = contact_mode_schedule_obj->get_active_Fr_mask(knotpoint);
+  set_inactive_contacts_to_zero_force(knotpoint, Fr_state_k);
+
+  std::vector<int> q_k_indices;
+  std::vector<int> qdot_k_indices;
+  std::vector<int> qdot_k_prev_indices;
+  std::vector<int> u_k_indices;
+  std::vector<int> Fr_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, q_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint, qdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint - 1, qdot_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_U, knotpoint, u_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  // A, b, g and Jc depend on q[k] and qdot[k] through RBDL. Their partials are taken by forward differences.
+  // The nominal point comes from the knotpoint's cached model state, the perturbed points from the robot model
+  Draco_Knotpoint_State &knotpoint_state = get_draco_knotpoint_state(knotpoint, var_manager);
+  sejong::Vector dynamics_k;
+  sejong::Vector dynamics_perturbed;
+  compute_dynamics_residual(knotpoint_state, qdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_k);
+
+  sejong::Matrix dF_dq_k(NUM_QDOT, NUM_Q);
+  sejong::Matrix dF_dqdot_k(NUM_QDOT, NUM_QDOT);
+  sejong::Vector q_perturbed = q_state_k;
+  sejong::Vector qdot_perturbed = qdot_state_k;
+  for(size_t j = 0; j < NUM_Q; j++){
+    q_perturbed[j] += OPT_FINITE_DIFF_STEP;
+    compute_dynamics_residual(q_perturbed, qdot_state_k, qdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_perturbed);
+    dF_dq_k.col(j) = (dynamics_perturbed - dynamics_k)/OPT_FINITE_DIFF_STEP;
+    q_perturbed[j] = q_state_k[j];
+  }
+  for(size_t j = 0; j < NUM_QDOT; j++){
+    qdot_perturbed[j] += OPT_FINITE_DIFF_STEP;
+    compute_dynamics_residual(q_state_k, qdot_perturbed, qdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_perturbed);
+    dF_dqdot_k.col(j) = (dynamics_perturbed - dynamics_k)/OPT_FINITE_DIFF_STEP;
+    qdot_perturbed[j] = qdot_state_k[j];
+  }
+
+  // Analytic terms at the nominal point
+  const Draco_Dimensions::Matrix_qdot &A_mat = knotpoint_state.A;
+  const Draco_Dimensions::Matrix_contact_jacobian &Jc = knotpoint_state.get_contact_jacobian(DracoModel::GetDracoModel(), contact_list_obj);
+
+  append_gradient_block(dF_dq_k, 0, q_k_indices, G, iG, jG);
+  append_gradient_block(dF_dqdot_k, 0, qdot_k_indices, G, iG, jG);
+  append_gradient_block(-A_mat/h_k, 0, qdot_k_prev_indices, G, iG, jG);
+  append_gradient_block(-Sa.transpose(), 0, u_k_indices, G, iG, jG);
+  append_gradient_block(-Jc.transpose()*Fr_mask.asDiagonal(), 0, Fr_k_indices, G, iG, jG);
+  append_gradient_block(-A_mat*(qdot_state_k - qdot_state_k_prev)/(h_k*h_k), 0, h_k_indices, G, iG, jG);
+}
 void Draco_Hybrid_Dynamics_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 
 
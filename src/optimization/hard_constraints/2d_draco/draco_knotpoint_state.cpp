@@ -0,0 +1,14 @@
+#include <optimization/hard_constraints/2d_draco/draco_knotpoint_state.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
+
+Draco_Knotpoint_State& get_draco_knotpoint_state(const int &knotpoint, Opt_Variable_Manager &var_manager){
+	return Knotpoint_Model_Cache<Draco_Knotpoint_State>::get_state(knotpoint, var_manager, [&](Draco_Knotpoint_State &state){
+		OPT_PROFILE_SCOPE("model", "Draco_Knotpoint_State fill");
+		var_manager.get_var_states(knotpoint, state.q, state.qdot);
+
+		DracoModel* robot_model = DracoModel::GetDracoModel();
+		robot_model->UpdateModel(state.q, state.qdot);
+		robot_model->getMassInertia(state.A);
+		robot_model->getNonlinearEffects(state.nonlinear_effects);
+	});
+}
@@ -14,8 +14,8 @@ Active_Contact_Kinematic_Constraint::~Active_Contact_Kinematic_Constraint(){
 }
 
 void Active_Contact_Kinematic_Constraint::Initialization(){
-	robot_model = HopperModel::GetRobotModel();
 	initialize_Flow_Fupp();
+	add_var_dependency(VAR_TYPE_Q, 0);
 }
 
 void Active_Contact_Kinematic_Constraint::initialize_Flow_Fupp(){
@@ -35,12 +35,11 @@ void Active_Contact_Kinematic_Constraint::evaluate_constraint(const int &knotpoi
 	int contact_link_id = current_contact->contact_link_id;
 
   // Get current robot states
-  sejong::Vector q_state;
-  sejong::Vector qdot_state;
-  var_manager.get_q_states(knotpoint, q_state);
-  var_manager.get_qdot_states(knotpoint, qdot_state);
+  Hopper_Dimensions::Vector_q q_state = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
 
   // Update the robot model
+  HopperModel* robot_model = HopperModel::GetRobotModel();
   robot_model->UpdateModel(q_state, qdot_state);  
 
   // Get distance to contact
@@ -57,5 +56,22 @@ void Active_Contact_Kinematic_Constraint::evaluate_constraint(const int &knotpoi
 
 
 
-void Active_Contact_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Active_Contact_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+	Contact* current_contact = contact_list_obj->get_contact(contact_index);
+
+  Hopper_Dimensions::Vector_q q_state = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+
+  std::vector<int> q_indices;
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, q_indices);
+
+  HopperModel* robot_model = HopperModel::GetRobotModel();
+  robot_model->UpdateModel(q_state, qdot_state);  
+
+  // d Phi(q) / dq
+  sejong::Matrix J_dist;
+  current_contact->getSignedDistanceJacobian(q_state, J_dist);
+
+  append_gradient_block(J_dist, 0, q_indices, G, iG, jG);
+}
 void Active_Contact_Kinematic_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}	
\ No newline at end of file
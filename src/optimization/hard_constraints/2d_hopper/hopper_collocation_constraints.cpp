@@ -0,0 +1,226 @@
+#include <optimization/hard_constraints/2d_hopper/hopper_collocation_constraints.hpp>
+#include "Hopper_Definition.h"
+#include <Utils/utilities.hpp>
+
+Hopper_Collocation_Constraint::Hopper_Collocation_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in,
+                                                             const int &collocation_method_in){
+  if ((collocation_method_in != COLLOCATION_TRAPEZOIDAL) && (collocation_method_in != COLLOCATION_HERMITE_SIMPSON)){
+    std::cerr << "[Hopper_Collocation_Constraint] Error! Unsupported collocation method " << collocation_method_in << std::endl;
+    throw "invalid_index";
+  }
+  collocation_method = collocation_method_in;
+  contact_list_obj = contact_list_in;
+  contact_mode_schedule_obj = contact_mode_schedule_in;
+
+  Sa.resize(NUM_ACT_JOINT, NUM_QDOT);
+  Sa.setZero();
+  Sa.block(0, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = sejong::Matrix::Identity(NUM_ACT_JOINT, NUM_ACT_JOINT);
+
+  // The hopper has NUM_Q = NUM_QDOT, so both defects have one row per joint
+	for(size_t i = 0; i < NUM_QDOT; i++){
+		F_low.push_back(0.0);
+		F_upp.push_back(0.0);
+	}
+	constraint_size = F_low.size();
+
+	add_var_dependency(VAR_TYPE_Q, 0);
+	add_var_dependency(VAR_TYPE_Q, -1);
+	add_var_dependency(VAR_TYPE_QDOT, 0);
+	add_var_dependency(VAR_TYPE_QDOT, -1);
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
+}
+
+Hopper_Collocation_Constraint::~Hopper_Collocation_Constraint(){}
+
+void Hopper_Collocation_Constraint::get_interval(const int &knotpoint, Opt_Variable_Manager& var_manager, Hopper_Interval<double> &interval){
+  interval.knotpoint = knotpoint;
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, interval.h);
+  interval.q_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  interval.qdot_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  interval.q = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  interval.qdot = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  interval.u = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  interval.Fr = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
+}
+
+template <typename Scalar>
+void Hopper_Collocation_Constraint::get_acceleration(const Eigen::Matrix<Scalar, NUM_Q, 1> &q_state, const Eigen::Matrix<Scalar, NUM_QDOT, 1> &qdot_state,
+                                                     const Hopper_Interval<Scalar> &interval, Eigen::Matrix<Scalar, NUM_QDOT, 1> &qddot_out,
+                                                     Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> &A_out){
+  Eigen::Matrix<Scalar, NUM_QDOT, 1> coriolis;
+  Eigen::Matrix<Scalar, NUM_QDOT, 1> gravity;
+  HopperModel* robot_model = HopperModel::GetRobotModel();
+  robot_model->getMassInertia(q_state, A_out);
+  robot_model->getCoriolis(q_state, qdot_state, coriolis);
+  robot_model->getGravity(q_state, gravity);
+
+  // The hopper's contact Jacobian does not depend on q, so it is a constant of the values
+  sejong::Vector q_value(NUM_Q);
+  for(int i = 0; i < NUM_Q; i++){
+    q_value[i] = dual_value(q_state[i]);
+  }
+  Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_value, Jc);
+
+  // Forces of contacts that are inactive in the interval's mode are ignored
+  const sejong::Vector &Fr_mask = contact_mode_schedule_obj->get_active_Fr_mask(interval.knotpoint);
+  Eigen::Matrix<Scalar, NUM_QDOT, 1> total_input = Sa.transpose().template cast<Scalar>()*interval.u - coriolis - gravity;
+  for(int i = 0; i < interval.Fr.size(); i++){
+    total_input += Jc.row(i).transpose().template cast<Scalar>()*(interval.Fr[i]*Fr_mask[i]);
+  }
+
+  // A is 2x2, so its inverse is closed-form and works with dual numbers
+  qddot_out = A_out.inverse()*total_input;
+}
+
+void Hopper_Collocation_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
+  F_vec.clear();
+
+  Hopper_Interval<double> interval;
+  get_interval(knotpoint, var_manager, interval);
+
+  Eigen::Matrix<double, NUM_QDOT, 1> defects;
+  compute_defects(interval, defects);
+
+  for(size_t i = 0; i < defects.size(); i++){
+    F_vec.push_back(defects[i]);
+  }
+}
+
+void Hopper_Collocation_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  using namespace Hopper_Collocation_Directions;
+  Hopper_Interval<double> interval;
+  get_interval(knotpoint, var_manager, interval);
+
+  std::vector<int> q_k_prev_indices;
+  std::vector<int> qdot_k_prev_indices;
+  std::vector<int> q_k_indices;
+  std::vector<int> qdot_k_indices;
+  std::vector<int> u_k_indices;
+  std::vector<int> Fr_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint - 1, q_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint - 1, qdot_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, q_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint, qdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_U, knotpoint, u_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  // The exact Jacobian w.r.t. all the variables of the interval comes from one evaluation with dual numbers
+  Hopper_Interval<Hopper_Collocation_Dual> interval_dual;
+  interval_dual.knotpoint = knotpoint;
+  seed_dual_vector(interval.q_prev, Q_K_PREV, interval_dual.q_prev);
+  seed_dual_vector(interval.qdot_prev, QDOT_K_PREV, interval_dual.qdot_prev);
+  seed_dual_vector(interval.q, Q_K, interval_dual.q);
+  seed_dual_vector(interval.qdot, QDOT_K, interval_dual.qdot);
+  seed_dual_vector(interval.u, U_K, interval_dual.u);
+  seed_dual_vector(interval.Fr, FR_K, interval_dual.Fr);
+  interval_dual.h = Hopper_Collocation_Dual::variable(interval.h, H_K);
+
+  Eigen::Matrix<Hopper_Collocation_Dual, NUM_QDOT, 1> defects_dual;
+  compute_defects(interval_dual, defects_dual);
+
+  sejong::Matrix dF;
+  get_dual_jacobian(defects_dual, dF);
+
+  // The fixed initial conditions have no columns. The columns of inactive contacts are kept in the pattern with zero entries.
+  append_gradient_block(dF.middleCols(Q_K_PREV, NUM_Q), 0, q_k_prev_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(QDOT_K_PREV, NUM_QDOT), 0, qdot_k_prev_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(Q_K, NUM_Q), 0, q_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(QDOT_K, NUM_QDOT), 0, qdot_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(U_K, NUM_ACT_JOINT), 0, u_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(FR_K, interval.Fr.size()), 0, Fr_k_indices, G, iG, jG);
+  append_gradient_block(dF.col(H_K), 0, h_k_indices, G, iG, jG);
+}
+
+void Hopper_Collocation_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
+
+
+Hopper_Collocation_Time_Integration_Constraint::Hopper_Collocation_Time_Integration_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in,
+                                                                                               const int &collocation_method_in):
+  Hopper_Collocation_Constraint(contact_list_in, contact_mode_schedule_in, collocation_method_in){
+  constraint_name = (collocation_method == COLLOCATION_TRAPEZOIDAL) ? "Hopper_Trapezoidal_Time_Integration_Constraint" :
+                                                                     "Hopper_Hermite_Simpson_Time_Integration_Constraint";
+  std::cout << "[" << constraint_name << "] Initialized" << std::endl;
+}
+
+Hopper_Collocation_Time_Integration_Constraint::~Hopper_Collocation_Time_Integration_Constraint(){
+  std::cout << "[" << constraint_name << "] Destructor called" << std::endl;
+}
+
+void Hopper_Collocation_Time_Integration_Constraint::compute_defects(const Hopper_Interval<double> &interval, Eigen::Matrix<double, NUM_QDOT, 1> &F_out){
+  compute_defects_s(interval, F_out);
+}
+
+void Hopper_Collocation_Time_Integration_Constraint::compute_defects(const Hopper_Interval<Hopper_Collocation_Dual> &interval,
+                                                                     Eigen::Matrix<Hopper_Collocation_Dual, NUM_QDOT, 1> &F_out){
+  compute_defects_s(interval, F_out);
+}
+
+template <typename Scalar>
+void Hopper_Collocation_Time_Integration_Constraint::compute_defects_s(const Hopper_Interval<Scalar> &interval, Eigen::Matrix<Scalar, NUM_QDOT, 1> &F_out){
+  const Scalar &h = interval.h;
+  // Trapezoidal: q[k] - q[k-1] - h/2*(qdot[k-1] + qdot[k])
+  F_out = interval.q - interval.q_prev - (0.5*h)*(interval.qdot_prev + interval.qdot);
+
+  if (collocation_method == COLLOCATION_HERMITE_SIMPSON){
+    // Simpson's rule with the Hermite midpoint qdot_c = (qdot[k-1] + qdot[k])/2 + h/8*(qddot[k-1] - qddot[k])
+    Eigen::Matrix<Scalar, NUM_QDOT, 1> qddot_prev;
+    Eigen::Matrix<Scalar, NUM_QDOT, 1> qddot;
+    Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> A_mat;
+    get_acceleration(interval.q_prev, interval.qdot_prev, interval, qddot_prev, A_mat);
+    get_acceleration(interval.q, interval.qdot, interval, qddot, A_mat);
+    F_out -= (h*h/12.0)*(qddot_prev - qddot);
+  }
+}
+
+
+Hopper_Collocation_Hybrid_Dynamics_Constraint::Hopper_Collocation_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in,
+                                                                                             const int &collocation_method_in):
+  Hopper_Collocation_Constraint(contact_list_in, contact_mode_schedule_in, collocation_method_in){
+  constraint_name = (collocation_method == COLLOCATION_TRAPEZOIDAL) ? "Hopper_Trapezoidal_Hybrid_Dynamics_Constraint" :
+                                                                     "Hopper_Hermite_Simpson_Hybrid_Dynamics_Constraint";
+  std::cout << "[" << constraint_name << "] Initialized" << std::endl;
+}
+
+Hopper_Collocation_Hybrid_Dynamics_Constraint::~Hopper_Collocation_Hybrid_Dynamics_Constraint(){
+  std::cout << "[" << constraint_name << "] Destructor called" << std::endl;
+}
+
+void Hopper_Collocation_Hybrid_Dynamics_Constraint::compute_defects(const Hopper_Interval<double> &interval, Eigen::Matrix<double, NUM_QDOT, 1> &F_out){
+  compute_defects_s(interval, F_out);
+}
+
+void Hopper_Collocation_Hybrid_Dynamics_Constraint::compute_defects(const Hopper_Interval<Hopper_Collocation_Dual> &interval,
+                                                                    Eigen::Matrix<Hopper_Collocation_Dual, NUM_QDOT, 1> &F_out){
+  compute_defects_s(interval, F_out);
+}
+
+template <typename Scalar>
+void Hopper_Collocation_Hybrid_Dynamics_Constraint::compute_defects_s(const Hopper_Interval<Scalar> &interval, Eigen::Matrix<Scalar, NUM_QDOT, 1> &F_out){
+  const Scalar &h = interval.h;
+  Eigen::Matrix<Scalar, NUM_QDOT, 1> qddot_prev;
+  Eigen::Matrix<Scalar, NUM_QDOT, 1> qddot;
+  Eigen::Matrix<Scalar, NUM_QDOT, 1> qddot_integral;
+  Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> A_mat_prev;
+  Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> A_mat;
+
+  get_acceleration(interval.q_prev, interval.qdot_prev, interval, qddot_prev, A_mat_prev);
+  get_acceleration(interval.q, interval.qdot, interval, qddot, A_mat);
+  if (collocation_method == COLLOCATION_TRAPEZOIDAL){
+    qddot_integral = (0.5*h)*(qddot_prev + qddot);
+  }else{
+    Eigen::Matrix<Scalar, NUM_QDOT, 1> qddot_c;
+    Eigen::Matrix<Scalar, NUM_QDOT, NUM_QDOT> A_mat_c;
+    Eigen::Matrix<Scalar, NUM_Q, 1> q_c = Scalar(0.5)*(interval.q_prev + interval.q) + (h/8.0)*(interval.qdot_prev - interval.qdot);
+    Eigen::Matrix<Scalar, NUM_QDOT, 1> qdot_c = Scalar(0.5)*(interval.qdot_prev + interval.qdot) + (h/8.0)*(qddot_prev - qddot);
+    get_acceleration(q_c, qdot_c, interval, qddot_c, A_mat_c);
+    qddot_integral = (h/6.0)*(qddot_prev + Scalar(4.0)*qddot_c + qddot);
+  }
+
+  // The mass matrix of knotpoint k scales the rows as in Hopper_Hybrid_Dynamics_Constraint
+  F_out = A_mat*(interval.qdot - interval.qdot_prev - qddot_integral)/h;
+}
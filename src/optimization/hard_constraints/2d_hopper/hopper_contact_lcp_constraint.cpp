@@ -20,8 +20,9 @@ Hopper_Floor_Contact_LCP_Constraint::~Hopper_Floor_Contact_LCP_Constraint(){
 void Hopper_Floor_Contact_LCP_Constraint::Initialization(){
   std::cout << "[Hopper_Floor_Contact_LCP_Constraint] Initialization called" << std::endl;
   constraint_name = "Hopper Contact LCP Constraint";  
-  robot_model = HopperModel::GetRobotModel();  
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_Q, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
 }
 
 void Hopper_Floor_Contact_LCP_Constraint::initialize_Flow_Fupp(){
@@ -74,17 +75,15 @@ void Hopper_Floor_Contact_LCP_Constraint::evaluate_constraint(const int &knotpoi
   int contact_link_id = current_contact->contact_link_id;
 
   // Get robot virtual states and actuator z position states---------------------------------------------------------------------------
-  sejong::Vector q_state;
-  sejong::Vector qdot_state;
-  var_manager.get_q_states(knotpoint, q_state);
-  var_manager.get_qdot_states(knotpoint, qdot_state);
+  Hopper_Dimensions::Vector_q q_state = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
 
   // Update the robot model
+  HopperModel* robot_model = HopperModel::GetRobotModel();
   robot_model->UpdateModel(q_state, qdot_state);  
 
   // Get Fr_states--------------------------------------------------------------------------
-  sejong::Vector Fr_all;
-  var_manager.get_var_reaction_forces(knotpoint, Fr_all);
+  Eigen::Map<const sejong::Vector> Fr_all = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
   int current_contact_size = current_contact->contact_dim;
 
   // Extract the segment of Reaction Forces corresponding to this contact-------------------
@@ -144,6 +143,48 @@ void Hopper_Floor_Contact_LCP_Constraint::evaluate_constraint(const int &knotpoi
 }
 
 void Hopper_Floor_Contact_LCP_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  Contact* current_contact = contact_list_obj->get_contact(contact_index);
+  int contact_link_id = current_contact->contact_link_id;
+
+  Hopper_Dimensions::Vector_q q_state = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+
+  HopperModel* robot_model = HopperModel::GetRobotModel();
+  robot_model->UpdateModel(q_state, qdot_state);  
+
+  Eigen::Map<const sejong::Vector> Fr_all = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
+  int current_contact_size = current_contact->contact_dim;
+
+  int index_offset = 0;
+  for (size_t i = 0; i < contact_index; i++){
+    index_offset += contact_list_obj->get_contact(i)->contact_dim;   
+  }
+  sejong::Vector Fr_contact = Fr_all.segment(index_offset, current_contact_size);
+  double Fr_l2_norm_squared = std::pow(Fr_contact.lpNorm<2>(), 2);
+
+  sejong::Vector contact_pos_vec;
+  sejong::Matrix J_contact;
+  robot_model->getPosition(q_state, contact_link_id, contact_pos_vec);
+  robot_model->getFullJacobian(q_state, contact_link_id, J_contact);
+  double phi_contact_dis = contact_pos_vec[0];
+
+  // Only the variables of this contact appear in the constraint
+  std::vector<int> q_indices;
+  std::vector<int> Fr_all_indices;
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, q_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_all_indices);
+  std::vector<int> Fr_contact_indices(Fr_all_indices.begin() + index_offset, Fr_all_indices.begin() + index_offset + current_contact_size);
+
+  // F = [Phi*||Fr||^2, Phi]
+  sejong::Matrix dF_dq = sejong::Matrix::Zero(num_constraints, NUM_Q);
+  dF_dq.row(0) = Fr_l2_norm_squared*J_contact.row(0);
+  dF_dq.row(1) = J_contact.row(0);
+
+  sejong::Matrix dF_dFr = sejong::Matrix::Zero(num_constraints, current_contact_size);
+  dF_dFr.row(0) = 2.0*phi_contact_dis*Fr_contact.transpose();
+
+  append_gradient_block(dF_dq, 0, q_indices, G, iG, jG);
+  append_gradient_block(dF_dFr, 0, Fr_contact_indices, G, iG, jG);
 }
 
 void Hopper_Floor_Contact_LCP_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){
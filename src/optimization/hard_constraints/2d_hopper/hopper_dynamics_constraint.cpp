@@ -17,13 +17,18 @@ Hopper_Dynamics_Constraint::~Hopper_Dynamics_Constraint(){
 
 void Hopper_Dynamics_Constraint::Initialization(){
 	constraint_name = "Hopper_Dynamics_Constraint";	
-	robot_model = HopperModel::GetRobotModel();	
 
   Sa.resize(NUM_ACT_JOINT, NUM_QDOT); 
   Sa.setZero();
   Sa.block(0, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = sejong::Matrix::Identity(NUM_ACT_JOINT, NUM_ACT_JOINT);  
 
 	initialize_Flow_Fupp();	
+	// The hopper mass matrix and Jc do not depend on q
+	add_var_dependency(VAR_TYPE_QDOT, 0);
+	add_var_dependency(VAR_TYPE_QDOT, -1);
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
   std::cout << "[Hopper_Dynamics_Constraint] Initialized" << std::endl;  
 }
 
@@ -44,52 +49,34 @@ void Hopper_Dynamics_Constraint::initialize_Flow_Fupp(){
 	constraint_size = F_low.size();
 }
 
-void Hopper_Dynamics_Constraint::Update_Contact_Jacobian_Jc(sejong::Vector &q_state){
-  // Stack the contact Jacobians
-  // Extract the segment of Reaction Forces corresponding to this contact-------------------
-  sejong::Matrix J_tmp;
-  int prev_row_size = 0;
-  for (size_t i = 0; i < contact_list_obj->get_size(); i++){
-    // Get the Jacobian for the current contact
-    contact_list_obj->get_contact(i)->getContactJacobian(q_state, J_tmp);   
-    Jc.conservativeResize(prev_row_size + J_tmp.rows(), NUM_QDOT);
-   	Jc.block(prev_row_size, 0, J_tmp.rows(), NUM_QDOT) = J_tmp;
-   	prev_row_size += J_tmp.rows();
-  }
-
-}
-
 
 
 void Hopper_Dynamics_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
   F_vec.clear();
 
-  sejong::Vector q_state_k; 
-  sejong::Vector q_state_k_prev;   
-  sejong::Vector qdot_state_k; 
-  sejong::Vector qdot_state_k_prev; 
-
   double h_k;
-  sejong::Vector u_state_k;
-  sejong::Vector Fr_state_k;
   sejong::Vector dynamics_k; 
   var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
 
-  var_manager.get_var_states(knotpoint, q_state_k, qdot_state_k);
-  var_manager.get_var_states(knotpoint - 1, q_state_k_prev, qdot_state_k_prev);
-  var_manager.get_u_states(knotpoint, u_state_k);
-  var_manager.get_var_reaction_forces(knotpoint, Fr_state_k);  
+  Hopper_Dimensions::Vector_q q_state_k = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  Hopper_Dimensions::Vector_q q_state_k_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  Hopper_Dimensions::Vector_qdot qdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  Eigen::Map<const sejong::Vector> Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
 
-  sejong::Matrix A_mat;
-  sejong::Vector coriolis;
-  sejong::Vector gravity;
+  Hopper_Dimensions::Matrix_qdot A_mat;
+  Hopper_Dimensions::Vector_qdot coriolis;
+  Hopper_Dimensions::Vector_qdot gravity;
 
   // Update the model then update the contact jacobian
+  HopperModel* robot_model = HopperModel::GetRobotModel();
   robot_model->UpdateModel(q_state_k, qdot_state_k);
   robot_model->getMassInertia(A_mat);
   robot_model->getCoriolis(coriolis);  
   robot_model->getGravity(gravity);  
-  Update_Contact_Jacobian_Jc(q_state_k); 
+  Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_state_k, Jc); 
 
   // Aqddot + b + g - Jc^T F = Sa^T * torque
   dynamics_k = A_mat*(qdot_state_k - qdot_state_k_prev)/h_k + coriolis + gravity - Jc.transpose()*Fr_state_k - Sa.transpose()*u_state_k;
@@ -105,7 +92,44 @@ void Hopper_Dynamics_Constraint::evaluate_constraint(const int &knotpoint, Opt_V
 
 }
 
-void Hopper_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Hopper_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  double h_k;
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
+
+  Hopper_Dimensions::Vector_q q_state_k = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  Hopper_Dimensions::Vector_q q_state_k_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  Hopper_Dimensions::Vector_qdot qdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  Eigen::Map<const sejong::Vector> Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
+
+  std::vector<int> qdot_k_indices;
+  std::vector<int> qdot_k_prev_indices;
+  std::vector<int> u_k_indices;
+  std::vector<int> Fr_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint, qdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint - 1, qdot_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_U, knotpoint, u_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  Hopper_Dimensions::Matrix_qdot A_mat;
+
+  HopperModel* robot_model = HopperModel::GetRobotModel();
+  robot_model->UpdateModel(q_state_k, qdot_state_k);
+  robot_model->getMassInertia(A_mat);
+  Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_state_k, Jc); 
+
+  // F = A*(qdot[k] - qdot[k-1])/h[k] + b + g - Jc^T*Fr[k] - Sa^T*u[k]
+  // The hopper's A, b, g and Jc do not depend on q, so there are no q[k] terms.
+  append_gradient_block(A_mat/h_k, 0, qdot_k_indices, G, iG, jG);
+  append_gradient_block(-A_mat/h_k, 0, qdot_k_prev_indices, G, iG, jG);
+  append_gradient_block(-Sa.transpose(), 0, u_k_indices, G, iG, jG);
+  append_gradient_block(-Jc.transpose(), 0, Fr_k_indices, G, iG, jG);
+  append_gradient_block(-A_mat*(qdot_state_k - qdot_state_k_prev)/(h_k*h_k), 0, h_k_indices, G, iG, jG);
+}
 void Hopper_Dynamics_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 
 
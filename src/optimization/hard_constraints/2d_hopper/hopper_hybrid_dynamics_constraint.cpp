@@ -1,7 +1,8 @@
 #include <optimization/hard_constraints/2d_hopper/hopper_hybrid_dynamics_constraint.hpp>
 #include "Hopper_Definition.h"
 #include <Utils/utilities.hpp>
-#include <algorithm>
+#include <optimization/profiling/opt_profiler.hpp>
+#include <optimization/parallel/knotpoint_batch.hpp>
 
 Hopper_Hybrid_Dynamics_Constraint::Hopper_Hybrid_Dynamics_Constraint(){
 	Initialization();
@@ -19,13 +20,18 @@ Hopper_Hybrid_Dynamics_Constraint::~Hopper_Hybrid_Dynamics_Constraint(){
 
 void Hopper_Hybrid_Dynamics_Constraint::Initialization(){
 	constraint_name = "Hopper_Hybrid_Dynamics_Constraint";	
-	robot_model = HopperModel::GetRobotModel();	
 
   Sa.resize(NUM_ACT_JOINT, NUM_QDOT); 
   Sa.setZero();
   Sa.block(0, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT) = sejong::Matrix::Identity(NUM_ACT_JOINT, NUM_ACT_JOINT);  
 
 	initialize_Flow_Fupp();	
+	// The hopper mass matrix and Jc do not depend on q
+	add_var_dependency(VAR_TYPE_QDOT, 0);
+	add_var_dependency(VAR_TYPE_QDOT, -1);
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
   std::cout << "[Hopper_Hybrid_Dynamics_Constraint] Initialized" << std::endl;  
 }
 
@@ -49,101 +55,40 @@ void Hopper_Hybrid_Dynamics_Constraint::initialize_Flow_Fupp(){
 	constraint_size = F_low.size();
 }
 
-void Hopper_Hybrid_Dynamics_Constraint::Update_Contact_Jacobian_Jc(sejong::Vector &q_state){
-  // Stack the contact Jacobians
-  // Extract the segment of Reaction Forces corresponding to this contact-------------------
-  sejong::Matrix J_tmp;
-  int prev_row_size = 0;
-  for (size_t i = 0; i < contact_list_obj->get_size(); i++){
-    // Get the Jacobian for the current contact
-    contact_list_obj->get_contact(i)->getContactJacobian(q_state, J_tmp);   
-    Jc.conservativeResize(prev_row_size + J_tmp.rows(), NUM_QDOT);
-   	Jc.block(prev_row_size, 0, J_tmp.rows(), NUM_QDOT) = J_tmp;
-   	prev_row_size += J_tmp.rows();
-  }
-
-}
-
 void Hopper_Hybrid_Dynamics_Constraint::set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all){
-  // Get all the active_contacts
-  std::vector<int> active_contacts;
-  contact_mode_schedule_obj->get_active_contacts(knotpoint, active_contacts);
-
-  // std::cout << "" <<std::endl;
-  // std::cout << "Knotpoint = " << knotpoint << " has active contacts with indices: ";
-  // if (active_contacts.size() == 0){
-  //   std::cout << "no active contacts" << std::endl;
-  // }else{
-  //   for (size_t i = 0; i < active_contacts.size(); i++){
-  //     std::cout << active_contacts[i] << ",";
-  //   }
-  //   std::cout << "" <<std::endl;
-  // }
-
-
-  // Go through all the contacts. If it is not in the active_contacts list, set the contact forces to 0.
-  Contact* current_contact;
-  int current_contact_size;
-  sejong::Vector Fr_contact;
-
-  for (size_t contact_index = 0; contact_index < contact_list_obj->get_size(); contact_index++){
-  // Get the current contact    
-    current_contact = contact_list_obj->get_contact(contact_index);
-    current_contact_size = current_contact->contact_dim;
-
-    // Extract the segment of Reaction Forces corresponding to this contact-------------------
-    int index_offset = 0;
-    for (size_t i = 0; i < contact_index; i++){
-      index_offset += contact_list_obj->get_contact(i)->contact_dim;   
-    }
-
-    // The contact forces for this contact
-    // Fr_contact = Fr_all.segment(index_offset, current_contact_size);
-
-    // Check if this is an active contact:
-    if (!(std::find(active_contacts.begin(), active_contacts.end(), contact_index) != active_contacts.end())) {
-      /* Contact index is not in this list */
-      // Set the contact forces to 0.
-       Fr_all.segment(index_offset, current_contact_size) = sejong::Vector::Zero(current_contact_size);
-    }
-
-  }
-
-
+  // The schedule tabulates the force rows of the active contacts at each knotpoint
+  Fr_all = Fr_all.cwiseProduct(contact_mode_schedule_obj->get_active_Fr_mask(knotpoint));
 }
 
 
 void Hopper_Hybrid_Dynamics_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
   F_vec.clear();
 
-  sejong::Vector q_state_k; 
-  sejong::Vector q_state_k_prev;   
-  sejong::Vector qdot_state_k; 
-  sejong::Vector qdot_state_k_prev; 
-
   double h_k;
-  sejong::Vector u_state_k;
-  sejong::Vector Fr_state_k;
   sejong::Vector dynamics_k; 
   var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
 
-  var_manager.get_var_states(knotpoint, q_state_k, qdot_state_k);
-  var_manager.get_var_states(knotpoint - 1, q_state_k_prev, qdot_state_k_prev);
-  var_manager.get_u_states(knotpoint, u_state_k);
-  var_manager.get_var_reaction_forces(knotpoint, Fr_state_k);  
+  Hopper_Dimensions::Vector_q q_state_k = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  Hopper_Dimensions::Vector_q q_state_k_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  Hopper_Dimensions::Vector_qdot qdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  sejong::Vector Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint); // Copied, the inactive contacts are zeroed below
 
   set_inactive_contacts_to_zero_force(knotpoint, Fr_state_k);
 
-  sejong::Matrix A_mat;
-  sejong::Vector coriolis;
-  sejong::Vector gravity;
+  Hopper_Dimensions::Matrix_qdot A_mat;
+  Hopper_Dimensions::Vector_qdot coriolis;
+  Hopper_Dimensions::Vector_qdot gravity;
 
   // Update the model then update the contact jacobian
+  HopperModel* robot_model = HopperModel::GetRobotModel();
   robot_model->UpdateModel(q_state_k, qdot_state_k);
   robot_model->getMassInertia(A_mat);
   robot_model->getCoriolis(coriolis);  
   robot_model->getGravity(gravity);  
-  Update_Contact_Jacobian_Jc(q_state_k); 
+  Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_state_k, Jc); 
 
   // Aqddot + b + g - Jc^T F = Sa^T * torque
   dynamics_k = A_mat*(qdot_state_k - qdot_state_k_prev)/h_k + coriolis + gravity - Jc.transpose()*Fr_state_k - Sa.transpose()*u_state_k;
@@ -159,7 +104,101 @@ void Hopper_Hybrid_Dynamics_Constraint::evaluate_constraint(const int &knotpoint
 
 }
 
-void Hopper_Hybrid_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Hopper_Hybrid_Dynamics_Constraint::evaluate_constraint_batch(const std::vector<int> &knotpoints, Opt_Variable_Manager& var_manager, double* F_eval, const int &knotpoint_stride){
+  if (knotpoints.empty()){
+    return;
+  }
+
+  // Stack the variables of the knotpoints, one knotpoint per row
+  batch.resize(knotpoints.size(), var_manager.get_var_block(VAR_TYPE_FR, knotpoints[0]).size());
+  for(size_t i = 0; i < knotpoints.size(); i++){
+    const int &knotpoint = knotpoints[i];
+    batch.qdot.row(i) = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint).transpose();
+    batch.qdot_prev.row(i) = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1).transpose();
+    batch.u.row(i) = var_manager.get_var_block(VAR_TYPE_U, knotpoint).transpose();
+    batch.Fr.row(i) = var_manager.get_var_block(VAR_TYPE_FR, knotpoint).cwiseProduct(contact_mode_schedule_obj->get_active_Fr_mask(knotpoint)).transpose();
+    var_manager.get_var_knotpoint_dt(knotpoint - 1, batch.h[i]);
+  }
+
+  // The model at the first knotpoint serves every knotpoint
+  Hopper_Dimensions::Vector_q q_state_first = var_manager.get_var_block(VAR_TYPE_Q, knotpoints[0]);
+  Hopper_Dimensions::Vector_qdot qdot_state_first = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoints[0]);
+
+  Hopper_Dimensions::Matrix_qdot A_mat;
+  Hopper_Dimensions::Vector_qdot coriolis;
+  Hopper_Dimensions::Vector_qdot gravity;
+  HopperModel* robot_model = HopperModel::GetRobotModel();
+  robot_model->UpdateModel(q_state_first, qdot_state_first);
+  robot_model->getMassInertia(A_mat);
+  robot_model->getCoriolis(coriolis);  
+  robot_model->getGravity(gravity);  
+  Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_state_first, Jc); 
+
+  evaluate_dynamics_batch(batch, A_mat, coriolis, gravity, Jc, dynamics_batch);
+
+  for(size_t i = 0; i < knotpoints.size(); i++){
+    double* F_out = F_eval + (knotpoints[i] - 1)*knotpoint_stride + constraint_index;
+    for(int j = 0; j < NUM_QDOT; j++){
+      F_out[j] = dynamics_batch(i, j);
+    }
+  }
+}
+
+void Hopper_Hybrid_Dynamics_Constraint::evaluate_dynamics_batch(const Hopper_Dynamics_Batch &batch, const Hopper_Dimensions::Matrix_qdot &A_mat, const Hopper_Dimensions::Vector_qdot &coriolis,
+                                                                const Hopper_Dimensions::Vector_qdot &gravity, const Hopper_Dimensions::Matrix_contact_jacobian &Jc,
+                                                                Hopper_Dynamics_Batch::Matrix_qdot_batch &dynamics_out){
+  OPT_PROFILE_SCOPE("model", "Hopper_Hybrid_Dynamics_Constraint::evaluate_dynamics_batch");
+  // One knotpoint per row, so every operation runs down the contiguous columns
+  dynamics_out.setZero(batch.qdot.rows(), NUM_QDOT);
+  batch_add_product(batch.qdot - batch.qdot_prev, A_mat.transpose(), dynamics_out);
+  dynamics_out.array().colwise() /= batch.h.array();
+  dynamics_out.rowwise() += (coriolis + gravity).transpose();
+  batch_add_product(batch.Fr, -Jc, dynamics_out);
+  batch_add_product(batch.u, -Sa, dynamics_out);
+}
+
+void Hopper_Hybrid_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  double h_k;
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
+
+  Hopper_Dimensions::Vector_q q_state_k = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+  Hopper_Dimensions::Vector_qdot qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+  Hopper_Dimensions::Vector_q q_state_k_prev = var_manager.get_var_block(VAR_TYPE_Q, knotpoint - 1);
+  Hopper_Dimensions::Vector_qdot qdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint - 1);
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  Eigen::Map<const sejong::Vector> Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
+
+  // Columns of inactive contacts are kept in the pattern with zero entries
+  const sejong::Vector &Fr_mask = contact_mode_schedule_obj->get_active_Fr_mask(knotpoint);
+
+  std::vector<int> qdot_k_indices;
+  std::vector<int> qdot_k_prev_indices;
+  std::vector<int> u_k_indices;
+  std::vector<int> Fr_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint, qdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint - 1, qdot_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_U, knotpoint, u_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  Hopper_Dimensions::Matrix_qdot A_mat;
+
+  HopperModel* robot_model = HopperModel::GetRobotModel();
+  robot_model->UpdateModel(q_state_k, qdot_state_k);
+  robot_model->getMassInertia(A_mat);
+  Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  contact_list_obj->get_stacked_contact_jacobian(q_state_k, Jc); 
+
+  // F = A*(qdot[k] - qdot[k-1])/h[k] + b + g - Jc^T*Fr[k] - Sa^T*u[k]
+  // The hopper's A, b, g and Jc do not depend on q, so there are no q[k] terms
+  append_gradient_block(A_mat/h_k, 0, qdot_k_indices, G, iG, jG);
+  append_gradient_block(-A_mat/h_k, 0, qdot_k_prev_indices, G, iG, jG);
+  append_gradient_block(-Sa.transpose(), 0, u_k_indices, G, iG, jG);
+  append_gradient_block(-Jc.transpose()*Fr_mask.asDiagonal(), 0, Fr_k_indices, G, iG, jG);
+  append_gradient_block(-A_mat*(qdot_state_k - qdot_state_k_prev)/(h_k*h_k), 0, h_k_indices, G, iG, jG);
+}
 void Hopper_Hybrid_Dynamics_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 
 
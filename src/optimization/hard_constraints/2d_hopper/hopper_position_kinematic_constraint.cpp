@@ -26,8 +26,8 @@ Hopper_Position_Kinematic_Constraint::~Hopper_Position_Kinematic_Constraint(){
 void Hopper_Position_Kinematic_Constraint::Initialization(){
 	constraint_name = "Position Constraint on link id " + std::to_string(link_id) + " dim " + std::to_string(dim) + " kp " + std::to_string(des_knotpoint);	
 
-	robot_model = HopperModel::GetRobotModel();	
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_Q, 0);
 
 }
 
@@ -47,17 +47,25 @@ void Hopper_Position_Kinematic_Constraint::initialize_Flow_Fupp(){
 
 
 void Hopper_Position_Kinematic_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
+	// pos[dim] = J_link.row(dim)*q is entirely in the A matrix
 	F_vec.clear();
-	sejong::Vector q_state;
-	sejong::Vector qdot_state;
-	var_manager.get_q_states(knotpoint, q_state);		
-	var_manager.get_qdot_states(knotpoint, qdot_state);			
+	F_vec.push_back(0.0);
+}
+void Hopper_Position_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+	// The hopper link positions are linear in q. The constant Jacobian is given in evaluate_sparse_A_matrix.
+}
+void Hopper_Position_Kinematic_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){
+	Hopper_Dimensions::Vector_q q_state = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+	Hopper_Dimensions::Vector_qdot qdot_state = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
 
-	robot_model->UpdateModel(q_state, qdot_state);
-	robot_model->getPosition(q_state, link_id, pos);
+	std::vector<int> q_indices;
+	var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, q_indices);
 
-	F_vec.push_back(pos[dim]);
-}
-void Hopper_Position_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
-void Hopper_Position_Kinematic_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
+	// pos[dim] = J_link.row(dim)*q
+	sejong::Matrix J_link;
+	HopperModel* robot_model = HopperModel::GetRobotModel();
+	robot_model->UpdateModel(q_state, qdot_state);
+	robot_model->getFullJacobian(q_state, link_id, J_link);
 
+	append_gradient_block(J_link.row(dim), 0, q_indices, A, iA, jA);
+}
\ No newline at end of file
@@ -12,9 +12,12 @@ Hopper_Back_Euler_Time_Integration_Constraint::~Hopper_Back_Euler_Time_Integrati
 
 void Hopper_Back_Euler_Time_Integration_Constraint::Initialization(){
 	constraint_name = "Hopper_Back_Euler_Time_Integration_Constraint";	
-	robot_model = HopperModel::GetRobotModel();	
 
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_Q, 0);
+	add_var_dependency(VAR_TYPE_Q, -1);
+	add_var_dependency(VAR_TYPE_QDOT, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
   std::cout << "[Hopper_Back_Euler_Time_Integration_Constraint] Initialized" << std::endl;  
 }
 
@@ -36,17 +39,18 @@ void Hopper_Back_Euler_Time_Integration_Constraint::evaluate_constraint(const in
   F_vec.clear();
 
   sejong::Vector integration_constraint; 
-  sejong::Vector q_state_k; 
-  sejong::Vector q_state_k_prev;   
-  sejong::Vector qdot_state_k; 
   double h_k;
 
   var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
-  var_manager.get_q_states(knotpoint, q_state_k);
-  var_manager.get_q_states(knotpoint-1, q_state_k_prev);  
-  var_manager.get_qdot_states(knotpoint, qdot_state_k);  
-
-  integration_constraint = q_state_k - qdot_state_k*h_k - q_state_k_prev;
+  Hopper_Dimensions::Vector_qdot qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+
+  // F = q[k] - qdot[k]*h[k] - q[k-1]. The q[k] and q[k-1] terms are in the A matrix, except for the
+  // fixed initial condition q[0], which has no column and stays here.
+  integration_constraint = -qdot_state_k*h_k;
+  if (knotpoint == 1){
+    Hopper_Dimensions::Vector_q q_state_init = var_manager.get_var_block(VAR_TYPE_Q, 0);
+    integration_constraint -= q_state_init;
+  }
 
   for(size_t i = 0; i < integration_constraint.size(); i++){
     //std::cout << "integration constraint " << i << ", value = " << integration_constraint[i] << std::endl;    
@@ -55,7 +59,33 @@ void Hopper_Back_Euler_Time_Integration_Constraint::evaluate_constraint(const in
 
 }
 
-void Hopper_Back_Euler_Time_Integration_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
-void Hopper_Back_Euler_Time_Integration_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
+void Hopper_Back_Euler_Time_Integration_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  double h_k;
+
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
+  Hopper_Dimensions::Vector_qdot qdot_state_k = var_manager.get_var_block(VAR_TYPE_QDOT, knotpoint);
+
+  std::vector<int> qdot_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_QDOT, knotpoint, qdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  // F = q[k] - qdot[k]*h[k] - q[k-1]
+  // The q[k] and q[k-1] terms are linear and are given in evaluate_sparse_A_matrix
+  sejong::Matrix I_q = sejong::Matrix::Identity(NUM_Q, NUM_Q);
+  append_gradient_block(-h_k*I_q, 0, qdot_k_indices, G, iG, jG);
+  append_gradient_block(-qdot_state_k, 0, h_k_indices, G, iG, jG);
+}
+void Hopper_Back_Euler_Time_Integration_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){
+  std::vector<int> q_k_indices;
+  std::vector<int> q_k_prev_indices;
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint, q_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_Q, knotpoint - 1, q_k_prev_indices);
+
+  // Constant coefficients of q[k] and q[k-1]. The fixed initial conditions at k = 1 stay in F.
+  sejong::Matrix I_q = sejong::Matrix::Identity(NUM_Q, NUM_Q);
+  append_gradient_block(I_q, 0, q_k_indices, A, iA, jA);
+  append_gradient_block(-I_q, 0, q_k_prev_indices, A, iA, jA);
+}
 
 
@@ -13,8 +13,8 @@ Hopper_Act_Active_Contact_Kinematic_Constraint::~Hopper_Act_Active_Contact_Kinem
 }
 
 void Hopper_Act_Active_Contact_Kinematic_Constraint::Initialization(){
-	combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
 	initialize_Flow_Fupp();
+	add_var_dependency(VAR_TYPE_X, 0);
 }
 
 void Hopper_Act_Active_Contact_Kinematic_Constraint::initialize_Flow_Fupp(){
@@ -33,25 +33,15 @@ void Hopper_Act_Active_Contact_Kinematic_Constraint::evaluate_constraint(const i
 	Contact* current_contact = contact_list_obj->get_contact(contact_index);
 	int contact_link_id = current_contact->contact_link_id;
 
-  // Get current robot states
-	sejong::Vector x_state;
-	sejong::Vector xdot_state;
-	var_manager.get_x_states(knotpoint, x_state);		
-	var_manager.get_xdot_states(knotpoint, xdot_state);			
-
-	sejong::Vector q_state;
-	sejong::Vector qdot_state;	
-
-	combined_model->convert_x_xdot_to_q_qdot(x_state, xdot_state, q_state, qdot_state);
-	combined_model->robot_model->UpdateModel(q_state, qdot_state);
+  // Get current robot states. The robot model is updated once per knotpoint state.
+	Hopper_Act_Knotpoint_State &knotpoint_state = get_hopper_act_knotpoint_state(knotpoint, var_manager);
 
   // Get distance to contact
   double distance_from_ground = 0.0;
-  current_contact->signed_distance_to_contact(q_state, distance_from_ground);
+  current_contact->signed_distance_to_contact(knotpoint_state.q, distance_from_ground);
 
   // std::cout << "knotpoint = " << knotpoint << std::endl;
-  // sejong::pretty_print(x_state, std::cout, "x_state");
-  //sejong::pretty_print(q_state, std::cout, "q_state"); 
+  //sejong::pretty_print(knotpoint_state.q, std::cout, "q_state"); 
   // std::cout << "Contact Link ID = " << contact_link_id << ", distance to contact = " << distance_from_ground << std::endl;
 
   F_vec.push_back(distance_from_ground);
@@ -60,5 +50,23 @@ void Hopper_Act_Active_Contact_Kinematic_Constraint::evaluate_constraint(const i
 
 
 
-void Hopper_Act_Active_Contact_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Hopper_Act_Active_Contact_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+	Contact* current_contact = contact_list_obj->get_contact(contact_index);
+
+	Eigen::Map<const sejong::Vector> x_state = var_manager.get_var_block(VAR_TYPE_X, knotpoint);
+
+	std::vector<int> x_indices;
+	var_manager.get_var_indices(VAR_TYPE_X, knotpoint, x_indices);
+
+	Hopper_Act_Knotpoint_State &knotpoint_state = get_hopper_act_knotpoint_state(knotpoint, var_manager);
+	Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+
+  // d Phi(q) / dx = d Phi(q) / dq * dq/dx
+  sejong::Matrix J_dist;
+  sejong::Matrix dq_dx;
+  current_contact->getSignedDistanceJacobian(knotpoint_state.q, J_dist);
+  combined_model->getJacobian_dq_dx(x_state, dq_dx);
+
+  append_gradient_block(J_dist*dq_dx, 0, x_indices, G, iG, jG);
+}
 void Hopper_Act_Active_Contact_Kinematic_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}	
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include <optimization/hard_constraints/2d_hopper_act/hopper_act_collocation_constraints.hpp>
+#include "Hopper_Definition.h"
+#include <Utils/utilities.hpp>
+
+Hopper_Act_Collocation_Constraint::Hopper_Act_Collocation_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in,
+                                                                     const int &collocation_method_in){
+  if ((collocation_method_in != COLLOCATION_TRAPEZOIDAL) && (collocation_method_in != COLLOCATION_HERMITE_SIMPSON)){
+    std::cerr << "[Hopper_Act_Collocation_Constraint] Error! Unsupported collocation method " << collocation_method_in << std::endl;
+    throw "invalid_index";
+  }
+  collocation_method = collocation_method_in;
+  contact_list_obj = contact_list_in;
+  contact_mode_schedule_obj = contact_mode_schedule_in;
+
+  // x = [q_virt, z, delta]
+	for(size_t i = 0; i < (NUM_VIRTUAL + NUM_ACT_JOINT + NUM_ACT_JOINT); i++){
+		F_low.push_back(0.0);
+		F_upp.push_back(0.0);
+	}
+	constraint_size = F_low.size();
+
+	add_var_dependency(VAR_TYPE_X, 0);
+	add_var_dependency(VAR_TYPE_X, -1);
+	add_var_dependency(VAR_TYPE_XDOT, 0);
+	add_var_dependency(VAR_TYPE_XDOT, -1);
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
+}
+
+Hopper_Act_Collocation_Constraint::~Hopper_Act_Collocation_Constraint(){}
+
+void Hopper_Act_Collocation_Constraint::set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all){
+  // The schedule tabulates the force rows of the active contacts at each knotpoint
+  Fr_all = Fr_all.cwiseProduct(contact_mode_schedule_obj->get_active_Fr_mask(knotpoint));
+}
+
+void Hopper_Act_Collocation_Constraint::get_interval(const int &knotpoint, Opt_Variable_Manager& var_manager, Hopper_Act_Interval<double> &interval){
+  interval.knotpoint = knotpoint;
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, interval.h);
+  interval.x_prev = var_manager.get_var_block(VAR_TYPE_X, knotpoint - 1);
+  interval.xdot_prev = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint - 1);
+  interval.x = var_manager.get_var_block(VAR_TYPE_X, knotpoint);
+  interval.xdot = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint);
+  interval.u = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  interval.Fr = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
+}
+
+void Hopper_Act_Collocation_Constraint::get_state_acceleration(const Hopper_Act_Interval<double>::Vector_x &x_state, const Hopper_Act_Interval<double>::Vector_x &xdot_state,
+                                                               const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state,
+                                                               Hopper_Act_Interval<double>::Vector_x &xddot_out, Hopper_Act_Interval<double>::Matrix_x &M_out){
+  Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+  if (state != NULL){
+    combined_model->UpdateModel(x_state, xdot_state, state->A, state->gravity, state->coriolis);
+    combined_model->setContactJacobian(state->get_contact_jacobian(combined_model->robot_model, contact_list_obj));
+  }else{
+    static thread_local sejong::Vector q_state;
+    static thread_local Hopper_Dimensions::Matrix_contact_jacobian Jc;
+    combined_model->UpdateModel(x_state, xdot_state);
+    combined_model->convert_x_to_q(x_state, q_state);
+    contact_list_obj->get_stacked_contact_jacobian(q_state, Jc);
+    combined_model->setContactJacobian(Jc);
+  }
+  // Forces of contacts that are inactive in the interval's mode are ignored
+  static thread_local sejong::Vector Fr_state;
+  static thread_local sejong::Vector xddot_state;
+  Fr_state = interval.Fr;
+  set_inactive_contacts_to_zero_force(interval.knotpoint, Fr_state);
+  combined_model->get_state_acceleration(x_state, xdot_state, interval.u, Fr_state, xddot_state);
+  xddot_out = xddot_state;
+  M_out = combined_model->M_combined;
+}
+
+void Hopper_Act_Collocation_Constraint::get_state_acceleration(const Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &x_state,
+                                                               const Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &xdot_state,
+                                                               const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state,
+                                                               Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &xddot_out,
+                                                               Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Matrix_x &M_out){
+  Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+  // The hopper's contact Jacobian does not depend on q, so it is a constant taken at the values of x_state
+  static thread_local sejong::Vector x_value;
+  static thread_local sejong::Vector q_state;
+  static thread_local Hopper_Dimensions::Matrix_contact_jacobian Jc;
+  get_dual_values(x_state, x_value);
+  combined_model->convert_x_to_q(x_value, q_state);
+  contact_list_obj->get_stacked_contact_jacobian(q_state, Jc);
+
+  // Columns of inactive contacts are kept in the pattern with zero entries
+  const sejong::Vector &Fr_mask = contact_mode_schedule_obj->get_active_Fr_mask(interval.knotpoint);
+  Eigen::Matrix<Hopper_Act_Interval_Dual, Eigen::Dynamic, 1, 0, Hopper_Dimensions::max_contact_dim, 1> Fr_state = interval.Fr;
+  for(size_t i = 0; i < Fr_state.size(); i++){
+    Fr_state[i] = Fr_state[i]*Fr_mask[i];
+  }
+  combined_model->get_state_acceleration(x_state, xdot_state, interval.u, Fr_state, Jc, xddot_out, M_out);
+}
+
+void Hopper_Act_Collocation_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
+  F_vec.clear();
+
+  Hopper_Act_Interval<double> interval;
+  get_interval(knotpoint, var_manager, interval);
+
+  Hopper_Act_Interval<double>::Vector_x defects;
+  compute_defects(interval, &get_hopper_act_knotpoint_state(knotpoint - 1, var_manager), &get_hopper_act_knotpoint_state(knotpoint, var_manager), defects);
+
+  for(size_t i = 0; i < defects.size(); i++){
+    F_vec.push_back(defects[i]);
+  }
+}
+
+void Hopper_Act_Collocation_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  typedef Hopper_Act_Interval_Directions Directions;
+  const int num_x = Hopper_Combined_Dimensions::num_x;
+
+  Hopper_Act_Interval<double> interval;
+  get_interval(knotpoint, var_manager, interval);
+
+  std::vector<int> x_k_prev_indices;
+  std::vector<int> xdot_k_prev_indices;
+  std::vector<int> x_k_indices;
+  std::vector<int> xdot_k_indices;
+  std::vector<int> u_k_indices;
+  std::vector<int> Fr_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_X, knotpoint - 1, x_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_XDOT, knotpoint - 1, xdot_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_X, knotpoint, x_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_XDOT, knotpoint, xdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_U, knotpoint, u_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  // The exact Jacobian w.r.t. all the variables of the interval comes from one evaluation with dual numbers
+  Hopper_Act_Interval<Hopper_Act_Interval_Dual> interval_dual;
+  interval_dual.knotpoint = knotpoint;
+  seed_dual_vector(interval.x_prev, Directions::x_prev, interval_dual.x_prev);
+  seed_dual_vector(interval.xdot_prev, Directions::xdot_prev, interval_dual.xdot_prev);
+  seed_dual_vector(interval.x, Directions::x, interval_dual.x);
+  seed_dual_vector(interval.xdot, Directions::xdot, interval_dual.xdot);
+  seed_dual_vector(interval.u, Directions::u, interval_dual.u);
+  seed_dual_vector(interval.Fr, Directions::Fr, interval_dual.Fr);
+  interval_dual.h = Hopper_Act_Interval_Dual::variable(interval.h, Directions::h);
+
+  Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x defects_dual;
+  compute_defects(interval_dual, NULL, NULL, defects_dual);
+
+  sejong::Matrix dF;
+  get_dual_jacobian(defects_dual, dF);
+
+  append_gradient_block(dF.middleCols(Directions::x_prev, num_x), 0, x_k_prev_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(Directions::xdot_prev, num_x), 0, xdot_k_prev_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(Directions::x, num_x), 0, x_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(Directions::xdot, num_x), 0, xdot_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(Directions::u, NUM_ACT_JOINT), 0, u_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(Directions::Fr, interval.Fr.size()), 0, Fr_k_indices, G, iG, jG);
+  append_gradient_block(dF.col(Directions::h), 0, h_k_indices, G, iG, jG);
+}
+
+void Hopper_Act_Collocation_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
+
+
+Hopper_Act_Collocation_Time_Integration_Constraint::Hopper_Act_Collocation_Time_Integration_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in,
+                                                                                                       const int &collocation_method_in):
+  Hopper_Act_Collocation_Constraint(contact_list_in, contact_mode_schedule_in, collocation_method_in){
+  constraint_name = (collocation_method == COLLOCATION_TRAPEZOIDAL) ? "Hopper_Act_Trapezoidal_Time_Integration_Constraint" :
+                                                                     "Hopper_Act_Hermite_Simpson_Time_Integration_Constraint";
+  std::cout << "[" << constraint_name << "] Initialized" << std::endl;
+}
+
+Hopper_Act_Collocation_Time_Integration_Constraint::~Hopper_Act_Collocation_Time_Integration_Constraint(){
+  std::cout << "[" << constraint_name << "] Destructor called" << std::endl;
+}
+
+void Hopper_Act_Collocation_Time_Integration_Constraint::compute_defects(const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state_prev,
+                                                                         Hopper_Act_Knotpoint_State* state, Hopper_Act_Interval<double>::Vector_x &F_out){
+  formulate_defects(interval, state_prev, state, F_out);
+}
+
+void Hopper_Act_Collocation_Time_Integration_Constraint::compute_defects(const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state_prev,
+                                                                         Hopper_Act_Knotpoint_State* state, Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &F_out){
+  formulate_defects(interval, state_prev, state, F_out);
+}
+
+template <typename Scalar>
+void Hopper_Act_Collocation_Time_Integration_Constraint::formulate_defects(const Hopper_Act_Interval<Scalar> &interval, Hopper_Act_Knotpoint_State* state_prev,
+                                                                           Hopper_Act_Knotpoint_State* state, typename Hopper_Act_Interval<Scalar>::Vector_x &F_out){
+  const Scalar &h = interval.h;
+  // Trapezoidal: x[k] - x[k-1] - h/2*(xdot[k-1] + xdot[k])
+  F_out = interval.x - interval.x_prev - (Scalar(0.5)*h)*(interval.xdot_prev + interval.xdot);
+
+  if (collocation_method == COLLOCATION_HERMITE_SIMPSON){
+    // Simpson's rule with the Hermite midpoint xdot_c = (xdot[k-1] + xdot[k])/2 + h/8*(xddot[k-1] - xddot[k])
+    // gives x[k] - x[k-1] - h/2*(xdot[k-1] + xdot[k]) - h^2/12*(xddot[k-1] - xddot[k])
+    typename Hopper_Act_Interval<Scalar>::Vector_x xddot_prev;
+    typename Hopper_Act_Interval<Scalar>::Vector_x xddot;
+    typename Hopper_Act_Interval<Scalar>::Matrix_x M_state;
+    get_state_acceleration(interval.x_prev, interval.xdot_prev, interval, state_prev, xddot_prev, M_state);
+    get_state_acceleration(interval.x, interval.xdot, interval, state, xddot, M_state);
+    F_out -= (h*h/Scalar(12.0))*(xddot_prev - xddot);
+  }
+}
+
+
+Hopper_Act_Collocation_Hybrid_Dynamics_Constraint::Hopper_Act_Collocation_Hybrid_Dynamics_Constraint(Contact_List* contact_list_in, Contact_Mode_Schedule* contact_mode_schedule_in,
+                                                                                                     const int &collocation_method_in):
+  Hopper_Act_Collocation_Constraint(contact_list_in, contact_mode_schedule_in, collocation_method_in){
+  constraint_name = (collocation_method == COLLOCATION_TRAPEZOIDAL) ? "Hopper_Act_Trapezoidal_Hybrid_Dynamics_Constraint" :
+                                                                     "Hopper_Act_Hermite_Simpson_Hybrid_Dynamics_Constraint";
+  std::cout << "[" << constraint_name << "] Initialized" << std::endl;
+}
+
+Hopper_Act_Collocation_Hybrid_Dynamics_Constraint::~Hopper_Act_Collocation_Hybrid_Dynamics_Constraint(){
+  std::cout << "[" << constraint_name << "] Destructor called" << std::endl;
+}
+
+void Hopper_Act_Collocation_Hybrid_Dynamics_Constraint::compute_defects(const Hopper_Act_Interval<double> &interval, Hopper_Act_Knotpoint_State* state_prev,
+                                                                        Hopper_Act_Knotpoint_State* state, Hopper_Act_Interval<double>::Vector_x &F_out){
+  formulate_defects(interval, state_prev, state, F_out);
+}
+
+void Hopper_Act_Collocation_Hybrid_Dynamics_Constraint::compute_defects(const Hopper_Act_Interval<Hopper_Act_Interval_Dual> &interval, Hopper_Act_Knotpoint_State* state_prev,
+                                                                        Hopper_Act_Knotpoint_State* state, Hopper_Act_Interval<Hopper_Act_Interval_Dual>::Vector_x &F_out){
+  formulate_defects(interval, state_prev, state, F_out);
+}
+
+template <typename Scalar>
+void Hopper_Act_Collocation_Hybrid_Dynamics_Constraint::formulate_defects(const Hopper_Act_Interval<Scalar> &interval, Hopper_Act_Knotpoint_State* state_prev,
+                                                                          Hopper_Act_Knotpoint_State* state, typename Hopper_Act_Interval<Scalar>::Vector_x &F_out){
+  typedef typename Hopper_Act_Interval<Scalar>::Vector_x Vector_x_s;
+  typedef typename Hopper_Act_Interval<Scalar>::Matrix_x Matrix_x_s;
+  const Scalar &h = interval.h;
+  Vector_x_s xddot_prev;
+  Vector_x_s xddot;
+  Vector_x_s xddot_integral;
+  Matrix_x_s M_prev;
+  Matrix_x_s M_k; // The rows are scaled by M at x[k]
+
+  get_state_acceleration(interval.x_prev, interval.xdot_prev, interval, state_prev, xddot_prev, M_prev);
+  get_state_acceleration(interval.x, interval.xdot, interval, state, xddot, M_k);
+
+  if (collocation_method == COLLOCATION_TRAPEZOIDAL){
+    xddot_integral = (Scalar(0.5)*h)*(xddot_prev + xddot);
+  }else{
+    // The Hermite midpoint is not a knotpoint, so its model state is never cached
+    Vector_x_s xddot_c;
+    Matrix_x_s M_c;
+    Vector_x_s x_c = Scalar(0.5)*(interval.x_prev + interval.x) + (h/Scalar(8.0))*(interval.xdot_prev - interval.xdot);
+    Vector_x_s xdot_c = Scalar(0.5)*(interval.xdot_prev + interval.xdot) + (h/Scalar(8.0))*(xddot_prev - xddot);
+    get_state_acceleration(x_c, xdot_c, interval, NULL, xddot_c, M_c);
+    xddot_integral = (h/Scalar(6.0))*(xddot_prev + Scalar(4.0)*xddot_c + xddot);
+  }
+
+  F_out = M_k*(interval.xdot - interval.xdot_prev - xddot_integral);
+}
@@ -1,7 +1,22 @@
 #include <optimization/hard_constraints/2d_hopper_act/hopper_act_hybrid_dynamics_constraint.hpp>
+#include <optimization/autodiff/dual.hpp>
 #include "Hopper_Definition.h"
 #include <Utils/utilities.hpp>
-#include <algorithm>
+
+namespace{
+  // Directions of the dual numbers. The variables are [x_k, xdot_k, xdot_k-1, u_k, Fr_k, h_k].
+  const int NUM_X = Hopper_Combined_Dimensions::num_x;
+  const int MAX_FR = Hopper_Dimensions::max_contact_dim;
+  const int X_K_DIRECTION = 0;
+  const int XDOT_K_DIRECTION = X_K_DIRECTION + NUM_X;
+  const int XDOT_K_PREV_DIRECTION = XDOT_K_DIRECTION + NUM_X;
+  const int U_K_DIRECTION = XDOT_K_PREV_DIRECTION + NUM_X;
+  const int FR_K_DIRECTION = U_K_DIRECTION + NUM_ACT_JOINT;
+  const int H_K_DIRECTION = FR_K_DIRECTION + MAX_FR;
+  const int NUM_DIRECTIONS = H_K_DIRECTION + 1;
+
+  typedef Dual<NUM_DIRECTIONS> Dynamics_Dual;
+}
 
 Hopper_Act_Hybrid_Dynamics_Constraint::Hopper_Act_Hybrid_Dynamics_Constraint(){
 	Initialization();
@@ -19,9 +34,14 @@ Hopper_Act_Hybrid_Dynamics_Constraint::~Hopper_Act_Hybrid_Dynamics_Constraint(){
 
 void Hopper_Act_Hybrid_Dynamics_Constraint::Initialization(){
 	constraint_name = "Hopper_Act_Hybrid_Dynamics_Constraint";	
-	combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();	
 
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_X, 0);
+	add_var_dependency(VAR_TYPE_XDOT, 0);
+	add_var_dependency(VAR_TYPE_XDOT, -1);
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
   std::cout << "[Hopper_Act_Hybrid_Dynamics_Constraint] Initialized" << std::endl;  
 }
 
@@ -45,99 +65,33 @@ void Hopper_Act_Hybrid_Dynamics_Constraint::initialize_Flow_Fupp(){
 	constraint_size = F_low.size();
 }
 
-void Hopper_Act_Hybrid_Dynamics_Constraint::Update_Contact_Jacobian_Jc(sejong::Vector &q_state){
-  // Stack the contact Jacobians
-  // Extract the segment of Reaction Forces corresponding to this contact-------------------
-  sejong::Matrix J_tmp;
-  int prev_row_size = 0;
-  for (size_t i = 0; i < contact_list_obj->get_size(); i++){
-    // Get the Jacobian for the current contact
-    contact_list_obj->get_contact(i)->getContactJacobian(q_state, J_tmp);   
-    Jc.conservativeResize(prev_row_size + J_tmp.rows(), NUM_QDOT);
-   	Jc.block(prev_row_size, 0, J_tmp.rows(), NUM_QDOT) = J_tmp;
-   	prev_row_size += J_tmp.rows();
-  }
-
-}
-
 void Hopper_Act_Hybrid_Dynamics_Constraint::set_inactive_contacts_to_zero_force(const int& knotpoint, sejong::Vector &Fr_all){
-  // Get all the active_contacts
-  std::vector<int> active_contacts;
-  contact_mode_schedule_obj->get_active_contacts(knotpoint, active_contacts);
-
-  // std::cout << "" <<std::endl;
-  // std::cout << "Knotpoint = " << knotpoint << " has active contacts with indices: ";
-  // if (active_contacts.size() == 0){
-  //   std::cout << "no active contacts" << std::endl;
-  // }else{
-  //   for (size_t i = 0; i < active_contacts.size(); i++){
-  //     std::cout << active_contacts[i] << ",";
-  //   }
-  //   std::cout << "" <<std::endl;
-  // }
-
-
-  // Go through all the contacts. If it is not in the active_contacts list, set the contact forces to 0.
-  Contact* current_contact;
-  int current_contact_size;
-  sejong::Vector Fr_contact;
-
-  for (size_t contact_index = 0; contact_index < contact_list_obj->get_size(); contact_index++){
-  // Get the current contact    
-    current_contact = contact_list_obj->get_contact(contact_index);
-    current_contact_size = current_contact->contact_dim;
-
-    // Extract the segment of Reaction Forces corresponding to this contact-------------------
-    int index_offset = 0;
-    for (size_t i = 0; i < contact_index; i++){
-      index_offset += contact_list_obj->get_contact(i)->contact_dim;   
-    }
-
-    // The contact forces for this contact
-    // Fr_contact = Fr_all.segment(index_offset, current_contact_size);
-
-    // Check if this is an active contact:
-    if (!(std::find(active_contacts.begin(), active_contacts.end(), contact_index) != active_contacts.end())) {
-      /* Contact index is not in this list */
-      // Set the contact forces to 0.
-       Fr_all.segment(index_offset, current_contact_size) = sejong::Vector::Zero(current_contact_size);
-    }
-
-  }
-
-
+  // The schedule tabulates the force rows of the active contacts at each knotpoint
+  Fr_all = Fr_all.cwiseProduct(contact_mode_schedule_obj->get_active_Fr_mask(knotpoint));
 }
 
 
 void Hopper_Act_Hybrid_Dynamics_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
   F_vec.clear();
 
-  sejong::Vector x_state_k; 
-  sejong::Vector q_state_k;
   sejong::Vector x_state_k_prev;   
-  sejong::Vector xdot_state_k; 
-  sejong::Vector xdot_state_k_prev; 
 
   double h_k;
-  sejong::Vector u_state_k;
-  sejong::Vector Fr_state_k;
   sejong::Vector dynamics_k; 
   var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
 
-  var_manager.get_x_states(knotpoint, x_state_k);
-  var_manager.get_xdot_states(knotpoint, xdot_state_k);
-  var_manager.get_xdot_states(knotpoint-1, xdot_state_k_prev);
+  Eigen::Map<const sejong::Vector> x_state_k = var_manager.get_var_block(VAR_TYPE_X, knotpoint);
+  Eigen::Map<const sejong::Vector> xdot_state_k = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint);
+  Eigen::Map<const sejong::Vector> xdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint-1);
 
-  var_manager.get_u_states(knotpoint, u_state_k);
-  var_manager.get_var_reaction_forces(knotpoint, Fr_state_k);  
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  sejong::Vector Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint); // Copied, the inactive contacts are zeroed below
 
-
-  // Update robot model then update the Jacobian
-  combined_model->UpdateModel(x_state_k, xdot_state_k);
-  combined_model->convert_x_to_q(x_state_k, q_state_k);
-  Update_Contact_Jacobian_Jc(q_state_k);
-  // Update the combined_model's Jacobian
-  combined_model->setContactJacobian(Jc); 
+  // Update the combined model and its contact Jacobian from the robot model state shared by the knotpoint's constraints
+  Hopper_Act_Knotpoint_State &knotpoint_state = get_hopper_act_knotpoint_state(knotpoint, var_manager);
+  Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+  combined_model->UpdateModel(x_state_k, xdot_state_k, knotpoint_state.A, knotpoint_state.gravity, knotpoint_state.coriolis);
+  combined_model->setContactJacobian(knotpoint_state.get_contact_jacobian(combined_model->robot_model, contact_list_obj)); 
   set_inactive_contacts_to_zero_force(knotpoint, Fr_state_k);
 
   combined_model->getDynamics_constraint(x_state_k, xdot_state_k, xdot_state_k_prev, u_state_k, Fr_state_k, h_k, dynamics_k);
@@ -148,7 +102,97 @@ void Hopper_Act_Hybrid_Dynamics_Constraint::evaluate_constraint(const int &knotp
   }
 
 }
-void Hopper_Act_Hybrid_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Hopper_Act_Hybrid_Dynamics_Constraint::evaluate_constraint_batch(const std::vector<int> &knotpoints, Opt_Variable_Manager& var_manager, double* F_eval, const int &knotpoint_stride){
+  if (knotpoints.empty()){
+    return;
+  }
+
+  // Stack the variables of the knotpoints, one knotpoint per row
+  batch.resize(knotpoints.size(), var_manager.get_var_block(VAR_TYPE_FR, knotpoints[0]).size());
+  for(size_t i = 0; i < knotpoints.size(); i++){
+    const int &knotpoint = knotpoints[i];
+    batch.x.row(i) = var_manager.get_var_block(VAR_TYPE_X, knotpoint).transpose();
+    batch.xdot.row(i) = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint).transpose();
+    batch.xdot_prev.row(i) = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint - 1).transpose();
+    batch.u.row(i) = var_manager.get_var_block(VAR_TYPE_U, knotpoint).transpose();
+    batch.Fr.row(i) = var_manager.get_var_block(VAR_TYPE_FR, knotpoint).cwiseProduct(contact_mode_schedule_obj->get_active_Fr_mask(knotpoint)).transpose();
+    var_manager.get_var_knotpoint_dt(knotpoint - 1, batch.h[i]);
+  }
+
+  // The hopper's contact Jacobian does not depend on q, so the one of the first knotpoint serves every knotpoint
+  Hopper_Act_Knotpoint_State &knotpoint_state = get_hopper_act_knotpoint_state(knotpoints[0], var_manager);
+  Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+  combined_model->setContactJacobian(knotpoint_state.get_contact_jacobian(combined_model->robot_model, contact_list_obj));
+  combined_model->getDynamics_constraint_batch(batch, dynamics_batch);
+
+  for(size_t i = 0; i < knotpoints.size(); i++){
+    double* F_out = F_eval + (knotpoints[i] - 1)*knotpoint_stride + constraint_index;
+    for(int j = 0; j < NUM_X; j++){
+      F_out[j] = dynamics_batch(i, j);
+    }
+  }
+}
+
+void Hopper_Act_Hybrid_Dynamics_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  double h_k;
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
+
+  Eigen::Map<const sejong::Vector> x_state_k = var_manager.get_var_block(VAR_TYPE_X, knotpoint);
+  Eigen::Map<const sejong::Vector> xdot_state_k = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint);
+  Eigen::Map<const sejong::Vector> xdot_state_k_prev = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint-1);
+
+  Eigen::Map<const sejong::Vector> u_state_k = var_manager.get_var_block(VAR_TYPE_U, knotpoint);
+  Eigen::Map<const sejong::Vector> Fr_state_k = var_manager.get_var_block(VAR_TYPE_FR, knotpoint);
+
+  std::vector<int> x_k_indices;
+  std::vector<int> xdot_k_indices;
+  std::vector<int> xdot_k_prev_indices;
+  std::vector<int> u_k_indices;
+  std::vector<int> Fr_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_X, knotpoint, x_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_XDOT, knotpoint, xdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_XDOT, knotpoint - 1, xdot_k_prev_indices);
+  var_manager.get_var_indices(VAR_TYPE_U, knotpoint, u_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_FR, knotpoint, Fr_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  Hopper_Act_Knotpoint_State &knotpoint_state = get_hopper_act_knotpoint_state(knotpoint, var_manager);
+  Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+  const Hopper_Dimensions::Matrix_contact_jacobian &Jc = knotpoint_state.get_contact_jacobian(combined_model->robot_model, contact_list_obj);
+
+  // The exact Jacobian w.r.t. all the variables of the knotpoint comes from one evaluation with dual numbers
+  Eigen::Matrix<Dynamics_Dual, NUM_X, 1> x_k_dual;
+  Eigen::Matrix<Dynamics_Dual, NUM_X, 1> xdot_k_dual;
+  Eigen::Matrix<Dynamics_Dual, NUM_X, 1> xdot_k_prev_dual;
+  Eigen::Matrix<Dynamics_Dual, NUM_ACT_JOINT, 1> u_k_dual;
+  Eigen::Matrix<Dynamics_Dual, Eigen::Dynamic, 1, 0, MAX_FR, 1> Fr_k_dual;
+  seed_dual_vector(x_state_k, X_K_DIRECTION, x_k_dual);
+  seed_dual_vector(xdot_state_k, XDOT_K_DIRECTION, xdot_k_dual);
+  seed_dual_vector(xdot_state_k_prev, XDOT_K_PREV_DIRECTION, xdot_k_prev_dual);
+  seed_dual_vector(u_state_k, U_K_DIRECTION, u_k_dual);
+  seed_dual_vector(Fr_state_k, FR_K_DIRECTION, Fr_k_dual);
+  Dynamics_Dual h_k_dual = Dynamics_Dual::variable(h_k, H_K_DIRECTION);
+
+  // Columns of inactive contacts are kept in the pattern with zero entries
+  const sejong::Vector &Fr_mask = contact_mode_schedule_obj->get_active_Fr_mask(knotpoint);
+  for(size_t i = 0; i < Fr_k_dual.size(); i++){
+    Fr_k_dual[i] = Fr_k_dual[i]*Fr_mask[i];
+  }
+
+  Eigen::Matrix<Dynamics_Dual, NUM_X, 1> dynamics_dual;
+  combined_model->getDynamics_constraint(x_k_dual, xdot_k_dual, xdot_k_prev_dual, u_k_dual, Fr_k_dual, h_k_dual, Jc, dynamics_dual);
+
+  sejong::Matrix dF;
+  get_dual_jacobian(dynamics_dual, dF);
+
+  append_gradient_block(dF.middleCols(X_K_DIRECTION, NUM_X), 0, x_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(XDOT_K_DIRECTION, NUM_X), 0, xdot_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(XDOT_K_PREV_DIRECTION, NUM_X), 0, xdot_k_prev_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(U_K_DIRECTION, NUM_ACT_JOINT), 0, u_k_indices, G, iG, jG);
+  append_gradient_block(dF.middleCols(FR_K_DIRECTION, Fr_state_k.size()), 0, Fr_k_indices, G, iG, jG);
+  append_gradient_block(dF.col(H_K_DIRECTION), 0, h_k_indices, G, iG, jG);
+}
 void Hopper_Act_Hybrid_Dynamics_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 
 
@@ -0,0 +1,21 @@
+#include <optimization/hard_constraints/2d_hopper_act/hopper_act_knotpoint_state.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
+
+Hopper_Act_Knotpoint_State& get_hopper_act_knotpoint_state(const int &knotpoint, Opt_Variable_Manager &var_manager){
+	return Knotpoint_Model_Cache<Hopper_Act_Knotpoint_State>::get_state(knotpoint, var_manager, [&](Hopper_Act_Knotpoint_State &state){
+		OPT_PROFILE_SCOPE("model", "Hopper_Act_Knotpoint_State fill");
+		static thread_local sejong::Vector x_state;
+		static thread_local sejong::Vector xdot_state;
+		var_manager.get_x_states(knotpoint, x_state);
+		var_manager.get_xdot_states(knotpoint, xdot_state);
+
+		Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+		combined_model->convert_x_xdot_to_q_qdot(x_state, xdot_state, state.q, state.qdot);
+
+		HopperModel* robot_model = combined_model->robot_model;
+		robot_model->UpdateModel(state.q, state.qdot);
+		robot_model->getMassInertia(state.A);
+		robot_model->getCoriolis(state.coriolis);
+		robot_model->getGravity(state.gravity);
+	});
+}
@@ -1,5 +1,6 @@
 #include <Utils/utilities.hpp>
 #include <optimization/hard_constraints/2d_hopper_act/hopper_act_position_kinematic_constraint.hpp>
+#include <optimization/autodiff/dual.hpp>
 
 Hopper_Act_Position_Kinematic_Constraint::Hopper_Act_Position_Kinematic_Constraint(int knotpoint_in, int link_id_in, int dim_in, double l_bound_in, double u_bound_in){
 	des_knotpoint = knotpoint_in;
@@ -25,8 +26,8 @@ Hopper_Act_Position_Kinematic_Constraint::~Hopper_Act_Position_Kinematic_Constra
 void Hopper_Act_Position_Kinematic_Constraint::Initialization(){
 	constraint_name = "Position Constraint on link id " + std::to_string(link_id) + " dim " + std::to_string(dim) + " kp " + std::to_string(des_knotpoint);	
 
-	combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();	
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_X, 0);
 
 }
 
@@ -47,23 +48,36 @@ void Hopper_Act_Position_Kinematic_Constraint::initialize_Flow_Fupp(){
 
 void Hopper_Act_Position_Kinematic_Constraint::evaluate_constraint(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& F_vec){
 	F_vec.clear();
-	sejong::Vector x_state;
-	sejong::Vector xdot_state;
-	var_manager.get_x_states(knotpoint, x_state);		
-	var_manager.get_xdot_states(knotpoint, xdot_state);			
+	// The link position is computed once per knotpoint state and shared with the other constraints
+	Hopper_Act_Knotpoint_State &knotpoint_state = get_hopper_act_knotpoint_state(knotpoint, var_manager);
+	Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+	const Link_Kinematics &link = knotpoint_state.get_link_kinematics(combined_model->robot_model, link_id);
 
-	sejong::Vector q_state;
-	sejong::Vector qdot_state;	
+	// sejong::pretty_print(link.pos, std::cout, "pos");	
 
-	combined_model->convert_x_xdot_to_q_qdot(x_state, xdot_state, q_state, qdot_state);
-	combined_model->robot_model->UpdateModel(q_state, qdot_state);
-	combined_model->robot_model->getPosition(q_state, link_id, pos);
-
-	// sejong::pretty_print(q_state, std::cout, "q_state");
-	// sejong::pretty_print(pos, std::cout, "pos");	
-
-	F_vec.push_back(pos[dim]);
+	F_vec.push_back(link.pos[dim]);
+}
+void Hopper_Act_Position_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+	Eigen::Map<const sejong::Vector> x_state = var_manager.get_var_block(VAR_TYPE_X, knotpoint);
+
+	std::vector<int> x_indices;
+	var_manager.get_var_indices(VAR_TYPE_X, knotpoint, x_indices);
+
+	// d pos[dim] / dx through the x to q conversion and the link position with dual numbers.
+	// The hopper's link positions are 1D, so dim is Z_DIM.
+	typedef Dual<Hopper_Combined_Dimensions::num_x> Kinematics_Dual;
+	Eigen::Matrix<Kinematics_Dual, Hopper_Combined_Dimensions::num_x, 1> x_dual;
+	Eigen::Matrix<Kinematics_Dual, NUM_Q, 1> q_dual;
+	Eigen::Matrix<Kinematics_Dual, 1, 1> pos_dual;
+	seed_dual_vector(x_state, 0, x_dual);
+
+	Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+	combined_model->convert_x_to_q(x_dual, q_dual);
+	pos_dual[0] = combined_model->robot_model->getPosition(q_dual, link_id);
+
+	sejong::Matrix dpos_dx;
+	get_dual_jacobian(pos_dual, dpos_dx);
+	append_gradient_block(dpos_dx, 0, x_indices, G, iG, jG);
 }
-void Hopper_Act_Position_Kinematic_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
 void Hopper_Act_Position_Kinematic_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 
@@ -14,6 +14,10 @@ void Hopper_Act_Back_Euler_Time_Integration_Constraint::Initialization(){
 	constraint_name = "Hopper_Act_Back_Euler_Time_Integration_Constraint";	
 
 	initialize_Flow_Fupp();	
+	add_var_dependency(VAR_TYPE_X, 0);
+	add_var_dependency(VAR_TYPE_X, -1);
+	add_var_dependency(VAR_TYPE_XDOT, 0);
+	add_var_dependency(VAR_TYPE_H, 0);
   std::cout << "[Hopper_Act_Back_Euler_Time_Integration_Constraint] Initialized" << std::endl;  
 }
 
@@ -35,17 +39,18 @@ void Hopper_Act_Back_Euler_Time_Integration_Constraint::evaluate_constraint(cons
   F_vec.clear();
 
   sejong::Vector integration_constraint; 
-  sejong::Vector x_state_k; 
-  sejong::Vector x_state_k_prev;   
-  sejong::Vector xdot_state_k; 
   double h_k;
 
   var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
-  var_manager.get_x_states(knotpoint, x_state_k);
-  var_manager.get_x_states(knotpoint-1, x_state_k_prev);  
-  var_manager.get_xdot_states(knotpoint, xdot_state_k);  
-
-  integration_constraint = x_state_k - xdot_state_k*h_k - x_state_k_prev;
+  Eigen::Map<const sejong::Vector> xdot_state_k = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint);
+
+  // F = x[k] - xdot[k]*h[k] - x[k-1]. The x[k] and x[k-1] terms are in the A matrix, except for the
+  // fixed initial condition x[0], which has no column and stays here.
+  integration_constraint = -xdot_state_k*h_k;
+  if (knotpoint == 1){
+    Eigen::Map<const sejong::Vector> x_state_init = var_manager.get_var_block(VAR_TYPE_X, 0);
+    integration_constraint -= x_state_init;
+  }
 
   for(size_t i = 0; i < integration_constraint.size(); i++){
     //std::cout << "integration constraint " << i << ", value = " << integration_constraint[i] << std::endl;    
@@ -54,7 +59,33 @@ void Hopper_Act_Back_Euler_Time_Integration_Constraint::evaluate_constraint(cons
 
 }
 
-void Hopper_Act_Back_Euler_Time_Integration_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
-void Hopper_Act_Back_Euler_Time_Integration_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
+void Hopper_Act_Back_Euler_Time_Integration_Constraint::evaluate_sparse_gradient(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+  double h_k;
+
+  var_manager.get_var_knotpoint_dt(knotpoint - 1, h_k);
+  Eigen::Map<const sejong::Vector> xdot_state_k = var_manager.get_var_block(VAR_TYPE_XDOT, knotpoint);
+
+  std::vector<int> xdot_k_indices;
+  std::vector<int> h_k_indices;
+  var_manager.get_var_indices(VAR_TYPE_XDOT, knotpoint, xdot_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_H, knotpoint, h_k_indices);
+
+  // F = x[k] - xdot[k]*h[k] - x[k-1]
+  // The x[k] and x[k-1] terms are linear and are given in evaluate_sparse_A_matrix
+  sejong::Matrix I_x = sejong::Matrix::Identity(constraint_size, constraint_size);
+  append_gradient_block(-h_k*I_x, 0, xdot_k_indices, G, iG, jG);
+  append_gradient_block(-xdot_state_k, 0, h_k_indices, G, iG, jG);
+}
+void Hopper_Act_Back_Euler_Time_Integration_Constraint::evaluate_sparse_A_matrix(const int &knotpoint, Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){
+  std::vector<int> x_k_indices;
+  std::vector<int> x_k_prev_indices;
+  var_manager.get_var_indices(VAR_TYPE_X, knotpoint, x_k_indices);
+  var_manager.get_var_indices(VAR_TYPE_X, knotpoint - 1, x_k_prev_indices);
+
+  // Constant coefficients of x[k] and x[k-1]. The fixed initial conditions at k = 1 stay in F.
+  sejong::Matrix I_x = sejong::Matrix::Identity(constraint_size, constraint_size);
+  append_gradient_block(I_x, 0, x_k_indices, A, iA, jA);
+  append_gradient_block(-I_x, 0, x_k_prev_indices, A, iA, jA);
+}
 
 
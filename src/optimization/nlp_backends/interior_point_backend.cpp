@@ -0,0 +1,938 @@
+#include <optimization/nlp_backends/interior_point_backend.hpp>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+namespace{
+	const double BOUND_PUSH = 1e-2;       // Relative distance of the starting point from its bounds
+	const double BOUND_FRAC = 1e-2;       // Largest push as a fraction of the bound range
+	const double TAU_MIN = 0.99;          // Fraction to the boundary
+	const double KAPPA_EPSILON = 10.0;    // The barrier problem is solved to KAPPA_EPSILON*mu
+	const double KAPPA_MU = 0.2;          // Linear decrease of mu
+	const double THETA_MU = 1.5;          // Superlinear decrease of mu
+	const double KAPPA_SIGMA = 1e10;      // Bound multipliers stay within this factor of mu/slack
+	// Filter line search, see Waechter and Biegler, Mathematical Programming 106(1), 2006
+	const double GAMMA_THETA = 1e-5;      // Required decrease of the constraint violation
+	const double GAMMA_PHI = 1e-8;        // Required decrease of the barrier objective
+	const double GAMMA_ALPHA = 0.05;      // Safety factor of the smallest step
+	const double ETA_PHI = 1e-8;          // Armijo condition
+	const double DELTA_SWITCH = 1.0;      // Switching condition: alpha*(-grad_phi*dz)^S_PHI > DELTA_SWITCH*theta^S_THETA
+	const double S_THETA = 1.1;
+	const double S_PHI = 2.3;
+	const double THETA_MAX_FACTOR = 1e4;  // Largest constraint violation relative to the start
+	const double THETA_MIN_FACTOR = 1e-4; // Below this violation the objective must decrease
+	const double KAPPA_SOC = 0.99;        // Required decrease of the violation by each second order correction
+	const int MAX_SOC = 4;
+	const double MIN_RESTORATION_STEP = 1e-10; // Shortest step of a restoration line search
+	const int MAX_FAILED_LINE_SEARCHES = 10; // Line searches in a row that end in a restoration step
+	const double MAX_SCALED_GRADIENT = 100.0; // Rows are scaled down until their gradient is at most this at the start
+	const double DELTA_C = 1e-8;          // Dual regularization
+	const double DELTA_W_FIRST = 1e-4;
+	const double DELTA_W_MAX = 1e40;
+	const double SCALING_S_MAX = 100.0;
+	const double HESSIAN_FD_STEP = 1e-7;  // Relative perturbation of the variables for the Hessian
+
+	// Rows of F whose G entries depend on the same variables share one dense Hessian block
+	struct Hessian_Element{
+		std::vector<int> cols; // Sorted variable indices
+		sejong::Matrix H;
+	};
+
+	class Interior_Point_Solver{
+	public:
+		Interior_Point_Solver(Optimization_Problem_Main* opt_problem_in, const bool &verbose_in): opt_problem(opt_problem_in), verbose(verbose_in){}
+
+		int solve(const double &tolerance, const double &constraint_tolerance, const int &max_iterations, int &iterations_out, std::vector<double> &x_out);
+
+	private:
+		Optimization_Problem_Main* opt_problem;
+		bool verbose;
+
+		int n = 0;  // Problem variables
+		int nz = 0; // Problem variables and slacks
+		int m = 0;  // Constraints
+		int obj_row = 0;
+
+		std::vector<double> F_low;
+		std::vector<double> F_upp;
+		std::vector<int> con_rows;   // Row of F of each constraint
+		std::vector<int> con_slack;  // Slack variable of each constraint or -1 for equalities
+		std::vector<int> row_to_con; // Constraint of each row of F or -1
+
+		sejong::Vector z_low;
+		sejong::Vector z_upp;
+		std::vector<bool> has_low;
+		std::vector<bool> has_upp;
+		std::vector<bool> is_fixed;
+
+		double obj_scale = 1.0;
+		sejong::Vector con_scale;
+
+		std::vector<double> A_eval;
+		std::vector<int> iAfun;
+		std::vector<int> jAvar;
+		std::vector<double> G_eval;
+		std::vector<int> iGfun;
+		std::vector<int> jGvar;
+		int neG = 0;
+
+		// Current iterate
+		sejong::Vector z;
+		sejong::Vector lambda;
+		sejong::Vector z_l; // Multipliers of the lower bounds
+		sejong::Vector z_u; // Multipliers of the upper bounds
+		std::vector<double> F_eval;
+		sejong::Vector grad_f;
+		Eigen::SparseMatrix<double> J;
+
+		bool use_exact_hessian = false;
+		std::vector<Hessian_Element> elements;
+		std::vector<int> row_to_element;
+		// Variables perturbed together for the finite difference Hessian. No element has two variables of the same color.
+		std::vector< std::vector<int> > color_cols;
+		std::vector< std::vector< std::pair<int, int> > > color_element_cols; // (element, local column) of each color
+		double last_delta_w = 0.0;
+		Eigen::SimplicialLDLT< Eigen::SparseMatrix<double>, Eigen::Lower > ldlt; // Factorization of the last KKT matrix
+
+		// (theta, phi) pairs that trial points must improve on. Cleared when mu decreases.
+		std::vector< std::pair<double, double> > filter;
+		double theta_min = 0.0;
+		double theta_max = 0.0;
+
+		void initialize_structure();
+		void initialize_point();
+		void push_into_bounds(const int &j, double &value);
+
+		void evaluate_F(const sejong::Vector &z_eval, std::vector<double> &F_out);
+		void evaluate_derivatives();
+		void compute_scaling();
+		void constraint_values(const sejong::Vector &z_eval, const std::vector<double> &F_in, sejong::Vector &g_out);
+		double unscaled_violation(const std::vector<double> &F_in);
+		double barrier_objective(const sejong::Vector &z_eval, const std::vector<double> &F_in, const double &mu);
+		void barrier_gradient(const double &mu, sejong::Vector &grad_out);
+		double optimality_error(const double &mu, const sejong::Vector &g);
+
+		double row_weight(const int &row);
+		void initialize_hessian_elements();
+		void accumulate_element_gradients(const std::vector<double> &G_in, const std::vector<int> &iG_in, const std::vector<int> &jG_in,
+										  const int &ne, std::vector<sejong::Vector> &g_out);
+		void compute_hessian_elements();
+		void append_hessian(std::vector< Eigen::Triplet<double> > &triplets);
+		bool factorize_kkt(const bool &with_hessian);
+		void kkt_rhs(const double &mu, const sejong::Vector &g, sejong::Vector &rhs_out);
+		bool solve_kkt(const sejong::Vector &rhs, sejong::Vector &dz, sejong::Vector &dlambda);
+		double max_primal_step(const sejong::Vector &dz, const double &tau);
+		void bound_multiplier_steps(const double &mu, const sejong::Vector &dz, const double &tau,
+									sejong::Vector &dz_l_out, sejong::Vector &dz_u_out, double &alpha_z_out);
+		bool is_acceptable(const double &theta, const double &phi, const double &theta_trial, const double &phi_trial,
+						   const double &alpha, const double &grad_phi_dz, bool &armijo_out);
+		bool restoration_step(const sejong::Vector &g, const double &theta, const double &tau, sejong::Vector &z_out, std::vector<double> &F_out);
+	};
+
+	void Interior_Point_Solver::push_into_bounds(const int &j, double &value){
+		if (is_fixed[j]){
+			value = z_low[j];
+			return;
+		}
+		double range = (has_low[j] && has_upp[j]) ? (z_upp[j] - z_low[j]) : OPT_INFINITY;
+		if (has_low[j]){
+			double push = std::min(BOUND_PUSH*std::max(1.0, std::fabs(z_low[j])), BOUND_FRAC*range);
+			value = std::max(value, z_low[j] + push);
+		}
+		if (has_upp[j]){
+			double push = std::min(BOUND_PUSH*std::max(1.0, std::fabs(z_upp[j])), BOUND_FRAC*range);
+			value = std::min(value, z_upp[j] - push);
+		}
+	}
+
+	void Interior_Point_Solver::initialize_structure(){
+		std::vector<double> x_low;
+		std::vector<double> x_upp;
+		opt_problem->get_opt_vars_bounds(x_low, x_upp);
+		opt_problem->get_F_bounds(F_low, F_upp);
+		opt_problem->get_F_obj_Row(obj_row);
+		n = x_low.size();
+
+		// Rows without bounds do not constrain the problem
+		row_to_con.assign(F_low.size(), -1);
+		int num_slacks = 0;
+		for(size_t r = 0; r < F_low.size(); r++){
+			bool bounded = (F_low[r] > -OPT_INFINITY) || (F_upp[r] < OPT_INFINITY);
+			if ((r == obj_row) || !bounded){
+				continue;
+			}
+			row_to_con[r] = con_rows.size();
+			con_rows.push_back(r);
+			if (F_upp[r] - F_low[r] > OPT_ZERO_GRADIENT_EPS){
+				con_slack.push_back(n + num_slacks);
+				num_slacks++;
+			}else{
+				con_slack.push_back(-1);
+			}
+		}
+		m = con_rows.size();
+		nz = n + num_slacks;
+
+		z_low = sejong::Vector::Zero(nz);
+		z_upp = sejong::Vector::Zero(nz);
+		for(int j = 0; j < n; j++){
+			z_low[j] = x_low[j];
+			z_upp[j] = x_upp[j];
+		}
+		for(int i = 0; i < m; i++){
+			if (con_slack[i] >= 0){
+				z_low[con_slack[i]] = F_low[con_rows[i]];
+				z_upp[con_slack[i]] = F_upp[con_rows[i]];
+			}
+		}
+		has_low.assign(nz, false);
+		has_upp.assign(nz, false);
+		is_fixed.assign(nz, false);
+		for(int j = 0; j < nz; j++){
+			// Variables with equal bounds are left out of the barrier and never move
+			if ((z_low[j] > -OPT_INFINITY) && (z_upp[j] < OPT_INFINITY) && (z_upp[j] - z_low[j] <= OPT_ZERO_GRADIENT_EPS)){
+				is_fixed[j] = true;
+				continue;
+			}
+			has_low[j] = (z_low[j] > -OPT_INFINITY);
+			has_upp[j] = (z_upp[j] < OPT_INFINITY);
+		}
+
+		con_scale = sejong::Vector::Ones(m);
+		int neA = 0;
+		opt_problem->compute_A(A_eval, iAfun, jAvar, neA);
+		A_eval.resize(neA);
+	}
+
+	void Interior_Point_Solver::initialize_point(){
+		std::vector<double> x_init;
+		opt_problem->get_init_opt_vars(x_init);
+
+		z = sejong::Vector::Zero(nz);
+		for(int j = 0; j < n; j++){
+			z[j] = x_init[j];
+			push_into_bounds(j, z[j]);
+		}
+		evaluate_F(z, F_eval);
+		for(int i = 0; i < m; i++){
+			if (con_slack[i] >= 0){
+				z[con_slack[i]] = F_eval[con_rows[i]];
+				push_into_bounds(con_slack[i], z[con_slack[i]]);
+			}
+		}
+
+		lambda = sejong::Vector::Zero(m);
+		z_l = sejong::Vector::Zero(nz);
+		z_u = sejong::Vector::Zero(nz);
+		for(int j = 0; j < nz; j++){
+			z_l[j] = has_low[j] ? 1.0 : 0.0;
+			z_u[j] = has_upp[j] ? 1.0 : 0.0;
+		}
+	}
+
+	void Interior_Point_Solver::evaluate_F(const sejong::Vector &z_eval, std::vector<double> &F_out){
+		opt_problem->update_opt_vars(z_eval.data(), n);
+		opt_problem->compute_F(F_out);
+		// compute_F leaves out the constant linear terms
+		for(size_t k = 0; k < A_eval.size(); k++){
+			F_out[iAfun[k]] += A_eval[k]*z_eval[jAvar[k]];
+		}
+	}
+
+	// Gradient of the objective and Jacobian of the constraints at the variables of the last evaluate_F.
+	// The Jacobian is the structural G plus the constant A.
+	void Interior_Point_Solver::evaluate_derivatives(){
+		opt_problem->compute_G(G_eval, iGfun, jGvar, neG);
+
+		grad_f = sejong::Vector::Zero(n);
+		std::vector< Eigen::Triplet<double> > triplets;
+		triplets.reserve(neG + A_eval.size() + nz);
+		for(int pass = 0; pass < 2; pass++){
+			const std::vector<double> &values = (pass == 0) ? G_eval : A_eval;
+			const std::vector<int> &rows = (pass == 0) ? iGfun : iAfun;
+			const std::vector<int> &cols = (pass == 0) ? jGvar : jAvar;
+			int ne = (pass == 0) ? neG : A_eval.size();
+			for(int k = 0; k < ne; k++){
+				if (is_fixed[cols[k]]){
+					continue;
+				}
+				if (rows[k] == obj_row){
+					grad_f[cols[k]] += obj_scale*values[k];
+				}else if (row_to_con[rows[k]] >= 0){
+					int con = row_to_con[rows[k]];
+					triplets.push_back(Eigen::Triplet<double>(con, cols[k], con_scale[con]*values[k]));
+				}
+			}
+		}
+		for(int i = 0; i < m; i++){
+			if ((con_slack[i] >= 0) && !is_fixed[con_slack[i]]){
+				triplets.push_back(Eigen::Triplet<double>(i, con_slack[i], -con_scale[i]));
+			}
+		}
+		J.resize(m, nz);
+		J.setFromTriplets(triplets.begin(), triplets.end());
+	}
+
+	// Scales the objective and each constraint so that their largest gradient entry at the start is at most MAX_SCALED_GRADIENT
+	void Interior_Point_Solver::compute_scaling(){
+		obj_scale = 1.0;
+		con_scale = sejong::Vector::Ones(m);
+		evaluate_derivatives();
+
+		double max_grad_f = (n > 0) ? grad_f.lpNorm<Eigen::Infinity>() : 0.0;
+		obj_scale = std::min(1.0, MAX_SCALED_GRADIENT/std::max(max_grad_f, OPT_ZERO_GRADIENT_EPS));
+
+		sejong::Vector max_row = sejong::Vector::Zero(m);
+		for(int k = 0; k < J.outerSize(); k++){
+			for(Eigen::SparseMatrix<double>::InnerIterator it(J, k); it; ++it){
+				if (it.col() < n){
+					max_row[it.row()] = std::max(max_row[it.row()], std::fabs(it.value()));
+				}
+			}
+		}
+		for(int i = 0; i < m; i++){
+			con_scale[i] = std::min(1.0, MAX_SCALED_GRADIENT/std::max(max_row[i], OPT_ZERO_GRADIENT_EPS));
+		}
+		evaluate_derivatives();
+	}
+
+	void Interior_Point_Solver::constraint_values(const sejong::Vector &z_eval, const std::vector<double> &F_in, sejong::Vector &g_out){
+		g_out.resize(m);
+		for(int i = 0; i < m; i++){
+			int r = con_rows[i];
+			double target = (con_slack[i] >= 0) ? z_eval[con_slack[i]] : F_low[r];
+			g_out[i] = con_scale[i]*(F_in[r] - target);
+		}
+	}
+
+	double Interior_Point_Solver::unscaled_violation(const std::vector<double> &F_in){
+		double violation = 0.0;
+		for(int i = 0; i < m; i++){
+			int r = con_rows[i];
+			violation = std::max(violation, std::max(F_low[r] - F_in[r], F_in[r] - F_upp[r]));
+		}
+		return violation;
+	}
+
+	double Interior_Point_Solver::barrier_objective(const sejong::Vector &z_eval, const std::vector<double> &F_in, const double &mu){
+		double phi = obj_scale*F_in[obj_row];
+		for(int j = 0; j < nz; j++){
+			if (has_low[j]){
+				phi -= mu*std::log(z_eval[j] - z_low[j]);
+			}
+			if (has_upp[j]){
+				phi -= mu*std::log(z_upp[j] - z_eval[j]);
+			}
+		}
+		return phi;
+	}
+
+	void Interior_Point_Solver::barrier_gradient(const double &mu, sejong::Vector &grad_out){
+		grad_out = sejong::Vector::Zero(nz);
+		grad_out.head(n) = grad_f;
+		for(int j = 0; j < nz; j++){
+			if (has_low[j]){
+				grad_out[j] -= mu/(z[j] - z_low[j]);
+			}
+			if (has_upp[j]){
+				grad_out[j] += mu/(z_upp[j] - z[j]);
+			}
+		}
+	}
+
+	// Scaled KKT error of the barrier problem
+	double Interior_Point_Solver::optimality_error(const double &mu, const sejong::Vector &g){
+		sejong::Vector grad_L = sejong::Vector::Zero(nz);
+		grad_L.head(n) = grad_f;
+		grad_L += J.transpose()*lambda - z_l + z_u;
+
+		double dual_error = 0.0;
+		double complementarity_error = 0.0;
+		double multiplier_sum = lambda.lpNorm<1>();
+		double bound_multiplier_sum = 0.0;
+		int num_bounds = 0;
+		for(int j = 0; j < nz; j++){
+			if (is_fixed[j]){
+				continue;
+			}
+			dual_error = std::max(dual_error, std::fabs(grad_L[j]));
+			if (has_low[j]){
+				complementarity_error = std::max(complementarity_error, std::fabs((z[j] - z_low[j])*z_l[j] - mu));
+				bound_multiplier_sum += z_l[j];
+				num_bounds++;
+			}
+			if (has_upp[j]){
+				complementarity_error = std::max(complementarity_error, std::fabs((z_upp[j] - z[j])*z_u[j] - mu));
+				bound_multiplier_sum += z_u[j];
+				num_bounds++;
+			}
+		}
+		// Large multipliers make the errors large in absolute terms
+		double s_d = std::max(SCALING_S_MAX, (multiplier_sum + bound_multiplier_sum)/std::max(1, m + num_bounds))/SCALING_S_MAX;
+		double s_c = std::max(SCALING_S_MAX, bound_multiplier_sum/std::max(1, num_bounds))/SCALING_S_MAX;
+		double primal_error = (m > 0) ? g.lpNorm<Eigen::Infinity>() : 0.0;
+		return std::max(std::max(dual_error/s_d, primal_error), complementarity_error/s_c);
+	}
+
+	double Interior_Point_Solver::row_weight(const int &row){
+		if (row == obj_row){
+			return obj_scale;
+		}
+		int con = row_to_con[row];
+		return (con >= 0) ? lambda[con]*con_scale[con] : 0.0;
+	}
+
+	void Interior_Point_Solver::initialize_hessian_elements(){
+		// Variables of each row of G
+		std::vector< std::vector<int> > row_cols(F_low.size());
+		for(int k = 0; k < neG; k++){
+			if (!is_fixed[jGvar[k]]){
+				row_cols[iGfun[k]].push_back(jGvar[k]);
+			}
+		}
+		row_to_element.assign(F_low.size(), -1);
+		std::map< std::vector<int>, int > cols_to_element;
+		for(size_t r = 0; r < row_cols.size(); r++){
+			if (row_cols[r].empty() || ((r != obj_row) && (row_to_con[r] < 0))){
+				continue;
+			}
+			std::sort(row_cols[r].begin(), row_cols[r].end());
+			row_cols[r].erase(std::unique(row_cols[r].begin(), row_cols[r].end()), row_cols[r].end());
+
+			std::map< std::vector<int>, int >::iterator it = cols_to_element.find(row_cols[r]);
+			if (it == cols_to_element.end()){
+				Hessian_Element element;
+				element.cols = row_cols[r];
+				element.H = sejong::Matrix::Zero(element.cols.size(), element.cols.size());
+				it = cols_to_element.insert(std::make_pair(row_cols[r], (int)elements.size())).first;
+				elements.push_back(element);
+			}
+			row_to_element[r] = it->second;
+		}
+
+		// Greedy coloring. The blocks of neighbouring knotpoints overlap, so the number of colors
+		// grows with the size of a block and not with the number of knotpoints.
+		std::vector< std::vector<int> > col_elements(n);
+		for(size_t e = 0; e < elements.size(); e++){
+			for(size_t a = 0; a < elements[e].cols.size(); a++){
+				col_elements[elements[e].cols[a]].push_back(e);
+			}
+		}
+		std::vector< std::vector<bool> > element_uses_color(elements.size());
+		for(int j = 0; j < n; j++){
+			if (col_elements[j].empty()){
+				continue;
+			}
+			int color = 0;
+			while (true){
+				bool used = false;
+				for(size_t k = 0; k < col_elements[j].size(); k++){
+					const std::vector<bool> &uses = element_uses_color[col_elements[j][k]];
+					if ((color < uses.size()) && uses[color]){
+						used = true;
+						break;
+					}
+				}
+				if (!used){
+					break;
+				}
+				color++;
+			}
+			if (color >= color_cols.size()){
+				color_cols.resize(color + 1);
+				color_element_cols.resize(color + 1);
+			}
+			color_cols[color].push_back(j);
+			for(size_t k = 0; k < col_elements[j].size(); k++){
+				int e = col_elements[j][k];
+				if (element_uses_color[e].size() <= color){
+					element_uses_color[e].resize(color + 1, false);
+				}
+				element_uses_color[e][color] = true;
+				int local = std::lower_bound(elements[e].cols.begin(), elements[e].cols.end(), j) - elements[e].cols.begin();
+				color_element_cols[color].push_back(std::make_pair(e, local));
+			}
+		}
+		if (verbose){
+			std::cout << "[Interior Point] Hessian has " << elements.size() << " blocks and is differenced in " << color_cols.size() << " evaluations of G" << std::endl;
+		}
+	}
+
+	// Gradient of each element's part of the Lagrangian with the current multipliers
+	void Interior_Point_Solver::accumulate_element_gradients(const std::vector<double> &G_in, const std::vector<int> &iG_in, const std::vector<int> &jG_in,
+															 const int &ne, std::vector<sejong::Vector> &g_out){
+		g_out.resize(elements.size());
+		for(size_t e = 0; e < elements.size(); e++){
+			g_out[e] = sejong::Vector::Zero(elements[e].cols.size());
+		}
+		for(int k = 0; k < ne; k++){
+			int e = row_to_element[iG_in[k]];
+			if (e < 0){
+				continue;
+			}
+			const std::vector<int> &cols = elements[e].cols;
+			std::vector<int>::const_iterator it = std::lower_bound(cols.begin(), cols.end(), jG_in[k]);
+			if ((it != cols.end()) && (*it == jG_in[k])){
+				g_out[e][it - cols.begin()] += row_weight(iG_in[k])*G_in[k];
+			}
+		}
+	}
+
+	// Each color gives one column of every block from the change of the block gradients when its variables are perturbed.
+	// The variables are left at the current iterate.
+	void Interior_Point_Solver::compute_hessian_elements(){
+		std::vector<sejong::Vector> g_nominal;
+		std::vector<sejong::Vector> g_perturbed;
+		accumulate_element_gradients(G_eval, iGfun, jGvar, neG, g_nominal);
+
+		std::vector<double> G_perturbed;
+		std::vector<int> iG_perturbed;
+		std::vector<int> jG_perturbed;
+		int neG_perturbed = 0;
+		sejong::Vector x_perturbed = z.head(n);
+		for(size_t color = 0; color < color_cols.size(); color++){
+			for(size_t k = 0; k < color_cols[color].size(); k++){
+				int j = color_cols[color][k];
+				x_perturbed[j] = z[j] + HESSIAN_FD_STEP*std::max(1.0, std::fabs(z[j]));
+			}
+			opt_problem->update_opt_vars(x_perturbed.data(), n);
+			opt_problem->compute_G(G_perturbed, iG_perturbed, jG_perturbed, neG_perturbed);
+			accumulate_element_gradients(G_perturbed, iG_perturbed, jG_perturbed, neG_perturbed, g_perturbed);
+
+			for(size_t k = 0; k < color_element_cols[color].size(); k++){
+				int e = color_element_cols[color][k].first;
+				int local = color_element_cols[color][k].second;
+				int j = elements[e].cols[local];
+				elements[e].H.col(local) = (g_perturbed[e] - g_nominal[e])/(x_perturbed[j] - z[j]);
+			}
+			for(size_t k = 0; k < color_cols[color].size(); k++){
+				int j = color_cols[color][k];
+				x_perturbed[j] = z[j];
+			}
+		}
+		opt_problem->update_opt_vars(z.data(), n);
+
+		for(size_t e = 0; e < elements.size(); e++){
+			sejong::Matrix H_symmetric = 0.5*(elements[e].H + elements[e].H.transpose());
+			elements[e].H = H_symmetric;
+		}
+	}
+
+	// Lower triangle of the Hessian of the Lagrangian
+	void Interior_Point_Solver::append_hessian(std::vector< Eigen::Triplet<double> > &triplets){
+		if (use_exact_hessian){
+			std::vector<double> lambda_F(F_low.size(), 0.0);
+			for(size_t r = 0; r < F_low.size(); r++){
+				lambda_F[r] = row_weight(r);
+			}
+			std::vector<double> H_eval;
+			std::vector<int> iHrow;
+			std::vector<int> jHcol;
+			int neH = 0;
+			opt_problem->compute_lagrangian_hessian(lambda_F, H_eval, iHrow, jHcol, neH);
+			for(int k = 0; k < neH; k++){
+				if (is_fixed[iHrow[k]] || is_fixed[jHcol[k]]){
+					continue;
+				}
+				triplets.push_back(Eigen::Triplet<double>(std::max(iHrow[k], jHcol[k]), std::min(iHrow[k], jHcol[k]), H_eval[k]));
+			}
+			return;
+		}
+		compute_hessian_elements();
+		for(size_t e = 0; e < elements.size(); e++){
+			const Hessian_Element &element = elements[e];
+			for(size_t a = 0; a < element.cols.size(); a++){
+				for(size_t b = 0; b <= a; b++){
+					triplets.push_back(Eigen::Triplet<double>(element.cols[a], element.cols[b], element.H(a, b)));
+				}
+			}
+		}
+	}
+
+	// Factorizes [W + Sigma + delta_w*I, J^T; J, -delta_c*I] at the current iterate, or without W for restoration steps
+	bool Interior_Point_Solver::factorize_kkt(const bool &with_hessian){
+		std::vector< Eigen::Triplet<double> > base_triplets;
+		if (with_hessian){
+			append_hessian(base_triplets);
+		}
+		for(int k = 0; k < J.outerSize(); k++){
+			for(Eigen::SparseMatrix<double>::InnerIterator it(J, k); it; ++it){
+				base_triplets.push_back(Eigen::Triplet<double>(nz + it.row(), it.col(), it.value()));
+			}
+		}
+		for(int i = 0; i < m; i++){
+			base_triplets.push_back(Eigen::Triplet<double>(nz + i, nz + i, -DELTA_C));
+		}
+		sejong::Vector sigma = sejong::Vector::Zero(nz);
+		for(int j = 0; j < nz; j++){
+			if (is_fixed[j]){
+				sigma[j] = 1.0;
+				continue;
+			}
+			if (has_low[j]){
+				sigma[j] += z_l[j]/(z[j] - z_low[j]);
+			}
+			if (has_upp[j]){
+				sigma[j] += z_u[j]/(z_upp[j] - z[j]);
+			}
+		}
+
+		Eigen::SparseMatrix<double> K(nz + m, nz + m);
+		double delta_w = 0.0;
+		while (true){
+			std::vector< Eigen::Triplet<double> > triplets = base_triplets;
+			for(int j = 0; j < nz; j++){
+				triplets.push_back(Eigen::Triplet<double>(j, j, sigma[j] + (is_fixed[j] ? 0.0 : delta_w)));
+			}
+			K.setFromTriplets(triplets.begin(), triplets.end());
+			ldlt.compute(K);
+
+			// The step is a descent direction if K has nz positive and m negative eigenvalues
+			bool correct_inertia = false;
+			if (ldlt.info() == Eigen::Success){
+				const sejong::Vector &D = ldlt.vectorD();
+				int num_positive = 0;
+				int num_negative = 0;
+				for(int i = 0; i < D.size(); i++){
+					if (D[i] > 0.0){
+						num_positive++;
+					}else if (D[i] < 0.0){
+						num_negative++;
+					}
+				}
+				correct_inertia = (num_positive == nz) && (num_negative == m);
+			}
+			if (correct_inertia){
+				break;
+			}
+			if (delta_w == 0.0){
+				delta_w = (last_delta_w == 0.0) ? DELTA_W_FIRST : std::max(OPT_ZERO_GRADIENT_EPS*OPT_ZERO_GRADIENT_EPS, last_delta_w/3.0);
+			}else{
+				delta_w *= (last_delta_w == 0.0) ? 100.0 : 8.0;
+			}
+			if (delta_w > DELTA_W_MAX){
+				std::cerr << "[Interior Point] Error! Could not correct the inertia of the KKT matrix" << std::endl;
+				return false;
+			}
+		}
+		if (with_hessian && (delta_w > 0.0)){
+			last_delta_w = delta_w;
+		}
+		return true;
+	}
+
+	// -[grad_phi + J^T lambda; g]. A second order correction replaces g.
+	void Interior_Point_Solver::kkt_rhs(const double &mu, const sejong::Vector &g, sejong::Vector &rhs_out){
+		sejong::Vector grad_phi;
+		barrier_gradient(mu, grad_phi);
+		rhs_out.resize(nz + m);
+		rhs_out.head(nz) = -(grad_phi + J.transpose()*lambda);
+		rhs_out.tail(m) = -g;
+		for(int j = 0; j < nz; j++){
+			if (is_fixed[j]){
+				rhs_out[j] = 0.0;
+			}
+		}
+	}
+
+	// Solves with the last factorize_kkt
+	bool Interior_Point_Solver::solve_kkt(const sejong::Vector &rhs, sejong::Vector &dz, sejong::Vector &dlambda){
+		sejong::Vector solution = ldlt.solve(rhs);
+		if (!solution.allFinite()){
+			return false;
+		}
+		dz = solution.head(nz);
+		dlambda = solution.tail(m);
+		return true;
+	}
+
+	// Largest step along dz that keeps the variables a fraction tau of their distance inside the bounds
+	double Interior_Point_Solver::max_primal_step(const sejong::Vector &dz, const double &tau){
+		double alpha_max = 1.0;
+		for(int j = 0; j < nz; j++){
+			if (has_low[j] && (dz[j] < 0.0)){
+				alpha_max = std::min(alpha_max, -tau*(z[j] - z_low[j])/dz[j]);
+			}
+			if (has_upp[j] && (dz[j] > 0.0)){
+				alpha_max = std::min(alpha_max, tau*(z_upp[j] - z[j])/dz[j]);
+			}
+		}
+		return alpha_max;
+	}
+
+	// Steps of the bound multipliers for the primal step dz and the largest step that keeps them positive
+	void Interior_Point_Solver::bound_multiplier_steps(const double &mu, const sejong::Vector &dz, const double &tau,
+													   sejong::Vector &dz_l_out, sejong::Vector &dz_u_out, double &alpha_z_out){
+		dz_l_out.resize(nz);
+		dz_u_out.resize(nz);
+		alpha_z_out = 1.0;
+		for(int j = 0; j < nz; j++){
+			dz_l_out[j] = has_low[j] ? (mu/(z[j] - z_low[j]) - z_l[j] - z_l[j]/(z[j] - z_low[j])*dz[j]) : 0.0;
+			dz_u_out[j] = has_upp[j] ? (mu/(z_upp[j] - z[j]) - z_u[j] + z_u[j]/(z_upp[j] - z[j])*dz[j]) : 0.0;
+			if (has_low[j] && (dz_l_out[j] < 0.0)){
+				alpha_z_out = std::min(alpha_z_out, -tau*z_l[j]/dz_l_out[j]);
+			}
+			if (has_upp[j] && (dz_u_out[j] < 0.0)){
+				alpha_z_out = std::min(alpha_z_out, -tau*z_u[j]/dz_u_out[j]);
+			}
+		}
+	}
+
+	// A trial point must not be in the filter and must either decrease the barrier objective enough (an Armijo step,
+	// when the step is a descent direction and the constraints are nearly satisfied) or decrease theta or phi
+	// by a small fraction of theta
+	bool Interior_Point_Solver::is_acceptable(const double &theta, const double &phi, const double &theta_trial, const double &phi_trial,
+											  const double &alpha, const double &grad_phi_dz, bool &armijo_out){
+		armijo_out = false;
+		if (!std::isfinite(phi_trial) || !std::isfinite(theta_trial) || (theta_trial > theta_max)){
+			return false;
+		}
+		bool switching = (grad_phi_dz < 0.0) && (alpha*std::pow(-grad_phi_dz, S_PHI) > DELTA_SWITCH*std::pow(theta, S_THETA));
+		if (switching && (theta <= theta_min)){
+			armijo_out = true;
+			if (phi_trial > phi + ETA_PHI*alpha*grad_phi_dz){
+				return false;
+			}
+		}else if ((theta_trial > (1.0 - GAMMA_THETA)*theta) && (phi_trial > phi - GAMMA_PHI*theta)){
+			return false;
+		}
+		for(size_t i = 0; i < filter.size(); i++){
+			if ((theta_trial >= filter[i].first) && (phi_trial >= filter[i].second)){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Gauss-Newton step towards the constraints with the bound terms Sigma in place of the Hessian, for when the filter
+	// rejects every step along the Newton direction. Backtracks until the violation decreases and returns false if it can not.
+	bool Interior_Point_Solver::restoration_step(const sejong::Vector &g, const double &theta, const double &tau, sejong::Vector &z_out, std::vector<double> &F_out){
+		sejong::Vector rhs = sejong::Vector::Zero(nz + m);
+		rhs.tail(m) = -g;
+		sejong::Vector dz;
+		sejong::Vector dlambda;
+		if (!factorize_kkt(false) || !solve_kkt(rhs, dz, dlambda)){
+			return false;
+		}
+		sejong::Vector g_trial;
+		for(double alpha = max_primal_step(dz, tau); alpha >= MIN_RESTORATION_STEP; alpha *= 0.5){
+			z_out = z + alpha*dz;
+			evaluate_F(z_out, F_out);
+			constraint_values(z_out, F_out, g_trial);
+			if (g_trial.allFinite() && (g_trial.lpNorm<1>() < theta)){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int Interior_Point_Solver::solve(const double &tolerance, const double &constraint_tolerance, const int &max_iterations,
+									 int &iterations_out, std::vector<double> &x_out){
+		initialize_structure();
+		initialize_point();
+		compute_scaling();
+
+		std::vector<double> lambda_F(F_low.size(), 0.0);
+		std::vector<double> H_eval;
+		std::vector<int> iHrow;
+		std::vector<int> jHcol;
+		int neH = 0;
+		use_exact_hessian = opt_problem->compute_lagrangian_hessian(lambda_F, H_eval, iHrow, jHcol, neH);
+		if (!use_exact_hessian){
+			initialize_hessian_elements();
+		}
+		if (verbose){
+			std::cout << "[Interior Point] " << n << " variables, " << (nz - n) << " slacks and " << m << " constraints" << std::endl;
+		}
+
+		double mu = 0.1;
+		int failed_line_searches = 0;
+		int exit_code = INTERIOR_POINT_ITERATION_LIMIT;
+
+		sejong::Vector g;
+		sejong::Vector g_trial;
+		sejong::Vector rhs;
+		sejong::Vector dz;
+		sejong::Vector dlambda;
+		sejong::Vector dz_l;
+		sejong::Vector dz_u;
+		std::vector<double> F_trial;
+
+		constraint_values(z, F_eval, g);
+		theta_max = THETA_MAX_FACTOR*std::max(1.0, g.lpNorm<1>());
+		theta_min = THETA_MIN_FACTOR*std::max(1.0, g.lpNorm<1>());
+
+		int iter = 0;
+		for(iter = 0; iter < max_iterations; iter++){
+			constraint_values(z, F_eval, g);
+			if ((optimality_error(0.0, g) <= tolerance) && (unscaled_violation(F_eval) <= constraint_tolerance)){
+				exit_code = INTERIOR_POINT_OPTIMAL;
+				break;
+			}
+			// Decrease mu once the barrier problem is solved well enough. The filter belongs to the old barrier problem.
+			while ((mu > tolerance/10.0) && (optimality_error(mu, g) <= KAPPA_EPSILON*mu)){
+				mu = std::max(tolerance/10.0, std::min(KAPPA_MU*mu, std::pow(mu, THETA_MU)));
+				filter.clear();
+			}
+
+			if (!factorize_kkt(true)){
+				exit_code = INTERIOR_POINT_NUMERICAL_DIFFICULTIES;
+				break;
+			}
+			kkt_rhs(mu, g, rhs);
+			if (!solve_kkt(rhs, dz, dlambda)){
+				exit_code = INTERIOR_POINT_NUMERICAL_DIFFICULTIES;
+				break;
+			}
+			double tau = std::max(TAU_MIN, 1.0 - mu);
+			double alpha_max = max_primal_step(dz, tau);
+			double alpha_z = 1.0;
+			bound_multiplier_steps(mu, dz, tau, dz_l, dz_u, alpha_z);
+
+			// Backtracking filter line search on the constraint violation theta and the barrier objective phi
+			sejong::Vector grad_phi;
+			barrier_gradient(mu, grad_phi);
+			double grad_phi_dz = grad_phi.dot(dz);
+			double theta = (m > 0) ? g.lpNorm<1>() : 0.0;
+			double phi = barrier_objective(z, F_eval, mu);
+			double alpha_min = GAMMA_THETA;
+			if (grad_phi_dz < 0.0){
+				alpha_min = std::min(alpha_min, std::min(GAMMA_PHI*theta/(-grad_phi_dz), DELTA_SWITCH*std::pow(theta, S_THETA)/std::pow(-grad_phi_dz, S_PHI)));
+			}
+			alpha_min *= GAMMA_ALPHA;
+
+			double alpha = alpha_max;
+			sejong::Vector z_trial;
+			bool accepted = false;
+			bool armijo = false;
+			while (alpha >= alpha_min){
+				z_trial = z + alpha*dz;
+				evaluate_F(z_trial, F_trial);
+				constraint_values(z_trial, F_trial, g_trial);
+				double theta_trial = (m > 0) ? g_trial.lpNorm<1>() : 0.0;
+				if (is_acceptable(theta, phi, theta_trial, barrier_objective(z_trial, F_trial, mu), alpha, grad_phi_dz, armijo)){
+					accepted = true;
+					break;
+				}
+				// The full step increased the violation, possibly because of the curvature of the constraints.
+				// Correct it with steps that use the same factorization and the constraint values at the trial point.
+				if ((alpha == alpha_max) && (theta_trial >= theta) && (m > 0)){
+					sejong::Vector g_soc = alpha*g + g_trial;
+					double theta_soc_previous = theta;
+					sejong::Vector rhs_soc = rhs;
+					sejong::Vector dz_soc;
+					sejong::Vector dlambda_soc;
+					std::vector<double> F_soc;
+					sejong::Vector g_soc_trial;
+					for(int p = 0; p < MAX_SOC; p++){
+						rhs_soc.tail(m) = -g_soc;
+						if (!solve_kkt(rhs_soc, dz_soc, dlambda_soc)){
+							break;
+						}
+						double alpha_soc = max_primal_step(dz_soc, tau);
+						sejong::Vector z_soc = z + alpha_soc*dz_soc;
+						evaluate_F(z_soc, F_soc);
+						constraint_values(z_soc, F_soc, g_soc_trial);
+						double theta_soc = g_soc_trial.lpNorm<1>();
+						if (is_acceptable(theta, phi, theta_soc, barrier_objective(z_soc, F_soc, mu), alpha, grad_phi_dz, armijo)){
+							accepted = true;
+							alpha = alpha_soc;
+							dz = dz_soc;
+							dlambda = dlambda_soc;
+							bound_multiplier_steps(mu, dz, tau, dz_l, dz_u, alpha_z);
+							z_trial = z_soc;
+							F_trial.swap(F_soc);
+							break;
+						}
+						if ((p > 0) && (theta_soc > KAPPA_SOC*theta_soc_previous)){
+							break;
+						}
+						theta_soc_previous = theta_soc;
+						g_soc = alpha_soc*g_soc + g_soc_trial;
+					}
+					if (accepted){
+						break;
+					}
+				}
+				alpha *= 0.5;
+			}
+			if (accepted){
+				failed_line_searches = 0;
+				if (!armijo){
+					filter.push_back(std::make_pair((1.0 - GAMMA_THETA)*theta, phi - GAMMA_PHI*theta));
+				}
+			}else{
+				// The current point goes into the filter so that the next iterates leave it. The constraint multipliers
+				// restart from zero, as the ones that led here are often very large.
+				failed_line_searches++;
+				filter.push_back(std::make_pair((1.0 - GAMMA_THETA)*theta, phi - GAMMA_PHI*theta));
+				if ((failed_line_searches >= MAX_FAILED_LINE_SEARCHES) || (m == 0) || !restoration_step(g, theta, tau, z_trial, F_trial)){
+					std::cerr << "[Interior Point] Error! The line search failed " << failed_line_searches << " times in a row and the restoration stalled" << std::endl;
+					evaluate_F(z, F_eval);
+					exit_code = INTERIOR_POINT_NUMERICAL_DIFFICULTIES;
+					break;
+				}
+				alpha = 0.0;
+				alpha_z = 0.0;
+				lambda.setZero();
+				dlambda.setZero();
+			}
+
+			z = z_trial;
+			F_eval.swap(F_trial);
+			lambda += alpha*dlambda;
+			z_l += alpha_z*dz_l;
+			z_u += alpha_z*dz_u;
+			// Bound multipliers may not drift too far from the primal-dual central path
+			for(int j = 0; j < nz; j++){
+				if (has_low[j]){
+					double slack = z[j] - z_low[j];
+					z_l[j] = std::max(std::min(z_l[j], KAPPA_SIGMA*mu/slack), mu/(KAPPA_SIGMA*slack));
+				}
+				if (has_upp[j]){
+					double slack = z_upp[j] - z[j];
+					z_u[j] = std::max(std::min(z_u[j], KAPPA_SIGMA*mu/slack), mu/(KAPPA_SIGMA*slack));
+				}
+			}
+
+			evaluate_derivatives();
+
+			if (verbose){
+				constraint_values(z, F_eval, g);
+				std::cout << "[Interior Point] iter " << iter << " objective = " << F_eval[obj_row]
+						  << " violation = " << unscaled_violation(F_eval) << " mu = " << mu << " alpha = " << alpha << std::endl;
+			}
+		}
+
+		iterations_out = iter;
+		x_out.assign(z.data(), z.data() + n);
+		return exit_code;
+	}
+}
+
+Interior_Point_Backend::Interior_Point_Backend(){}
+Interior_Point_Backend::~Interior_Point_Backend(){}
+
+void Interior_Point_Backend::set_tolerance(const double &tolerance_in){
+	tolerance = tolerance_in;
+}
+
+void Interior_Point_Backend::set_constraint_tolerance(const double &constraint_tolerance_in){
+	constraint_tolerance = constraint_tolerance_in;
+}
+
+void Interior_Point_Backend::set_max_iterations(const int &max_iterations_in){
+	max_iterations = max_iterations_in;
+}
+
+void Interior_Point_Backend::set_verbose(const bool &verbose_in){
+	verbose = verbose_in;
+}
+
+void Interior_Point_Backend::solve_problem(Optimization_Problem_Main* opt_problem, NLP_Result &result_out){
+	std::cout << "[Interior Point] Solving " << opt_problem->problem_name << std::endl;
+	Interior_Point_Solver solver(opt_problem, verbose);
+	result_out.exit_code = solver.solve(tolerance, constraint_tolerance, max_iterations, result_out.iterations, result_out.x);
+}
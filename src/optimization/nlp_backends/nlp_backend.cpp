@@ -0,0 +1,69 @@
+#include <optimization/nlp_backends/nlp_backend.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+void NLP_Backend::solve(Optimization_Problem_Main* opt_problem, NLP_Result &result_out){
+	result_out = NLP_Result();
+	result_out.problem_name = opt_problem->problem_name;
+	result_out.backend_name = get_name();
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	solve_problem(opt_problem, result_out);
+	result_out.solve_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+	if (result_out.x.empty()){
+		opt_problem->get_current_opt_vars(result_out.x);
+	}
+	result_out.max_violation = compute_max_violation(opt_problem, result_out.x, result_out.objective);
+
+	std::cout << "[NLP Backend] " << result_out.backend_name << " solved " << result_out.problem_name
+			  << " in " << result_out.solve_time << " s. exit code = " << result_out.exit_code
+			  << " objective = " << result_out.objective << " max violation = " << result_out.max_violation << std::endl;
+}
+
+void compare_backends(const std::vector<NLP_Backend*> &backends, const std::function<Optimization_Problem_Main*()> &create_problem,
+					  std::vector<NLP_Result> &results_out){
+	results_out.resize(backends.size());
+	for(size_t i = 0; i < backends.size(); i++){
+		Optimization_Problem_Main* opt_problem = create_problem();
+		backends[i]->solve(opt_problem, results_out[i]);
+		delete opt_problem;
+	}
+	for(size_t i = 0; i < results_out.size(); i++){
+		std::cout << "[NLP Backend] " << results_out[i].problem_name << " " << results_out[i].backend_name << ": exit code = " << results_out[i].exit_code
+				  << " iterations = " << results_out[i].iterations << " objective = " << results_out[i].objective
+				  << " max violation = " << results_out[i].max_violation << " time = " << results_out[i].solve_time << " s" << std::endl;
+	}
+}
+
+double compute_max_violation(Optimization_Problem_Main* opt_problem, const std::vector<double> &x, double &objective_out){
+	std::vector<double> x_low;
+	std::vector<double> x_upp;
+	std::vector<double> F_low;
+	std::vector<double> F_upp;
+	std::vector<double> F_eval;
+	int obj_row = 0;
+
+	opt_problem->get_opt_vars_bounds(x_low, x_upp);
+	opt_problem->get_F_bounds(F_low, F_upp);
+	opt_problem->get_F_obj_Row(obj_row);
+
+	std::vector<double> x_vars = x;
+	opt_problem->update_opt_vars(x_vars);
+	opt_problem->compute_F(F_eval);
+	opt_problem->add_linear_terms(F_eval);
+	objective_out = (obj_row < F_eval.size()) ? F_eval[obj_row] : 0.0;
+
+	double max_violation = 0.0;
+	for(size_t i = 0; (i < x.size()) && (i < x_low.size()); i++){
+		max_violation = std::max(max_violation, std::max(x_low[i] - x[i], x[i] - x_upp[i]));
+	}
+	for(size_t i = 0; (i < F_eval.size()) && (i < F_low.size()); i++){
+		if (i == obj_row){
+			continue;
+		}
+		max_violation = std::max(max_violation, std::max(F_low[i] - F_eval[i], F_eval[i] - F_upp[i]));
+	}
+	return max_violation;
+}
@@ -0,0 +1,33 @@
+#include <optimization/nlp_backends/snopt_backend.hpp>
+
+SNOPT_Backend::SNOPT_Backend(){}
+SNOPT_Backend::~SNOPT_Backend(){}
+
+void SNOPT_Backend::set_use_gradients(const bool &use_gradients_in){
+	use_gradients = use_gradients_in;
+}
+
+void SNOPT_Backend::set_finite_difference_jacobian(Finite_Difference_Jacobian* fd_jacobian_in){
+	fd_jacobian = fd_jacobian_in;
+}
+
+void SNOPT_Backend::set_print_file(const std::string &print_file_in){
+	print_file = print_file_in;
+}
+
+void SNOPT_Backend::set_warm_start(const snopt_wrapper::Solver_State &warm_start_in){
+	warm_start = warm_start_in;
+}
+
+void SNOPT_Backend::solve_problem(Optimization_Problem_Main* opt_problem, NLP_Result &result_out){
+	last_snopt_result = snopt_wrapper::Solve_Result();
+	if (fd_jacobian != NULL){
+		snopt_wrapper::solve_problem_with_finite_differences(opt_problem, fd_jacobian, print_file, warm_start, last_snopt_result);
+	}else if (use_gradients){
+		snopt_wrapper::solve_problem_with_gradients(opt_problem, print_file, warm_start, last_snopt_result);
+	}else{
+		snopt_wrapper::solve_problem_no_gradients(opt_problem, print_file, warm_start, last_snopt_result);
+	}
+	result_out.exit_code = last_snopt_result.exit_code;
+	result_out.x = last_snopt_result.x;
+}
@@ -1,7 +1,12 @@
 #include <optimization/objective_functions/2d_hopper/hopper_min_torque_objective_func.hpp>
 #include <Utils/utilities.hpp>
 
-Hopper_Min_Torque_Objective_Function::Hopper_Min_Torque_Objective_Function(){}
+Hopper_Min_Torque_Objective_Function::Hopper_Min_Torque_Objective_Function(){
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_Q, 0);
+	add_var_dependency(VAR_TYPE_Q, -1);
+}
 
 Hopper_Min_Torque_Objective_Function::~Hopper_Min_Torque_Objective_Function(){
 	std::cout << "[Hopper_Min_Torque_Objective_Function Destructor] called" << std::endl;
@@ -14,29 +19,19 @@ void Hopper_Min_Torque_Objective_Function::set_var_manager(Opt_Variable_Manager&
 }
 
 void Hopper_Min_Torque_Objective_Function::evaluate_objective_function(Opt_Variable_Manager& var_manager, double &result){
-	sejong::Vector q_states;
-	sejong::Vector q_states_prev;
-	sejong::Vector qdot_states;
-	sejong::Vector q_init_states;
-
-	sejong::Vector u_states;	
-	sejong::Vector Fr_states;	
-
-
 	double cost = 0.0;
 	double h_k = 1.0; 
 
-	var_manager.get_q_states(0, q_init_states);
-
 	for(size_t k = 1; k < N_total_knotpoints + 1; k++){
-		var_manager.get_u_states(k, u_states);
-		var_manager.get_var_reaction_forces(k, Fr_states);
-		var_manager.get_q_states(k, q_states);
-		var_manager.get_q_states(k-1, q_states_prev);
+		// Views into the variable manager. No copies are made.
+		Eigen::Map<const sejong::Vector> u_k = var_manager.get_var_block(VAR_TYPE_U, k);
+		Eigen::Map<const sejong::Vector> Fr_k = var_manager.get_var_block(VAR_TYPE_FR, k);
+		Eigen::Map<const sejong::Vector> q_k = var_manager.get_var_block(VAR_TYPE_Q, k);
+		Eigen::Map<const sejong::Vector> q_k_prev = var_manager.get_var_block(VAR_TYPE_Q, k-1);
 
-		cost += u_states.transpose()*Q_u*u_states;
-		double q_cost = (q_states - q_states_prev).transpose()*(q_states - q_states_prev);
-		double fr_cost = (Fr_states.transpose()*Fr_states);
+		cost += u_k.dot(Q_u*u_k);
+		double q_cost = (q_k - q_k_prev).squaredNorm();
+		double fr_cost = Fr_k.squaredNorm();
 
 		cost += (q_cost*1);
 		cost += (fr_cost*1);		
@@ -48,7 +43,34 @@ void Hopper_Min_Torque_Objective_Function::evaluate_objective_function(Opt_Varia
 }
 
 
-void Hopper_Min_Torque_Objective_Function::evaluate_objective_gradient(Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Hopper_Min_Torque_Objective_Function::evaluate_objective_gradient(Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+	std::vector<int> q_indices;
+	std::vector<int> u_indices;
+	std::vector<int> Fr_indices;
+
+	// Each variable appears once in the gradient so that the pattern has no duplicate entries
+	for(size_t k = 1; k < N_total_knotpoints + 1; k++){
+		Eigen::Map<const sejong::Vector> u_states = var_manager.get_var_block(VAR_TYPE_U, k);
+		Eigen::Map<const sejong::Vector> Fr_states = var_manager.get_var_block(VAR_TYPE_FR, k);
+		Eigen::Map<const sejong::Vector> q_states = var_manager.get_var_block(VAR_TYPE_Q, k);
+		Eigen::Map<const sejong::Vector> q_states_prev = var_manager.get_var_block(VAR_TYPE_Q, k-1);
+
+		var_manager.get_var_indices(VAR_TYPE_U, k, u_indices);
+		var_manager.get_var_indices(VAR_TYPE_FR, k, Fr_indices);
+		var_manager.get_var_indices(VAR_TYPE_Q, k, q_indices);
+
+		// d/dq[k] of ||q[k] - q[k-1]||^2 + ||q[k+1] - q[k]||^2
+		sejong::Vector dq = 2.0*(q_states - q_states_prev);
+		if (k < N_total_knotpoints){
+			Eigen::Map<const sejong::Vector> q_states_next = var_manager.get_var_block(VAR_TYPE_Q, k+1);
+			dq -= 2.0*(q_states_next - q_states);
+		}
+
+		append_gradient_entries((Q_u + Q_u.transpose())*u_states, u_indices, G, iG, jG);
+		append_gradient_entries(dq, q_indices, G, iG, jG);		
+		append_gradient_entries(2.0*Fr_states, Fr_indices, G, iG, jG);
+	}
+}
 void Hopper_Min_Torque_Objective_Function::evaluate_sparse_A_matrix(Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 void Hopper_Min_Torque_Objective_Function::setQ_vals(const int &i, const int &j, const double &value){}
 
@@ -3,6 +3,10 @@
 
 Hopper_Act_Min_Torque_Objective_Function::Hopper_Act_Min_Torque_Objective_Function(){
 	combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+	add_var_dependency(VAR_TYPE_U, 0);
+	add_var_dependency(VAR_TYPE_FR, 0);
+	add_var_dependency(VAR_TYPE_X, 0);
+	add_var_dependency(VAR_TYPE_X, -1);
 }
 
 Hopper_Act_Min_Torque_Objective_Function::~Hopper_Act_Min_Torque_Objective_Function(){
@@ -16,15 +20,6 @@ void Hopper_Act_Min_Torque_Objective_Function::set_var_manager(Opt_Variable_Mana
 }
 
 void Hopper_Act_Min_Torque_Objective_Function::evaluate_objective_function(Opt_Variable_Manager& var_manager, double &result){
-	sejong::Vector x_states;
-	sejong::Vector x_states_prev;
-	sejong::Vector qdot_states;
-	sejong::Vector q_init_states;
-
-	sejong::Vector u_states;	
-	sejong::Vector Fr_states;	
-
-
 	double cost = 0.0;
 	double h_k = 1.0; 
 
@@ -34,14 +29,15 @@ void Hopper_Act_Min_Torque_Objective_Function::evaluate_objective_function(Opt_V
 	sejong::Vector q_states_prev;
 
 	for(size_t k = 1; k < N_total_knotpoints + 1; k++){
-		var_manager.get_u_states(k, u_states);
-		var_manager.get_var_reaction_forces(k, Fr_states);
-		var_manager.get_x_states(k, x_states);
-		var_manager.get_x_states(k-1, x_states_prev);
+		// Views into the variable manager. No copies are made.
+		Eigen::Map<const sejong::Vector> u_k = var_manager.get_var_block(VAR_TYPE_U, k);
+		Eigen::Map<const sejong::Vector> Fr_k = var_manager.get_var_block(VAR_TYPE_FR, k);
+		Eigen::Map<const sejong::Vector> x_k = var_manager.get_var_block(VAR_TYPE_X, k);
+		Eigen::Map<const sejong::Vector> x_k_prev = var_manager.get_var_block(VAR_TYPE_X, k-1);
 
-		cost += u_states.transpose()*Q_u*u_states;
-		cost += (x_states - x_states_prev).transpose()*(x_states - x_states_prev);
-		cost += (Fr_states.transpose()*Fr_states);		
+		cost += u_k.dot(Q_u*u_k);
+		cost += (x_k - x_k_prev).squaredNorm();
+		cost += Fr_k.squaredNorm();		
 
 		// combined_model->convert_x_to_q(x_states, q_states);
 		// combined_model->convert_x_to_q(x_states_prev, q_states_prev);		
@@ -55,6 +51,33 @@ void Hopper_Act_Min_Torque_Objective_Function::evaluate_objective_function(Opt_V
 }
 
 
-void Hopper_Act_Min_Torque_Objective_Function::evaluate_objective_gradient(Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){}
+void Hopper_Act_Min_Torque_Objective_Function::evaluate_objective_gradient(Opt_Variable_Manager& var_manager, std::vector<double>& G, std::vector<int>& iG, std::vector<int>& jG){
+	std::vector<int> x_indices;
+	std::vector<int> u_indices;
+	std::vector<int> Fr_indices;
+
+	// Each variable appears once in the gradient so that the pattern has no duplicate entries
+	for(size_t k = 1; k < N_total_knotpoints + 1; k++){
+		Eigen::Map<const sejong::Vector> u_states = var_manager.get_var_block(VAR_TYPE_U, k);
+		Eigen::Map<const sejong::Vector> Fr_states = var_manager.get_var_block(VAR_TYPE_FR, k);
+		Eigen::Map<const sejong::Vector> x_states = var_manager.get_var_block(VAR_TYPE_X, k);
+		Eigen::Map<const sejong::Vector> x_states_prev = var_manager.get_var_block(VAR_TYPE_X, k-1);
+
+		var_manager.get_var_indices(VAR_TYPE_U, k, u_indices);
+		var_manager.get_var_indices(VAR_TYPE_FR, k, Fr_indices);
+		var_manager.get_var_indices(VAR_TYPE_X, k, x_indices);
+
+		// d/dx[k] of ||x[k] - x[k-1]||^2 + ||x[k+1] - x[k]||^2
+		sejong::Vector dx = 2.0*(x_states - x_states_prev);
+		if (k < N_total_knotpoints){
+			Eigen::Map<const sejong::Vector> x_states_next = var_manager.get_var_block(VAR_TYPE_X, k+1);
+			dx -= 2.0*(x_states_next - x_states);
+		}
+
+		append_gradient_entries((Q_u + Q_u.transpose())*u_states, u_indices, G, iG, jG);
+		append_gradient_entries(dx, x_indices, G, iG, jG);		
+		append_gradient_entries(2.0*Fr_states, Fr_indices, G, iG, jG);
+	}
+}
 void Hopper_Act_Min_Torque_Objective_Function::evaluate_sparse_A_matrix(Opt_Variable_Manager& var_manager, std::vector<double>& A, std::vector<int>& iA, std::vector<int>& jA){}
 
@@ -1,6 +1,7 @@
 #include <Utils/utilities.hpp>
 #include <optimization/optimization_problems/2d_hopper/hopper_jump_opt_problem.hpp>
 #include <optimization/optimization_constants.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
 
 #include <optimization/hard_constraints/2d_hopper/hopper_dynamics_constraint.hpp>
 #include <optimization/hard_constraints/2d_hopper/hopper_hybrid_dynamics_constraint.hpp>
@@ -8,6 +9,7 @@
 #include <optimization/hard_constraints/2d_hopper/hopper_contact_lcp_constraint.hpp>
 #include <optimization/hard_constraints/2d_hopper/hopper_active_contact_kinematic_constraint.hpp>
 #include <optimization/hard_constraints/2d_hopper/hopper_position_kinematic_constraint.hpp>
+#include <optimization/hard_constraints/2d_hopper/hopper_collocation_constraints.hpp>
 
 #include <optimization/contacts/2d_hopper/hopper_foot_contact.hpp>
 
@@ -24,8 +26,14 @@
 
 #include <string>
 
-Hopper_Jump_Opt::Hopper_Jump_Opt(){
+Hopper_Jump_Opt::Hopper_Jump_Opt(): Hopper_Jump_Opt(27){}
+
+Hopper_Jump_Opt::Hopper_Jump_Opt(const int &N_total_knotpoints_in): Hopper_Jump_Opt(N_total_knotpoints_in, COLLOCATION_BACK_EULER){}
+
+Hopper_Jump_Opt::Hopper_Jump_Opt(const int &N_total_knotpoints_in, const int &collocation_method_in){
 	problem_name = "Hopper Jump Optimization Problem";
+	N_total_knotpoints = N_total_knotpoints_in;
+	collocation_method = collocation_method_in;
 
 	robot_q_init.resize(NUM_Q); 
 	robot_qdot_init.resize(NUM_QDOT);	
@@ -45,8 +53,6 @@ Hopper_Jump_Opt::~Hopper_Jump_Opt(){
 void Hopper_Jump_Opt::Initialization(){
 	robot_model = HopperModel::GetRobotModel();
 
-	N_total_knotpoints = 27;//9; //6;
-
 	h_dt_min = 0.001; // Minimum knotpoint timestep
 	max_normal_force = 1e10;//10000; // Newtons
 	max_tangential_force = 10000; // Newtons  	  	
@@ -61,6 +67,8 @@ void Hopper_Jump_Opt::Initialization(){
 	initialize_ti_constraint_list();
  	initialize_td_constraint_list();
 	initialize_objective_func();
+	initialize_G_sparsity_pattern();
+	knotpoint_evaluator.initialize_dependencies(ti_constraint_list, td_constraint_list, opt_var_manager, N_total_knotpoints);
 
 }
 void Hopper_Jump_Opt::initialize_starting_configuration(){
@@ -100,6 +108,7 @@ void Hopper_Jump_Opt::initialize_contact_mode_schedule(){
   contact_mode_schedule.add_new_mode(mode_0_start_time, mode_0_final_time, mode_0_active_contacts);
   contact_mode_schedule.add_new_mode(mode_1_start_time, mode_1_final_time, mode_1_active_contacts);  
   contact_mode_schedule.add_new_mode(mode_2_start_time, mode_2_final_time, mode_2_active_contacts);  
+  contact_mode_schedule.finalize_schedule(&contact_list, N_total_knotpoints);
 
 }
 
@@ -107,8 +116,13 @@ void Hopper_Jump_Opt::initialize_contact_mode_schedule(){
 void Hopper_Jump_Opt::initialize_ti_constraint_list(){
   int foot_contact_index = 0;
 	//ti_constraint_list.append_constraint(new Hopper_Dynamics_Constraint(&contact_list)); 
-  ti_constraint_list.append_constraint(new Hopper_Hybrid_Dynamics_Constraint(&contact_list, &contact_mode_schedule));   
-  ti_constraint_list.append_constraint(new Hopper_Back_Euler_Time_Integration_Constraint());
+  if (collocation_method == COLLOCATION_BACK_EULER){
+    ti_constraint_list.append_constraint(new Hopper_Hybrid_Dynamics_Constraint(&contact_list, &contact_mode_schedule));   
+    ti_constraint_list.append_constraint(new Hopper_Back_Euler_Time_Integration_Constraint());
+  }else{
+    ti_constraint_list.append_constraint(new Hopper_Collocation_Hybrid_Dynamics_Constraint(&contact_list, &contact_mode_schedule, collocation_method));
+    ti_constraint_list.append_constraint(new Hopper_Collocation_Time_Integration_Constraint(&contact_list, &contact_mode_schedule, collocation_method));
+  }
   ti_constraint_list.append_constraint(new Hopper_Position_Kinematic_Constraint(SJ_Hopper_LinkID::LK_foot, Z_DIM, 0, OPT_INFINITY));
 
   //ti_constraint_list.append_constraint(new Hopper_Floor_Contact_LCP_Constraint(&contact_list, foot_contact_index));
@@ -206,15 +220,12 @@ void Hopper_Jump_Opt::initialize_opt_vars(){
 
 void Hopper_Jump_Opt::initialize_specific_variable_bounds(){
   // Jump at half way
-  opt_var_manager.knotpoint_to_q_state_vars[N_total_knotpoints/2][0]->l_bound = 1.25;
-  opt_var_manager.knotpoint_to_q_state_vars[N_total_knotpoints/2][0]->u_bound = OPT_INFINITY;
+  opt_var_manager.set_var_bounds(VAR_TYPE_Q, N_total_knotpoints/2, 0, 1.25, OPT_INFINITY);
 
   //Set final position of the base to be at 0.7
-  // opt_var_manager.knotpoint_to_q_state_vars[N_total_knotpoints][0]->l_bound = 0.7 - OPT_ZERO_EPS;
-  // opt_var_manager.knotpoint_to_q_state_vars[N_total_knotpoints][0]->u_bound = 0.7 + OPT_ZERO_EPS;
+  // opt_var_manager.set_var_bounds(VAR_TYPE_Q, N_total_knotpoints, 0, 0.7 - OPT_ZERO_EPS, 0.7 + OPT_ZERO_EPS);
 
-  opt_var_manager.knotpoint_to_qdot_state_vars[N_total_knotpoints][0]->l_bound = -OPT_ZERO_EPS;
-  opt_var_manager.knotpoint_to_qdot_state_vars[N_total_knotpoints][0]->u_bound = +OPT_ZERO_EPS;
+  opt_var_manager.set_var_bounds(VAR_TYPE_QDOT, N_total_knotpoints, 0, -OPT_ZERO_EPS, +OPT_ZERO_EPS);
 
 }
 
@@ -243,6 +254,9 @@ void Hopper_Jump_Opt::get_current_opt_vars(std::vector<double> &x_vars_out){
 }
 void Hopper_Jump_Opt::update_opt_vars(std::vector<double> &x_vars){
   opt_var_manager.update_opt_vars(x_vars);
+}
+void Hopper_Jump_Opt::update_opt_vars(const double* x_vars, const int &n){
+  opt_var_manager.update_opt_vars(x_vars, n);
 } 	  		
 
 
@@ -286,66 +300,156 @@ void Hopper_Jump_Opt::get_F_obj_Row(int &obj_row){
 }
 
 void Hopper_Jump_Opt::compute_F_objective_function(double &result_out){
+  OPT_PROFILE_SCOPE_NAMED("objective F", objective_function.objective_function_name);
   objective_function.evaluate_objective_function(opt_var_manager, result_out);
   //std::cout << "[Hopper_Jump_Opt] cost = " << result_out << std::endl;
 }
 
 void Hopper_Jump_Opt::compute_F(std::vector<double> &F_eval){
+  // The objective function is the last row
+  F_eval.resize(objective_function.objective_function_index + 1);
+  compute_F(F_eval.data());
+}
+
+void Hopper_Jump_Opt::compute_F(double* F_eval){
   compute_F_constraints(F_eval);
-  double cost = 0.0;
+  compute_F_objective_function(F_eval[objective_function.objective_function_index]);
+}
 
-  compute_F_objective_function(cost);
-  F_eval.push_back(cost);
+void Hopper_Jump_Opt::compute_F_constraints(std::vector<double> &F_eval){
+  F_eval.resize(objective_function.objective_function_index);
+  compute_F_constraints(F_eval.data());
+}
 
+void Hopper_Jump_Opt::compute_F_constraints(double* F_eval){
+  // Each constraint writes its values in place at the same rows as compute_G.
+  // Knotpoints may run on their own threads, and blocks whose variables did not change since the last call are reused.
+  knotpoint_evaluator.evaluate_constraints(ti_constraint_list, td_constraint_list, opt_var_manager, N_total_knotpoints, F_eval);
 }
 
 
-void Hopper_Jump_Opt::compute_F_constraints(std::vector<double> &F_eval){
-  std::vector<double> F_vec_const;
-  //std::cout << "[Hopper_Jump_Opt] Computing F Constraints" << std::endl;
+void Hopper_Jump_Opt::initialize_G_sparsity_pattern(){
+  G_sparsity_pattern.clear();
+  Constraint_Function* current_constraint;
+  int row_offset = 0;
 
-  // Compute Timestep Independent Constraints
+  // Timestep Independent Constraints use the same rows as compute_F
   for(int knotpoint = 1; knotpoint < N_total_knotpoints + 1; knotpoint++){
     for(int i = 0; i < ti_constraint_list.get_size(); i++){
-      F_vec_const.clear();
-      ti_constraint_list.get_constraint(i)->evaluate_constraint(knotpoint, opt_var_manager, F_vec_const);
-      //std::cout << " Adding TD Constraint " << ti_constraint_list.get_constraint(i)->constraint_name << std::endl;
-
-      for(int j = 0; j < F_vec_const.size(); j++){
-        //std::cout << "F_td_const[" << j <<"] = " << F_vec_const[j] << std::endl;
-        // Add to F_eval
-        F_eval.push_back(F_vec_const[j]);
-      }
+      current_constraint = ti_constraint_list.get_constraint(i);
+      row_offset = (knotpoint - 1)*ti_constraint_list.get_num_constraint_funcs() + current_constraint->constraint_index;
+      current_constraint->get_sparsity_pattern(knotpoint, opt_var_manager, row_offset, G_sparsity_pattern);
     }
   }
 
-  // Compute Timestep Dependent Constraints
-  Constraint_Function* current_constraint;
+  // Timestep Dependent Constraints
   for(size_t i = 0; i < td_constraint_list.get_size(); i++){
-      F_vec_const.clear();
-      current_constraint = td_constraint_list.get_constraint(i);         
-      current_constraint->evaluate_constraint(current_constraint->des_knotpoint, opt_var_manager, F_vec_const);
-      //std::cout << " Adding TI Constraint " << current_constraint->constraint_name << std::endl;
-
-      //std::cout << "F_vec_const.size() = " << F_vec_const.size() << std::endl;
-    for(size_t j = 0; j < current_constraint->F_low.size(); j++ ){
-      //std::cout << " des knotpoint = " << current_constraint->des_knotpoint << std::endl;
-      //std::cout << "F_ti_const[" << j <<"] = " << F_vec_const[j] << std::endl;      
-      F_eval.push_back(F_vec_const[j]);
+    current_constraint = td_constraint_list.get_constraint(i);
+    row_offset = ti_constraint_list.get_num_constraint_funcs()*N_total_knotpoints + current_constraint->constraint_index;
+    current_constraint->get_sparsity_pattern(current_constraint->des_knotpoint, opt_var_manager, row_offset, G_sparsity_pattern);
+  }
+
+  // Objective Function
+  objective_function.get_sparsity_pattern(opt_var_manager, G_sparsity_pattern);
+
+  G_sparsity_pattern.finalize();
+
+  // Elements of the constant linear A matrix must not appear in G
+  std::vector<double> A_eval;
+  std::vector<int> iAfun;
+  std::vector<int> jAvar;
+  int neA = 0;
+  compute_A(A_eval, iAfun, jAvar, neA);
+  G_sparsity_pattern.remove_elements(iAfun, jAvar);
+
+  std::cout << "[Hopper_Jump_Opt] Sparsity pattern has " << G_sparsity_pattern.get_size() << " nonzero elements" << std::endl;
+}
+
+void Hopper_Jump_Opt::compute_G(std::vector<double> &G_eval, std::vector<int> &iGfun, std::vector<int> &jGvar, int &neG){
+  G_eval.clear();
+  iGfun.clear();
+  jGvar.clear();
+
+  // Constraints return their gradients with local row indices. Shift them to the rows used in compute_F.
+  Constraint_Function* current_constraint;
+  size_t prev_size = 0;
+  int row_offset = 0;
+
+  // Gradients of Timestep Independent Constraints
+  for(int knotpoint = 1; knotpoint < N_total_knotpoints + 1; knotpoint++){
+    for(int i = 0; i < ti_constraint_list.get_size(); i++){
+      current_constraint = ti_constraint_list.get_constraint(i);
+      row_offset = (knotpoint - 1)*ti_constraint_list.get_num_constraint_funcs() + current_constraint->constraint_index;
+
+      OPT_PROFILE_SCOPE_NAMED("constraint G", current_constraint->constraint_name);
+      prev_size = G_eval.size();
+      current_constraint->evaluate_sparse_gradient(knotpoint, opt_var_manager, G_eval, iGfun, jGvar);
+      for(size_t j = prev_size; j < iGfun.size(); j++){
+        iGfun[j] += row_offset;
+      }
     }
+  }
 
+  // Gradients of Timestep Dependent Constraints
+  for(size_t i = 0; i < td_constraint_list.get_size(); i++){
+    current_constraint = td_constraint_list.get_constraint(i);
+    row_offset = ti_constraint_list.get_num_constraint_funcs()*N_total_knotpoints + current_constraint->constraint_index;
+
+    OPT_PROFILE_SCOPE_NAMED("constraint G", current_constraint->constraint_name);
+    prev_size = G_eval.size();
+    current_constraint->evaluate_sparse_gradient(current_constraint->des_knotpoint, opt_var_manager, G_eval, iGfun, jGvar);
+    for(size_t j = prev_size; j < iGfun.size(); j++){
+      iGfun[j] += row_offset;
+    }
   }
 
-  // Debug statement  
-  /*  for(int j = 0; j < F_eval.size(); j++){
-      std::cout << "F_eval[" << j << "] = " << F_eval[j] << std::endl;
-    }*/
+  // Gradient of the Objective Function
+  OPT_PROFILE_SCOPE_NAMED("objective G", objective_function.objective_function_name);
+  prev_size = G_eval.size();
+  objective_function.evaluate_objective_gradient(opt_var_manager, G_eval, iGfun, jGvar);
+  for(size_t j = prev_size; j < iGfun.size(); j++){
+    iGfun[j] += objective_function.objective_function_index;
+  }
 
+  neG = G_eval.size();
 }
+void Hopper_Jump_Opt::compute_A(std::vector<double> &A_eval, std::vector<int> &iAfun, std::vector<int> &jAvar, int &neA){
+  A_eval.clear();
+  iAfun.clear();
+  jAvar.clear();
+
+  // The A matrix is constant. Rows follow compute_F as in compute_G.
+  Constraint_Function* current_constraint;
+  size_t prev_size = 0;
+  int row_offset = 0;
 
+  // Linear terms of Timestep Independent Constraints
+  for(int knotpoint = 1; knotpoint < N_total_knotpoints + 1; knotpoint++){
+    for(int i = 0; i < ti_constraint_list.get_size(); i++){
+      current_constraint = ti_constraint_list.get_constraint(i);
+      row_offset = (knotpoint - 1)*ti_constraint_list.get_num_constraint_funcs() + current_constraint->constraint_index;
 
+      prev_size = A_eval.size();
+      current_constraint->evaluate_sparse_A_matrix(knotpoint, opt_var_manager, A_eval, iAfun, jAvar);
+      for(size_t j = prev_size; j < iAfun.size(); j++){
+        iAfun[j] += row_offset;
+      }
+    }
+  }
 
-void Hopper_Jump_Opt::compute_G(std::vector<double> &G_eval, std::vector<int> &iGfun, std::vector<int> &jGvar, int &neG){}
-void Hopper_Jump_Opt::compute_A(std::vector<double> &A_eval, std::vector<int> &iAfun, std::vector<int> &jAvar, int &neA){}
+  // Linear terms of Timestep Dependent Constraints
+  for(size_t i = 0; i < td_constraint_list.get_size(); i++){
+    current_constraint = td_constraint_list.get_constraint(i);
+    row_offset = ti_constraint_list.get_num_constraint_funcs()*N_total_knotpoints + current_constraint->constraint_index;
+
+    prev_size = A_eval.size();
+    current_constraint->evaluate_sparse_A_matrix(current_constraint->des_knotpoint, opt_var_manager, A_eval, iAfun, jAvar);
+    for(size_t j = prev_size; j < iAfun.size(); j++){
+      iAfun[j] += row_offset;
+    }
+  }
+
+  neA = A_eval.size();
+}
 
 
@@ -0,0 +1,152 @@
+#include <optimization/parallel/finite_difference_jacobian.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
+#include <iostream>
+#include <cmath>
+
+Finite_Difference_Jacobian::Finite_Difference_Jacobian(Optimization_Problem_Main* problem_in): problem(problem_in), thread_pool(1){
+	initialize_colors();
+}
+
+Finite_Difference_Jacobian::Finite_Difference_Jacobian(Optimization_Problem_Main* problem_in, const std::function<Optimization_Problem_Main*()> &problem_factory,
+													   const int &num_threads): problem(problem_in), thread_pool(num_threads){
+	initialize_colors();
+	for(int t = 0; t < num_threads; t++){
+		Optimization_Problem_Main* copy = problem_factory();
+		// The threads already run in parallel, so the copies evaluate their knotpoints serially
+		copy->set_num_threads(1);
+		problem_copies.push_back(copy);
+
+		std::vector<int> iG_copy;
+		std::vector<int> jG_copy;
+		copy->G_sparsity_pattern.get_pattern(iG_copy, jG_copy);
+		if ((iG_copy != G_rows) || (jG_copy != G_cols)){
+			std::cerr << "[Finite_Difference_Jacobian] Error! The problem copies must have the same sparsity pattern as " << problem->problem_name << std::endl;
+			throw "invalid_index";
+		}
+	}
+}
+
+Finite_Difference_Jacobian::~Finite_Difference_Jacobian(){
+	for(size_t t = 0; t < problem_copies.size(); t++){
+		delete problem_copies[t];
+	}
+}
+
+int Finite_Difference_Jacobian::get_num_colors(){
+	return color_cols.size();
+}
+
+int Finite_Difference_Jacobian::get_num_threads(){
+	return thread_pool.get_num_threads();
+}
+
+void Finite_Difference_Jacobian::set_relative_step(const double &step){
+	relative_step = step;
+}
+
+void Finite_Difference_Jacobian::initialize_colors(){
+	std::vector<double> x_init;
+	std::vector<double> F_low;
+	std::vector<double> F_upp;
+	problem->get_init_opt_vars(x_init);
+	problem->get_F_bounds(F_low, F_upp);
+	n = x_init.size();
+	nF = F_low.size();
+	problem->G_sparsity_pattern.get_pattern(G_rows, G_cols);
+
+	// Columns of each row and rows of each column
+	std::vector< std::vector<int> > row_cols(nF);
+	std::vector< std::vector<int> > col_elements(n);
+	for(size_t e = 0; e < G_rows.size(); e++){
+		row_cols[G_rows[e]].push_back(G_cols[e]);
+		col_elements[G_cols[e]].push_back(e);
+	}
+
+	// Greedy coloring. Two columns conflict if they have an element in the same row.
+	std::vector<int> col_color(n, -1);
+	std::vector<int> color_used_by(n, -1); // Last column that found the color taken by a neighbour
+	for(int j = 0; j < n; j++){
+		if (col_elements[j].empty()){
+			continue;
+		}
+		for(size_t a = 0; a < col_elements[j].size(); a++){
+			const std::vector<int> &cols = row_cols[G_rows[col_elements[j][a]]];
+			for(size_t b = 0; b < cols.size(); b++){
+				if (col_color[cols[b]] >= 0){
+					color_used_by[col_color[cols[b]]] = j;
+				}
+			}
+		}
+		int color = 0;
+		while (color_used_by[color] == j){
+			color++;
+		}
+		col_color[j] = color;
+		if (color >= (int) color_cols.size()){
+			color_cols.resize(color + 1);
+			color_elements.resize(color + 1);
+		}
+		color_cols[color].push_back(j);
+		color_elements[color].insert(color_elements[color].end(), col_elements[j].begin(), col_elements[j].end());
+	}
+
+	std::cout << "[Finite_Difference_Jacobian] " << n << " variables of " << problem->problem_name << " are differenced in "
+			  << color_cols.size() << " colors" << std::endl;
+}
+
+void Finite_Difference_Jacobian::evaluate_color(const int &color, Optimization_Problem_Main* eval_problem, const int &slot, const double* x,
+												const double* F_nominal, double* G_out){
+	std::vector<double> &x_perturbed = x_work[slot];
+	std::vector<double> &F_perturbed = F_work[slot];
+	x_perturbed.assign(x, x + n);
+	F_perturbed.resize(nF);
+
+	const std::vector<int> &cols = color_cols[color];
+	for(size_t k = 0; k < cols.size(); k++){
+		x_perturbed[cols[k]] = x[cols[k]] + relative_step*(1.0 + std::fabs(x[cols[k]]));
+	}
+	eval_problem->update_opt_vars(x_perturbed.data(), n);
+	eval_problem->compute_F(F_perturbed.data());
+	// Each row has at most one column of the color, so the row's change belongs to that element
+	const std::vector<int> &elements = color_elements[color];
+	for(size_t k = 0; k < elements.size(); k++){
+		int e = elements[k];
+		int j = G_cols[e];
+		G_out[e] = (F_perturbed[G_rows[e]] - F_nominal[G_rows[e]])/(x_perturbed[j] - x[j]);
+	}
+}
+
+void Finite_Difference_Jacobian::compute_G(const double* x, const int &n_in, const double* F_nominal, double* G_out){
+	OPT_PROFILE_SCOPE("finite differences", "Finite_Difference_Jacobian::compute_G");
+	if (n_in != n){
+		std::cerr << "[Finite_Difference_Jacobian] Error! Expected " << n << " variables but got " << n_in << std::endl;
+		throw "invalid_index";
+	}
+	if (F_nominal == NULL){
+		F_nominal_buffer.resize(nF);
+		problem->update_opt_vars(x, n);
+		problem->compute_F(F_nominal_buffer.data());
+		F_nominal = F_nominal_buffer.data();
+	}
+
+	int num_colors = color_cols.size();
+	if (problem_copies.empty()){
+		x_work.resize(1);
+		F_work.resize(1);
+		for(int color = 0; color < num_colors; color++){
+			evaluate_color(color, problem, 0, x, F_nominal, G_out);
+		}
+		problem->update_opt_vars(x, n);
+		return;
+	}
+
+	// Copy t evaluates colors t, t + num_copies, ... so no two threads share a copy. Colors write disjoint elements of G.
+	int num_copies = problem_copies.size();
+	x_work.resize(num_copies);
+	F_work.resize(num_copies);
+	thread_pool.parallel_for(0, num_copies, [&](int t){
+		for(int color = t; color < num_colors; color += num_copies){
+			evaluate_color(color, problem_copies[t], t, x, F_nominal, G_out);
+		}
+	});
+}
@@ -0,0 +1,209 @@
+#include <optimization/parallel/knotpoint_evaluator.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+Knotpoint_Evaluator::Knotpoint_Evaluator(){
+	// hardware_concurrency() returns 0 when it is unknown
+	int num_cores = std::thread::hardware_concurrency();
+	set_num_threads(num_cores > 0 ? num_cores : 1);
+}
+Knotpoint_Evaluator::~Knotpoint_Evaluator(){}
+
+void Knotpoint_Evaluator::set_num_threads(const int &num_threads){
+	thread_pool.set_num_threads(num_threads);
+}
+
+int Knotpoint_Evaluator::get_num_threads(){
+	return thread_pool.get_num_threads();
+}
+
+void Knotpoint_Evaluator::set_incremental_evaluation(const bool &incremental){
+	incremental_evaluation = incremental;
+	cache_valid = false;
+}
+
+bool Knotpoint_Evaluator::get_incremental_evaluation(){
+	return incremental_evaluation;
+}
+
+void Knotpoint_Evaluator::set_batch_evaluation(const bool &batch){
+	batch_evaluation = batch;
+	cache_valid = false;
+}
+
+bool Knotpoint_Evaluator::get_batch_evaluation(){
+	return batch_evaluation;
+}
+
+void Knotpoint_Evaluator::invalidate_cache(){
+	cache_valid = false;
+}
+
+bool Knotpoint_Evaluator::is_batched(Constraint_Function* constraint){
+	return batch_evaluation && constraint->supports_batch_evaluation();
+}
+
+void Knotpoint_Evaluator::evaluate_batches(Constraint_List &ti_constraint_list, Opt_Variable_Manager &var_manager, const std::vector<int> &knotpoints, double* F_eval){
+	if (knotpoints.empty()){
+		return;
+	}
+	for(int i = 0; i < ti_constraint_list.get_size(); i++){
+		Constraint_Function* current_constraint = ti_constraint_list.get_constraint(i);
+		if (is_batched(current_constraint)){
+			OPT_PROFILE_SCOPE_NAMED("constraint F", current_constraint->constraint_name);
+			current_constraint->evaluate_constraint_batch(knotpoints, var_manager, F_eval, ti_constraint_list.get_num_constraint_funcs());
+		}
+	}
+}
+
+void Knotpoint_Evaluator::evaluate_knotpoint(Constraint_List &ti_constraint_list, Opt_Variable_Manager &var_manager, const int &knotpoint, double* F_eval){
+	double* F_knotpoint = F_eval + (knotpoint - 1)*ti_constraint_list.get_num_constraint_funcs();
+	for(int i = 0; i < ti_constraint_list.get_size(); i++){
+		Constraint_Function* current_constraint = ti_constraint_list.get_constraint(i);
+		if (is_batched(current_constraint)){
+			continue;
+		}
+		if (current_constraint->is_linear()){
+			std::fill(F_knotpoint + current_constraint->constraint_index, F_knotpoint + current_constraint->constraint_index + current_constraint->constraint_size, 0.0);
+			continue;
+		}
+		OPT_PROFILE_SCOPE_NAMED("constraint F", current_constraint->constraint_name);
+		current_constraint->evaluate_constraint_in_place(knotpoint, var_manager, F_knotpoint + current_constraint->constraint_index);
+	}
+}
+
+void Knotpoint_Evaluator::evaluate_td_constraint(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, const int &index, 
+												 Opt_Variable_Manager &var_manager, const int &total_knotpoints, double* F_eval){
+	Constraint_Function* current_constraint = td_constraint_list.get_constraint(index);
+	double* F_constraint = F_eval + ti_constraint_list.get_num_constraint_funcs()*total_knotpoints + current_constraint->constraint_index;
+	if (current_constraint->is_linear()){
+		std::fill(F_constraint, F_constraint + current_constraint->constraint_size, 0.0);
+		return;
+	}
+	OPT_PROFILE_SCOPE_NAMED("constraint F", current_constraint->constraint_name);
+	current_constraint->evaluate_constraint_in_place(current_constraint->des_knotpoint, var_manager, F_constraint);
+}
+
+void Knotpoint_Evaluator::evaluate_ti_constraints(Constraint_List &ti_constraint_list, Opt_Variable_Manager &var_manager, 
+												  const int &total_knotpoints, double* F_eval){
+	if ((int) all_knotpoints.size() != total_knotpoints){
+		all_knotpoints.clear();
+		for(int knotpoint = 1; knotpoint <= total_knotpoints; knotpoint++){
+			all_knotpoints.push_back(knotpoint);
+		}
+	}
+	evaluate_batches(ti_constraint_list, var_manager, all_knotpoints, F_eval);
+	thread_pool.parallel_for(1, total_knotpoints + 1, [&](int knotpoint){
+		evaluate_knotpoint(ti_constraint_list, var_manager, knotpoint, F_eval);
+	});
+}
+
+void Knotpoint_Evaluator::evaluate_all(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, 
+									   Opt_Variable_Manager &var_manager, const int &total_knotpoints, double* F_eval){
+	evaluate_ti_constraints(ti_constraint_list, var_manager, total_knotpoints, F_eval);
+	for(int i = 0; i < td_constraint_list.get_size(); i++){
+		evaluate_td_constraint(ti_constraint_list, td_constraint_list, i, var_manager, total_knotpoints, F_eval);
+	}
+}
+
+void Knotpoint_Evaluator::initialize_dependencies(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, 
+												  Opt_Variable_Manager &var_manager, const int &total_knotpoints){
+	num_ti_blocks = total_knotpoints;
+	int num_blocks = num_ti_blocks + td_constraint_list.get_size();
+
+	var_blocks.clear();
+	var_blocks.resize(var_manager.get_size() - var_manager.initial_conditions_offset);
+
+	std::vector<int> var_indices;
+	for(int block = 0; block < num_blocks; block++){
+		Constraint_Function* current_constraint;
+		int num_constraints = (block < num_ti_blocks) ? ti_constraint_list.get_size() : 1;
+		for(int i = 0; i < num_constraints; i++){
+			int knotpoint = block + 1;
+			if (block < num_ti_blocks){
+				current_constraint = ti_constraint_list.get_constraint(i);
+			}else{
+				current_constraint = td_constraint_list.get_constraint(block - num_ti_blocks);
+				knotpoint = current_constraint->des_knotpoint;
+			}
+			// The rows of linear constraints are always zero
+			if (current_constraint->is_linear()){
+				continue;
+			}
+
+			for(size_t j = 0; j < current_constraint->var_dependencies.size(); j++){
+				const Var_Dependency &dependency = current_constraint->var_dependencies[j];
+				var_manager.get_var_indices(dependency.var_type, knotpoint + dependency.knotpoint_offset, var_indices);
+				for(size_t k = 0; k < var_indices.size(); k++){
+					// Fixed initial conditions never change
+					if (var_indices[k] < 0){
+						continue;
+					}
+					std::vector<int> &blocks = var_blocks[var_indices[k]];
+					if (blocks.empty() || (blocks.back() != block)){
+						blocks.push_back(block);
+					}
+				}
+			}
+		}
+	}
+
+	dirty_blocks.assign(num_blocks, false);
+	dependencies_initialized = true;
+	cache_valid = false;
+}
+
+void Knotpoint_Evaluator::evaluate_constraints(Constraint_List &ti_constraint_list, Constraint_List &td_constraint_list, 
+											   Opt_Variable_Manager &var_manager, const int &total_knotpoints, double* F_eval){
+	if (!(incremental_evaluation && dependencies_initialized)){
+		evaluate_all(ti_constraint_list, td_constraint_list, var_manager, total_knotpoints, F_eval);
+		return;
+	}
+
+	size_t num_rows = ti_constraint_list.get_num_constraint_funcs()*total_knotpoints + td_constraint_list.get_num_constraint_funcs();
+	var_manager.get_current_opt_vars(x_current);
+
+	if (!cache_valid || (x_current.size() != var_blocks.size()) || (F_cache.size() != num_rows)){
+		cache_valid = false;
+		dirty_blocks.assign(dirty_blocks.size(), false);
+		F_cache.resize(num_rows);
+		evaluate_all(ti_constraint_list, td_constraint_list, var_manager, total_knotpoints, F_cache.data());
+		x_prev.swap(x_current);
+		cache_valid = (x_prev.size() == var_blocks.size());
+	}else{
+		// Stays invalid if a constraint throws before the dirty blocks are evaluated
+		cache_valid = false;
+		for(size_t i = 0; i < x_current.size(); i++){
+			if (x_current[i] != x_prev[i]){
+				for(size_t j = 0; j < var_blocks[i].size(); j++){
+					dirty_blocks[var_blocks[i][j]] = true;
+				}
+			}
+		}
+		x_prev.swap(x_current);
+
+		dirty_knotpoints.clear();
+		for(int block = 0; block < num_ti_blocks; block++){
+			if (dirty_blocks[block]){
+				dirty_knotpoints.push_back(block + 1);
+				dirty_blocks[block] = false;
+			}
+		}
+		evaluate_batches(ti_constraint_list, var_manager, dirty_knotpoints, F_cache.data());
+		thread_pool.parallel_for(0, dirty_knotpoints.size(), [&](int i){
+			evaluate_knotpoint(ti_constraint_list, var_manager, dirty_knotpoints[i], F_cache.data());
+		});
+
+		for(size_t block = num_ti_blocks; block < dirty_blocks.size(); block++){
+			if (dirty_blocks[block]){
+				evaluate_td_constraint(ti_constraint_list, td_constraint_list, block - num_ti_blocks, var_manager, total_knotpoints, F_cache.data());
+				dirty_blocks[block] = false;
+			}
+		}
+		cache_valid = true;
+	}
+
+	memcpy(F_eval, F_cache.data(), num_rows*sizeof(double));
+}
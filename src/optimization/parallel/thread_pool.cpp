@@ -0,0 +1,132 @@
+#include <optimization/parallel/thread_pool.hpp>
+#include <iostream>
+
+Thread_Pool::Thread_Pool(const int &num_threads_in): next_index(0){
+	set_num_threads(num_threads_in);
+}
+
+Thread_Pool::~Thread_Pool(){
+	stop_workers();
+}
+
+void Thread_Pool::set_num_threads(const int &num_threads_in){
+	if (num_threads_in < 1){
+		std::cerr << "Error setting the number of threads. At least 1 thread is required" << std::endl;
+		throw "invalid_index";
+	}
+	if (num_threads_in == num_threads){
+		return;
+	}
+	stop_workers();
+	num_threads = num_threads_in;
+}
+
+int Thread_Pool::get_num_threads(){
+	return num_threads;
+}
+
+void Thread_Pool::start_workers(){
+	stop = false;
+	// The calling thread is the remaining thread. New workers skip the loops that ran before they started,
+	// otherwise a restarted worker would wake for a finished loop and count itself done twice in the next one.
+	for(int i = 0; i < num_threads - 1; i++){
+		workers.push_back(std::thread(&Thread_Pool::worker_loop, this, generation));
+	}
+}
+
+void Thread_Pool::stop_workers(){
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		stop = true;
+	}
+	work_cv.notify_all();
+	for(size_t i = 0; i < workers.size(); i++){
+		workers[i].join();
+	}
+	workers.clear();
+}
+
+void Thread_Pool::run_tasks(){
+	int i = next_index.fetch_add(1);
+	while(i < end_index){
+		try{
+			(*current_func)(i);
+		}catch(...){
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			if (!first_exception){
+				first_exception = std::current_exception();
+			}
+			// Skip the remaining iterations
+			next_index.store(end_index);
+		}
+		i = next_index.fetch_add(1);
+	}
+}
+
+void Thread_Pool::worker_loop(unsigned int seen_generation){
+	while(true){
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			work_cv.wait(lock, [&]{ return stop || (generation != seen_generation); });
+			if (stop){
+				return;
+			}
+			seen_generation = generation;
+		}
+
+		run_tasks();
+
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			num_busy_workers--;
+		}
+		done_cv.notify_one();
+	}
+}
+
+void Thread_Pool::parallel_for(const int &begin, const int &end, const std::function<void(int)> &func){
+	if (end <= begin){
+		return;
+	}
+
+	// Workers are started on the first loop that needs them, so an unused pool costs no threads
+	if ((num_threads > 1) && workers.empty()){
+		start_workers();
+	}
+
+	// Serial path. Avoids any synchronization when there are no workers or a single iteration.
+	if (workers.empty() || (end - begin == 1)){
+		for(int i = begin; i < end; i++){
+			func(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		current_func = &func;
+		end_index = end;
+		next_index.store(begin);
+		first_exception = NULL;
+		// Every worker takes part in every loop, even if it finds no index left
+		num_busy_workers = workers.size();
+		generation++;
+	}
+	work_cv.notify_all();
+
+	run_tasks();
+
+	// Wait until every worker is done with this loop so that none of them still reads its state
+	std::exception_ptr loop_exception;
+	{
+		std::unique_lock<std::mutex> lock(pool_mutex);
+		done_cv.wait(lock, [&]{ return num_busy_workers == 0; });
+		current_func = NULL;
+		loop_exception = first_exception;
+		first_exception = NULL;
+	}
+
+	if (loop_exception){
+		std::rethrow_exception(loop_exception);
+	}
+}
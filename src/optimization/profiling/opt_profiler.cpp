@@ -0,0 +1,166 @@
+#include <optimization/profiling/opt_profiler.hpp>
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+
+namespace{
+	struct Profile_Totals{
+		unsigned long calls = 0;
+		long long total_ns = 0;
+		long long max_ns = 0;
+
+		void add(const unsigned long &calls_in, const long long &total_ns_in, const long long &max_ns_in){
+			calls += calls_in;
+			total_ns += total_ns_in;
+			max_ns = std::max(max_ns, max_ns_in);
+		}
+	};
+
+	typedef std::pair<std::string, std::string> Profile_Key; // (category, name)
+	typedef std::map<Profile_Key, Profile_Totals> Profile_Totals_Map;
+
+	// Records of one thread. Categories are string literals, so they are looked up by address.
+	// Only the owning thread inserts, and it holds the mutex while doing so.
+	struct Profile_Table{
+		Profile_Table();
+		~Profile_Table();
+
+		std::mutex table_mutex;
+		std::unordered_map<const char*, std::unordered_map<std::string, Profile_Record> > categories;
+
+		void add_to(Profile_Totals_Map &totals){
+			std::lock_guard<std::mutex> lock(table_mutex);
+			for(auto &category : categories){
+				for(auto &record : category.second){
+					totals[Profile_Key(category.first, record.first)].add(record.second.calls.load(std::memory_order_relaxed),
+																	   record.second.total_ns.load(std::memory_order_relaxed),
+																	   record.second.max_ns.load(std::memory_order_relaxed));
+				}
+			}
+		}
+	};
+
+	// Live tables and the totals of the threads that have exited
+	struct Profile_Registry{
+		std::mutex registry_mutex;
+		std::vector<Profile_Table*> tables;
+		Profile_Totals_Map retired_totals;
+	};
+
+	Profile_Registry& get_registry(){
+		static Profile_Registry registry;
+		return registry;
+	}
+
+	Profile_Table::Profile_Table(){
+		// Constructed first, so the registry outlives the tables of every thread
+		Profile_Registry &registry = get_registry();
+		std::lock_guard<std::mutex> lock(registry.registry_mutex);
+		registry.tables.push_back(this);
+	}
+
+	Profile_Table::~Profile_Table(){
+		Profile_Registry &registry = get_registry();
+		std::lock_guard<std::mutex> lock(registry.registry_mutex);
+		add_to(registry.retired_totals);
+		registry.tables.erase(std::remove(registry.tables.begin(), registry.tables.end(), this), registry.tables.end());
+	}
+
+	Profile_Table& get_thread_table(){
+		static thread_local Profile_Table table;
+		return table;
+	}
+
+	void collect_totals(std::vector<std::pair<Profile_Key, Profile_Totals> > &totals_out){
+		Profile_Registry &registry = get_registry();
+		Profile_Totals_Map totals;
+		{
+			std::lock_guard<std::mutex> lock(registry.registry_mutex);
+			totals = registry.retired_totals;
+			for(size_t i = 0; i < registry.tables.size(); i++){
+				registry.tables[i]->add_to(totals);
+			}
+		}
+
+		totals_out.assign(totals.begin(), totals.end());
+		std::sort(totals_out.begin(), totals_out.end(),
+				  [](const std::pair<Profile_Key, Profile_Totals> &a, const std::pair<Profile_Key, Profile_Totals> &b){
+			return a.second.total_ns > b.second.total_ns;
+		});
+	}
+}
+
+Profile_Record* Opt_Profiler::get_record(const char* category, const std::string &name){
+	Profile_Table &table = get_thread_table();
+
+	auto category_it = table.categories.find(category);
+	if (category_it != table.categories.end()){
+		auto record_it = category_it->second.find(name);
+		if (record_it != category_it->second.end()){
+			return &(record_it->second);
+		}
+	}
+
+	// First call of the key on this thread. Elements of an unordered_map do not move on insertion.
+	std::lock_guard<std::mutex> lock(table.table_mutex);
+	return &(table.categories[category][name]);
+}
+
+void Opt_Profiler::print_summary(std::ostream &os){
+	std::vector<std::pair<Profile_Key, Profile_Totals> > totals;
+	collect_totals(totals);
+
+	os << "[Opt Profiler] Inclusive wall time of the profiled scopes" << std::endl;
+	os << std::left << std::setw(16) << "category" << std::setw(56) << "name" << std::right
+	   << std::setw(12) << "calls" << std::setw(14) << "total [ms]" << std::setw(14) << "mean [us]" << std::setw(14) << "max [us]" << std::endl;
+
+	std::ios::fmtflags flags(os.flags());
+	os << std::fixed << std::setprecision(3);
+	for(size_t i = 0; i < totals.size(); i++){
+		const Profile_Totals &record = totals[i].second;
+		double mean_us = (record.calls > 0) ? (1e-3*record.total_ns/record.calls) : 0.0;
+		os << std::left << std::setw(16) << totals[i].first.first << std::setw(56) << totals[i].first.second << std::right
+		   << std::setw(12) << record.calls << std::setw(14) << 1e-6*record.total_ns << std::setw(14) << mean_us
+		   << std::setw(14) << 1e-3*record.max_ns << std::endl;
+	}
+	os.flags(flags);
+}
+
+bool Opt_Profiler::write_dump(const std::string &filename){
+	std::ofstream file(filename.c_str());
+	if (!file.is_open()){
+		std::cerr << "[Opt Profiler] Error! Could not open " << filename << std::endl;
+		return false;
+	}
+
+	std::vector<std::pair<Profile_Key, Profile_Totals> > totals;
+	collect_totals(totals);
+
+	file << "category,name,calls,total_ns,max_ns" << std::endl;
+	for(size_t i = 0; i < totals.size(); i++){
+		file << totals[i].first.first << ",\"" << totals[i].first.second << "\"," << totals[i].second.calls << ","
+			 << totals[i].second.total_ns << "," << totals[i].second.max_ns << std::endl;
+	}
+	return true;
+}
+
+void Opt_Profiler::reset(){
+	// Scopes that are running while this is called may write back their old totals
+	Profile_Registry &registry = get_registry();
+	std::lock_guard<std::mutex> lock(registry.registry_mutex);
+	registry.retired_totals.clear();
+	for(size_t i = 0; i < registry.tables.size(); i++){
+		std::lock_guard<std::mutex> table_lock(registry.tables[i]->table_mutex);
+		for(auto &category : registry.tables[i]->categories){
+			for(auto &record : category.second){
+				record.second.calls.store(0, std::memory_order_relaxed);
+				record.second.total_ns.store(0, std::memory_order_relaxed);
+				record.second.max_ns.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+}
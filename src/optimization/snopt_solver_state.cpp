@@ -0,0 +1,121 @@
+#include <optimization/snopt_solver_state.hpp>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+
+namespace snopt_wrapper{
+
+  const char SOLVER_STATE_MAGIC[8] = {'N', 'L', 'P', 'W', 'A', 'R', 'M', '\0'};
+  const uint32_t SOLVER_STATE_VERSION = 1;
+  const uint32_t MAX_PROBLEM_NAME_LENGTH = 4096;
+
+  struct Solver_State_Header{
+    char magic[8];
+    uint32_t version;
+    uint32_t sizeof_double; // Files are only read back on machines with the same layout
+    int32_t n;
+    int32_t nF;
+    int32_t nS;
+    uint32_t problem_name_length;
+  };
+
+  template <typename T>
+  void write_array(std::ofstream &file, const std::vector<T> &values){
+	if (!values.empty()){
+		file.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(T));
+	}
+  }
+
+  template <typename T>
+  void read_array(std::ifstream &file, const int &size, std::vector<T> &values){
+	values.resize(size);
+	if (size > 0){
+		file.read(reinterpret_cast<char*>(values.data()), size*sizeof(T));
+	}
+  }
+
+  bool write_solver_state(const std::string &filename, const Solver_State &state){
+	size_t n = state.x.size();
+	size_t nF = state.F.size();
+	if ((state.xstate.size() != n) || (state.xmul.size() != n) || (state.Fstate.size() != nF) || (state.Fmul.size() != nF) ||
+		(state.problem_name.size() > MAX_PROBLEM_NAME_LENGTH)){
+		std::cerr << "[SNOPT Wrapper] Error! Solver state arrays of " << filename << " have inconsistent sizes" << std::endl;
+		return false;
+	}
+
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file.is_open()){
+		std::cerr << "[SNOPT Wrapper] Error! Could not open " << filename << std::endl;
+		return false;
+	}
+
+	Solver_State_Header header;
+	memcpy(header.magic, SOLVER_STATE_MAGIC, sizeof(header.magic));
+	header.version = SOLVER_STATE_VERSION;
+	header.sizeof_double = sizeof(double);
+	header.n = n;
+	header.nF = nF;
+	header.nS = state.nS;
+	header.problem_name_length = state.problem_name.size();
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(state.problem_name.data(), state.problem_name.size());
+	write_array(file, state.x);
+	write_array(file, state.xstate);
+	write_array(file, state.xmul);
+	write_array(file, state.F);
+	write_array(file, state.Fstate);
+	write_array(file, state.Fmul);
+
+	if (!file.good()){
+		std::cerr << "[SNOPT Wrapper] Error! Could not write " << filename << std::endl;
+		return false;
+	}
+	return true;
+  }
+
+  bool read_solver_state(const std::string &filename, Solver_State &state_out){
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file.is_open()){
+		std::cerr << "[SNOPT Wrapper] Error! Could not open " << filename << std::endl;
+		return false;
+	}
+
+	Solver_State_Header header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file.good() || (memcmp(header.magic, SOLVER_STATE_MAGIC, sizeof(header.magic)) != 0)){
+		std::cerr << "[SNOPT Wrapper] Error! " << filename << " is not a solver state file" << std::endl;
+		return false;
+	}
+	if ((header.version != SOLVER_STATE_VERSION) || (header.sizeof_double != sizeof(double))){
+		std::cerr << "[SNOPT Wrapper] Error! " << filename << " has version " << header.version << " but version " << SOLVER_STATE_VERSION << " is expected" << std::endl;
+		return false;
+	}
+	if ((header.n < 0) || (header.nF < 0) || (header.nS < 0) || (header.problem_name_length > MAX_PROBLEM_NAME_LENGTH)){
+		std::cerr << "[SNOPT Wrapper] Error! " << filename << " has invalid dimensions" << std::endl;
+		return false;
+	}
+
+	Solver_State state;
+	state.problem_name.resize(header.problem_name_length);
+	if (header.problem_name_length > 0){
+		file.read(&state.problem_name[0], header.problem_name_length);
+	}
+	state.nS = header.nS;
+	read_array(file, header.n, state.x);
+	read_array(file, header.n, state.xstate);
+	read_array(file, header.n, state.xmul);
+	read_array(file, header.nF, state.F);
+	read_array(file, header.nF, state.Fstate);
+	read_array(file, header.nF, state.Fmul);
+
+	if (!file.good()){
+		std::cerr << "[SNOPT Wrapper] Error! " << filename << " is truncated" << std::endl;
+		return false;
+	}
+	state_out = state;
+	return true;
+  }
+
+}
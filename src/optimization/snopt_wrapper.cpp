@@ -1,9 +1,34 @@
 #include <optimization/snopt_wrapper.hpp>
+#include <optimization/profiling/opt_profiler.hpp>
 #include <string>
 
 namespace snopt_wrapper{
 
-  Optimization_Problem_Main* ptr_optimization_problem;
+  // Everything the callbacks need for one solve. It lives on the stack of the solve function.
+  struct Callback_Data{
+	Optimization_Problem_Main* ptr_optimization_problem = NULL;
+
+	// Gradient buffers are kept between calls so that compute_G reuses their capacity
+	std::vector<double> G_eval_buffer;
+	std::vector<int> iGfun_buffer;
+	std::vector<int> jGvar_buffer;
+
+	// When set, G is the colored finite difference of F instead of the problem's compute_G
+	Finite_Difference_Jacobian* fd_jacobian = NULL;
+  };
+
+  // SNOPT hands iu back to the callbacks untouched. The address of the Callback_Data is stored in it.
+  const int CALLBACK_DATA_LENIU = (sizeof(Callback_Data*) + sizeof(int) - 1)/sizeof(int);
+
+  void pack_callback_data(Callback_Data* data, int iu[]){
+	memcpy(iu, &data, sizeof(data));
+  }
+
+  Callback_Data* unpack_callback_data(int iu[]){
+	Callback_Data* data;
+	memcpy(&data, iu, sizeof(data));
+	return data;
+  }
 
   void wbt_F(int    *Status, int *n,    double x[],
      int    *needF,  int *lenF,  double F[],
@@ -12,37 +37,168 @@ namespace snopt_wrapper{
      int    iu[],    int *leniu,
      double ru[],    int *lenru){
 
-		std::vector<double> x_vars;
-		std::vector<double> F_eval;
-		std::vector<double> G_eval;				
-		std::vector<int> iGfun_eval;
-		std::vector<int> jGvar_eval;	
-		int neG_eval = 0;							
+		OPT_PROFILE_SCOPE("snopt", "wbt_F");
+		Callback_Data* data = unpack_callback_data(iu);
+		Optimization_Problem_Main* ptr_optimization_problem = data->ptr_optimization_problem;
 
-	  	// Update optimization x_vars
-		for (size_t i = 0; i < *n; i++){
-			x_vars.push_back(x[i]);
+		// Copy x into the variable manager and write F straight into SNOPT's array. The constraints still allocate their temporaries.
+		{
+			OPT_PROFILE_SCOPE("snopt", "update_opt_vars");
+			ptr_optimization_problem->update_opt_vars(x, *n);
+		}
+		if ((*needF) > 0){
+			OPT_PROFILE_SCOPE("snopt", "compute_F");
+			ptr_optimization_problem->compute_F(F);
 		}
 
-		ptr_optimization_problem->update_opt_vars(x_vars);
+    }    
+
+  void wbt_FG(int    *Status, int *n,    double x[],
+     int    *needF,  int *lenF,  double F[],
+     int    *needG,  int *lenG,  double G[],
+     char      *cu,  int *lencu,
+     int    iu[],    int *leniu,
+     double ru[],    int *lenru){
+
+		OPT_PROFILE_SCOPE("snopt", "wbt_FG");
+		Callback_Data* data = unpack_callback_data(iu);
+		Optimization_Problem_Main* ptr_optimization_problem = data->ptr_optimization_problem;
+		int neG_eval = 0;							
+
+		{
+			OPT_PROFILE_SCOPE("snopt", "update_opt_vars");
+			ptr_optimization_problem->update_opt_vars(x, *n);
+		}
 		// Get F evaluations
 		if ((*needF) > 0){
-			ptr_optimization_problem->compute_F(F_eval);
+			OPT_PROFILE_SCOPE("snopt", "compute_F");
+			ptr_optimization_problem->compute_F(F);
+		}
+
+		// Differences are taken from the F of this x, or from a fresh evaluation when SNOPT did not ask for F
+		if (((*needG) > 0) && (data->fd_jacobian != NULL)){
+			if (ptr_optimization_problem->G_sparsity_pattern.get_size() != (*lenG)){
+				std::cerr << "[SNOPT Wrapper] Error! Sparsity pattern has " << ptr_optimization_problem->G_sparsity_pattern.get_size() << " elements but SNOPT has " << (*lenG) << std::endl;
+				*Status = -1;
+				return;
+			}
+			data->fd_jacobian->compute_G(x, *n, ((*needF) > 0) ? F : NULL, G);
+			return;
 		}
 
-		// Populate F
-		for (size_t i = 0; i < F_eval.size(); i++){
-			F[i] = F_eval[i];
+		// Get G evaluations and place them in the order of the pattern given to SNOPT
+		if ((*needG) > 0){
+			OPT_PROFILE_SCOPE("snopt", "compute_G");
+			ptr_optimization_problem->compute_G(data->G_eval_buffer, data->iGfun_buffer, data->jGvar_buffer, neG_eval);
+			if (ptr_optimization_problem->G_sparsity_pattern.get_size() != (*lenG)){
+				std::cerr << "[SNOPT Wrapper] Error! Sparsity pattern has " << ptr_optimization_problem->G_sparsity_pattern.get_size() << " elements but SNOPT has " << (*lenG) << std::endl;
+				*Status = -1;
+				return;
+			}
+			// Populate G
+			if (!ptr_optimization_problem->G_sparsity_pattern.scatter(data->G_eval_buffer, data->iGfun_buffer, data->jGvar_buffer, G)){
+				*Status = -1;
+				return;
+			}
 		}
 
     }    
 
+  void store_result(Optimization_Problem_Main* ptr_optimization_problem, const int &exit_code, const int &n, const int &nF, 
+  					double x[], int xstate[], double xmul[], double F[], int Fstate[], double Fmul[], const int &nS, const int &ObjRow, 
+  					const int &nInf, const double &sInf, Solve_Result &result_out){
+	result_out.problem_name = ptr_optimization_problem->problem_name;
+	result_out.exit_code = exit_code;
+	result_out.objective = F[ObjRow];
+	result_out.nInf = nInf;
+	result_out.sInf = sInf;
+	result_out.x.assign(x, x + n);
+
+	Solver_State &state = result_out.solver_state;
+	state.problem_name = ptr_optimization_problem->problem_name;
+	state.nS = nS;
+	state.x.assign(x, x + n);
+	state.xstate.assign(xstate, xstate + n);
+	state.xmul.assign(xmul, xmul + n);
+	state.F.assign(F, F + nF);
+	state.Fstate.assign(Fstate, Fstate + nF);
+	state.Fmul.assign(Fmul, Fmul + nF);
+
+	ptr_optimization_problem->update_opt_vars(x, n);
+  }
+
+  // Copies a previous solver state into the SNOPT arrays. Returns false if the state can not be used.
+  bool apply_warm_start(const Solver_State &warm_start, const int &n, const int &nF, double x[], int xstate[], double xmul[], 
+  						double F[], int Fstate[], double Fmul[], int &nS){
+	if (warm_start.empty()){
+		return false;
+	}
+	if (!warm_start.matches(n, nF)){
+		std::cerr << "[SNOPT Wrapper] Warning! The warm start state has " << warm_start.x.size() << " variables and " << warm_start.F.size() 
+				  << " functions but the problem has " << n << " and " << nF << ". Starting from the initial guess." << std::endl;
+		return false;
+	}
+	for(int i = 0; i < n; i++){
+		x[i] = warm_start.x[i];
+		xstate[i] = warm_start.xstate[i];
+		xmul[i] = warm_start.xmul[i];
+	}
+	for(int i = 0; i < nF; i++){
+		F[i] = warm_start.F[i];
+		Fstate[i] = warm_start.Fstate[i];
+		Fmul[i] = warm_start.Fmul[i];
+	}
+	nS = warm_start.nS;
+	std::cout << "[SNOPT Wrapper] Warm starting from the state of " << warm_start.problem_name << std::endl;
+	return true;
+  }
+
+  // Prints the profile and writes it as CSV next to the print file when compiled with OPT_PROFILING.
+  // Totals cover every solve of the process so far, including the ones running on other threads.
+  void report_profile(const std::string &print_file){
+#ifdef OPT_PROFILING
+	Opt_Profiler::print_summary(std::cout);
+	std::string profile_file = (print_file.empty() ? std::string("snopt_problem.out") : print_file) + ".profile.csv";
+	if (Opt_Profiler::write_dump(profile_file)){
+		std::cout << "[SNOPT Wrapper] Profile written to " << profile_file << std::endl;
+	}
+#endif
+  }
 
   void solve_problem_no_gradients(Optimization_Problem_Main* input_ptr_optimization_problem){
+	Solve_Result result;
+	solve_problem_no_gradients(input_ptr_optimization_problem, "snopt_problem.out", result);
+  }
+
+  void solve_problem_with_gradients(Optimization_Problem_Main* input_ptr_optimization_problem){
+	Solve_Result result;
+	solve_problem_with_gradients(input_ptr_optimization_problem, "snopt_problem.out", result);
+  }
+
+
+  void solve_problem_no_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, Solve_Result &result_out){
+	solve_problem_no_gradients(input_ptr_optimization_problem, print_file, Solver_State(), result_out);
+  }
+
+  void solve_problem_with_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, Solve_Result &result_out){
+	solve_problem_with_gradients(input_ptr_optimization_problem, print_file, Solver_State(), result_out);
+  }
+
+
+  // How SNOPT gets the derivatives of F
+  enum Derivative_Mode{
+	DERIVATIVES_SNOPT_DIFFERENCES, // SNOPT differences F itself
+	DERIVATIVES_USER_G // G from the problem's compute_G, or from the colored differences of a Finite_Difference_Jacobian
+  };
+
+  // Shared by every solve. fd_jacobian is only used with DERIVATIVES_USER_G and may be NULL.
+  void solve_problem_main(Optimization_Problem_Main* ptr_optimization_problem, const Derivative_Mode &derivative_mode, Finite_Difference_Jacobian* fd_jacobian,
+  						  const std::string &print_file, const Solver_State &warm_start, Solve_Result &result_out){
   	std::cout << "[SNOPT Wrapper] Initializing Optimization Problem" << std::endl;
-	ptr_optimization_problem = input_ptr_optimization_problem;
   	std::cout << "[SNOPT Wrapper] Problem Name: " << ptr_optimization_problem->problem_name << std::endl;
-
+	Callback_Data callback_data;
+	callback_data.ptr_optimization_problem = ptr_optimization_problem;
+	callback_data.fd_jacobian = fd_jacobian;
 
 	// Prepare Variable Containers
 	std::vector<double> x_vars;
@@ -53,7 +209,6 @@ namespace snopt_wrapper{
 	std::vector<double> F_eval_low;
 	std::vector<double> F_eval_upp;
 
-	std::vector<double> G_eval;
 	std::vector<int> iGfun_eval;
 	std::vector<int> jGvar_eval;
 	int neG_eval = 0;
@@ -63,20 +218,12 @@ namespace snopt_wrapper{
 	std::vector<int> jAvar_eval;
 	int neA_eval = 0;
 
-
 	ptr_optimization_problem->get_init_opt_vars(x_vars);
 	std::cout << "[SNOPT Wrapper] Initialized Initial Value of Optimization Variables" << std::endl;
 	std::cout << "[SNOPT Wrapper]                    Number of Optimization Variables: " << x_vars.size() << std::endl;	
 
 	ptr_optimization_problem->get_opt_vars_bounds(x_vars_low, x_vars_upp);
-	std::cout << "[SNOPT Wrapper] Initialized Bounds of Optimization Variables" << std::endl;
-	std::cout << "[SNOPT Wrapper]  						  Num of Lower Bounds: " << x_vars_low.size() << std::endl;	
-	std::cout << "[SNOPT Wrapper]  						  Num of Upper Bounds: " << x_vars_upp.size() << std::endl;		
-
 	ptr_optimization_problem->get_F_bounds(F_eval_low, F_eval_upp);
-	std::cout << "[SNOPT Wrapper] Initialized Bounds of Functions" << std::endl;
-	std::cout << "[SNOPT Wrapper]  			  Num of Lower Bounds: " << F_eval_low.size() << std::endl;	
-	std::cout << "[SNOPT Wrapper]  			  Num of Upper Bounds: " << F_eval_upp.size() << std::endl;		
 
 	if (F_eval_low.size() == F_eval_upp.size()){
 		std::cout << "[SNOPT_Wrapper] There are " << F_eval_low.size() << " problem functions" << std::endl; 
@@ -85,21 +232,19 @@ namespace snopt_wrapper{
 		throw;
 	}
 
-	// Compute F initially
+	// Compute F initially. SNOPT only differences or asks for the structural nonzeros the problem declared at setup.
 	ptr_optimization_problem->compute_F(F_eval);
+	ptr_optimization_problem->G_sparsity_pattern.get_pattern(iGfun_eval, jGvar_eval);
+	neG_eval = iGfun_eval.size();
 	std::cout << "[SNOPT_Wrapper] F_eval has size " << F_eval.size() << std::endl; 
+	std::cout << "[SNOPT_Wrapper] G has " << neG_eval << " structural nonzero elements" << std::endl; 
 
-
-	int Cold  = 0; int Basis = 1; int Warm = 2;
+	int Basis = 1; int Warm = 2;
 	int start_condition = Basis;
 
-	// Get Sizes
-	// int n = 2;
-	// int nF = 2;
 	int n = x_vars.size(); // Size of optimization variables
 	int nF = F_eval_low.size(); // Size of Constraints
 
-
 	// Initialize Variables
 	double *x      = new double[n];
 	double *xlow   = new double[n];
@@ -113,93 +258,107 @@ namespace snopt_wrapper{
 	double *Fmul   = new double[nF];
 	int    *Fstate = new int[nF];
 
+	// Constant linear terms go in A. All other derivatives are in G.
+	ptr_optimization_problem->compute_A(A_eval, iAfun_eval, jAvar_eval, neA_eval);
+	std::cout << "[SNOPT_Wrapper] A has " << neA_eval << " constant elements" << std::endl; 
+
+	int    neA    = neA_eval;
+	int    lenA   = (neA_eval > 0) ? neA_eval : 1;
+	int    *iAfun = new int[lenA];
+	int    *jAvar = new int[lenA];
+	double *A     = new double[lenA];
+	for (int i = 0; i < neA_eval; i++){
+		iAfun[i] = iAfun_eval[i];
+		jAvar[i] = jAvar_eval[i];
+		A[i] = A_eval[i];
+	}
+
+	int    neG    = neG_eval;
+	int    lenG   = (neG_eval > 0) ? neG_eval : 1;
+	int    *iGfun = new int[lenG];
+	int    *jGvar = new int[lenG];
+
 	// Get Objective Row
 	int ObjRow = 0;
 	ptr_optimization_problem->get_F_obj_Row(ObjRow);
 	double ObjAdd = 0.0;
 
 	int nS = 0, nInf = 0;
-
-	int jx1, jx2, ju, ode1, ode2, Obj;
 	double sInf;
-	double inf = OPT_INFINITY;	
-
 
 	// Populate x_vars
-	for(size_t i = 0; i < x_vars.size(); i++){
+	for(int i = 0; i < n; i++){
 		x[i] = x_vars[i];		
-		xstate[i] = x[i];
+		xstate[i] = 0;
 		xmul[i] = 0.0;
-		//std::cout << "x[" << i << "] = " << x[i] << std::endl;
 	}
-	// Populate F bounds
-	for (size_t i = 0; i < F_eval.size(); i++){
+	// Populate F
+	for (int i = 0; i < nF; i++){
 		F[i] = F_eval[i];
-		Fstate[i] =  F_eval[i];
+		Fstate[i] = 0;
 		Fmul[i] = 0.0;
 	}
 	// Populate x bounds
-	for(size_t i = 0; i < x_vars_low.size(); i++){
+	for(int i = 0; i < n; i++){
 		xlow[i] = x_vars_low[i];		
-	}
-	for(size_t i = 0; i < x_vars_upp.size(); i++){
 		xupp[i] = x_vars_upp[i];		
 	}
 	// Populate F bounds
-	for (size_t i = 0; i < F_eval_low.size(); i++){
+	for (int i = 0; i < nF; i++){
 		Flow[i] = F_eval_low[i];
-	}
-	for (size_t i = 0; i < F_eval_upp.size(); i++){
 		Fupp[i] = F_eval_upp[i];
 	}	
+	// Populate the gradient pattern
+	for (int i = 0; i < neG_eval; i++){
+		iGfun[i] = iGfun_eval[i];
+		jGvar[i] = jGvar_eval[i];
+	}
 
-	int *iAfun_test;
-	int *jAvar_test;
-	double *A_test;
-	int    neA_test;
-
-	int *iGfun_test;
-	int *jGvar_test;
-	double *G_test;
-	int    neG_test;
-
-
+	// Continue from a previous solve. Its variables, states and multipliers replace the initial guess.
+	if (apply_warm_start(warm_start, n, nF, x, xstate, xmul, F, Fstate, Fmul, nS)){
+		start_condition = Warm;
+	}
 
 	snoptProblemA snopt_optimization_problem;
 	snopt_optimization_problem.initialize("", 1);  // no print file, summary on
 
-	
-   	snopt_optimization_problem.setPrintFile("snopt_problem.out"); 
-	snopt_optimization_problem.setIntParameter("Derivative option", 0);
-	snopt_optimization_problem.setIntParameter("Verify level ", 3);	
+	int iu_callback[CALLBACK_DATA_LENIU];
+	pack_callback_data(&callback_data, iu_callback);
+	snopt_optimization_problem.setUserI(iu_callback, CALLBACK_DATA_LENIU);
+
+	if (!print_file.empty()){
+   		snopt_optimization_problem.setPrintFile(print_file.c_str()); 
+	}
 	snopt_optimization_problem.setIntParameter("Major iterations limit", 20000);
 	snopt_optimization_problem.setIntParameter("Iterations limit", 200000);	
-	//whole_body_trajectory_problem.setSpecsFile("small_jump.spc");
-	//whole_body_trajectory_problem.setSpecsFile("com_jump.spc");
 
-	// whole_body_trajectory_problem.computeJac(nF, n, snopt_wrapper::wbt_FG, x, xlow, xupp,
-	// 	  iAfun_test, jAvar_test, A_test, neA_test,
-	// 	  iGfun_test, jGvar_test, neG_test);
-
-  	std::cout << "[SNOPT Wrapper] Solving Problem with no Gradients" << std::endl;
+	snFunA user_function = snopt_wrapper::wbt_FG;
+	if (derivative_mode == DERIVATIVES_SNOPT_DIFFERENCES){
+		snopt_optimization_problem.setIntParameter("Derivative option", 0);
+		snopt_optimization_problem.setIntParameter("Verify level ", 3);	
+		user_function = snopt_wrapper::wbt_F;
+  		std::cout << "[SNOPT Wrapper] Solving Problem with no Gradients" << std::endl;
+	}else{
+		snopt_optimization_problem.setIntParameter("Derivative option", 1);
+		// Set to 3 to check the analytic gradients against finite differences before solving
+		snopt_optimization_problem.setIntParameter("Verify level ", 0);	
+		if (fd_jacobian != NULL){
+  			std::cout << "[SNOPT Wrapper] Solving Problem with Colored Finite Differences (" << fd_jacobian->get_num_colors() << " colors, " 
+  					  << fd_jacobian->get_num_threads() << " threads)" << std::endl;
+		}else{
+  			std::cout << "[SNOPT Wrapper] Solving Problem with Gradients" << std::endl;
+		}
+	}
 
-  	snopt_optimization_problem.solve(start_condition, nF, n, ObjAdd, ObjRow, snopt_wrapper::wbt_F,
-			       xlow, xupp, Flow, Fupp,
+  	int exit_code = snopt_optimization_problem.solve(start_condition, nF, n, ObjAdd, ObjRow, user_function,
+  				  iAfun, jAvar, A, neA,
+  				  iGfun, jGvar, neG,
+			      xlow, xupp, Flow, Fupp,
      			  x, xstate, xmul, F, Fstate, Fmul,
      			  nS, nInf, sInf);
 
-
-	// for (size_t i = 0; i < n; i++){
-	// 	std::cout << "x[" << i << "] = " << x[i] << std::endl;
-	// }
-
-
-	// for (size_t i = 0; i < nF; i++){
-	// 	std::cout << "F[" << i << "] = " << F[i] << std::endl;
-	// }	
-
-
-
+	store_result(ptr_optimization_problem, exit_code, n, nF, x, xstate, xmul, F, Fstate, Fmul, nS, ObjRow, nInf, sInf, result_out);
+	report_profile(print_file);
 
 	delete []x;      delete []xlow;   delete []xupp;
 	delete []xmul;   delete []xstate;
@@ -207,10 +366,28 @@ namespace snopt_wrapper{
 	delete []F;      delete []Flow;   delete []Fupp;
 	delete []Fmul;   delete []Fstate;
 
+	delete []iAfun;  delete []jAvar;  delete []A;
+	delete []iGfun;  delete []jGvar;
+  }
 
+  void solve_problem_no_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, 
+  								  const Solver_State &warm_start, Solve_Result &result_out){
+	solve_problem_main(input_ptr_optimization_problem, DERIVATIVES_SNOPT_DIFFERENCES, NULL, print_file, warm_start, result_out);
   }
 
+  void solve_problem_with_gradients(Optimization_Problem_Main* input_ptr_optimization_problem, const std::string &print_file, 
+  									const Solver_State &warm_start, Solve_Result &result_out){
+	solve_problem_main(input_ptr_optimization_problem, DERIVATIVES_USER_G, NULL, print_file, warm_start, result_out);
+  }
 
+  void solve_problem_with_finite_differences(Optimization_Problem_Main* input_ptr_optimization_problem, Finite_Difference_Jacobian* fd_jacobian,
+  											 const std::string &print_file, Solve_Result &result_out){
+	solve_problem_with_finite_differences(input_ptr_optimization_problem, fd_jacobian, print_file, Solver_State(), result_out);
+  }
 
+  void solve_problem_with_finite_differences(Optimization_Problem_Main* input_ptr_optimization_problem, Finite_Difference_Jacobian* fd_jacobian,
+  											 const std::string &print_file, const Solver_State &warm_start, Solve_Result &result_out){
+	solve_problem_main(input_ptr_optimization_problem, DERIVATIVES_USER_G, fd_jacobian, print_file, warm_start, result_out);
+  }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,406 @@
+#include <rbdl_model_cache/rbdl_model_cache.hpp>
+#include <rbdl/urdfreader.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace RigidBodyDynamics;
+using namespace RigidBodyDynamics::Math;
+
+namespace{
+	const char CACHE_MAGIC[8] = {'R', 'B', 'D', 'L', 'S', 'N', 'A', 'P'};
+	const uint32_t CACHE_FORMAT_VERSION = 1;
+
+	const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+	const uint64_t FNV_PRIME = 1099511628211ULL;
+
+	uint64_t fnv1a(const char* data, const size_t &size, uint64_t hash){
+		for(size_t i = 0; i < size; i++){
+			hash ^= (unsigned char) data[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	// Appends the values of a snapshot in the native byte order. Snapshots are not meant to move between machines.
+	struct Cache_Writer{
+		std::string buffer;
+
+		template <typename T>
+		void put(const T &value){
+			buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+		void put_vector3(const Vector3d &v){
+			for(int i = 0; i < 3; i++){ put(v[i]); }
+		}
+		void put_matrix3(const Matrix3d &m){
+			for(int i = 0; i < 3; i++){
+				for(int j = 0; j < 3; j++){ put(m(i, j)); }
+			}
+		}
+		void put_spatial_vector(const SpatialVector &v){
+			for(int i = 0; i < 6; i++){ put(v[i]); }
+		}
+		void put_transform(const SpatialTransform &X){
+			put_matrix3(X.E);
+			put_vector3(X.r);
+		}
+		void put_string(const std::string &s){
+			put((uint32_t) s.size());
+			buffer.append(s);
+		}
+		void put_body(const Body &body){
+			put(body.mMass);
+			put_vector3(body.mCenterOfMass);
+			put_matrix3(body.mInertia);
+			put((uint8_t) body.mIsVirtual);
+		}
+	};
+
+	// Reads the values back from the mapped file. A read past the end fails this and every later read.
+	struct Cache_Reader{
+		const char* data;
+		size_t size;
+		size_t offset = 0;
+		bool ok = true;
+
+		Cache_Reader(const char* data_in, const size_t &size_in): data(data_in), size(size_in){}
+
+		template <typename T>
+		bool get(T &value){
+			if (!ok || (size - offset < sizeof(T))){
+				ok = false;
+				return false;
+			}
+			memcpy(&value, data + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+		bool get_vector3(Vector3d &v){
+			for(int i = 0; i < 3; i++){ get(v[i]); }
+			return ok;
+		}
+		bool get_matrix3(Matrix3d &m){
+			for(int i = 0; i < 3; i++){
+				for(int j = 0; j < 3; j++){ get(m(i, j)); }
+			}
+			return ok;
+		}
+		bool get_spatial_vector(SpatialVector &v){
+			for(int i = 0; i < 6; i++){ get(v[i]); }
+			return ok;
+		}
+		bool get_transform(SpatialTransform &X){
+			get_matrix3(X.E);
+			return get_vector3(X.r);
+		}
+		bool get_string(std::string &s){
+			uint32_t length = 0;
+			if (!get(length) || (size - offset < length)){
+				ok = false;
+				return false;
+			}
+			s.assign(data + offset, length);
+			offset += length;
+			return true;
+		}
+		bool get_body(Body &body){
+			uint8_t is_virtual = 0;
+			get(body.mMass);
+			get_vector3(body.mCenterOfMass);
+			get_matrix3(body.mInertia);
+			get(is_virtual);
+			body.mIsVirtual = (is_virtual != 0);
+			return ok;
+		}
+	};
+
+	// Joints of the model have one axis, eg: revolute, or are one of RBDL's multi-DoF joints that take no axes,
+	// eg: spherical. Other multi-DoF joints are split into single axis joints when they are added to the model.
+	bool make_joint(const int32_t &type, const std::vector<SpatialVector> &axes, Joint &joint_out){
+		if (axes.size() == 1){
+			joint_out = Joint(axes[0]);
+		}else{
+			joint_out = Joint(static_cast<JointType>(type));
+		}
+		if (joint_out.mDoFCount != axes.size()){
+			return false;
+		}
+		joint_out.mJointType = static_cast<JointType>(type);
+		for(size_t d = 0; d < axes.size(); d++){
+			joint_out.mJointAxes[d] = axes[d];
+		}
+		return true;
+	}
+
+	bool parse_model_cache(Cache_Reader &reader, const uint64_t &key, Model* model){
+		char magic[8];
+		uint32_t format_version = 0;
+		uint64_t cache_key = 0;
+		for(int i = 0; i < 8; i++){ reader.get(magic[i]); }
+		reader.get(format_version);
+		reader.get(cache_key);
+		if (!reader.ok || (memcmp(magic, CACHE_MAGIC, 8) != 0) || (format_version != CACHE_FORMAT_VERSION) || (cache_key != key)){
+			return false;
+		}
+		reader.get_vector3(model->gravity);
+
+		// Bodies are added in the order of their ids. The bodies already hold their merged fixed children.
+		uint32_t num_bodies = 0;
+		Body root_body;
+		if (!reader.get(num_bodies) || (num_bodies == 0) || !reader.get_body(root_body)){
+			return false;
+		}
+		for(uint32_t i = 1; i < num_bodies; i++){
+			Body body;
+			uint32_t parent_id = 0;
+			SpatialTransform joint_frame;
+			int32_t joint_type = 0;
+			uint32_t dof_count = 0;
+			reader.get_body(body);
+			reader.get(parent_id);
+			reader.get_transform(joint_frame);
+			reader.get(joint_type);
+			if (!reader.get(dof_count) || (parent_id >= i) || (dof_count == 0) || (dof_count > 6)){
+				return false;
+			}
+			std::vector<SpatialVector> axes(dof_count);
+			for(uint32_t d = 0; d < dof_count; d++){
+				reader.get_spatial_vector(axes[d]);
+			}
+			Joint joint;
+			if (!reader.ok || !make_joint(joint_type, axes, joint)){
+				return false;
+			}
+			model->AddBody(parent_id, joint_frame, joint, body);
+		}
+		model->mBodies[0] = root_body;
+		model->I[0] = SpatialRigidBodyInertia::createFromMassComInertiaC(root_body.mMass, root_body.mCenterOfMass, root_body.mInertia);
+
+		// Fixed bodies are only referenced, their mass is already in their movable parents
+		uint32_t num_fixed_bodies = 0;
+		if (!reader.get(num_fixed_bodies)){
+			return false;
+		}
+		for(uint32_t i = 0; i < num_fixed_bodies; i++){
+			FixedBody fixed_body;
+			reader.get(fixed_body.mMass);
+			reader.get_vector3(fixed_body.mCenterOfMass);
+			reader.get_matrix3(fixed_body.mInertia);
+			reader.get(fixed_body.mMovableParent);
+			if (!reader.get_transform(fixed_body.mParentTransform) || (fixed_body.mMovableParent >= num_bodies)){
+				return false;
+			}
+			fixed_body.mBaseTransform = fixed_body.mParentTransform;
+			model->mFixedBodies.push_back(fixed_body);
+		}
+
+		uint32_t num_names = 0;
+		if (!reader.get(num_names)){
+			return false;
+		}
+		model->mBodyNameMap.clear();
+		for(uint32_t i = 0; i < num_names; i++){
+			std::string name;
+			uint32_t body_id = 0;
+			reader.get_string(name);
+			if (!reader.get(body_id)){
+				return false;
+			}
+			model->mBodyNameMap[name] = body_id;
+		}
+		return reader.ok && (reader.offset == reader.size);
+	}
+
+	bool same_body(const Body &a, const Body &b){
+		return (a.mMass == b.mMass) && (a.mCenterOfMass == b.mCenterOfMass) && (a.mInertia == b.mInertia) && (a.mIsVirtual == b.mIsVirtual);
+	}
+
+	// Everything the snapshot stores, compared bit for bit
+	bool same_model(const Model &a, const Model &b){
+		if ((a.gravity != b.gravity) || (a.dof_count != b.dof_count) || (a.q_size != b.q_size) || (a.qdot_size != b.qdot_size) ||
+			(a.mBodies.size() != b.mBodies.size()) || (a.mFixedBodies.size() != b.mFixedBodies.size()) || (a.mBodyNameMap != b.mBodyNameMap)){
+			return false;
+		}
+		for(size_t i = 0; i < a.mBodies.size(); i++){
+			if (!same_body(a.mBodies[i], b.mBodies[i])){
+				return false;
+			}
+			if (i == 0){
+				continue;
+			}
+			if ((a.lambda[i] != b.lambda[i]) || (a.X_T[i].E != b.X_T[i].E) || (a.X_T[i].r != b.X_T[i].r) ||
+				(a.mJoints[i].mJointType != b.mJoints[i].mJointType) || (a.mJoints[i].mDoFCount != b.mJoints[i].mDoFCount)){
+				return false;
+			}
+			for(unsigned int d = 0; d < a.mJoints[i].mDoFCount; d++){
+				if (a.mJoints[i].mJointAxes[d] != b.mJoints[i].mJointAxes[d]){
+					return false;
+				}
+			}
+		}
+		for(size_t i = 0; i < a.mFixedBodies.size(); i++){
+			const FixedBody &fa = a.mFixedBodies[i];
+			const FixedBody &fb = b.mFixedBodies[i];
+			if ((fa.mMass != fb.mMass) || (fa.mCenterOfMass != fb.mCenterOfMass) || (fa.mInertia != fb.mInertia) ||
+				(fa.mMovableParent != fb.mMovableParent) || (fa.mParentTransform.E != fb.mParentTransform.E) || (fa.mParentTransform.r != fb.mParentTransform.r)){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string cache_file_path(const std::string &urdf_path, const uint64_t &key){
+		const char* cache_dir = getenv("RBDL_MODEL_CACHE_DIR");
+		size_t name_start = urdf_path.find_last_of('/');
+		std::string urdf_name = (name_start == std::string::npos) ? urdf_path : urdf_path.substr(name_start + 1);
+
+		std::ostringstream path;
+		path << ((cache_dir != NULL) ? cache_dir : "/tmp") << "/" << urdf_name << "." << std::hex << key << ".rbdl_cache";
+		return path.str();
+	}
+}
+
+namespace rbdl_model_cache{
+
+bool hash_file(const std::string &file_path, uint64_t &hash_out){
+	std::ifstream file(file_path.c_str(), std::ios::binary);
+	if (!file.is_open()){
+		return false;
+	}
+	uint64_t hash = FNV_OFFSET;
+	char chunk[4096];
+	while (file.read(chunk, sizeof(chunk)) || (file.gcount() > 0)){
+		hash = fnv1a(chunk, file.gcount(), hash);
+	}
+	hash_out = hash;
+	return true;
+}
+
+bool write_model_cache(const Model &model, const uint64_t &key, const std::string &cache_path){
+	if (!model.mCustomJoints.empty()){
+		std::cerr << "[rbdl_model_cache] Models with custom joints are not cached" << std::endl;
+		return false;
+	}
+
+	Cache_Writer writer;
+	writer.buffer.append(CACHE_MAGIC, 8);
+	writer.put(CACHE_FORMAT_VERSION);
+	writer.put(key);
+	writer.put_vector3(model.gravity);
+
+	writer.put((uint32_t) model.mBodies.size());
+	writer.put_body(model.mBodies[0]);
+	for(size_t i = 1; i < model.mBodies.size(); i++){
+		const Joint &joint = model.mJoints[i];
+		writer.put_body(model.mBodies[i]);
+		writer.put((uint32_t) model.lambda[i]);
+		writer.put_transform(model.X_T[i]);
+		writer.put((int32_t) joint.mJointType);
+		writer.put((uint32_t) joint.mDoFCount);
+		for(unsigned int d = 0; d < joint.mDoFCount; d++){
+			writer.put_spatial_vector(joint.mJointAxes[d]);
+		}
+	}
+
+	writer.put((uint32_t) model.mFixedBodies.size());
+	for(size_t i = 0; i < model.mFixedBodies.size(); i++){
+		const FixedBody &fixed_body = model.mFixedBodies[i];
+		writer.put(fixed_body.mMass);
+		writer.put_vector3(fixed_body.mCenterOfMass);
+		writer.put_matrix3(fixed_body.mInertia);
+		writer.put(fixed_body.mMovableParent);
+		writer.put_transform(fixed_body.mParentTransform);
+	}
+
+	writer.put((uint32_t) model.mBodyNameMap.size());
+	for(std::map<std::string, unsigned int>::const_iterator it = model.mBodyNameMap.begin(); it != model.mBodyNameMap.end(); it++){
+		writer.put_string(it->first);
+		writer.put((uint32_t) it->second);
+	}
+
+	// Written next to the cache and renamed over it
+	std::ostringstream temp_path;
+	temp_path << cache_path << ".tmp" << getpid();
+	std::ofstream file(temp_path.str().c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()){
+		return false;
+	}
+	file.write(writer.buffer.data(), writer.buffer.size());
+	file.close();
+	if (!file || (rename(temp_path.str().c_str(), cache_path.c_str()) != 0)){
+		remove(temp_path.str().c_str());
+		return false;
+	}
+	return true;
+}
+
+bool read_model_cache(const std::string &cache_path, const uint64_t &key, Model* model){
+	int fd = open(cache_path.c_str(), O_RDONLY);
+	if (fd < 0){
+		return false;
+	}
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size == 0)){
+		close(fd);
+		return false;
+	}
+	size_t size = file_stat.st_size;
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED){
+		return false;
+	}
+
+	Cache_Reader reader(static_cast<const char*>(data), size);
+	bool loaded = parse_model_cache(reader, key, model);
+	munmap(data, size);
+	if (!loaded){
+		*model = Model();
+	}
+	return loaded;
+}
+
+bool read_urdf_model(const std::string &urdf_path, Model* model, const bool &floating_base){
+	uint64_t key;
+	if (!hash_file(urdf_path, key)){
+		std::cerr << "[rbdl_model_cache] Error! Cannot read " << urdf_path << std::endl;
+		return false;
+	}
+	// The RBDL version and the floating base option also change the assembled model
+	int rbdl_version = RBDL_API_VERSION;
+	char floating_base_flag = floating_base ? 1 : 0;
+	key = fnv1a(reinterpret_cast<const char*>(&rbdl_version), sizeof(rbdl_version), key);
+	key = fnv1a(&floating_base_flag, 1, key);
+
+	std::string cache_path = cache_file_path(urdf_path, key);
+	if (read_model_cache(cache_path, key, model)){
+		std::cout << "[rbdl_model_cache] Read " << urdf_path << " from " << cache_path << std::endl;
+		return true;
+	}
+
+	if (!Addons::URDFReadFromFile(urdf_path.c_str(), model, floating_base)){
+		return false;
+	}
+	// Only a snapshot that reads back into the same model is kept
+	Model cached_model;
+	if (!write_model_cache(*model, key, cache_path)){
+		std::cerr << "[rbdl_model_cache] Could not write " << cache_path << std::endl;
+	}else if (!read_model_cache(cache_path, key, &cached_model) || !same_model(*model, cached_model)){
+		std::cerr << "[rbdl_model_cache] The snapshot of " << urdf_path << " does not match the parsed model and is removed" << std::endl;
+		remove(cache_path.c_str());
+	}
+	return true;
+}
+
+}
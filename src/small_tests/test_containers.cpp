@@ -50,6 +50,8 @@ int main(int argc, char **argv){
 	Contact* contact_2 = new Contact();
 	contact_1->contact_name = "contact 1";
 	contact_2->contact_name = "contact 2";
+	contact_1->contact_dim = 1;
+	contact_2->contact_dim = 2;
 
 	Contact_List contact_list;
 	contact_list.append_contact(contact_1);
@@ -80,6 +82,25 @@ int main(int argc, char **argv){
 	mode_schedule.add_new_mode(mode_0_start_time, mode_0_final_time, mode_0_contacts);
 	mode_schedule.add_new_mode(mode_1_start_time, mode_1_final_time, mode_1_contacts);	
 
+	// The finalized tables must agree with the mode lookup
+	int N_total_knotpoints = 7;
+	mode_schedule.finalize_schedule(&contact_list, N_total_knotpoints);
+	int mismatches = 0;
+	if ((mode_schedule.get_contact_Fr_offset(foot_contact_index) != 0) || (mode_schedule.get_contact_Fr_offset(toe_contact_index) != 1)){
+		mismatches++;
+	}
+	for(int knotpoint = 0; knotpoint <= N_total_knotpoints; knotpoint++){
+		bool active = (knotpoint >= mode_1_start_time);
+		uint64_t expected_mask = active ? 3 : 0;
+		sejong::Vector expected_Fr_mask = active ? sejong::Vector::Ones(3) : sejong::Vector::Zero(3);
+		std::vector<int> active_contacts;
+		mode_schedule.get_active_contacts(knotpoint, active_contacts);
+		if ((mode_schedule.get_mode(knotpoint) != (active ? 1 : 0)) || (active_contacts.size() != (active ? 2 : 0)) ||
+			(mode_schedule.get_active_contact_mask(knotpoint) != expected_mask) || (mode_schedule.get_active_Fr_mask(knotpoint) != expected_Fr_mask)){
+			mismatches++;
+		}
+	}
+	std::cout << "Contact mode schedule table mismatches = " << mismatches << std::endl;
 
-	return 0;
+	return (mismatches == 0) ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
+#include <optimization/autodiff/dual.hpp>
+
+#include <Utils/utilities.hpp>
+#include <cmath>
+
+// Compares the dual number Jacobian of the templated backward Euler dynamics against the hand written
+// getDynamics_constraint_gradient, and its value against the double version of the constraint.
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing Hopper Combined Model Automatic Differentiation" << std::endl;
+	const int num_x = Hopper_Combined_Dimensions::num_x;
+	const int num_Fr = Hopper_Dimensions::max_contact_dim;
+	const int num_vars = 3*num_x + NUM_ACT_JOINT + num_Fr + 1;
+	typedef Dual<num_vars> Test_Dual;
+
+	Hopper_Combined_Dynamics_Model* combined_model = Hopper_Combined_Dynamics_Model::GetCombinedModel();
+
+	double max_value_error = 0.0;
+	double max_gradient_error = 0.0;
+	for(int trial = 0; trial < 10; trial++){
+		sejong::Vector x_k = sejong::Vector::Random(num_x);
+		sejong::Vector xdot_k = sejong::Vector::Random(num_x);
+		sejong::Vector xdot_k_prev = sejong::Vector::Random(num_x);
+		sejong::Vector u_k = 10.0*sejong::Vector::Random(NUM_ACT_JOINT);
+		sejong::Vector Fr_k = 100.0*sejong::Vector::Random(num_Fr);
+		double h_k = 0.05 + 0.01*trial;
+
+		sejong::Vector q_k;
+		sejong::Matrix Jc_dynamic;
+		combined_model->convert_x_to_q(x_k, q_k);
+		combined_model->robot_model->getFullJacobian(q_k, SJ_Hopper_LinkID::LK_foot, Jc_dynamic);
+		Hopper_Dimensions::Matrix_contact_jacobian Jc = Jc_dynamic;
+
+		// Hand written value and gradient
+		sejong::Vector F_analytic;
+		sejong::Matrix dF_dx_k, dF_dxdot_k, dF_dxdot_k_prev, dF_du_k, dF_dFr_k;
+		sejong::Vector dF_dh_k;
+		combined_model->setContactJacobian(Jc);
+		combined_model->getDynamics_constraint(x_k, xdot_k, xdot_k_prev, u_k, Fr_k, h_k, F_analytic);
+		combined_model->getDynamics_constraint_gradient(x_k, xdot_k, xdot_k_prev, u_k, Fr_k, h_k,
+		                                                dF_dx_k, dF_dxdot_k, dF_dxdot_k_prev, dF_du_k, dF_dFr_k, dF_dh_k);
+		sejong::Matrix dF_analytic(num_x, num_vars);
+		dF_analytic << dF_dx_k, dF_dxdot_k, dF_dxdot_k_prev, dF_du_k, dF_dFr_k, dF_dh_k;
+
+		// Dual numbers
+		Eigen::Matrix<Test_Dual, num_x, 1> x_k_dual, xdot_k_dual, xdot_k_prev_dual, F_dual;
+		Eigen::Matrix<Test_Dual, NUM_ACT_JOINT, 1> u_k_dual;
+		Eigen::Matrix<Test_Dual, Eigen::Dynamic, 1, 0, num_Fr, 1> Fr_k_dual;
+		seed_dual_vector(x_k, 0, x_k_dual);
+		seed_dual_vector(xdot_k, num_x, xdot_k_dual);
+		seed_dual_vector(xdot_k_prev, 2*num_x, xdot_k_prev_dual);
+		seed_dual_vector(u_k, 3*num_x, u_k_dual);
+		seed_dual_vector(Fr_k, 3*num_x + NUM_ACT_JOINT, Fr_k_dual);
+		Test_Dual h_k_dual = Test_Dual::variable(h_k, num_vars - 1);
+		combined_model->getDynamics_constraint(x_k_dual, xdot_k_dual, xdot_k_prev_dual, u_k_dual, Fr_k_dual, h_k_dual, Jc, F_dual);
+
+		sejong::Vector F_autodiff;
+		sejong::Matrix dF_autodiff;
+		get_dual_values(F_dual, F_autodiff);
+		get_dual_jacobian(F_dual, dF_autodiff);
+
+		for(int i = 0; i < num_x; i++){
+			max_value_error = std::max(max_value_error, std::fabs(F_autodiff[i] - F_analytic[i])/std::max(1.0, std::fabs(F_analytic[i])));
+			for(int j = 0; j < num_vars; j++){
+				double scale = std::max(1.0, std::fabs(dF_analytic(i, j)));
+				max_gradient_error = std::max(max_gradient_error, std::fabs(dF_autodiff(i, j) - dF_analytic(i, j))/scale);
+			}
+		}
+	}
+
+	std::cout << "[Main] Max relative error of the dual number values = " << max_value_error << std::endl;
+	std::cout << "[Main] Max relative error of the dual number Jacobian = " << max_gradient_error << std::endl;
+	if ((max_value_error > 1e-12) || (max_gradient_error > 1e-12)){
+		std::cout << "[Main] Automatic differentiation check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Automatic differentiation check passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <cmath>
+#include <Utils/utilities.hpp>
+
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <optimization/batch_solver.hpp>
+
+int main(int argc, char **argv)
+{
+	std::cout << "[Main] Running a batch of Hopper Act Jump Optimization Problems" << std::endl;
+
+	// Two solves at a time. Print files stay off so the solves do not wait for each other.
+	Batch_Solver batch_solver(2);
+
+	std::vector<int> knotpoints_list = {9, 18, 27};
+	for(size_t i = 0; i < knotpoints_list.size(); i++){
+		int N_knotpoints = knotpoints_list[i];
+		Batch_Problem_Spec spec;
+		spec.name = "hopper_act_jump_" + std::to_string(N_knotpoints) + "_kp";
+		spec.create_problem = [N_knotpoints](){ return new Hopper_Act_Jump_Opt(N_knotpoints); };
+		batch_solver.add_problem(spec);
+	}
+
+	std::vector<snopt_wrapper::Solve_Result> results;
+	batch_solver.solve_all(results);
+
+	// Every batched solve must end like a serial solve of the same problem
+	int num_mismatches = 0;
+	for(size_t i = 0; i < results.size(); i++){
+		Hopper_Act_Jump_Opt serial_problem(knotpoints_list[i]);
+		serial_problem.set_num_threads(1);
+		snopt_wrapper::Solve_Result serial_result;
+		snopt_wrapper::solve_problem_with_gradients(&serial_problem, "", serial_result);
+
+		bool match = (results[i].exit_code == serial_result.exit_code) &&
+		             (std::fabs(results[i].objective - serial_result.objective) <= 1e-6*std::max(1.0, std::fabs(serial_result.objective)));
+		if (!match){
+			num_mismatches++;
+		}
+		std::cout << "[Main] " << results[i].problem_name
+		          << " exit code = " << results[i].exit_code << " (serial " << serial_result.exit_code << ")"
+		          << " objective = " << results[i].objective << " (serial " << serial_result.objective << ")"
+		          << " nInf = " << results[i].nInf
+		          << " sInf = " << results[i].sInf << (match ? "" : " MISMATCH") << std::endl;
+	}
+
+	if (num_mismatches > 0){
+		std::cout << "[Main] Batch solve check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Batch solve check passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,28 @@
+#include <iostream>
+#include <Utils/utilities.hpp>
+
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <optimization/continuation_solver.hpp>
+
+int main(int argc, char **argv)
+{
+	std::cout << "[Main] Running Hopper Act Jump Optimization Problem from coarse to fine knotpoints" << std::endl;
+
+	// The contact modes have equal lengths, so every stage must be a multiple of 3 knotpoints
+	std::vector<int> knotpoint_schedule = {9, 27};
+	Continuation_Solver continuation_solver([](const int &N_knotpoints){ return new Hopper_Act_Jump_Opt(N_knotpoints); }, knotpoint_schedule);
+
+	std::vector<snopt_wrapper::Solve_Result> results;
+	Optimization_Problem_Main* opt_problem = continuation_solver.solve(results);
+
+	for(size_t i = 0; i < results.size(); i++){
+		std::cout << "[Main] " << knotpoint_schedule[i] << " knotpoints"
+		          << " exit code = " << results[i].exit_code
+		          << " objective = " << results[i].objective
+		          << " nInf = " << results[i].nInf
+		          << " sInf = " << results[i].sInf << std::endl;
+	}
+
+	delete opt_problem;
+	return (results.size() == knotpoint_schedule.size()) ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <optimization/parallel/finite_difference_jacobian.hpp>
+
+#include <Utils/utilities.hpp>
+#include <cmath>
+
+// Compares the colored, multithreaded finite difference G against the analytic compute_G
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing Hopper Actuator Jump Problem Colored Finite Differences" << std::endl;
+	Hopper_Act_Jump_Opt hopper_opt_prob;
+	Finite_Difference_Jacobian fd_jacobian(&hopper_opt_prob, [](){ return new Hopper_Act_Jump_Opt(); }, 4);
+
+	std::vector<double> x_vars;
+	std::vector<double> F_nominal;
+	std::vector<double> G_eval;
+	std::vector<int> iGfun;
+	std::vector<int> jGvar;
+	int neG = 0;
+
+	hopper_opt_prob.get_init_opt_vars(x_vars);
+	hopper_opt_prob.update_opt_vars(x_vars);
+	hopper_opt_prob.compute_F(F_nominal);
+	hopper_opt_prob.compute_G(G_eval, iGfun, jGvar, neG);
+
+	int n = x_vars.size();
+	std::vector<double> G_analytic(hopper_opt_prob.G_sparsity_pattern.get_size());
+	hopper_opt_prob.G_sparsity_pattern.scatter(G_eval, iGfun, jGvar, G_analytic.data());
+
+	// Once with the nominal F of the caller and once evaluating it inside
+	std::vector<double> G_colored(G_analytic.size());
+	std::vector<double> G_colored_no_F(G_analytic.size());
+	fd_jacobian.compute_G(x_vars.data(), n, F_nominal.data(), G_colored.data());
+	fd_jacobian.compute_G(x_vars.data(), n, NULL, G_colored_no_F.data());
+
+	double max_error = 0.0;
+	double max_difference = 0.0;
+	for(size_t i = 0; i < G_analytic.size(); i++){
+		double scale = std::max(1.0, std::fabs(G_analytic[i]));
+		max_error = std::max(max_error, std::fabs(G_colored[i] - G_analytic[i])/scale);
+		max_difference = std::max(max_difference, std::fabs(G_colored[i] - G_colored_no_F[i]));
+	}
+
+	std::cout << "[Main] Number of variables = " << n << std::endl;
+	std::cout << "[Main] Number of colors = " << fd_jacobian.get_num_colors() << std::endl;
+	std::cout << "[Main] Number of threads = " << fd_jacobian.get_num_threads() << std::endl;
+	std::cout << "[Main] Max relative error between colored differences and analytic gradients = " << max_error << std::endl;
+	std::cout << "[Main] Max difference with the nominal F evaluated inside = " << max_difference << std::endl;
+
+	if ((max_error > 1e-3) || (max_difference > 0.0) || (fd_jacobian.get_num_colors() >= n)){
+		std::cout << "[Main] Colored finite difference check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Colored finite difference check passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+
+#include <Utils/utilities.hpp>
+#include <cmath>
+
+// Compares the analytic sparse gradient from compute_G and compute_A against forward differences of compute_F plus A*x
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing Hopper Actuator Jump Problem Gradients" << std::endl;
+	Hopper_Act_Jump_Opt hopper_opt_prob;
+
+	std::vector<double> x_vars;
+	std::vector<double> F_nominal;
+	std::vector<double> F_perturbed;
+
+	std::vector<double> G_eval;
+	std::vector<int> iGfun;
+	std::vector<int> jGvar;
+	int neG = 0;
+
+	std::vector<double> A_eval;
+	std::vector<int> iAfun;
+	std::vector<int> jAvar;
+	int neA = 0;
+
+	hopper_opt_prob.get_init_opt_vars(x_vars);
+	hopper_opt_prob.update_opt_vars(x_vars);
+	hopper_opt_prob.compute_F(F_nominal);
+	hopper_opt_prob.add_linear_terms(F_nominal);
+	hopper_opt_prob.compute_G(G_eval, iGfun, jGvar, neG);
+	hopper_opt_prob.compute_A(A_eval, iAfun, jAvar, neA);
+
+	int n = x_vars.size();
+	int nF = F_nominal.size();
+	sejong::Matrix G_analytic = sejong::Matrix::Zero(nF, n);
+	for(size_t i = 0; i < neG; i++){
+		G_analytic(iGfun[i], jGvar[i]) += G_eval[i];
+	}
+	// Constant linear terms
+	for(size_t i = 0; i < neA; i++){
+		G_analytic(iAfun[i], jAvar[i]) += A_eval[i];
+	}
+
+	sejong::Matrix G_numeric = sejong::Matrix::Zero(nF, n);
+	double step = 1e-6;
+	for(size_t j = 0; j < n; j++){
+		std::vector<double> x_perturbed = x_vars;
+		x_perturbed[j] += step;
+		hopper_opt_prob.update_opt_vars(x_perturbed);
+		F_perturbed.clear();
+		hopper_opt_prob.compute_F(F_perturbed);
+		hopper_opt_prob.add_linear_terms(F_perturbed);
+		for(size_t i = 0; i < nF; i++){
+			G_numeric(i, j) = (F_perturbed[i] - F_nominal[i])/step;
+		}
+	}
+	hopper_opt_prob.update_opt_vars(x_vars);
+
+	// Relative error with respect to the magnitude of each entry
+	double max_error = 0.0;
+	for(size_t i = 0; i < nF; i++){
+		for(size_t j = 0; j < n; j++){
+			double scale = std::max(1.0, std::fabs(G_numeric(i, j)));
+			max_error = std::max(max_error, std::fabs(G_analytic(i, j) - G_numeric(i, j))/scale);
+		}
+	}
+
+	// Every analytic and numeric nonzero must be part of the declared sparsity pattern or of A
+	sejong::Matrix A_dense = sejong::Matrix::Zero(nF, n);
+	for(size_t i = 0; i < neA; i++){
+		A_dense(iAfun[i], jAvar[i]) = 1.0;
+	}
+	int num_missing = 0;
+	for(size_t i = 0; i < nF; i++){
+		for(size_t j = 0; j < n; j++){
+			bool nonzero = (std::fabs(G_numeric(i, j)) > 1e-4) || (G_analytic(i, j) != 0.0);
+			if (nonzero && (A_dense(i, j) == 0.0) && (hopper_opt_prob.G_sparsity_pattern.find_element(i, j) < 0)){
+				num_missing++;
+			}
+		}
+	}
+
+	std::cout << "[Main] Number of nonzero gradient elements = " << neG << " of " << nF*n << std::endl;
+	std::cout << "[Main] Number of structural nonzero elements = " << hopper_opt_prob.G_sparsity_pattern.get_size() << std::endl;
+	std::cout << "[Main] Number of constant linear elements = " << neA << std::endl;
+	std::cout << "[Main] Max relative error between analytic and numeric gradients = " << max_error << std::endl;
+	std::cout << "[Main] Nonzero elements missing from the sparsity pattern = " << num_missing << std::endl;
+
+	if ((max_error > 1e-3) || (num_missing > 0)){
+		std::cout << "[Main] Gradient check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Gradient check passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+
+#include <cmath>
+
+// Compares compute_F with incremental evaluation against a full evaluation of every block.
+// Each variable is perturbed alone, as in finite differencing, and then several at a time.
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing Incremental F Evaluation of the Hopper Actuator Jump Problem" << std::endl;
+	Hopper_Act_Jump_Opt incremental_prob;
+	Hopper_Act_Jump_Opt full_prob;
+	full_prob.set_incremental_evaluation(false);
+
+	std::vector<double> x_vars;
+	std::vector<double> F_incremental;
+	std::vector<double> F_full;
+
+	incremental_prob.get_init_opt_vars(x_vars);
+	int n = x_vars.size();
+	int num_mismatches = 0;
+	int num_evaluations = 0;
+
+	// Moves x_vars to x_new on both problems and counts rows that differ
+	auto compare = [&](const std::vector<double> &x_new){
+		std::vector<double> x_copy = x_new;
+		incremental_prob.update_opt_vars(x_copy);
+		full_prob.update_opt_vars(x_copy);
+		incremental_prob.compute_F(F_incremental);
+		full_prob.compute_F(F_full);
+		for(size_t i = 0; i < F_full.size(); i++){
+			if (F_incremental[i] != F_full[i]){
+				num_mismatches++;
+			}
+		}
+		num_evaluations++;
+	};
+
+	compare(x_vars);
+
+	double step = 1e-6;
+	for(int j = 0; j < n; j++){
+		std::vector<double> x_perturbed = x_vars;
+		x_perturbed[j] += step;
+		compare(x_perturbed);
+		compare(x_vars);
+	}
+
+	// Steps that change several knotpoints at once
+	for(int j = 0; j < n; j++){
+		x_vars[j] += 0.01*((j*37) % 11);
+		if ((j % 7) == 0){
+			compare(x_vars);
+		}
+	}
+	compare(x_vars);
+
+	std::cout << "[Main] Evaluations compared = " << num_evaluations << std::endl;
+	std::cout << "[Main] Rows that differ from the full evaluation = " << num_mismatches << std::endl;
+
+	if (num_mismatches > 0){
+		std::cout << "[Main] Incremental evaluation check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Incremental evaluation check passed" << std::endl;
+	return 0;
+}
@@ -5,6 +5,7 @@
 #include <hopper_combined_dynamics_model/hopper_combined_dynamics_model.hpp>
 
 #include <optimization/snopt_wrapper.hpp>
+#include <optimization/containers/trajectory_file.hpp>
 
 
 void parse_output(Optimization_Problem_Main* opt_prob){
@@ -25,6 +26,17 @@ void parse_output(Optimization_Problem_Main* opt_prob){
 
 	sejong::Vector pos;
 
+	// Also store the trajectory in binary so downstream tools do not need to parse the console dump
+	Trajectory_Knotpoint traj_knotpoint;
+	Trajectory_Writer traj_writer;
+	var_manager->get_x_states(1, x_states);
+	var_manager->get_u_states(1, torque_states);
+	var_manager->get_var_reaction_forces(1, Fr_states);
+	combined_model->convert_x_to_q(x_states, q_states);
+	int block_sizes[NUM_TRAJ_BLOCKS - 1] = {(int) x_states.size(), (int) x_states.size(), (int) q_states.size(), (int) q_states.size(),
+											(int) torque_states.size(), (int) Fr_states.size()};
+	traj_writer.open("hopper_act_jump_traj.bin", block_sizes, "hopper_act_jump");
+
 	for(size_t k = 0; k < var_manager->total_knotpoints+1; k++){
 
 	 	std::cout << "--------------------------" << std::endl;
@@ -53,7 +65,20 @@ void parse_output(Optimization_Problem_Main* opt_prob){
 		 	std::cout << "h_dt = " << h_dt << std::endl;
 	 	}
 	 	sejong::pretty_print(pos, std::cout, "pos");	 	
+
+	 	traj_knotpoint.clear();
+	 	traj_knotpoint.x = x_states;
+	 	traj_knotpoint.xdot = xdot_states;
+	 	traj_knotpoint.q = q_states;
+	 	combined_model->convert_xdot_to_qdot(xdot_states, traj_knotpoint.qdot);
+	 	if (k != 0){
+	 		traj_knotpoint.u = torque_states;
+	 		traj_knotpoint.Fr = Fr_states;
+	 		traj_knotpoint.h = h_dt;
+	 	}
+	 	traj_writer.append_knotpoint(traj_knotpoint);
 	}	
+	traj_writer.close();
 
 }
 
@@ -62,7 +87,8 @@ int main(int argc, char **argv)
 	std::cout << "[Main] Running Hopper Stand Optimization Problem" << std::endl;
 	Optimization_Problem_Main* 	opt_problem = new Hopper_Act_Jump_Opt();
 
-	snopt_wrapper::solve_problem_no_gradients(opt_problem);
+	//snopt_wrapper::solve_problem_no_gradients(opt_problem);
+	snopt_wrapper::solve_problem_with_gradients(opt_problem);
 	parse_output(opt_problem);
 	
 	delete opt_problem;
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <Utils/utilities.hpp>
+
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <optimization/snopt_wrapper.hpp>
+
+// SNOPT does not return the number of major iterations, but its print file ends with it, eg:
+// " No. of major iterations             15   Linear    obj. term ..."
+// Returns -1 if the file has no such line.
+int read_major_iterations(const std::string &print_file){
+	std::ifstream file(print_file.c_str());
+	std::string line;
+	std::string key = "No. of major iterations";
+	int major_iterations = -1;
+	while(std::getline(file, line)){
+		size_t key_start = line.find(key);
+		if (key_start != std::string::npos){
+			major_iterations = std::atoi(line.c_str() + key_start + key.size());
+		}
+	}
+	return major_iterations;
+}
+
+// The problem of every solve after the first one: jump slightly higher
+Hopper_Act_Jump_Opt* create_higher_jump_problem(){
+	Hopper_Act_Jump_Opt* problem = new Hopper_Act_Jump_Opt();
+	problem->opt_var_manager.set_var_bounds(VAR_TYPE_X, problem->N_total_knotpoints/2, 0, 1.3, OPT_INFINITY);
+	return problem;
+}
+
+int main(int argc, char **argv)
+{
+	std::cout << "[Main] Warm starting a Hopper Act Jump Optimization Problem from a saved solver state" << std::endl;
+	std::string state_file = "hopper_act_jump_state.bin";
+	std::string cold_print_file = "snopt_cold_start.out";
+	std::string warm_print_file = "snopt_warm_start.out";
+
+	// Solve from the initial guess and save the final solver state
+	Hopper_Act_Jump_Opt* first_problem = new Hopper_Act_Jump_Opt();
+	snopt_wrapper::Solve_Result first_result;
+	snopt_wrapper::solve_problem_with_gradients(first_problem, "", first_result);
+	snopt_wrapper::write_solver_state(state_file, first_result.solver_state);
+	delete first_problem;
+
+	snopt_wrapper::Solver_State warm_start;
+	if (!snopt_wrapper::read_solver_state(state_file, warm_start)){
+		return 1;
+	}
+
+	// The higher jump from the initial guess
+	std::remove(cold_print_file.c_str());
+	Hopper_Act_Jump_Opt* cold_problem = create_higher_jump_problem();
+	snopt_wrapper::Solve_Result cold_result;
+	snopt_wrapper::solve_problem_with_gradients(cold_problem, cold_print_file, cold_result);
+	delete cold_problem;
+
+	// The same jump from the saved state
+	std::remove(warm_print_file.c_str());
+	Hopper_Act_Jump_Opt* warm_problem = create_higher_jump_problem();
+	snopt_wrapper::Solve_Result warm_result;
+	snopt_wrapper::solve_problem_with_gradients(warm_problem, warm_print_file, warm_start, warm_result);
+	delete warm_problem;
+
+	int cold_major_iterations = read_major_iterations(cold_print_file);
+	int warm_major_iterations = read_major_iterations(warm_print_file);
+	std::cout << "[Main] Cold start exit code = " << cold_result.exit_code << " objective = " << cold_result.objective
+	          << " major iterations = " << cold_major_iterations << std::endl;
+	std::cout << "[Main] Warm start exit code = " << warm_result.exit_code << " objective = " << warm_result.objective
+	          << " major iterations = " << warm_major_iterations << std::endl;
+
+	bool same_exit_code = (warm_result.exit_code == cold_result.exit_code);
+	bool same_objective = std::fabs(warm_result.objective - cold_result.objective) <= 1e-4*std::max(1.0, std::fabs(cold_result.objective));
+	bool fewer_major_iterations = (warm_major_iterations >= 0) && (cold_major_iterations >= 0) && (warm_major_iterations < cold_major_iterations);
+	if (!same_exit_code || !same_objective || !fewer_major_iterations){
+		std::cout << "[Main] Warm start check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Warm start check passed" << std::endl;
+	return 0;
+}
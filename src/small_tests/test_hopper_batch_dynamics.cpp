@@ -0,0 +1,61 @@
+#include <optimization/optimization_problems/2d_hopper/hopper_jump_opt_problem.hpp>
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+
+#include <cmath>
+
+// Compares compute_F with the batched dynamics kernels against the dynamics evaluated one knotpoint at a time.
+// Each variable is perturbed alone, so the incremental evaluation batches only the changed knotpoints.
+// Returns the largest relative difference of a row.
+template <typename Problem>
+double compare_batch_evaluation(Problem &batch_prob, Problem &single_prob){
+	single_prob.set_batch_evaluation(false);
+
+	std::vector<double> x_vars;
+	std::vector<double> F_batch;
+	std::vector<double> F_single;
+	batch_prob.get_init_opt_vars(x_vars);
+
+	double max_error = 0.0;
+	auto compare = [&](const std::vector<double> &x_new){
+		std::vector<double> x_copy = x_new;
+		batch_prob.update_opt_vars(x_copy);
+		single_prob.update_opt_vars(x_copy);
+		batch_prob.compute_F(F_batch);
+		single_prob.compute_F(F_single);
+		for(size_t i = 0; i < F_single.size(); i++){
+			max_error = std::max(max_error, std::fabs(F_batch[i] - F_single[i])/std::max(1.0, std::fabs(F_single[i])));
+		}
+	};
+
+	compare(x_vars);
+	for(size_t j = 0; j < x_vars.size(); j++){
+		x_vars[j] += 0.01*((j*37) % 11);
+	}
+	compare(x_vars);
+	for(size_t j = 0; j < x_vars.size(); j++){
+		std::vector<double> x_perturbed = x_vars;
+		x_perturbed[j] += 1e-3;
+		compare(x_perturbed);
+	}
+	return max_error;
+}
+
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing the Batched Hopper Dynamics" << std::endl;
+	Hopper_Jump_Opt hopper_batch_prob;
+	Hopper_Jump_Opt hopper_single_prob;
+	double hopper_error = compare_batch_evaluation(hopper_batch_prob, hopper_single_prob);
+
+	Hopper_Act_Jump_Opt hopper_act_batch_prob;
+	Hopper_Act_Jump_Opt hopper_act_single_prob;
+	double hopper_act_error = compare_batch_evaluation(hopper_act_batch_prob, hopper_act_single_prob);
+
+	std::cout << "[Main] Max relative difference of the hopper rows = " << hopper_error << std::endl;
+	std::cout << "[Main] Max relative difference of the hopper actuator rows = " << hopper_act_error << std::endl;
+	if ((hopper_error > 1e-12) || (hopper_act_error > 1e-12)){
+		std::cout << "[Main] Batched dynamics check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Batched dynamics check passed" << std::endl;
+	return 0;
+}
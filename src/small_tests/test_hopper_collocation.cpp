@@ -0,0 +1,187 @@
+#include <optimization/optimization_problems/2d_hopper/hopper_jump_opt_problem.hpp>
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <optimization/hard_constraints/2d_hopper/hopper_collocation_constraints.hpp>
+#include <optimization/optimization_constants.hpp>
+
+#include <Utils/utilities.hpp>
+#include <cmath>
+
+// The hopper has a constant mass matrix and gravity and no coriolis terms, so with a constant u and no contact forces
+// qddot = A^-1 (Sa^T u - g) = c everywhere. Along q(t) = q0 + v0 t + c t^2/2 + d t^3 both collocation methods have
+// closed-form residuals over [t0, t1], h = t1 - t0:
+//   time integration  q1 - q0 - h/2 (qdot0 + qdot1) (- h^2/12 (c - c))  = -d h^3/2
+//   dynamics          A (qdot1 - qdot0 - h c)/h                          = 3 A d (t0 + t1)
+// d = 0 is a trajectory of the dynamics, which both methods must integrate exactly.
+double check_hopper_residuals(const int &collocation_method, const sejong::Vector &d){
+	Hopper_Jump_Opt problem(9, collocation_method);
+	Opt_Variable_Manager &var_manager = problem.opt_var_manager;
+
+	double u_const = 5.0;
+	sejong::Vector u = sejong::Vector::Constant(NUM_ACT_JOINT, u_const);
+	sejong::Matrix A;
+	sejong::Vector grav;
+	HopperModel* robot_model = HopperModel::GetRobotModel();
+	robot_model->getMassInertia(A);
+	robot_model->getGravity(grav);
+	sejong::Matrix Sa = sejong::Matrix::Zero(NUM_ACT_JOINT, NUM_QDOT);
+	Sa.block(0, NUM_VIRTUAL, NUM_ACT_JOINT, NUM_ACT_JOINT).setIdentity();
+	sejong::Vector c = A.ldlt().solve(Sa.transpose()*u - grav);
+
+	// Knotpoint 0 holds the fixed initial conditions
+	sejong::Vector q0;
+	sejong::Vector v0;
+	var_manager.get_var_states(0, q0, v0);
+
+	std::vector<double> x_vars;
+	problem.get_current_opt_vars(x_vars);
+	std::vector<double> knotpoint_times(1, 0.0);
+	std::vector<int> indices;
+	for(int k = 1; k < problem.N_total_knotpoints + 1; k++){
+		double h = 0.01 + 0.002*k; // Uneven steps
+		double t = knotpoint_times.back() + h;
+		knotpoint_times.push_back(t);
+		sejong::Vector q = q0 + v0*t + 0.5*c*t*t + d*t*t*t;
+		sejong::Vector qdot = v0 + c*t + 3.0*d*t*t;
+
+		var_manager.get_var_indices(VAR_TYPE_Q, k, indices);
+		for(size_t i = 0; i < indices.size(); i++){ x_vars[indices[i]] = q[i]; }
+		var_manager.get_var_indices(VAR_TYPE_QDOT, k, indices);
+		for(size_t i = 0; i < indices.size(); i++){ x_vars[indices[i]] = qdot[i]; }
+		var_manager.get_var_indices(VAR_TYPE_U, k, indices);
+		for(size_t i = 0; i < indices.size(); i++){ x_vars[indices[i]] = u_const; }
+		var_manager.get_var_indices(VAR_TYPE_FR, k, indices);
+		for(size_t i = 0; i < indices.size(); i++){ x_vars[indices[i]] = 0.0; }
+		var_manager.get_var_indices(VAR_TYPE_H, k, indices);
+		for(size_t i = 0; i < indices.size(); i++){ x_vars[indices[i]] = h; }
+	}
+	problem.update_opt_vars(x_vars);
+
+	Hopper_Collocation_Time_Integration_Constraint integration_constraint(&problem.contact_list, &problem.contact_mode_schedule, collocation_method);
+	Hopper_Collocation_Hybrid_Dynamics_Constraint dynamics_constraint(&problem.contact_list, &problem.contact_mode_schedule, collocation_method);
+
+	// Largest error, relative to the expected residual when it is larger than one
+	double max_error = 0.0;
+	std::vector<double> F_integration;
+	std::vector<double> F_dynamics;
+	for(int k = 1; k < problem.N_total_knotpoints + 1; k++){
+		double t0 = knotpoint_times[k - 1];
+		double t1 = knotpoint_times[k];
+		double h = t1 - t0;
+		sejong::Vector expected_integration = -0.5*d*h*h*h;
+		sejong::Vector expected_dynamics = 3.0*A*d*(t0 + t1);
+
+		integration_constraint.evaluate_constraint(k, var_manager, F_integration);
+		dynamics_constraint.evaluate_constraint(k, var_manager, F_dynamics);
+		for(int i = 0; i < NUM_QDOT; i++){
+			max_error = std::max(max_error, std::fabs(F_integration[i] - expected_integration[i])/std::max(1.0, std::fabs(expected_integration[i])));
+			max_error = std::max(max_error, std::fabs(F_dynamics[i] - expected_dynamics[i])/std::max(1.0, std::fabs(expected_dynamics[i])));
+		}
+	}
+	return max_error;
+}
+
+// Largest relative error between compute_G + compute_A and central differences of compute_F plus A*x,
+// at a point away from the initial guess so that every term of the defects is active
+double check_gradients(Optimization_Problem_Main* problem){
+	Opt_Variable_Manager* var_manager;
+	problem->get_var_manager(var_manager);
+
+	std::vector<double> x_vars;
+	problem->get_init_opt_vars(x_vars);
+	std::vector<bool> is_timestep(x_vars.size(), false);
+	std::vector<int> h_indices;
+	for(int k = 1; k < var_manager->total_knotpoints + 1; k++){
+		var_manager->get_var_indices(VAR_TYPE_H, k, h_indices);
+		for(size_t i = 0; i < h_indices.size(); i++){
+			x_vars[h_indices[i]] = 0.02;
+			is_timestep[h_indices[i]] = true;
+		}
+	}
+	for(size_t j = 0; j < x_vars.size(); j++){
+		if (!is_timestep[j]){
+			x_vars[j] += 0.05*std::sin(1.3*j + 0.4);
+		}
+	}
+
+	std::vector<double> G_eval;
+	std::vector<int> iGfun;
+	std::vector<int> jGvar;
+	int neG = 0;
+	std::vector<double> A_eval;
+	std::vector<int> iAfun;
+	std::vector<int> jAvar;
+	int neA = 0;
+	std::vector<double> F_nominal;
+	problem->update_opt_vars(x_vars);
+	problem->compute_F(F_nominal);
+	problem->compute_G(G_eval, iGfun, jGvar, neG);
+	problem->compute_A(A_eval, iAfun, jAvar, neA);
+
+	int n = x_vars.size();
+	int nF = F_nominal.size();
+	sejong::Matrix G_analytic = sejong::Matrix::Zero(nF, n);
+	for(size_t i = 0; i < neG; i++){
+		G_analytic(iGfun[i], jGvar[i]) += G_eval[i];
+	}
+	for(size_t i = 0; i < neA; i++){
+		G_analytic(iAfun[i], jAvar[i]) += A_eval[i];
+	}
+
+	double step = 1e-6;
+	double max_error = 0.0;
+	std::vector<double> F_plus;
+	std::vector<double> F_minus;
+	for(size_t j = 0; j < n; j++){
+		std::vector<double> x_perturbed = x_vars;
+		x_perturbed[j] = x_vars[j] + step;
+		problem->update_opt_vars(x_perturbed);
+		F_plus.clear();
+		problem->compute_F(F_plus);
+		problem->add_linear_terms(F_plus);
+		x_perturbed[j] = x_vars[j] - step;
+		problem->update_opt_vars(x_perturbed);
+		F_minus.clear();
+		problem->compute_F(F_minus);
+		problem->add_linear_terms(F_minus);
+		for(size_t i = 0; i < nF; i++){
+			double numeric = (F_plus[i] - F_minus[i])/(2.0*step);
+			max_error = std::max(max_error, std::fabs(G_analytic(i, j) - numeric)/std::max(1.0, std::fabs(numeric)));
+		}
+	}
+	problem->update_opt_vars(x_vars);
+	return max_error;
+}
+
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing the Trapezoidal and Hermite-Simpson Collocation Constraints" << std::endl;
+	int num_failures = 0;
+
+	sejong::Vector d_zero = sejong::Vector::Zero(NUM_QDOT);
+	sejong::Vector d_cubic(NUM_QDOT);
+	d_cubic << 2.0, -3.0;
+
+	int collocation_methods[2] = {COLLOCATION_TRAPEZOIDAL, COLLOCATION_HERMITE_SIMPSON};
+	std::string method_names[2] = {"Trapezoidal", "Hermite-Simpson"};
+	for(int m = 0; m < 2; m++){
+		double exact_error = check_hopper_residuals(collocation_methods[m], d_zero);
+		double cubic_error = check_hopper_residuals(collocation_methods[m], d_cubic);
+		std::cout << "[Main] " << method_names[m] << " residual error on a trajectory of the dynamics = " << exact_error
+		          << ", on a cubic trajectory = " << cubic_error << std::endl;
+		num_failures += (exact_error > 1e-9) || (cubic_error > 1e-9);
+
+		Hopper_Jump_Opt hopper_problem(9, collocation_methods[m]);
+		double hopper_gradient_error = check_gradients(&hopper_problem);
+		Hopper_Act_Jump_Opt hopper_act_problem(9, collocation_methods[m]);
+		double hopper_act_gradient_error = check_gradients(&hopper_act_problem);
+		std::cout << "[Main] " << method_names[m] << " max relative gradient error: hopper = " << hopper_gradient_error
+		          << ", hopper act = " << hopper_act_gradient_error << std::endl;
+		num_failures += (hopper_gradient_error > 1e-3) || (hopper_act_gradient_error > 1e-3);
+	}
+
+	if (num_failures > 0){
+		std::cout << "[Main] Collocation check failed (" << num_failures << " failures)" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Collocation check passed" << std::endl;
+	return 0;
+}
@@ -3,6 +3,7 @@
 
 #include <optimization/optimization_problems/2d_hopper/hopper_jump_opt_problem.hpp>
 #include <optimization/snopt_wrapper.hpp>
+#include <optimization/containers/trajectory_file.hpp>
 
 
 void parse_output(Optimization_Problem_Main* opt_prob){
@@ -15,6 +16,15 @@ void parse_output(Optimization_Problem_Main* opt_prob){
 	sejong::Vector Fr_states;	
 	double h_dt = -1.0;
 
+	// Also store the trajectory in binary. The state of this hopper is q, so the x and xdot blocks are empty.
+	Trajectory_Knotpoint traj_knotpoint;
+	Trajectory_Writer traj_writer;
+	var_manager->get_q_states(1, q_states);
+	var_manager->get_u_states(1, torque_states);
+	var_manager->get_var_reaction_forces(1, Fr_states);
+	int block_sizes[NUM_TRAJ_BLOCKS - 1] = {0, 0, (int) q_states.size(), (int) q_states.size(), (int) torque_states.size(), (int) Fr_states.size()};
+	traj_writer.open("hopper_jump_traj.bin", block_sizes, "hopper_jump");
+
 	for(size_t k = 0; k < var_manager->total_knotpoints+1; k++){
 
 	 	std::cout << "--------------------------" << std::endl;
@@ -32,7 +42,18 @@ void parse_output(Optimization_Problem_Main* opt_prob){
 		 	sejong::pretty_print(Fr_states, std::cout, "Fr_states");	 		 	
 		 	std::cout << "h_dt = " << h_dt << std::endl;
 	 	}
+
+	 	traj_knotpoint.clear();
+	 	traj_knotpoint.q = q_states;
+	 	traj_knotpoint.qdot = qdot_states;
+	 	if (k != 0){
+	 		traj_knotpoint.u = torque_states;
+	 		traj_knotpoint.Fr = Fr_states;
+	 		traj_knotpoint.h = h_dt;
+	 	}
+	 	traj_writer.append_knotpoint(traj_knotpoint);
 	}	
+	traj_writer.close();
 
 }
 
@@ -41,7 +62,8 @@ int main(int argc, char **argv)
 	std::cout << "[Main] Running Hopper Jump Optimization Problem" << std::endl;
 	Optimization_Problem_Main* 	opt_problem = new Hopper_Jump_Opt();
 
-	snopt_wrapper::solve_problem_no_gradients(opt_problem);
+	//snopt_wrapper::solve_problem_no_gradients(opt_problem);
+	snopt_wrapper::solve_problem_with_gradients(opt_problem);
 	parse_output(opt_problem);
 	
 	delete opt_problem;
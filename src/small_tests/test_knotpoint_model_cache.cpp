@@ -0,0 +1,101 @@
+#include <Utils/utilities.hpp>
+#include <optimization/containers/opt_variable_manager.hpp>
+#include <optimization/containers/knotpoint_model_cache.hpp>
+
+#include <iostream>
+
+// Records how it was filled, so the test can tell a cached state from a refilled one
+struct Test_Model_State{
+	sejong::Vector q;
+	int num_fills = 0;
+	int num_clears = 0;
+
+	void clear(){
+		num_clears++;
+	}
+};
+
+typedef Knotpoint_Model_Cache<Test_Model_State> Test_Cache;
+
+int check(const bool &passed, const std::string &description){
+	std::cout << "[Main] " << description << (passed ? " passed" : " FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
+
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing Knotpoint Model Cache" << std::endl;
+
+	// Two q variables at knotpoints 0 and 1
+	Opt_Variable_Manager var_manager;
+	for(int k = 0; k < 2; k++){
+		var_manager.append_variable(new Opt_Variable("q", VAR_TYPE_Q, k, 0.1*k, -10, 10));
+		var_manager.append_variable(new Opt_Variable("q", VAR_TYPE_Q, k, 0.2*k, -10, 10));
+	}
+	var_manager.compute_size_time_dep_vars();
+
+	const int knotpoint = 1;
+	auto fill = [&](Test_Model_State &state){
+		state.q = var_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+		state.num_fills++;
+	};
+
+	int failures = 0;
+
+	Test_Model_State &state = Test_Cache::get_state(knotpoint, var_manager, fill);
+	failures += check((state.num_fills == 1) && (state.q == var_manager.get_var_block(VAR_TYPE_Q, knotpoint)), "First request fills the state");
+
+	Test_Cache::get_state(knotpoint, var_manager, fill);
+	failures += check(state.num_fills == 1, "Second request with the same variables reads the cached state");
+
+	// Changing x must refresh the state
+	std::vector<double> x_vars;
+	var_manager.get_current_opt_vars(x_vars);
+	for(size_t i = 0; i < x_vars.size(); i++){
+		x_vars[i] += 1.0;
+	}
+	var_manager.update_opt_vars(x_vars);
+	Test_Cache::get_state(knotpoint, var_manager, fill);
+	failures += check((state.num_fills == 2) && (state.num_clears == 2) && (state.q == var_manager.get_var_block(VAR_TYPE_Q, knotpoint)),
+	                  "Request after update_opt_vars refills the state");
+
+	// A fill that throws after writing part of the state must not leave it cached
+	for(size_t i = 0; i < x_vars.size(); i++){
+		x_vars[i] += 1.0;
+	}
+	var_manager.update_opt_vars(x_vars);
+	auto throwing_fill = [&](Test_Model_State &state_in){
+		state_in.q.setZero();
+		throw "invalid_index";
+	};
+	bool thrown = false;
+	try{
+		Test_Cache::get_state(knotpoint, var_manager, throwing_fill);
+	}catch(const char* e){
+		thrown = true;
+	}
+	failures += check(thrown, "Exception of the fill reaches the caller");
+
+	Test_Cache::get_state(knotpoint, var_manager, fill);
+	failures += check((state.num_fills == 3) && (state.q == var_manager.get_var_block(VAR_TYPE_Q, knotpoint)),
+	                  "Request after a throwing fill refills the state");
+
+	// Another manager with the same values has its own state version
+	Opt_Variable_Manager other_manager;
+	for(int k = 0; k < 2; k++){
+		other_manager.append_variable(new Opt_Variable("q", VAR_TYPE_Q, k, 0.0, -10, 10));
+		other_manager.append_variable(new Opt_Variable("q", VAR_TYPE_Q, k, 0.0, -10, 10));
+	}
+	other_manager.compute_size_time_dep_vars();
+	other_manager.update_opt_vars(x_vars);
+	auto other_fill = [&](Test_Model_State &state_in){
+		state_in.q = other_manager.get_var_block(VAR_TYPE_Q, knotpoint);
+		state_in.num_fills++;
+	};
+	Test_Cache::get_state(knotpoint, other_manager, other_fill);
+	failures += check(state.num_fills == 4, "Request from another variable manager refills the state");
+
+	if (failures == 0){
+		std::cout << "[Main] Knotpoint model cache check passed" << std::endl;
+	}
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <cmath>
+#include <Utils/utilities.hpp>
+
+#include <optimization/optimization_problems/2d_hopper_act/hopper_act_jump_prob.hpp>
+#include <optimization/nlp_backends/snopt_backend.hpp>
+#include <optimization/nlp_backends/interior_point_backend.hpp>
+
+// Hock-Schittkowski problem 71. The optimal objective is 17.0140173.
+// min x0*x3*(x0 + x1 + x2) + x2  s.t.  x0*x1*x2*x3 >= 25,  x0^2 + x1^2 + x2^2 + x3^2 = 40,  1 <= x <= 5
+class HS071_Problem: public Optimization_Problem_Main{
+public:
+	HS071_Problem(const bool &provide_hessian_in): provide_hessian(provide_hessian_in){
+		problem_name = "HS071";
+		x = {1.0, 5.0, 5.0, 1.0};
+	}
+
+	bool provide_hessian;
+	std::vector<double> x;
+
+	void get_init_opt_vars(std::vector<double> &x_vars){ x_vars = {1.0, 5.0, 5.0, 1.0}; }
+	void get_opt_vars_bounds(std::vector<double> &x_low, std::vector<double> &x_upp){
+		x_low.assign(4, 1.0);
+		x_upp.assign(4, 5.0);
+	}
+	void get_current_opt_vars(std::vector<double> &x_vars_out){ x_vars_out = x; }
+	void update_opt_vars(std::vector<double> &x_vars){ x = x_vars; }
+	void update_opt_vars(const double* x_vars, const int &n){ x.assign(x_vars, x_vars + n); }
+
+	void get_F_bounds(std::vector<double> &F_low, std::vector<double> &F_upp){
+		F_low = {-OPT_INFINITY, 25.0, 40.0};
+		F_upp = {OPT_INFINITY, OPT_INFINITY, 40.0};
+	}
+	void get_F_obj_Row(int &obj_row){ obj_row = 0; }
+
+	void compute_F(std::vector<double> &F_eval){
+		F_eval = {x[0]*x[3]*(x[0] + x[1] + x[2]) + x[2], 
+				  x[0]*x[1]*x[2]*x[3],
+				  x[0]*x[0] + x[1]*x[1] + x[2]*x[2] + x[3]*x[3]};
+	}
+
+	void compute_G(std::vector<double> &G_eval, std::vector<int> &iGfun, std::vector<int> &jGvar, int &neG){
+		G_eval = {x[3]*(2.0*x[0] + x[1] + x[2]), x[0]*x[3], x[0]*x[3] + 1.0, x[0]*(x[0] + x[1] + x[2]),
+				  x[1]*x[2]*x[3], x[0]*x[2]*x[3], x[0]*x[1]*x[3], x[0]*x[1]*x[2],
+				  2.0*x[0], 2.0*x[1], 2.0*x[2], 2.0*x[3]};
+		iGfun = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2};
+		jGvar = {0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3};
+		neG = G_eval.size();
+	}
+	void compute_A(std::vector<double> &A_eval, std::vector<int> &iAfun, std::vector<int> &jAvar, int &neA){
+		A_eval.clear(); iAfun.clear(); jAvar.clear();
+		neA = 0;
+	}
+
+	bool compute_lagrangian_hessian(const std::vector<double> &lambda, std::vector<double> &H_eval, std::vector<int> &iHrow, 
+									std::vector<int> &jHcol, int &neH){
+		if (!provide_hessian){
+			return false;
+		}
+		double s = lambda[0];
+		H_eval = {s*2.0*x[3] + lambda[2]*2.0,
+				  s*x[3] + lambda[1]*x[2]*x[3],
+				  lambda[2]*2.0,
+				  s*x[3] + lambda[1]*x[1]*x[3],
+				  lambda[1]*x[0]*x[3],
+				  lambda[2]*2.0,
+				  s*(2.0*x[0] + x[1] + x[2]) + lambda[1]*x[1]*x[2],
+				  s*x[0] + lambda[1]*x[0]*x[2],
+				  s*x[0] + lambda[1]*x[0]*x[1],
+				  lambda[2]*2.0};
+		iHrow = {0, 1, 1, 2, 2, 2, 3, 3, 3, 3};
+		jHcol = {0, 0, 1, 0, 1, 2, 0, 1, 2, 3};
+		neH = H_eval.size();
+		return true;
+	}
+};
+
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing the interior point backend on HS071" << std::endl;
+	int failures = 0;
+	for(int provide_hessian = 0; provide_hessian < 2; provide_hessian++){
+		HS071_Problem hs071(provide_hessian == 1);
+		Interior_Point_Backend interior_point;
+		interior_point.set_verbose(false);
+		NLP_Result result;
+		interior_point.solve(&hs071, result);
+		bool passed = (result.exit_code == INTERIOR_POINT_OPTIMAL) && (std::fabs(result.objective - 17.0140173) < 1e-4) && (result.max_violation < 1e-6);
+		std::cout << "[Main] " << (provide_hessian ? "Exact Hessian" : "Finite difference Hessian") << ": " << result.iterations << " iterations"
+				  << " objective = " << result.objective << (passed ? " passed" : " FAILED") << std::endl;
+		if (!passed){
+			failures++;
+		}
+	}
+
+	// The same jump problem with each backend. The interior point backend must solve it.
+	std::cout << "[Main] Comparing the backends on the Hopper Act Jump Optimization Problem" << std::endl;
+	SNOPT_Backend snopt;
+	snopt.set_print_file("snopt_backend_comparison.out");
+	Interior_Point_Backend interior_point;
+	interior_point.set_verbose(false);
+	std::vector<NLP_Backend*> backends = {&snopt, &interior_point};
+	std::vector<NLP_Result> results;
+	compare_backends(backends, [](){ return new Hopper_Act_Jump_Opt(); }, results);
+	if ((results[1].exit_code != INTERIOR_POINT_OPTIMAL) || (results[1].max_violation > 1e-6)){
+		std::cout << "[Main] The interior point backend did not solve " << results[1].problem_name << std::endl;
+		failures++;
+	}
+
+	return (failures == 0) ? 0 : 1;
+}
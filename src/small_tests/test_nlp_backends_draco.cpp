@@ -0,0 +1,25 @@
+#include <iostream>
+#include <Utils/utilities.hpp>
+
+#include <optimization/optimization_problems/2d_draco/draco_jump_opt_problem.hpp>
+#include <optimization/nlp_backends/snopt_backend.hpp>
+#include <optimization/nlp_backends/interior_point_backend.hpp>
+
+// The Draco and hopper definitions can not share a translation unit, so the Draco comparison is its own test
+int main(int argc, char **argv){
+	std::cout << "[Main] Comparing the backends on the Draco Jump Optimization Problem" << std::endl;
+	SNOPT_Backend snopt;
+	snopt.set_print_file("snopt_backend_comparison_draco.out");
+	Interior_Point_Backend interior_point;
+	interior_point.set_verbose(false);
+	std::vector<NLP_Backend*> backends = {&snopt, &interior_point};
+	std::vector<NLP_Result> results;
+	compare_backends(backends, [](){ return new Draco_Jump_Opt(); }, results);
+	// The interior point backend must solve it
+	if ((results[1].exit_code != INTERIOR_POINT_OPTIMAL) || (results[1].max_violation > 1e-6)){
+		std::cout << "[Main] The interior point backend did not solve " << results[1].problem_name << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Backend comparison passed" << std::endl;
+	return 0;
+}
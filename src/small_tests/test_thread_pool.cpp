@@ -0,0 +1,49 @@
+#include <optimization/parallel/thread_pool.hpp>
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+// Resizes the pool between loops. Every index must run once, and no call may still be running once parallel_for returns.
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing the Thread Pool" << std::endl;
+	Thread_Pool pool;
+	const int thread_counts[] = {4, 2, 8, 1, 3, 8, 2, 5};
+	const int num_loops = 200;
+	const int num_iterations = 64;
+
+	std::atomic<int> num_running(0);
+	int num_errors = 0;
+	for(int loop = 0; loop < num_loops; loop++){
+		pool.set_num_threads(thread_counts[loop % 8]);
+		// A few loops with the same size so that restarted workers run more than one loop
+		for(int repeat = 0; repeat < 3; repeat++){
+			std::vector<int> visits(num_iterations, 0);
+			pool.parallel_for(0, num_iterations, [&](int i){
+				num_running++;
+				visits[i]++;
+				if (i % 16 == 0){
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+				}
+				num_running--;
+			});
+			if (num_running.load() != 0){
+				num_errors++;
+			}
+			for(int i = 0; i < num_iterations; i++){
+				if (visits[i] != 1){
+					num_errors++;
+				}
+			}
+		}
+	}
+
+	std::cout << "[Main] Errors = " << num_errors << std::endl;
+	if (num_errors > 0){
+		std::cout << "[Main] Thread pool check failed" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] Thread pool check passed" << std::endl;
+	return 0;
+}
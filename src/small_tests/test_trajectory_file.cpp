@@ -0,0 +1,81 @@
+#include <Utils/utilities.hpp>
+#include <optimization/containers/trajectory_file.hpp>
+
+#include <iostream>
+#include <cmath>
+
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing Trajectory File" << std::endl;
+	std::string filename = "test_trajectory_file.bin";
+
+	const int num_knotpoints = 5;
+	int block_sizes[NUM_TRAJ_BLOCKS - 1] = {4, 4, 3, 3, 2, 6};
+
+	Trajectory_Writer writer;
+	if (!writer.open(filename, block_sizes, "test_trajectory")){
+		return 1;
+	}
+
+	std::vector<Trajectory_Knotpoint> knotpoints(num_knotpoints);
+	for(int k = 0; k < num_knotpoints; k++){
+		knotpoints[k].x = sejong::Vector::Random(block_sizes[TRAJ_BLOCK_X]);
+		knotpoints[k].xdot = sejong::Vector::Random(block_sizes[TRAJ_BLOCK_XDOT]);
+		knotpoints[k].q = sejong::Vector::Random(block_sizes[TRAJ_BLOCK_Q]);
+		knotpoints[k].qdot = sejong::Vector::Random(block_sizes[TRAJ_BLOCK_QDOT]);
+		// Knotpoint 0 has no inputs, reaction forces or time step
+		if (k != 0){
+			knotpoints[k].u = sejong::Vector::Random(block_sizes[TRAJ_BLOCK_U]);
+			knotpoints[k].Fr = sejong::Vector::Random(block_sizes[TRAJ_BLOCK_FR]);
+			knotpoints[k].h = 0.01*k;
+		}
+		writer.append_knotpoint(knotpoints[k]);
+	}
+
+	// A block with the wrong size must be rejected
+	Trajectory_Knotpoint bad_knotpoint = knotpoints[1];
+	bad_knotpoint.q = sejong::Vector::Zero(block_sizes[TRAJ_BLOCK_Q] + 1);
+	if (writer.append_knotpoint(bad_knotpoint)){
+		std::cout << "[Main] Error! A block with the wrong size was accepted" << std::endl;
+		return 1;
+	}
+	writer.close();
+
+	Trajectory_Reader reader;
+	if (!reader.open(filename)){
+		return 1;
+	}
+	std::cout << "Problem name: " << reader.get_problem_name() << std::endl;
+	std::cout << "Knotpoints: " << reader.get_num_knotpoints() << std::endl;
+
+	int errors = 0;
+	if ((reader.get_num_knotpoints() != num_knotpoints) || (reader.get_problem_name() != "test_trajectory")){
+		errors++;
+	}
+	for(int k = 0; k < reader.get_num_knotpoints(); k++){
+		errors += (reader.get_block(k, TRAJ_BLOCK_X) != knotpoints[k].x);
+		errors += (reader.get_block(k, TRAJ_BLOCK_XDOT) != knotpoints[k].xdot);
+		errors += (reader.get_block(k, TRAJ_BLOCK_Q) != knotpoints[k].q);
+		errors += (reader.get_block(k, TRAJ_BLOCK_QDOT) != knotpoints[k].qdot);
+		if (k == 0){
+			errors += !reader.get_block(k, TRAJ_BLOCK_U).array().isNaN().all();
+			errors += !reader.get_block(k, TRAJ_BLOCK_FR).array().isNaN().all();
+			errors += !std::isnan(reader.get_h(k));
+		}else{
+			errors += (reader.get_block(k, TRAJ_BLOCK_U) != knotpoints[k].u);
+			errors += (reader.get_block(k, TRAJ_BLOCK_FR) != knotpoints[k].Fr);
+			errors += (reader.get_h(k) != knotpoints[k].h);
+		}
+	}
+	sejong::pretty_print(sejong::Vector(reader.get_block(num_knotpoints - 1, TRAJ_BLOCK_Q)), std::cout, "last q");
+
+	try{
+		reader.get_block(num_knotpoints, TRAJ_BLOCK_X);
+		errors++;
+	}catch(const char* e){
+		std::cout << "Out of range knotpoint throws " << e << std::endl;
+	}
+	reader.close();
+
+	std::cout << "Mismatches: " << errors << std::endl;
+	return (errors == 0) ? 0 : 1;
+}
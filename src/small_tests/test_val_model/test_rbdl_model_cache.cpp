@@ -0,0 +1,182 @@
+#include <Utils/utilities.hpp>
+#include <rbdl_model_cache/rbdl_model_cache.hpp>
+#include <rbdl/urdfreader.h>
+
+#include "valkyrie_definition.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace RigidBodyDynamics;
+using namespace RigidBodyDynamics::Math;
+
+// A tree with every kind of body the snapshot stores: native multi-DoF joints, a floating base and a 2-DoF joint that
+// RBDL splits into virtual bodies, fixed bodies on the root, on a movable body and on another fixed body, and names for all.
+void build_test_model(Model* model){
+	model->gravity = Vector3d(0.1, -0.2, -9.81);
+	Body body(1.5, Vector3d(0.1, 0.02, -0.3), Matrix3d(Vector3d(0.05, 0.04, 0.03).asDiagonal()));
+	Body light_body(0.25, Vector3d(0.0, 0.01, 0.02), Matrix3d(Vector3d(0.002, 0.003, 0.001).asDiagonal()));
+
+	unsigned int pelvis_id = model->AddBody(0, Xtrans(Vector3d(0.0, 0.0, 1.0)), Joint(JointTypeFloatingBase), body, "pelvis");
+	model->AddBody(0, Xtrans(Vector3d(0.3, 0.0, 0.0)), Joint(JointTypeFixed), light_body, "root_sensor");
+	unsigned int hip_id = model->AddBody(pelvis_id, Xtrans(Vector3d(0.0, 0.1, -0.1)), Joint(JointTypeEulerZYX), body, "hip");
+	unsigned int knee_id = model->AddBody(hip_id, Xtrans(Vector3d(0.0, 0.0, -0.4)),
+										  Joint(SpatialVector(0., 1., 0., 0., 0., 0.), SpatialVector(1., 0., 0., 0., 0., 0.)), body, "knee");
+	unsigned int ankle_id = model->AddBody(knee_id, Xtrans(Vector3d(0.0, 0.0, -0.4)), Joint(JointTypeSpherical), body, "ankle");
+	unsigned int slider_id = model->AddBody(ankle_id, Xtrans(Vector3d(0.05, 0.0, -0.05)), Joint(SpatialVector(0., 0., 0., 0., 0., 1.)), light_body, "slider");
+	unsigned int foot_id = model->AddBody(slider_id, Xtrans(Vector3d(0.1, 0.0, -0.02)), Joint(JointTypeFixed), light_body, "foot");
+	model->AddBody(foot_id, Xtrans(Vector3d(0.08, 0.0, 0.0)), Joint(JointTypeFixed), light_body, "toe");
+	model->AddBody(pelvis_id, Xtrans(Vector3d(0.0, 0.0, 0.3)), Joint(JointTypeTranslationXYZ), light_body, "torso");
+}
+
+// Largest difference of the mass matrix, the nonlinear effects and the base positions of a point on every named body
+double compare_dynamics(Model &model_a, Model &model_b){
+	if ((model_a.q_size != model_b.q_size) || (model_a.qdot_size != model_b.qdot_size) || (model_a.mBodyNameMap != model_b.mBodyNameMap)){
+		return INFINITY;
+	}
+	VectorNd q = VectorNd::Zero(model_a.q_size);
+	VectorNd qdot = VectorNd::Zero(model_a.qdot_size);
+	for(int i = 0; i < q.size(); i++){
+		q[i] = 0.1*std::sin(1.3*i + 0.2);
+	}
+	for(int i = 0; i < qdot.size(); i++){
+		qdot[i] = 0.5*std::cos(0.7*i);
+	}
+
+	MatrixNd H_a = MatrixNd::Zero(model_a.qdot_size, model_a.qdot_size);
+	MatrixNd H_b = MatrixNd::Zero(model_b.qdot_size, model_b.qdot_size);
+	VectorNd tau_a = VectorNd::Zero(model_a.qdot_size);
+	VectorNd tau_b = VectorNd::Zero(model_b.qdot_size);
+	CompositeRigidBodyAlgorithm(model_a, q, H_a, true);
+	CompositeRigidBodyAlgorithm(model_b, q, H_b, true);
+	NonlinearEffects(model_a, q, qdot, tau_a);
+	NonlinearEffects(model_b, q, qdot, tau_b);
+	double max_error = std::max((H_a - H_b).cwiseAbs().maxCoeff(), (tau_a - tau_b).cwiseAbs().maxCoeff());
+
+	Vector3d point(0.01, -0.02, 0.03);
+	for(std::map<std::string, unsigned int>::const_iterator it = model_a.mBodyNameMap.begin(); it != model_a.mBodyNameMap.end(); it++){
+		Vector3d pos_a = CalcBodyToBaseCoordinates(model_a, q, it->second, point, true);
+		Vector3d pos_b = CalcBodyToBaseCoordinates(model_b, q, it->second, point, true);
+		max_error = std::max(max_error, (pos_a - pos_b).cwiseAbs().maxCoeff());
+	}
+	return max_error;
+}
+
+// The only snapshot in the directory
+std::string find_cache_file(const std::string &cache_dir){
+	std::string cache_file;
+	DIR* dir = opendir(cache_dir.c_str());
+	if (dir == NULL){
+		return cache_file;
+	}
+	struct dirent* entry;
+	while((entry = readdir(dir)) != NULL){
+		std::string name = entry->d_name;
+		if ((name.size() > 11) && (name.compare(name.size() - 11, 11, ".rbdl_cache") == 0)){
+			cache_file = cache_dir + "/" + name;
+		}
+	}
+	closedir(dir);
+	return cache_file;
+}
+
+long file_size(const std::string &path){
+	struct stat file_stat;
+	return (stat(path.c_str(), &file_stat) == 0) ? (long) file_stat.st_size : -1;
+}
+
+int main(int argc, char **argv){
+	std::cout << "[Main] Testing the RBDL Model Cache" << std::endl;
+	int num_failures = 0;
+	const double tolerance = 1e-12;
+
+	// Round trip of a model built in code
+	Model built_model;
+	build_test_model(&built_model);
+	std::string snapshot_file = "test_rbdl_model_cache.rbdl_cache";
+	uint64_t key = 0x0123456789abcdefULL;
+	Model read_model;
+	if (!rbdl_model_cache::write_model_cache(built_model, key, snapshot_file) || !rbdl_model_cache::read_model_cache(snapshot_file, key, &read_model)){
+		std::cout << "[Main] Could not write and read the snapshot" << std::endl;
+		num_failures++;
+	}else{
+		double error = compare_dynamics(built_model, read_model);
+		std::cout << "[Main] Round trip max difference = " << error << std::endl;
+		num_failures += (error > tolerance);
+	}
+
+	// A snapshot under another key, or cut short, is not read and leaves the model empty
+	Model stale_model;
+	bool stale_read = rbdl_model_cache::read_model_cache(snapshot_file, key + 1, &stale_model);
+	std::cout << "[Main] Stale key read = " << stale_read << " bodies = " << stale_model.mBodies.size() << std::endl;
+	num_failures += stale_read || (stale_model.mBodies.size() != 1);
+
+	long full_size = file_size(snapshot_file);
+	bool all_truncations_rejected = true;
+	for(long size = 0; size < full_size; size += 7){
+		if (truncate(snapshot_file.c_str(), size) != 0){
+			break;
+		}
+		Model truncated_model;
+		if (rbdl_model_cache::read_model_cache(snapshot_file, key, &truncated_model) || (truncated_model.mBodies.size() != 1)){
+			all_truncations_rejected = false;
+		}
+		rbdl_model_cache::write_model_cache(built_model, key, snapshot_file);
+	}
+	std::cout << "[Main] Truncated snapshots rejected = " << all_truncations_rejected << std::endl;
+	num_failures += !all_truncations_rejected;
+	std::remove(snapshot_file.c_str());
+
+	// The URDF through the cache: parsed and written, then read from the snapshot
+	std::string cache_dir = "test_rbdl_model_cache_dir";
+	mkdir(cache_dir.c_str(), 0755);
+	std::string old_cache_file = find_cache_file(cache_dir);
+	if (!old_cache_file.empty()){
+		std::remove(old_cache_file.c_str());
+	}
+	setenv("RBDL_MODEL_CACHE_DIR", cache_dir.c_str(), 1);
+	std::string urdf_file = URDF_PATH"r5_urdf_rbdl.urdf";
+
+	Model parsed_model;
+	Addons::URDFReadFromFile(urdf_file.c_str(), &parsed_model, false);
+	Model first_model;
+	Model cached_model;
+	rbdl_model_cache::read_urdf_model(urdf_file, &first_model, false);
+	std::string cache_file = find_cache_file(cache_dir);
+	rbdl_model_cache::read_urdf_model(urdf_file, &cached_model, false);
+	double urdf_error = std::max(compare_dynamics(parsed_model, first_model), compare_dynamics(parsed_model, cached_model));
+	std::cout << "[Main] Snapshot " << cache_file << " max difference to the parsed URDF = " << urdf_error << std::endl;
+	num_failures += cache_file.empty() || (urdf_error > tolerance);
+
+	// A damaged snapshot falls back to parsing and is replaced
+	long cache_size = file_size(cache_file);
+	truncate(cache_file.c_str(), cache_size/2);
+	Model reparsed_model;
+	bool reparsed = rbdl_model_cache::read_urdf_model(urdf_file, &reparsed_model, false);
+	double reparsed_error = compare_dynamics(parsed_model, reparsed_model);
+	std::cout << "[Main] Truncated snapshot max difference = " << reparsed_error << " size restored = " << (file_size(cache_file) == cache_size) << std::endl;
+	num_failures += !reparsed || (reparsed_error > tolerance) || (file_size(cache_file) != cache_size);
+
+	// So does a snapshot of another model under the URDF's file name, whose key can not match
+	rbdl_model_cache::write_model_cache(built_model, key, cache_file);
+	Model restale_model;
+	bool restale = rbdl_model_cache::read_urdf_model(urdf_file, &restale_model, false);
+	double restale_error = compare_dynamics(parsed_model, restale_model);
+	std::cout << "[Main] Stale snapshot max difference = " << restale_error << std::endl;
+	num_failures += !restale || (restale_error > tolerance);
+
+	std::remove(cache_file.c_str());
+	rmdir(cache_dir.c_str());
+
+	if (num_failures > 0){
+		std::cout << "[Main] RBDL model cache check failed (" << num_failures << " failures)" << std::endl;
+		return 1;
+	}
+	std::cout << "[Main] RBDL model cache check passed" << std::endl;
+	return 0;
+}
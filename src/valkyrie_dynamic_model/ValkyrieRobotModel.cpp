@@ -2,6 +2,7 @@
 #include "Valkyrie_Dyn_Model.hpp"
 #include "Valkyrie_Kin_Model.hpp"
 #include "rbdl/urdfreader.h"
+#include <rbdl_model_cache/rbdl_model_cache.hpp>
 #include "Utils/utilities.hpp"
 
 #include <stdio.h>
@@ -10,14 +11,24 @@ using namespace RigidBodyDynamics;
 using namespace RigidBodyDynamics::Math;
 
 ValkyrieRobotModel* ValkyrieRobotModel::GetValkyrieRobotModel(){
-    static ValkyrieRobotModel valkyrie_model_;
+    // The URDF is read once and every thread works on its own clone of the model
+    static const ValkyrieRobotModel valkyrie_model_prototype;
+    thread_local ValkyrieRobotModel valkyrie_model_(valkyrie_model_prototype);
     return & valkyrie_model_;
 }
 
+ValkyrieRobotModel::ValkyrieRobotModel(const ValkyrieRobotModel &other){
+    model_ = new Model(*other.model_);
+    dyn_model_ = new Valkyrie_Dyn_Model(*other.dyn_model_, model_);
+    kin_model_ = new Valkyrie_Kin_Model(*other.kin_model_, model_);
+    last_timestep_model_update = other.last_timestep_model_update;
+}
+
 ValkyrieRobotModel::ValkyrieRobotModel(){
     model_ = new Model();
 
-    if (!Addons::URDFReadFromFile (URDF_PATH"r5_urdf_rbdl.urdf", model_, false)) {
+    // Later runs read the assembled model from its snapshot instead of parsing the URDF
+    if (!rbdl_model_cache::read_urdf_model(URDF_PATH"r5_urdf_rbdl.urdf", model_, false)) {
         std::cerr << "Error loading model ./r5_urdf_rbdl.urdf" << std::endl;
         abort();
     }
@@ -76,6 +87,10 @@ bool ValkyrieRobotModel::getCoriolis(Vector & coriolis) {
     return dyn_model_->getCoriolis(coriolis);
 }
 
+bool ValkyrieRobotModel::getNonlinearEffects(Vector & nonlinear) {
+    return dyn_model_->getNonlinearEffects(nonlinear);
+}
+
 void ValkyrieRobotModel::getFullJacobian(const Vector & q, int link_id, sejong::Matrix & J) const {
   J.setZero();
   kin_model_->getJacobian(q, link_id, J);
@@ -107,14 +122,12 @@ void ValkyrieRobotModel::getCoMJacobian(const Vector & q, sejong::Matrix & J){
 }
 
 void ValkyrieRobotModel::getCoMPosition(const Vector & q, Vect3 & com_pos, bool update){
-  com_pos = kin_model_->com_pos_;
-    // kin_model_->getCoMPos(q, com_pos, update);
+  kin_model_->getCentroidCoMPos(com_pos);
 }
 
 void ValkyrieRobotModel::getCoMVelocity(const Vector & q, const Vector & qdot, Vect3 & com_vel){
     kin_model_->getCoMVel(q, qdot, com_vel);
 }
 void ValkyrieRobotModel::getCentroidVelocity(sejong::Vector & centroid_vel){
-  centroid_vel = kin_model_->centroid_vel_;
-  // kin_model_->getCentroidVelocity(centroid_vel);
+  kin_model_->getCentroidVelocity(centroid_vel);
 }
@@ -12,7 +12,11 @@ using namespace sejong;
 class ValkyrieRobotModel{
 public:
     // EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    // Returns the calling thread's model. UpdateModel writes into the RBDL model, so threads must not share one.
     static ValkyrieRobotModel* GetValkyrieRobotModel();
+    // Clones the loaded RBDL model and the cached dynamics without reading the URDF again
+    ValkyrieRobotModel(const ValkyrieRobotModel &other);
+    ValkyrieRobotModel& operator=(const ValkyrieRobotModel &other) = delete;
     virtual ~ValkyrieRobotModel(void);
 
     bool getMassInertia(sejong::Matrix & A);
@@ -20,6 +24,7 @@ public:
     virtual bool getInverseMassInertia(sejong::Matrix & Ainv) ;
     virtual bool getGravity(Vector & grav) ;
     virtual bool getCoriolis(Vector & coriolis) ;
+    virtual bool getNonlinearEffects(Vector & nonlinear) ;
 
     virtual void getCentroidJacobian(sejong::Matrix & Jcent);
     virtual void getCentroidInertia(sejong::Matrix & Icent);
@@ -40,6 +45,8 @@ public:
     void getCentroidVelocity(sejong::Vector & centroid_vel);
     void getCoMJacobian(const Vector & q, sejong::Matrix & J);
     void UpdateKinematics(const Vector & q, const Vector &qdot);
+    // Updates the kinematics. M, the coriolis and gravity terms, Ainv and the centroid frame are computed on their
+    // first request, so read them before the model is moved to another state with UpdateKinematics or UpdateModel.
     void UpdateModel(const sejong::Vector & q, const sejong::Vector & qdot);
     void UpdateModel(int timestep, const sejong::Vector & q, const sejong::Vector & qdot);    
 
@@ -3,7 +3,6 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/syscall.h>
-#include <Utils/pseudo_inverse.hpp>
 
 using namespace RigidBodyDynamics::Math;
 
@@ -11,44 +10,95 @@ Valkyrie_Dyn_Model::Valkyrie_Dyn_Model(RigidBodyDynamics::Model* model){
     model_ = model;
 }
 
+Valkyrie_Dyn_Model::Valkyrie_Dyn_Model(const Valkyrie_Dyn_Model &other, RigidBodyDynamics::Model* model){
+    *this = other;
+    model_ = model;
+}
+
 Valkyrie_Dyn_Model::~Valkyrie_Dyn_Model(){
 }
 
 bool Valkyrie_Dyn_Model::getMassInertia(Matrix & a){
+    updateMassInertia();
     a = A_;
     return true;
 }
 
 bool Valkyrie_Dyn_Model::getInverseMassInertia(Matrix & ainv){
+    if (!Ainv_updated_){
+        factorizeMassInertia();
+        Ainv_ = A_ldlt_.solve(Matrix::Identity(A_.rows(), A_.cols()));
+        Ainv_updated_ = true;
+    }
     ainv = Ainv_;
     return true;
 }
 
+bool Valkyrie_Dyn_Model::solveMassInertia(const Vector & b, Vector & ainv_b){
+    factorizeMassInertia();
+    ainv_b = A_ldlt_.solve(b);
+    return true;
+}
+
+void Valkyrie_Dyn_Model::factorizeMassInertia(){
+    if (!A_factorized_){
+        updateMassInertia();
+        A_ldlt_.compute(A_);
+        A_factorized_ = true;
+    }
+}
+
 bool Valkyrie_Dyn_Model::getGravity(Vector &  grav){
+    updateGravity();
     grav = grav_;
     return true;
 }
 bool Valkyrie_Dyn_Model::getCoriolis(Vector & coriolis){
-    coriolis = coriolis_;
+    updateNonlinearEffects();
+    updateGravity();
+    coriolis = nonlinear_ - grav_;
+    return true;
+}
+bool Valkyrie_Dyn_Model::getNonlinearEffects(Vector & nonlinear){
+    updateNonlinearEffects();
+    nonlinear = nonlinear_;
     return true;
 }
 
 void Valkyrie_Dyn_Model::UpdateDynamics(const sejong::Vector & q, const sejong::Vector & qdot){
-    // Mass Matrix
-    A_ = Matrix::Zero(model_->qdot_size, model_->qdot_size);
-    CompositeRigidBodyAlgorithm(*model_, q, A_, false);
-
-    // Ainv_ = A_.inverse();
-    sejong::pseudoInverse(A_, 1.e-10, Ainv_, 0);
-
-    Vector ZeroQdot = Vector::Zero(model_->qdot_size);
-    // Gravity
-    Vector grav_tmp = sejong::Vector::Zero(model_->qdot_size);
-    InverseDynamics(*model_, q, ZeroQdot, ZeroQdot, grav_tmp);
-    grav_ = grav_tmp;
-    // Coriolis
-    Vector coriolis_tmp = sejong::Vector::Zero(model_->qdot_size);
-    InverseDynamics(*model_, q, qdot, ZeroQdot, coriolis_tmp);
-
-    coriolis_ = coriolis_tmp - grav_;
-} 
+    q_ = q;
+    qdot_ = qdot;
+    A_updated_ = false;
+    A_factorized_ = false;
+    Ainv_updated_ = false;
+    nonlinear_updated_ = false;
+    grav_updated_ = false;
+}
+
+void Valkyrie_Dyn_Model::updateMassInertia(){
+    if (!A_updated_){
+        A_ = Matrix::Zero(model_->qdot_size, model_->qdot_size);
+        // The robot model may have been moved since UpdateDynamics, so the CRBA brings its kinematics to q first
+        CompositeRigidBodyAlgorithm(*model_, q_, A_, true);
+        A_updated_ = true;
+    }
+}
+
+void Valkyrie_Dyn_Model::updateNonlinearEffects(){
+    if (!nonlinear_updated_){
+        nonlinear_ = sejong::Vector::Zero(model_->qdot_size);
+        NonlinearEffects(*model_, q_, qdot_, nonlinear_);
+        nonlinear_updated_ = true;
+    }
+}
+
+void Valkyrie_Dyn_Model::updateGravity(){
+    if (!grav_updated_){
+        // An RNEA pass with zero qdot and qddot. It overwrites the body velocities, which are brought back to qdot.
+        Vector zero_qdot = sejong::Vector::Zero(model_->qdot_size);
+        grav_ = sejong::Vector::Zero(model_->qdot_size);
+        InverseDynamics(*model_, q_, zero_qdot, zero_qdot, grav_);
+        UpdateKinematicsCustom(*model_, NULL, &qdot_, NULL);
+        grav_updated_ = true;
+    }
+}
@@ -10,20 +10,42 @@ class Valkyrie_Dyn_Model{
 public:
 
     Valkyrie_Dyn_Model(RigidBodyDynamics::Model* model);
+    // Copies the cached quantities of other and works on model, which must be a copy of other's model
+    Valkyrie_Dyn_Model(const Valkyrie_Dyn_Model &other, RigidBodyDynamics::Model* model);
     ~Valkyrie_Dyn_Model(void);
 
     bool getMassInertia(Matrix & a);
+    // Ainv is only formed when requested, from the cached factorization of A
     bool getInverseMassInertia(Matrix & ainv);
+    // ainv_b = A^-1 * b without forming the inverse. Repeated solves at the same q reuse one factorization.
+    bool solveMassInertia(const Vector & b, Vector & ainv_b);
     bool getGravity(Vector &  grav);
     bool getCoriolis(Vector & coriolis);
+    // coriolis + gravity from one RNEA pass. Use it when only the sum is needed, as getCoriolis needs both passes.
+    bool getNonlinearEffects(Vector & nonlinear);
 
+    // Only stores the state. Each quantity is computed on its first request after the update.
     void UpdateDynamics(const sejong::Vector & q, const sejong::Vector & qdot);
 
 protected:
+    void updateMassInertia(); // CRBA
+    void updateNonlinearEffects(); // coriolis + gravity, one RNEA pass
+    void updateGravity(); // One RNEA pass with zero qdot
+    void factorizeMassInertia();
+
+    Vector q_;
+    Vector qdot_;
+
     Matrix A_;
     Matrix Ainv_;
+    Eigen::LDLT<Matrix> A_ldlt_; // A is symmetric positive definite
+    bool A_updated_ = true; // Nothing to compute before the first update
+    bool A_factorized_ = false;
+    bool Ainv_updated_ = false;
+    Vector nonlinear_; // coriolis + gravity
     Vector grav_;
-    Vector coriolis_;
+    bool nonlinear_updated_ = true;
+    bool grav_updated_ = true;
 
     RigidBodyDynamics::Model* model_;
 };
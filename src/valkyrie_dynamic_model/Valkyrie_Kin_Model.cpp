@@ -16,10 +16,44 @@ Valkyrie_Kin_Model::Valkyrie_Kin_Model( RigidBodyDynamics::Model* model){
     Jg_ = Matrix::Zero(6, model_->qdot_size);
 }
 
+Valkyrie_Kin_Model::Valkyrie_Kin_Model(const Valkyrie_Kin_Model &other, RigidBodyDynamics::Model* model){
+    *this = other;
+    model_ = model;
+}
+
 Valkyrie_Kin_Model::~Valkyrie_Kin_Model(){
 }
 void Valkyrie_Kin_Model::UpdateKinematics(const sejong::Vector & q, const sejong::Vector & qdot){
-  _UpdateCentroidFrame(q, qdot);
+  q_ = q;
+  qdot_ = qdot;
+  centroid_frame_updated_ = false;
+}
+
+void Valkyrie_Kin_Model::_CheckCentroidFrame(){
+  if(!centroid_frame_updated_){
+    _UpdateCentroidFrame(q_, qdot_);
+    centroid_frame_updated_ = true;
+  }
+}
+
+void Valkyrie_Kin_Model::getCentroidInertia(sejong::Matrix & Icent){
+  _CheckCentroidFrame();
+  Icent = Ig_;
+}
+
+void Valkyrie_Kin_Model::getCentroidJacobian(sejong::Matrix & Jcent){
+  _CheckCentroidFrame();
+  Jcent = Jg_;
+}
+
+void Valkyrie_Kin_Model::getCentroidVelocity(sejong::Vector & centroid_vel){
+  _CheckCentroidFrame();
+  centroid_vel = centroid_vel_;
+}
+
+void Valkyrie_Kin_Model::getCentroidCoMPos(sejong::Vect3 & com_pos){
+  _CheckCentroidFrame();
+  com_pos = com_pos_;
 }
 
 void Valkyrie_Kin_Model::_UpdateCentroidFrame(const sejong::Vector & q, const sejong::Vector & qdot){
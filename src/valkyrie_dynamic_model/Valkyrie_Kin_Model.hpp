@@ -10,6 +10,8 @@ using namespace sejong;
 class Valkyrie_Kin_Model{
 public:
     Valkyrie_Kin_Model(RigidBodyDynamics::Model* model);
+    // Copies the cached quantities of other and works on model, which must be a copy of other's model
+    Valkyrie_Kin_Model(const Valkyrie_Kin_Model &other, RigidBodyDynamics::Model* model);
     ~Valkyrie_Kin_Model(void);
 
     void getPosition(const Vector & q, int link_id, Vect3 & pos);
@@ -28,16 +30,23 @@ public:
     void getCoMPos  (const Vector &q, Vect3 & com_pos, bool update) const;
     void getCoMVel (const Vector & q, const Vector & qdot, Vect3 & com_vel) const;
 
-    void getCentroidInertia(sejong::Matrix & Icent){ Icent = Ig_; }
-    void getCentroidJacobian(sejong::Matrix & Jcent){ Jcent = Jg_; }
+    // The centroid frame is built on the first of these calls after UpdateKinematics
+    void getCentroidInertia(sejong::Matrix & Icent);
+    void getCentroidJacobian(sejong::Matrix & Jcent);
   void getCentroidVelocity(sejong::Vector & centroid_vel);
+  void getCentroidCoMPos(sejong::Vect3 & com_pos);
 
+  // Only stores the state for the centroid frame
   void UpdateKinematics(const sejong::Vector & q, const sejong::Vector & qdot);
 
-  sejong::Vector com_pos_;
-  sejong::Vector centroid_vel_;
 protected:
   void _UpdateCentroidFrame(const sejong::Vector & q, const sejong::Vector & qdot);
+  void _CheckCentroidFrame();
+  sejong::Vector q_;
+  sejong::Vector qdot_;
+  bool centroid_frame_updated_ = true; // Nothing to build before the first update
+  sejong::Vector com_pos_;
+  sejong::Vector centroid_vel_;
     sejong::Matrix Ig_;
     sejong::Matrix Jg_;
 